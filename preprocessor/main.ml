@@ -185,6 +185,7 @@ let main () =
     ^ "// DO NOT EDIT!\n" ^ "\n" ^ "#include <algorithm>\n"
     ^ "#include <typeinfo>\n" ^ "#include \"" ^ output_file_leaf_name ^ "\"\n"
     ^ "#include <cradle/typing/core/preprocessed.h>\n"
+    ^ "#include <cradle/typing/encodings/msgpack_codec.h>\n"
     ^ "#include <boost/algorithm/string/case_conv.hpp>\n" ^ "\n" ^ "namespace "
     ^ namespace ^ " {\n" ^ "\n"
     ^ String.concat ""
@@ -625,6 +625,70 @@ let structure_value_conversion_declarations s =
     ^ s.structure_id ^ " const& x);"
   else structure_value_conversion_implementation s
 
+(* Generate the C++ code to encode and decode a structure directly as
+   MessagePack (see cradle/typing/encodings/msgpack_codec.h). This mirrors the
+   dynamic value conversion above. *)
+let structure_msgpack_implementation s =
+  "size_t count_msgpack_fields(" ^ full_structure_type s ^ " const& x) "
+  ^ "{ " ^ "using cradle::count_msgpack_field; " ^ "return "
+  ^ ( match s.structure_super with
+    | Some super -> "count_msgpack_fields(as_" ^ super ^ "(x))"
+    | None -> "0" )
+  ^ String.concat ""
+      (List.map
+         (fun f -> " + count_msgpack_field(x." ^ f.field_id ^ ")")
+         s.structure_fields)
+  ^ "; } " ^ "void write_fields_to_msgpack(cradle::msgpack_writer& w, "
+  ^ full_structure_type s ^ " const& x) " ^ "{ "
+  ^ "using cradle::write_field_to_msgpack; "
+  ^ ( match s.structure_super with
+    | Some super -> "write_fields_to_msgpack(w, as_" ^ super ^ "(x)); "
+    | None -> "" )
+  ^ String.concat ""
+      (List.map
+         (fun f ->
+           "write_field_to_msgpack(w, \"" ^ f.field_id ^ "\", x." ^ f.field_id
+           ^ "); ")
+         s.structure_fields)
+  ^ "} " ^ "void to_msgpack(cradle::msgpack_writer& w, "
+  ^ full_structure_type s ^ " const& x) " ^ "{ "
+  ^ "w.pack_map_header(count_msgpack_fields(x)); "
+  ^ "write_fields_to_msgpack(w, x); " ^ "} "
+  ^ "void read_fields_from_msgpack(" ^ full_structure_type s
+  ^ "& x, cradle::msgpack_record const& record) " ^ "{ "
+  ^ "using cradle::read_field_from_msgpack; "
+  ^ ( match s.structure_super with
+    | Some super -> "read_fields_from_msgpack(as_" ^ super ^ "(x), record); "
+    | None -> "" )
+  ^ String.concat ""
+      (List.map
+         (fun f ->
+           "read_field_from_msgpack(&x." ^ f.field_id ^ ", record, \""
+           ^ f.field_id ^ "\"); ")
+         s.structure_fields)
+  ^ "} " ^ "void from_msgpack(" ^ full_structure_type s ^ "* x, "
+  ^ "cradle::msgpack_reader& r) " ^ "{ "
+  ^ "cradle::msgpack_record record(r); "
+  ^ "read_fields_from_msgpack(*x, record); " ^ "} "
+
+(* Generate the definitions of the MessagePack functions. Templated
+   structures don't get them; they fall back to going through dynamic
+   values. *)
+let structure_msgpack_definitions s =
+  if not (has_parameters s) then structure_msgpack_implementation s else ""
+
+(* Generate the declarations of the MessagePack functions. *)
+let structure_msgpack_declarations s =
+  if not (has_parameters s) then
+    "size_t count_msgpack_fields(" ^ s.structure_id ^ " const& x); "
+    ^ "void write_fields_to_msgpack(cradle::msgpack_writer& w, "
+    ^ s.structure_id ^ " const& x); "
+    ^ "void to_msgpack(cradle::msgpack_writer& w, " ^ s.structure_id
+    ^ " const& x); " ^ "void read_fields_from_msgpack(" ^ s.structure_id
+    ^ "& x, cradle::msgpack_record const& record); " ^ "void from_msgpack("
+    ^ s.structure_id ^ "* x, cradle::msgpack_reader& r); "
+  else ""
+
 (* Generate the iostream interface for a structure. *)
 let structure_iostream_implementation s =
   template_parameters_declaration s.structure_parameters
@@ -926,6 +990,7 @@ let hpp_string_of_structure app_id app_namespace env s =
   ^ structure_swap_declaration s
   ^ structure_deep_sizeof_declaration s
   ^ structure_value_conversion_declarations s
+  ^ structure_msgpack_declarations s
   ^ ( if structure_component_is_preexisting s "iostream" then ""
     else structure_iostream_declarations s )
   ^ structure_hash_declaration namespace s
@@ -948,6 +1013,7 @@ let cpp_string_of_structure account_id app_id app_namespace env s =
   ^ structure_swap_implementation s
   ^ structure_deep_sizeof_implementation s
   ^ structure_value_conversion_definitions s
+  ^ structure_msgpack_definitions s
   ^ ( if structure_component_is_preexisting s "iostream" then ""
     else structure_iostream_definitions s )
   ^ structure_hash_definition namespace s
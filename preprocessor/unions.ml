@@ -406,6 +406,41 @@ let union_conversion_definitions u =
   ^ "} " ^ "} " ^ "std::ostream& operator<<(std::ostream& s, " ^ u.union_id
   ^ " const& x) " ^ "{ return s << to_dynamic(x); } "
 
+(* Generate the C++ code to encode and decode a union directly as MessagePack
+   (see cradle/typing/encodings/msgpack_codec.h). As with dynamic values, a
+   union is a map with a single entry, from the member name to its value. *)
+let union_msgpack_declarations u =
+  "void to_msgpack(cradle::msgpack_writer& w, " ^ u.union_id ^ " const& x); "
+  ^ "void from_msgpack(" ^ u.union_id ^ "* x, cradle::msgpack_reader& r); "
+
+let union_msgpack_definitions u =
+  "void to_msgpack(cradle::msgpack_writer& w, " ^ u.union_id ^ " const& x) "
+  ^ "{ " ^ "w.pack_map_header(1); " ^ "switch (x.type) " ^ "{ "
+  ^ String.concat ""
+      (List.map
+         (fun m ->
+           "case "
+           ^ cpp_enum_value_of_union_member u m
+           ^ ": " ^ "w.pack_string(\"" ^ m.um_id ^ "\"); "
+           ^ "to_msgpack(w, as_" ^ m.um_id ^ "(x)); " ^ "break; ")
+         u.union_members)
+  ^ "} " ^ "} " ^ "void from_msgpack(" ^ u.union_id
+  ^ "* x, cradle::msgpack_reader& r) " ^ "{ "
+  ^ "auto tag = cradle::read_msgpack_union_tag(r); "
+  ^ "from_dynamic(&x->type, cradle::dynamic(std::string(tag))); "
+  ^ "switch (x->type) " ^ "{ "
+  ^ String.concat ""
+      (List.map
+         (fun m ->
+           "case "
+           ^ cpp_enum_value_of_union_member u m
+           ^ ": " ^ " { "
+           ^ cpp_code_for_type m.um_type
+           ^ " tmp; " ^ "from_msgpack(&tmp, r); "
+           ^ "x->contents_ = std::move(tmp); " ^ "break; " ^ " } ")
+         u.union_members)
+  ^ "} " ^ "} "
+
 let union_swap_declaration u =
   "void swap(" ^ u.union_id ^ "& a, " ^ u.union_id ^ "& b); "
 
@@ -484,6 +519,7 @@ let hpp_string_of_union account_id app_id namespace u =
   ^ union_hash_declarations namespace u
   ^ union_swap_declaration u
   ^ union_conversion_declarations u
+  ^ union_msgpack_declarations u
   ^ union_deep_sizeof_declaration u
 
 (* ^ union_upgrade_type_info_declaration u
@@ -499,6 +535,7 @@ let cpp_string_of_union account_id app_id namespace u =
   ^ union_hash_definitions namespace u
   ^ union_swap_definition u
   ^ union_conversion_definitions u
+  ^ union_msgpack_definitions u
   ^ union_deep_sizeof_definition u
 
 (* ^ union_upgrade_type_info_definition app_id u
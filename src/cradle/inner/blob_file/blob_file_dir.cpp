@@ -1,5 +1,8 @@
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <regex>
+#include <system_error>
 
 #include <fmt/format.h>
 
@@ -31,9 +34,28 @@ file_path
 blob_file_directory::allocate_file()
 {
     std::scoped_lock lock{mutex_};
-    auto result{next_file_path()};
-    ++next_file_id_;
-    return result;
+    // Another process (e.g., a contained one) could be allocating blob files
+    // in the same directory, so checking whether a file exists would be racy.
+    // Instead, claim the file by creating it exclusively ("x" mode), moving on
+    // to the next file_id if it already exists.
+    while (true)
+    {
+        auto result{next_file_path()};
+        ++next_file_id_;
+        errno = 0;
+        if (auto* file = std::fopen(result.string().c_str(), "wbx"))
+        {
+            std::fclose(file);
+            return result;
+        }
+        if (errno != EEXIST)
+        {
+            throw std::system_error(
+                errno,
+                std::generic_category(),
+                fmt::format("cannot create {}", result.string()));
+        }
+    }
 }
 
 // Finds the highest file_id for which a "blob_{file_id}" file exists,
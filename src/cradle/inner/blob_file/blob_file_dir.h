@@ -33,7 +33,8 @@ class blob_file_directory
         return path_;
     }
 
-    // Returns the path to a newly to-be-created blob file
+    // Returns the path to a new, empty, blob file; the file is created
+    // exclusively, so no other process can claim the same path.
     file_path
     allocate_file();
 
@@ -17,8 +17,7 @@ immutable_cache::immutable_cache(immutable_cache_config config)
 void
 immutable_cache::reset(immutable_cache_config config)
 {
-    this->impl = std::make_unique<detail::immutable_cache_impl>();
-    this->impl->config = std::move(config);
+    this->impl = std::make_unique<detail::immutable_cache_impl>(config);
 }
 
 void
@@ -31,18 +30,22 @@ immutable_cache_info
 get_summary_info(immutable_cache& cache)
 {
     auto& impl = *cache.impl;
-    std::scoped_lock<std::mutex> lock(impl.mutex);
-    immutable_cache_info info;
-    info.ac_num_records = static_cast<int>(impl.records.size());
-    info.ac_num_records_pending_eviction
-        = static_cast<int>(impl.eviction_list.size());
+    immutable_cache_info info{};
+    for (auto& shard : impl.shards)
+    {
+        std::scoped_lock<std::mutex> lock(shard->mutex);
+        info.ac_num_records += static_cast<int>(shard->records.size());
+        info.ac_num_records_pending_eviction
+            += static_cast<int>(shard->evictor->size());
+        info.hit_count += shard->hit_count;
+        info.miss_count += shard->miss_count;
+        info.recompute_cost_saved += shard->recompute_cost_saved;
+    }
     info.ac_num_records_in_use
         = info.ac_num_records - info.ac_num_records_pending_eviction;
     info.cas_num_records = impl.cas.num_records();
     info.cas_total_size = impl.cas.total_size();
     info.cas_total_locked_size = impl.cas.total_locked_size();
-    info.hit_count = impl.hit_count;
-    info.miss_count = impl.miss_count;
     return info;
 }
 
@@ -78,23 +81,26 @@ immutable_cache_snapshot
 get_cache_snapshot(immutable_cache& cache_object)
 {
     auto& cache = *cache_object.impl;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
     immutable_cache_snapshot snapshot;
-    for (auto const& [key, record] : cache.records)
+    for (auto& shard : cache.shards)
     {
-        immutable_cache_entry_snapshot entry{
-            get_unique_string(*record->key),
-            record->state,
-            record->cas_record ? record->cas_record->deep_size() : 0};
-        // Put the entry's info the appropriate list depending on whether
-        // or not it's in the eviction list.
-        if (record->eviction_list_iterator != cache.eviction_list.end())
-        {
-            snapshot.pending_eviction.push_back(std::move(entry));
-        }
-        else
+        std::scoped_lock<std::mutex> lock(shard->mutex);
+        for (auto const& [key, record] : shard->records)
         {
-            snapshot.in_use.push_back(std::move(entry));
+            immutable_cache_entry_snapshot entry{
+                get_unique_string(*record->key),
+                record->state,
+                record->cas_record ? record->cas_record->deep_size() : 0};
+            // Put the entry's info the appropriate list depending on whether
+            // or not it's pending eviction.
+            if (record->pending_eviction)
+            {
+                snapshot.pending_eviction.push_back(std::move(entry));
+            }
+            else
+            {
+                snapshot.in_use.push_back(std::move(entry));
+            }
         }
     }
     return snapshot;
@@ -1,6 +1,7 @@
 #ifndef CRADLE_INNER_CACHING_IMMUTABLE_CACHE_H
 #define CRADLE_INNER_CACHING_IMMUTABLE_CACHE_H
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -54,6 +55,15 @@
  *   immediately returns.
  * - The AC record contains a reference to a CAS record; a copy of the value
  *   in that CAS record is returned to the client.
+ *
+ * Instead of a copy, a client can also obtain a shared pointer to the value
+ * in the CAS record (see resolve_request_shared()). This costs the same for
+ * any value size, and is the preferred option for large values.
+ *
+ * Both subcaches are split into shards, each protected by its own mutex: AC
+ * records by the hash of their key, CAS records by their digest. Unused AC
+ * records are evicted in an order decided by a pluggable eviction policy
+ * (see eviction.h); by default, this is approximate global LRU order.
  */
 
 namespace cradle {
@@ -64,11 +74,23 @@ struct immutable_cache_impl;
 
 } // namespace detail
 
+class immutable_cache_eviction_policy;
+
 struct immutable_cache_config
 {
     // The maximum amount of memory to use for caching results that are no
     // longer in use, in bytes.
     std::size_t unused_size_limit;
+
+    // The number of independently locked shards that the AC and CAS are
+    // split into. More shards means less contention between threads
+    // accessing the cache concurrently.
+    int num_shards{16};
+
+    // Decides which unused results are evicted first (see eviction.h);
+    // LRU if not set. The policy object holds state for a single cache, so
+    // should not be shared between caches.
+    std::shared_ptr<immutable_cache_eviction_policy> eviction_policy{};
 };
 
 // Summary information on the data in the cache.
@@ -90,6 +112,9 @@ struct immutable_cache_info
     int hit_count;
     // Number of cache misses.
     int miss_count;
+    // Recompute cost saved: the sum, over all hits on ready records, of the
+    // time it took to compute the record's value.
+    std::chrono::nanoseconds recompute_cost_saved;
 };
 
 struct immutable_cache
@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <cradle/inner/caching/immutable/eviction.h>
+#include <cradle/inner/caching/immutable/internals.h>
+
+namespace cradle {
+
+namespace {
+
+using detail::cache_record_eviction_list;
+using detail::cache_record_eviction_set;
+using detail::immutable_cache_record;
+
+class lru_eviction_shard : public immutable_cache_eviction_shard
+{
+ public:
+    void
+    add(immutable_cache_record& record) override
+    {
+        list_.push_back(record);
+    }
+
+    void
+    remove(immutable_cache_record& record, bool evicted) override
+    {
+        list_.erase(list_.iterator_to(record));
+    }
+
+    // All candidates get the same score, so the least recently released one
+    // over all shards is evicted.
+    eviction_candidate
+    next_victim() override
+    {
+        if (list_.empty())
+        {
+            return {};
+        }
+        return {&list_.front(), 0};
+    }
+
+    std::size_t
+    size() const override
+    {
+        return list_.size();
+    }
+
+ private:
+    cache_record_eviction_list list_;
+};
+
+class lru_eviction_policy : public immutable_cache_eviction_policy
+{
+ public:
+    std::string
+    name() const override
+    {
+        return "lru";
+    }
+
+    std::unique_ptr<immutable_cache_eviction_shard>
+    make_shard() override
+    {
+        return std::make_unique<lru_eviction_shard>();
+    }
+};
+
+/*
+ * GDSF assigns each record the priority
+ *   clock + frequency * cost / size
+ * when the record becomes unused, and evicts the record with the lowest
+ * priority first. The clock is raised to the priority of each evicted
+ * record, so that records that were popular long ago eventually age out.
+ *
+ * The cost is the time it took to compute the value, in nanoseconds; the
+ * size is the value's deep size, in bytes.
+ */
+class gdsf_eviction_policy : public immutable_cache_eviction_policy
+{
+ public:
+    std::string
+    name() const override
+    {
+        return "gdsf";
+    }
+
+    std::unique_ptr<immutable_cache_eviction_shard>
+    make_shard() override;
+
+    double
+    clock() const
+    {
+        return clock_.load(std::memory_order_relaxed);
+    }
+
+    void
+    advance_clock(double priority)
+    {
+        double current = clock_.load(std::memory_order_relaxed);
+        while (priority > current
+               && !clock_.compare_exchange_weak(
+                   current, priority, std::memory_order_relaxed))
+        {
+        }
+    }
+
+ private:
+    std::atomic<double> clock_{0};
+};
+
+class gdsf_eviction_shard : public immutable_cache_eviction_shard
+{
+ public:
+    explicit gdsf_eviction_shard(gdsf_eviction_policy& policy)
+        : policy_{policy}
+    {
+    }
+
+    void
+    add(immutable_cache_record& record) override
+    {
+        double frequency = record.hit_count + 1;
+        double cost = static_cast<double>(record.compute_time.count());
+        double size = static_cast<double>(
+            std::max<std::size_t>(detail::get_record_deep_size(record), 1));
+        record.eviction_priority = policy_.clock() + frequency * cost / size;
+        set_.insert(record);
+    }
+
+    void
+    remove(immutable_cache_record& record, bool evicted) override
+    {
+        set_.erase(set_.iterator_to(record));
+        if (evicted)
+        {
+            policy_.advance_clock(record.eviction_priority);
+        }
+    }
+
+    eviction_candidate
+    next_victim() override
+    {
+        if (set_.empty())
+        {
+            return {};
+        }
+        auto& record = *set_.begin();
+        return {&record, record.eviction_priority};
+    }
+
+    std::size_t
+    size() const override
+    {
+        return set_.size();
+    }
+
+ private:
+    gdsf_eviction_policy& policy_;
+    cache_record_eviction_set set_;
+};
+
+std::unique_ptr<immutable_cache_eviction_shard>
+gdsf_eviction_policy::make_shard()
+{
+    return std::make_unique<gdsf_eviction_shard>(*this);
+}
+
+/*
+ * Count-min sketch with 4-bit (saturating) counters, estimating how often
+ * keys were accessed. After a number of increments proportional to the
+ * sketch's width, all counters are halved, so that the estimates favor
+ * recent accesses.
+ * Updates are lock-free, and may occasionally get lost under contention;
+ * this is acceptable for a frequency estimate.
+ */
+class frequency_sketch
+{
+ public:
+    explicit frequency_sketch(std::size_t width)
+        : width_{std::bit_ceil(std::max<std::size_t>(width, 64))},
+          counters_(num_rows * width_),
+          sample_size_{10 * width_}
+    {
+    }
+
+    void
+    increment(std::size_t key_hash)
+    {
+        for (std::size_t row = 0; row < num_rows; ++row)
+        {
+            auto& counter = counters_[index(key_hash, row)];
+            uint8_t value = counter.load(std::memory_order_relaxed);
+            if (value < max_count)
+            {
+                counter.compare_exchange_weak(
+                    value, value + 1, std::memory_order_relaxed);
+            }
+        }
+        if (samples_.fetch_add(1, std::memory_order_relaxed) + 1
+            >= sample_size_)
+        {
+            age();
+        }
+    }
+
+    int
+    estimate(std::size_t key_hash) const
+    {
+        uint8_t result = max_count;
+        for (std::size_t row = 0; row < num_rows; ++row)
+        {
+            result = std::min(
+                result,
+                counters_[index(key_hash, row)].load(
+                    std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+ private:
+    static constexpr std::size_t num_rows = 4;
+    static constexpr uint8_t max_count = 15;
+    static constexpr uint64_t row_seeds[num_rows]
+        = {0x9e3779b97f4a7c15,
+           0xc2b2ae3d27d4eb4f,
+           0x165667b19e3779f9,
+           0xd6e8feb86659fd93};
+
+    std::size_t width_;
+    std::vector<std::atomic<uint8_t>> counters_;
+    std::size_t sample_size_;
+    std::atomic<std::size_t> samples_{0};
+    std::mutex aging_mutex_;
+
+    std::size_t
+    index(std::size_t key_hash, std::size_t row) const
+    {
+        uint64_t h = (static_cast<uint64_t>(key_hash) + row) * row_seeds[row];
+        h ^= h >> 32;
+        return row * width_ + (h & (width_ - 1));
+    }
+
+    void
+    age()
+    {
+        std::unique_lock<std::mutex> lock(aging_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()
+            || samples_.load(std::memory_order_relaxed) < sample_size_)
+        {
+            // Another thread is (or was just) aging the sketch.
+            return;
+        }
+        for (auto& counter : counters_)
+        {
+            counter.store(
+                counter.load(std::memory_order_relaxed) / 2,
+                std::memory_order_relaxed);
+        }
+        samples_.store(sample_size_ / 2, std::memory_order_relaxed);
+    }
+};
+
+/*
+ * W-TinyLFU splits a shard's unused records into a small LRU window, and a
+ * main area (also in LRU order). Newly released records enter the window.
+ * When the window is over its capacity, its least recently released record
+ * (the candidate) competes with the main area's least recently released
+ * record (the victim): if the candidate was accessed more often, it is
+ * admitted to the main area and the victim is evicted; otherwise, the
+ * candidate is evicted. While the main area is empty, candidates are
+ * admitted unconditionally.
+ *
+ * Access frequencies come from a sketch that also remembers keys that are
+ * no longer in the cache, so a value that is requested again and again
+ * after being evicted will eventually be retained.
+ *
+ * Admission happens only when an eviction actually takes place in the shard,
+ * rather than each time the window overflows; proposing a victim has no side
+ * effects. Across shards, the candidate with the lowest estimated frequency
+ * is evicted.
+ */
+class w_tinylfu_eviction_policy : public immutable_cache_eviction_policy
+{
+ public:
+    w_tinylfu_eviction_policy(double window_fraction, std::size_t sketch_width)
+        : window_fraction_{window_fraction}, sketch_{sketch_width}
+    {
+    }
+
+    std::string
+    name() const override
+    {
+        return "w_tinylfu";
+    }
+
+    std::unique_ptr<immutable_cache_eviction_shard>
+    make_shard() override;
+
+    void
+    on_access(std::size_t key_hash) override
+    {
+        sketch_.increment(key_hash);
+    }
+
+    double
+    window_fraction() const
+    {
+        return window_fraction_;
+    }
+
+    int
+    frequency(immutable_cache_record const& record) const
+    {
+        return sketch_.estimate(record.key->hash());
+    }
+
+ private:
+    double window_fraction_;
+    frequency_sketch sketch_;
+};
+
+class w_tinylfu_eviction_shard : public immutable_cache_eviction_shard
+{
+ public:
+    explicit w_tinylfu_eviction_shard(w_tinylfu_eviction_policy& policy)
+        : policy_{policy}
+    {
+    }
+
+    void
+    add(immutable_cache_record& record) override
+    {
+        record.in_eviction_window = true;
+        window_.push_back(record);
+    }
+
+    // If the window is over its capacity, and record is the main area's
+    // victim, then record lost against the window's candidate, which is now
+    // admitted to the main area.
+    void
+    remove(immutable_cache_record& record, bool evicted) override
+    {
+        if (evicted && !record.in_eviction_window
+            && window_.size() > window_capacity())
+        {
+            admit(window_.front());
+        }
+        auto& list = record.in_eviction_window ? window_ : main_;
+        list.erase(list.iterator_to(record));
+    }
+
+    // Does not admit anything; remove() does, once the victim is actually
+    // evicted.
+    eviction_candidate
+    next_victim() override
+    {
+        if (window_.size() > window_capacity() && !main_.empty())
+        {
+            auto& candidate = window_.front();
+            auto& victim = main_.front();
+            int candidate_frequency = policy_.frequency(candidate);
+            int victim_frequency = policy_.frequency(victim);
+            if (candidate_frequency > victim_frequency)
+            {
+                return {&victim, static_cast<double>(victim_frequency)};
+            }
+            return {&candidate, static_cast<double>(candidate_frequency)};
+        }
+        // If the window is over its capacity while the main area is empty,
+        // the candidate would be admitted unconditionally, and then be the
+        // main area's victim; so it can be evicted straight away.
+        return make_candidate(main_.empty() ? window_ : main_);
+    }
+
+    std::size_t
+    size() const override
+    {
+        return window_.size() + main_.size();
+    }
+
+ private:
+    w_tinylfu_eviction_policy& policy_;
+    cache_record_eviction_list window_;
+    cache_record_eviction_list main_;
+
+    std::size_t
+    window_capacity() const
+    {
+        return std::max<std::size_t>(
+            static_cast<std::size_t>(policy_.window_fraction() * size()), 1);
+    }
+
+    // Moves the window's front record to the main area.
+    void
+    admit(immutable_cache_record& record)
+    {
+        window_.pop_front();
+        record.in_eviction_window = false;
+        main_.push_back(record);
+    }
+
+    eviction_candidate
+    make_candidate(cache_record_eviction_list& list)
+    {
+        if (list.empty())
+        {
+            return {};
+        }
+        auto& record = list.front();
+        return {&record, static_cast<double>(policy_.frequency(record))};
+    }
+};
+
+std::unique_ptr<immutable_cache_eviction_shard>
+w_tinylfu_eviction_policy::make_shard()
+{
+    return std::make_unique<w_tinylfu_eviction_shard>(*this);
+}
+
+} // namespace
+
+std::shared_ptr<immutable_cache_eviction_policy>
+make_lru_eviction_policy()
+{
+    return std::make_shared<lru_eviction_policy>();
+}
+
+std::shared_ptr<immutable_cache_eviction_policy>
+make_gdsf_eviction_policy()
+{
+    return std::make_shared<gdsf_eviction_policy>();
+}
+
+std::shared_ptr<immutable_cache_eviction_policy>
+make_w_tinylfu_eviction_policy(
+    double window_fraction, std::size_t sketch_width)
+{
+    return std::make_shared<w_tinylfu_eviction_policy>(
+        window_fraction, sketch_width);
+}
+
+std::shared_ptr<immutable_cache_eviction_policy>
+make_eviction_policy(std::string const& name)
+{
+    if (name == "lru")
+    {
+        return make_lru_eviction_policy();
+    }
+    if (name == "gdsf")
+    {
+        return make_gdsf_eviction_policy();
+    }
+    if (name == "w_tinylfu")
+    {
+        return make_w_tinylfu_eviction_policy();
+    }
+    throw std::invalid_argument(
+        fmt::format("unknown memory cache eviction policy {}", name));
+}
+
+} // namespace cradle
@@ -0,0 +1,132 @@
+#ifndef CRADLE_INNER_CACHING_IMMUTABLE_EVICTION_H
+#define CRADLE_INNER_CACHING_IMMUTABLE_EVICTION_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/*
+ * Eviction policies for the memory (immutable) cache.
+ *
+ * When the total size of the unused AC records exceeds the cache's
+ * unused_size_limit, records are evicted one at a time. An eviction policy
+ * decides which record goes first. The cache keeps the following statistics
+ * on each AC record, for use by the policies:
+ * - The time it took to compute the record's value (its recompute cost).
+ * - The deep size of the value.
+ * - The number of hits on the record.
+ *
+ * An eviction policy object is shared by all shards of a cache, and creates
+ * a per-shard object that tracks the unused records in one shard. To pick
+ * the next victim, the cache asks each shard for its best candidate, and
+ * evicts the candidate with the lowest score (ties are broken by evicting
+ * the least recently released record).
+ */
+
+namespace cradle {
+
+namespace detail {
+
+struct immutable_cache_record;
+
+} // namespace detail
+
+// A record that an eviction shard proposes to evict next.
+struct eviction_candidate
+{
+    // nullptr if the shard has no unused records
+    detail::immutable_cache_record* record{nullptr};
+
+    // Across shards, the candidate with the lowest score is evicted.
+    double score{0};
+};
+
+/*
+ * The part of an eviction policy tracking the unused AC records in one
+ * shard of the cache.
+ *
+ * All functions are called while holding the shard's mutex.
+ */
+class immutable_cache_eviction_shard
+{
+ public:
+    virtual ~immutable_cache_eviction_shard() = default;
+
+    // Starts tracking a record that is no longer in use.
+    virtual void
+    add(detail::immutable_cache_record& record)
+        = 0;
+
+    // Stops tracking a record, either because it is in use again
+    // (evicted == false), or because it is being evicted (evicted == true).
+    virtual void
+    remove(detail::immutable_cache_record& record, bool evicted)
+        = 0;
+
+    // Returns the record that should be evicted next from this shard.
+    // This is a pure query: it doesn't change the shard's state, as the
+    // cache asks all shards for their candidates, but evicts only one of
+    // them. Any state changes accompanying an eviction should happen in
+    // remove().
+    virtual eviction_candidate
+    next_victim()
+        = 0;
+
+    // Returns the number of records being tracked.
+    virtual std::size_t
+    size() const
+        = 0;
+};
+
+/*
+ * Interface to an eviction policy for the memory cache
+ */
+class immutable_cache_eviction_policy
+{
+ public:
+    virtual ~immutable_cache_eviction_policy() = default;
+
+    virtual std::string
+    name() const
+        = 0;
+
+    virtual std::unique_ptr<immutable_cache_eviction_shard>
+    make_shard()
+        = 0;
+
+    // Notifies the policy of an access (hit or miss) to the record with the
+    // given key hash. May be called concurrently for different shards, while
+    // holding the mutex for the record's shard.
+    virtual void
+    on_access(std::size_t key_hash)
+    {
+    }
+};
+
+// Evicts the least recently released record first. This is the default.
+std::shared_ptr<immutable_cache_eviction_policy>
+make_lru_eviction_policy();
+
+// Greedy-Dual-Size-Frequency: evicts the record with the lowest
+// (frequency * recompute cost / size), plus an aging term, first. This favors
+// keeping small, expensive and popular values over large, cheap ones.
+std::shared_ptr<immutable_cache_eviction_policy>
+make_gdsf_eviction_policy();
+
+// Window TinyLFU: newly released records go into a small LRU window; records
+// leaving the window compete with the main area's LRU victim, based on
+// access frequencies estimated by a (periodically aged) count-min sketch.
+// :window_fraction is the fraction of a shard's unused records that the
+// window can hold; :sketch_width is the number of counters per sketch row.
+std::shared_ptr<immutable_cache_eviction_policy>
+make_w_tinylfu_eviction_policy(
+    double window_fraction = 0.01, std::size_t sketch_width = 1 << 16);
+
+// Creates the eviction policy with the given name: "lru", "gdsf" or
+// "w_tinylfu". Throws std::invalid_argument for any other name.
+std::shared_ptr<immutable_cache_eviction_policy>
+make_eviction_policy(std::string const& name);
+
+} // namespace cradle
+
+#endif
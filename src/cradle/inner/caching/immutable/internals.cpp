@@ -1,3 +1,5 @@
+#include <stdexcept>
+
 #include <boost/functional/hash.hpp>
 
 #include <cradle/inner/caching/immutable/internals.h>
@@ -8,69 +10,130 @@ namespace detail {
 
 namespace {
 
-void
-add_to_eviction_list(
-    cache_record_eviction_list& list, immutable_cache_record& record)
+// Returns the shard holding the best eviction candidate over all shards: the
+// one with the lowest score, or for equal scores, the least recently released
+// one. Returns nullptr if there are no unused records.
+immutable_cache_shard*
+find_eviction_shard(immutable_cache_impl& cache)
 {
-    assert(record.eviction_list_iterator == list.end());
-    record.eviction_list_iterator = list.insert(list.end(), record);
+    immutable_cache_shard* best_shard{nullptr};
+    double best_score{0};
+    uint64_t best_tick{0};
+    for (auto& shard : cache.shards)
+    {
+        std::scoped_lock<std::mutex> lock(shard->mutex);
+        auto candidate = shard->evictor->next_victim();
+        if (!candidate.record)
+        {
+            continue;
+        }
+        auto tick = candidate.record->release_tick;
+        if (!best_shard || candidate.score < best_score
+            || (candidate.score == best_score && tick < best_tick))
+        {
+            best_shard = &*shard;
+            best_score = candidate.score;
+            best_tick = tick;
+        }
+    }
+    return best_shard;
 }
 
+// Evicts the shard's next victim, if any.
+// Should be called while holding the shard's mutex.
 void
-remove_from_eviction_list(
-    cache_record_eviction_list& list, immutable_cache_record& record)
+evict_next_record(immutable_cache_impl& cache, immutable_cache_shard& shard)
 {
-    assert(record.eviction_list_iterator != list.end());
-    list.erase(record.eviction_list_iterator);
-    record.eviction_list_iterator = list.end();
+    auto* record = shard.evictor->next_victim().record;
+    if (!record)
+    {
+        // Another thread revived or evicted the record in the meantime.
+        return;
+    }
+    shard.evictor->remove(*record, true);
+    record->pending_eviction = false;
+    if (auto* cas_record = record->cas_record)
+    {
+        cache.cas.release_record(*cas_record);
+    }
+    shard.records.erase(&*record->key);
 }
 
-void
-reduce_memory_cache_size_impl(
-    immutable_cache_impl& cache, uint64_t desired_size)
+// Returns config if it is valid, throws otherwise.
+immutable_cache_config const&
+checked_config(immutable_cache_config const& config)
 {
-    // The critical size excludes CAS records with locked referrer(s).
-    while (!cache.eviction_list.empty()
-           && cache.cas.total_unlocked_size() > desired_size)
+    if (config.num_shards < 1)
     {
-        auto const& record = cache.eviction_list.front();
-        if (auto* cas_record = record.cas_record)
-        {
-            cas_record->del_ref();
-            if (cas_record->ref_count() == 0)
-            {
-                cache.cas.del_record(*cas_record);
-            }
-        }
-        // Unlink the record, then destroy it.
-        cache.eviction_list.pop_front();
-        cache.records.erase(&*record.key);
+        throw std::invalid_argument("immutable cache needs at least 1 shard");
     }
+    return config;
 }
 
 } // namespace
 
+immutable_cache_impl::immutable_cache_impl(
+    immutable_cache_config const& config)
+    : config{checked_config(config)},
+      eviction_policy{
+          config.eviction_policy ? config.eviction_policy
+                                 : make_lru_eviction_policy()},
+      cas{config.num_shards}
+{
+    shards.reserve(config.num_shards);
+    for (int i = 0; i < config.num_shards; ++i)
+    {
+        auto shard = std::make_unique<immutable_cache_shard>();
+        shard->evictor = eviction_policy->make_shard();
+        shards.push_back(std::move(shard));
+    }
+}
+
 void
 add_ref_to_cache_record(immutable_cache_record& record)
 {
-    auto& cache = *record.owner_cache;
-    ++record.ref_count;
-    if (record.eviction_list_iterator != cache.eviction_list.end())
+    auto& shard = *record.owner_shard;
+    if (record.ref_count.fetch_add(1, std::memory_order_acq_rel) == 0
+        && record.pending_eviction)
     {
-        assert(record.ref_count == 1);
-        remove_from_eviction_list(cache.eviction_list, record);
+        shard.evictor->remove(record, false);
+        record.pending_eviction = false;
     }
 }
 
 void
 del_ref_from_cache_record(immutable_cache_record& record)
 {
+    // Fast path: this is not the last reference, so the record stays in use
+    // and no mutex is needed.
+    int count = record.ref_count.load(std::memory_order_relaxed);
+    while (count > 1)
+    {
+        if (record.ref_count.compare_exchange_weak(
+                count, count - 1, std::memory_order_acq_rel))
+        {
+            return;
+        }
+    }
+
     auto& cache = *record.owner_cache;
-    --record.ref_count;
-    if (record.ref_count == 0)
+    auto& shard = *record.owner_shard;
+    {
+        std::scoped_lock<std::mutex> lock(shard.mutex);
+        if (record.ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            // Revived by another thread while we were acquiring the mutex.
+            return;
+        }
+        record.release_tick = cache.release_counter.fetch_add(
+            1, std::memory_order_relaxed);
+        shard.evictor->add(record);
+        record.pending_eviction = true;
+    }
+    // From here on, the record may be evicted by another thread.
+    if (cache.cas.total_unlocked_size() > cache.config.unused_size_limit)
     {
-        add_to_eviction_list(cache.eviction_list, record);
-        reduce_memory_cache_size_impl(cache, cache.config.unused_size_limit);
+        reduce_memory_cache_size(cache, cache.config.unused_size_limit);
     }
 }
 
@@ -101,8 +164,18 @@ del_lock_from_cache_record(immutable_cache_record& record)
 void
 reduce_memory_cache_size(immutable_cache_impl& cache, uint64_t desired_size)
 {
-    std::scoped_lock<std::mutex> lock(cache.mutex);
-    reduce_memory_cache_size_impl(cache, desired_size);
+    std::scoped_lock<std::mutex> eviction_lock(cache.eviction_mutex);
+    // The critical size excludes CAS records with locked referrer(s).
+    while (cache.cas.total_unlocked_size() > desired_size)
+    {
+        auto* shard = find_eviction_shard(cache);
+        if (!shard)
+        {
+            break;
+        }
+        std::scoped_lock<std::mutex> lock(shard->mutex);
+        evict_next_record(cache, *shard);
+    }
 }
 
 std::size_t
@@ -112,12 +185,29 @@ cas_record_hash::operator()(cas_record_base::digest_type const& val) const
     return boost::hash_range(bytes, bytes + val.size());
 }
 
+cas_cache::cas_cache(int num_shards)
+{
+    shards_.reserve(num_shards);
+    for (int i = 0; i < num_shards; ++i)
+    {
+        shards_.push_back(std::make_unique<shard>());
+    }
+}
+
+cas_cache::shard&
+cas_cache::shard_for(digest_type const& digest)
+{
+    return *shards_[cas_record_hash{}(digest) % shards_.size()];
+}
+
 cas_record_base&
 cas_cache::ensure_record(
     digest_type const& digest, cas_record_maker_intf const& record_maker)
 {
-    auto it = map_.find(digest);
-    if (it != map_.end())
+    auto& shard = shard_for(digest);
+    std::scoped_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(digest);
+    if (it != shard.map.end())
     {
         auto& existing_record = *it->second;
         existing_record.add_ref();
@@ -126,25 +216,35 @@ cas_cache::ensure_record(
     auto new_record = record_maker();
     auto& ret_value = *new_record;
     total_size_ += new_record->deep_size();
+    num_records_ += 1;
     [[maybe_unused]] auto [_, inserted]
-        = map_.insert(std::make_pair(digest, std::move(new_record)));
+        = shard.map.insert(std::make_pair(digest, std::move(new_record)));
     assert(inserted);
     return ret_value;
 }
 
 void
-cas_cache::del_record(cas_record_base const& record)
+cas_cache::release_record(cas_record_base& record)
 {
-    assert(record.ref_count() == 0);
+    auto& shard = shard_for(record.digest());
+    std::scoped_lock<std::mutex> lock(shard.mutex);
+    record.del_ref();
+    if (record.ref_count() > 0)
+    {
+        return;
+    }
     assert(record.lock_count() == 0);
     total_size_ -= record.deep_size();
-    [[maybe_unused]] auto num_deleted = map_.erase(record.digest());
+    num_records_ -= 1;
+    [[maybe_unused]] auto num_deleted = shard.map.erase(record.digest());
     assert(num_deleted == 1);
 }
 
 void
 cas_cache::add_lock(cas_record_base& record)
 {
+    auto& shard = shard_for(record.digest());
+    std::scoped_lock<std::mutex> lock(shard.mutex);
     record.add_lock();
     if (record.lock_count() == 1)
     {
@@ -155,6 +255,8 @@ cas_cache::add_lock(cas_record_base& record)
 void
 cas_cache::del_lock(cas_record_base& record)
 {
+    auto& shard = shard_for(record.digest());
+    std::scoped_lock<std::mutex> lock(shard.mutex);
     record.del_lock();
     if (record.lock_count() == 0)
     {
@@ -1,16 +1,23 @@
 #ifndef CRADLE_INNER_CACHING_IMMUTABLE_INTERNALS_H
 #define CRADLE_INNER_CACHING_IMMUTABLE_INTERNALS_H
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/intrusive/list.hpp>
+#include <boost/intrusive/set.hpp>
 #include <cppcoro/shared_task.hpp>
 
 #include <cradle/inner/caching/immutable/cache.h>
+#include <cradle/inner/caching/immutable/eviction.h>
 #include <cradle/inner/core/type_interfaces.h>
 #include <cradle/inner/core/unique_hash.h>
 
@@ -19,34 +26,58 @@ namespace cradle {
 namespace detail {
 
 struct immutable_cache_impl;
+struct immutable_cache_shard;
 class cas_record_base;
 
 /*
  * A record in the Action Cache.
  */
-struct immutable_cache_record : public boost::intrusive::list_base_hook<>
+struct immutable_cache_record
 {
     // These remain constant for the life of the record.
     immutable_cache_impl* owner_cache;
+    immutable_cache_shard* owner_shard;
     captured_id key;
 
-    // All of the following fields are protected by the cache mutex, i.e.,
-    // should be accessed only while holding that mutex.
-
     // This is a count of how many active pointers (immutable_cache_pointer or
     // cache_record_lock) reference this data.
     // If this is 0, the data is no longer actively in use and is queued for
-    // eviction. In this case, :eviction_list_iterator points to this record's
-    // entry in the eviction list.
-    int ref_count = 0;
+    // eviction: it is tracked by its shard's eviction policy, and
+    // :pending_eviction is set.
+    // A decrement that keeps the count above 0 can happen without holding
+    // any mutex; the transitions from 0 to 1 and from 1 to 0 happen only
+    // while holding the shard mutex.
+    std::atomic<int> ref_count{0};
+
+    // All of the following fields are protected by the shard mutex, i.e.,
+    // should be accessed only while holding that mutex.
 
     // The number of cache_record_lock objects referencing this record;
     // at most ref_count.
     int lock_count = 0;
 
     // (See :ref_count comment.)
-    boost::intrusive::list<immutable_cache_record>::iterator
-        eviction_list_iterator;
+    bool pending_eviction{false};
+
+    // Value of the cache's release counter when this record was last handed
+    // to its shard's eviction policy. Breaks ties between eviction candidates
+    // from different shards, in (approximate) global LRU order.
+    uint64_t release_tick{0};
+
+    // Statistics for the eviction policy.
+    // The number of cache hits on this record.
+    int hit_count{0};
+    // When the current attempt to compute the value started.
+    std::chrono::steady_clock::time_point compute_start;
+    // How long it took to compute the value; valid if the state is READY.
+    std::chrono::nanoseconds compute_time{0};
+
+    // Reserved for the eviction policy tracking the record while it is
+    // pending eviction.
+    boost::intrusive::list_member_hook<> eviction_list_hook;
+    boost::intrusive::set_member_hook<> eviction_set_hook;
+    double eviction_priority{0};
+    bool in_eviction_window{false};
 
     // Is the data ready?
     immutable_cache_entry_state state = immutable_cache_entry_state::LOADING;
@@ -62,20 +93,26 @@ struct immutable_cache_record : public boost::intrusive::list_base_hook<>
 };
 
 // Indicates that a pointer started referring to the given record.
+// Should be called while holding the record's shard mutex.
 void
 add_ref_to_cache_record(immutable_cache_record& record);
 
 // Indicates that a pointer stopped referring to the given record.
+// Should be called while NOT holding any cache mutex: if the record becomes
+// unused, this may trigger an eviction run over all shards.
+// The record may no longer exist when this function returns.
 void
 del_ref_from_cache_record(immutable_cache_record& record);
 
 // Adds a lock to the given record. Must be paired with an
 // add_ref_to_cache_record() call.
+// Should be called while holding the record's shard mutex.
 void
 add_lock_to_cache_record(immutable_cache_record& record);
 
 // Removes a lock from the given record. Must be paired with a
 // del_ref_to_cache_record() call.
+// Should be called while holding the record's shard mutex.
 void
 del_lock_from_cache_record(immutable_cache_record& record);
 
@@ -94,17 +131,45 @@ typedef std::unordered_map<
     cache_record_map;
 
 /*
- * The eviction list contains AC records in an LRU order.
- * Record ownership lies with the unordered map, not this list.
+ * Intrusive containers that eviction policies can use to track AC records.
+ * Record ownership lies with the unordered map, not these containers.
  */
-using cache_record_eviction_list
-    = boost::intrusive::list<immutable_cache_record>;
+using cache_record_eviction_list = boost::intrusive::list<
+    immutable_cache_record,
+    boost::intrusive::member_hook<
+        immutable_cache_record,
+        boost::intrusive::list_member_hook<>,
+        &immutable_cache_record::eviction_list_hook>>;
+
+// Orders records by increasing eviction priority, then by release tick.
+struct cache_record_eviction_order
+{
+    bool
+    operator()(
+        immutable_cache_record const& a, immutable_cache_record const& b) const
+    {
+        if (a.eviction_priority != b.eviction_priority)
+        {
+            return a.eviction_priority < b.eviction_priority;
+        }
+        return a.release_tick < b.release_tick;
+    }
+};
+
+using cache_record_eviction_set = boost::intrusive::multiset<
+    immutable_cache_record,
+    boost::intrusive::member_hook<
+        immutable_cache_record,
+        boost::intrusive::set_member_hook<>,
+        &immutable_cache_record::eviction_set_hook>,
+    boost::intrusive::compare<cache_record_eviction_order>>;
 
 /*
  * Untyped base class for a record in the CAS.
  *
  * This holds a reference count of AC records referencing this CAS record,
- * and a count of how many of those AC records are locked.
+ * and a count of how many of those AC records are locked. Both counts are
+ * protected by the mutex of the CAS shard holding the record.
  * It does not hold the (typed) value itself.
  */
 class cas_record_base
@@ -191,31 +256,36 @@ struct cas_record_hash
 
 /*
  * Typed class for a record in the CAS, storing the (typed) value.
+ *
+ * The value is held via a shared pointer so that clients can access it
+ * without copying (see immutable_cache_ptr::get_shared_value()); the value
+ * then stays alive as long as a client holds on to it, even if the record
+ * is evicted.
  */
 template<typename Value>
 class cas_record : public cas_record_base
 {
  public:
     cas_record(digest_type const& digest, Value&& value)
-        : cas_record_base(digest, deep_sizeof(value))
+        : cas_record_base(digest, deep_sizeof(value)),
+          value_{std::make_shared<Value const>(std::move(value))}
     {
-        new (&value_storage_) Value(std::move(value));
     }
 
-    ~cas_record()
+    Value const&
+    value() const
     {
-        reinterpret_cast<Value*>(&value_storage_)->~Value();
+        return *value_;
     }
 
-    Value const&
-    value() const
+    std::shared_ptr<Value const> const&
+    shared_value() const
     {
-        return *reinterpret_cast<Value const*>(&value_storage_);
+        return value_;
     }
 
  private:
-    // Borrowed from cppcoro's shared_task_promise class
-    alignas(Value) char value_storage_[sizeof(Value)];
+    std::shared_ptr<Value const> value_;
 };
 
 /*
@@ -264,6 +334,10 @@ class cas_record_maker : public cas_record_maker_intf
 /*
  * Content-addressable storage (CAS), storing the cache values, indexed by a
  * digest over the value.
+ *
+ * The records are split over a number of shards, based on their digest;
+ * each shard has its own mutex. The totals are atomic so that they can be
+ * inspected without taking any mutex.
  */
 class cas_cache
 {
@@ -273,6 +347,8 @@ class cas_cache
     using map_type
         = std::unordered_map<digest_type, record_ptr_type, cas_record_hash>;
 
+    explicit cas_cache(int num_shards);
+
     // Ensure that a record exists for the given value, with the given digest.
     // If a record for the digest already exists, increases the record's
     // reference count and returns a reference to that object.
@@ -284,8 +360,10 @@ class cas_cache
     ensure_record(
         digest_type const& digest, cas_record_maker_intf const& record_maker);
 
+    // Removes a reference to the given record, deleting the record when no
+    // references remain.
     void
-    del_record(cas_record_base const& record);
+    release_record(cas_record_base& record);
 
     void
     add_lock(cas_record_base& record);
@@ -296,14 +374,14 @@ class cas_cache
     int
     num_records() const
     {
-        return static_cast<int>(map_.size());
+        return num_records_.load(std::memory_order_relaxed);
     }
 
     // Returns the total deep size of all records in the CAS.
     std::size_t
     total_size() const
     {
-        return total_size_;
+        return total_size_.load(std::memory_order_relaxed);
     }
 
     // Returns the total deep size of all records in the CAS, that are referred
@@ -311,7 +389,7 @@ class cas_cache
     std::size_t
     total_locked_size() const
     {
-        return total_locked_size_;
+        return total_locked_size_.load(std::memory_order_relaxed);
     }
 
     // Returns the total deep size of all records in the CAS, that are referred
@@ -319,31 +397,86 @@ class cas_cache
     std::size_t
     total_unlocked_size() const
     {
-        return total_size_ - total_locked_size_;
+        // The two loads are not atomic as a pair.
+        auto total = total_size();
+        auto locked = total_locked_size();
+        return total > locked ? total - locked : 0;
     }
 
  private:
-    map_type map_;
-    std::size_t total_size_{0};
-    std::size_t total_locked_size_{0};
+    struct shard
+    {
+        std::mutex mutex;
+        map_type map;
+    };
+
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::atomic<int> num_records_{0};
+    std::atomic<std::size_t> total_size_{0};
+    std::atomic<std::size_t> total_locked_size_{0};
+
+    shard&
+    shard_for(digest_type const& digest);
 };
 
-struct immutable_cache_impl
+// Returns the deep size of the value referenced by an AC record, or 0 if the
+// record has no value.
+inline std::size_t
+get_record_deep_size(immutable_cache_record const& record)
+{
+    return record.cas_record ? record.cas_record->deep_size() : 0;
+}
+
+/*
+ * A shard of the Action Cache: the AC records whose key hashes to this shard,
+ * and the eviction policy's state for those records.
+ */
+struct immutable_cache_shard
 {
-    immutable_cache_config config;
-    cache_record_map records;
-    cache_record_eviction_list eviction_list;
-    cas_cache cas;
     std::mutex mutex;
+    cache_record_map records;
+    std::unique_ptr<immutable_cache_eviction_shard> evictor;
     int hit_count{0};
     int miss_count{0};
+    // Sum of the compute times of the records at the time of their hits.
+    std::chrono::nanoseconds recompute_cost_saved{0};
+};
+
+/*
+ * The AC is split over a number of shards, each with its own mutex, so that
+ * cache accesses for different keys normally don't contend. Lock order:
+ * AC shard mutex, then CAS shard mutex; at most one of each at any time.
+ */
+struct immutable_cache_impl
+{
+    explicit immutable_cache_impl(immutable_cache_config const& config);
+
+    immutable_cache_config config;
+    std::shared_ptr<immutable_cache_eviction_policy> eviction_policy;
+    std::vector<std::unique_ptr<immutable_cache_shard>> shards;
+    cas_cache cas;
+
+    // Incremented each time a record is handed to an eviction policy.
+    std::atomic<uint64_t> release_counter{0};
+
+    // Serializes eviction runs; must not be acquired while holding a shard
+    // mutex.
+    std::mutex eviction_mutex;
+
+    immutable_cache_shard&
+    shard_for(id_interface const& key)
+    {
+        return *shards[key.hash() % shards.size()];
+    }
 };
 
-// Evict unused entries (in LRU order) until the total size of unused entries
-// in the cache is at most :desired_size (in bytes).
+// Evict unused entries (in the order decided by the cache's eviction policy)
+// until the total size of unused entries in the cache is at most
+// :desired_size (in bytes).
 // The cache doesn't know which entries are in use, so the criterion is instead
 // based on the total size of all unlocked entries (entries that are not
 // referred to by a locked AC record).
+// Should be called while NOT holding any cache mutex.
 void
 reduce_memory_cache_size(immutable_cache_impl& cache, uint64_t desired_size);
 
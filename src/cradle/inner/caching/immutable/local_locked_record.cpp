@@ -10,17 +10,17 @@ local_locked_cache_record::local_locked_cache_record(
     detail::immutable_cache_record& record)
     : record_{record}
 {
-    auto& cache = *record_.owner_cache;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::scoped_lock<std::mutex> lock(record_.owner_shard->mutex);
     detail::add_ref_to_cache_record(record_);
     detail::add_lock_to_cache_record(record_);
 }
 
 local_locked_cache_record::~local_locked_cache_record()
 {
-    auto& cache = *record_.owner_cache;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
-    detail::del_lock_from_cache_record(record_);
+    {
+        std::scoped_lock<std::mutex> lock(record_.owner_shard->mutex);
+        detail::del_lock_from_cache_record(record_);
+    }
     detail::del_ref_from_cache_record(record_);
 }
 
@@ -1,3 +1,5 @@
+#include <chrono>
+
 #include <cradle/inner/caching/immutable/internals.h>
 #include <cradle/inner/caching/immutable/ptr.h>
 
@@ -7,40 +9,52 @@ namespace detail {
 
 // create_task() is called with a ptr that must live until the task has run;
 // the caller has to ensure this.
-immutable_cache_record*
+// ptr_record is set before the shard mutex is released: another thread could
+// start the record's task as soon as that happens.
+void
 acquire_cache_record(
     immutable_cache_impl& cache,
     captured_id const& key,
     untyped_immutable_cache_ptr& ptr,
-    create_task_function_t const& create_task)
+    create_task_function_t const& create_task,
+    immutable_cache_record*& ptr_record)
 {
-    std::scoped_lock<std::mutex> lock(cache.mutex);
-    cache_record_map::iterator i = cache.records.find(&*key);
-    if (i != cache.records.end())
+    auto& shard = cache.shard_for(*key);
+    std::scoped_lock<std::mutex> lock(shard.mutex);
+    cache.eviction_policy->on_access(key->hash());
+    cache_record_map::iterator i = shard.records.find(&*key);
+    if (i != shard.records.end())
     {
-        cache.hit_count += 1;
+        shard.hit_count += 1;
+        auto& record = *i->second;
+        record.hit_count += 1;
+        if (record.state == immutable_cache_entry_state::READY)
+        {
+            shard.recompute_cost_saved += record.compute_time;
+        }
     }
     else
     {
-        cache.miss_count += 1;
+        shard.miss_count += 1;
         auto record = std::make_unique<immutable_cache_record>();
         record->owner_cache = &cache;
-        record->eviction_list_iterator = cache.eviction_list.end();
+        record->owner_shard = &shard;
         record->key = key;
-        record->ref_count = 0;
         record->lock_count = 0;
+        record->compute_start = std::chrono::steady_clock::now();
         record->task = create_task(ptr);
-        i = cache.records.emplace(&*record->key, std::move(record)).first;
+        i = shard.records.emplace(&*record->key, std::move(record)).first;
     }
     immutable_cache_record* record = i->second.get();
     // TODO: Better (optional) retry logic.
     if (record->state == immutable_cache_entry_state::FAILED)
     {
+        record->compute_start = std::chrono::steady_clock::now();
         record->task = create_task(ptr);
         record->state = immutable_cache_entry_state::LOADING;
     }
     add_ref_to_cache_record(*record);
-    return record;
+    ptr_record = record;
 }
 
 } // namespace detail
@@ -49,16 +63,14 @@ untyped_immutable_cache_ptr::untyped_immutable_cache_ptr(
     immutable_cache& cache,
     captured_id const& key,
     create_task_function_t const& create_task)
-    : record_{
-        *detail::acquire_cache_record(*cache.impl, key, *this, create_task)}
 {
+    detail::acquire_cache_record(
+        *cache.impl, key, *this, create_task, record_);
 }
 
 untyped_immutable_cache_ptr::~untyped_immutable_cache_ptr()
 {
-    auto& cache = *record_.owner_cache;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
-    detail::del_ref_from_cache_record(record_);
+    detail::del_ref_from_cache_record(*record_);
 }
 
 void
@@ -66,14 +78,16 @@ untyped_immutable_cache_ptr::record_value_untyped(
     detail::cas_record_base::digest_type const& digest,
     detail::cas_record_maker_intf const& record_maker)
 {
-    auto& cache = *record_.owner_cache;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
-    assert(record_.state == immutable_cache_entry_state::LOADING);
-    record_.state = immutable_cache_entry_state::READY;
-    assert(record_.cas_record == nullptr);
+    auto& cache = *record_->owner_cache;
+    std::scoped_lock<std::mutex> lock(record_->owner_shard->mutex);
+    assert(record_->state == immutable_cache_entry_state::LOADING);
+    record_->state = immutable_cache_entry_state::READY;
+    record_->compute_time
+        = std::chrono::steady_clock::now() - record_->compute_start;
+    assert(record_->cas_record == nullptr);
     auto& cas_record = cache.cas.ensure_record(digest, record_maker);
-    record_.cas_record = &cas_record;
-    if (record_.lock_count > 0)
+    record_->cas_record = &cas_record;
+    if (record_->lock_count > 0)
     {
         cache.cas.add_lock(cas_record);
     }
@@ -82,10 +96,9 @@ untyped_immutable_cache_ptr::record_value_untyped(
 void
 untyped_immutable_cache_ptr::record_failure()
 {
-    auto& cache = *record_.owner_cache;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::scoped_lock<std::mutex> lock(record_->owner_shard->mutex);
     // Alternatively, make state atomic
-    record_.state = immutable_cache_entry_state::FAILED;
+    record_->state = immutable_cache_entry_state::FAILED;
 }
 
 } // namespace cradle
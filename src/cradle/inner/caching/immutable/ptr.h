@@ -60,15 +60,15 @@ class untyped_immutable_cache_ptr
     detail::immutable_cache_record&
     get_record()
     {
-        return record_;
+        return *record_;
     }
 
-    // Should be called while holding the cache's mutex.
+    // Should be called while holding the record's shard mutex.
     // Used by test code only (also the three is_* functions).
     immutable_cache_entry_state
     state() const
     {
-        return record_.state;
+        return record_->state;
     }
     bool
     is_loading() const
@@ -89,21 +89,23 @@ class untyped_immutable_cache_ptr
     id_interface const&
     key() const
     {
-        return *record_.key;
+        return *record_->key;
     }
 
     cppcoro::shared_task<void> const&
     ensure_value_task() const
     {
-        return record_.task;
+        return record_->task;
     }
 
     void
     record_failure();
 
  protected:
-    // the internal cache record for the entry
-    detail::immutable_cache_record& record_;
+    // the internal cache record for the entry; set while holding the
+    // record's shard mutex, so that it is valid before another thread could
+    // run the record's task
+    detail::immutable_cache_record* record_{nullptr};
 
     void
     record_value_untyped(
@@ -135,13 +137,28 @@ class immutable_cache_ptr : public untyped_immutable_cache_ptr
             digest, detail::cas_record_maker(digest, std::move(value)));
     }
 
+    // Returns a copy of the value in the CAS record.
     Value
     get_value() const
     {
-        assert(record_.cas_record != nullptr);
+        return get_cas_record().value();
+    }
+
+    // Returns a shared pointer to the value in the CAS record; no copy of the
+    // value is made.
+    std::shared_ptr<Value const>
+    get_shared_value() const
+    {
+        return get_cas_record().shared_value();
+    }
+
+ private:
+    detail::cas_record<Value> const&
+    get_cas_record() const
+    {
+        assert(record_->cas_record != nullptr);
         using typed_cas_record = detail::cas_record<Value>;
-        return static_cast<typed_cas_record const*>(record_.cas_record)
-            ->value();
+        return *static_cast<typed_cas_record const*>(record_->cas_record);
     }
 };
 
@@ -1,6 +1,7 @@
 #ifndef CRADLE_INNER_CORE_TYPE_DEFINITIONS_H
 #define CRADLE_INNER_CORE_TYPE_DEFINITIONS_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -30,7 +31,7 @@ typedef std::vector<std::uint8_t> byte_vector;
 class data_owner
 {
  public:
-    virtual ~data_owner() = default;
+    virtual ~data_owner();
 
     // Returns a pointer to the data. Throws if not supported.
     virtual std::uint8_t*
@@ -63,6 +64,41 @@ class data_owner
     on_write_completed()
     {
     }
+
+    // Identifies a digest over (a range of) the owned data
+    struct digest_key
+    {
+        void const* data{nullptr};
+        std::size_t size{0};
+        // The unique_hash_scheme the digest was calculated with
+        int scheme{0};
+
+        bool
+        operator==(digest_key const&) const = default;
+    };
+
+    // Returns the digest that was memoized for key, if any.
+    std::optional<byte_vector>
+    find_digest(digest_key const& key) const;
+
+    // Memoizes a digest over the owned data, so that hashing the same data
+    // again does not need to process all bytes. Only the most recent digest
+    // is remembered.
+    // The data must not be modified anymore once a digest has been memoized.
+    // The memo is allocated on first use, so this is intended for large data
+    // only (unique_hasher does it for at least parallel_threshold bytes);
+    // other owners only pay for a null pointer.
+    // unique_hasher memoizes only chunk digests, which its sha256_chunked and
+    // blake3 schemes hash instead of the bytes themselves. The original
+    // sha256 scheme streams all bytes into the enclosing hash, so it has no
+    // digest to reuse and still processes the full data each time.
+    void
+    memoize_digest(digest_key const& key, byte_vector digest) const;
+
+ private:
+    struct digest_memo;
+
+    mutable std::atomic<digest_memo*> digest_memo_{nullptr};
 };
 
 // A blob represents a sequence of bytes. It is intended to be immutable: once
@@ -4,11 +4,59 @@
 #include <cctype>
 #include <cstring>
 #include <iomanip>
+#include <mutex>
 
 #include <boost/functional/hash.hpp>
 
 namespace cradle {
 
+struct data_owner::digest_memo
+{
+    std::mutex mutex;
+    digest_key key;
+    byte_vector digest;
+};
+
+data_owner::~data_owner()
+{
+    delete digest_memo_.load(std::memory_order_acquire);
+}
+
+std::optional<byte_vector>
+data_owner::find_digest(digest_key const& key) const
+{
+    auto* memo = digest_memo_.load(std::memory_order_acquire);
+    if (!memo)
+    {
+        return std::nullopt;
+    }
+    std::scoped_lock lock{memo->mutex};
+    if (!(memo->key == key))
+    {
+        return std::nullopt;
+    }
+    return memo->digest;
+}
+
+void
+data_owner::memoize_digest(digest_key const& key, byte_vector digest) const
+{
+    auto* memo = digest_memo_.load(std::memory_order_acquire);
+    if (!memo)
+    {
+        auto new_memo = std::make_unique<digest_memo>();
+        if (digest_memo_.compare_exchange_strong(
+                memo, new_memo.get(), std::memory_order_acq_rel))
+        {
+            memo = new_memo.release();
+        }
+        // Otherwise, memo now points to the one installed by another thread.
+    }
+    std::scoped_lock lock{memo->mutex};
+    memo->key = key;
+    memo->digest = std::move(digest);
+}
+
 bool
 operator==(blob const& a, blob const& b)
 {
@@ -1,16 +1,288 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include <BS_thread_pool.hpp>
+#include <fmt/format.h>
+
 #include <cradle/inner/core/unique_hash.h>
 
 namespace cradle {
 
+namespace {
+
+std::atomic<unique_hash_scheme> the_unique_hash_scheme{
+    unique_hash_scheme::sha256};
+
+// Protects the_unique_hash_scheme against conflicting claims
+std::mutex scheme_claims_mutex;
+int num_scheme_claims{0};
+
+void
+check_scheme_available(unique_hash_scheme scheme)
+{
+#if !defined(CRADLE_HAVE_BLAKE3)
+    if (scheme == unique_hash_scheme::blake3)
+    {
+        throw std::invalid_argument{
+            "unique hash scheme blake3 requires a build with "
+            "CRADLE_HAVE_BLAKE3"};
+    }
+#endif
+}
+
+} // namespace
+
+unique_hash_scheme
+parse_unique_hash_scheme(std::string const& name)
+{
+    unique_hash_scheme scheme;
+    if (name == "sha256")
+    {
+        scheme = unique_hash_scheme::sha256;
+    }
+    else if (name == "sha256_chunked")
+    {
+        scheme = unique_hash_scheme::sha256_chunked;
+    }
+    else if (name == "blake3")
+    {
+        scheme = unique_hash_scheme::blake3;
+    }
+    else
+    {
+        throw std::invalid_argument{
+            fmt::format("unknown unique hash scheme {}", name)};
+    }
+    check_scheme_available(scheme);
+    return scheme;
+}
+
+void
+set_unique_hash_scheme(unique_hash_scheme scheme)
+{
+    check_scheme_available(scheme);
+    the_unique_hash_scheme.store(scheme);
+}
+
+unique_hash_scheme
+get_unique_hash_scheme()
+{
+    return the_unique_hash_scheme.load(std::memory_order_relaxed);
+}
+
+unique_hash_scheme_claim::unique_hash_scheme_claim(unique_hash_scheme scheme)
+{
+    std::scoped_lock lock{scheme_claims_mutex};
+    auto current{get_unique_hash_scheme()};
+    if (num_scheme_claims > 0 && scheme != current)
+    {
+        throw std::invalid_argument{fmt::format(
+            "unique hash scheme {} conflicts with scheme {} claimed by "
+            "other live resources",
+            static_cast<int>(scheme),
+            static_cast<int>(current))};
+    }
+    set_unique_hash_scheme(scheme);
+    num_scheme_claims += 1;
+}
+
+unique_hash_scheme_claim::~unique_hash_scheme_claim()
+{
+    std::scoped_lock lock{scheme_claims_mutex};
+    num_scheme_claims -= 1;
+}
+
+unique_hasher::unique_hasher(unique_hash_scheme scheme) : scheme_{scheme}
+{
+    check_scheme_available(scheme);
+#if defined(CRADLE_HAVE_BLAKE3)
+    if (scheme == unique_hash_scheme::blake3)
+    {
+        blake3_hasher_init(&blake3_ctx_);
+        return;
+    }
+#endif
+    SHA256_Init(&ctx_);
+}
+
+namespace {
+
+// Hashes chunk ix of a large byte sequence, storing the result at its
+// position in chunk_results
+void
+hash_chunk(
+    unique_hash_scheme scheme,
+    unique_hasher::byte_t const* bytes,
+    size_t len,
+    size_t ix,
+    byte_vector& chunk_results)
+{
+    auto chunk_size{unique_hasher::parallel_chunk_size};
+    auto offset{ix * chunk_size};
+    unique_hasher chunk_hasher{scheme};
+    chunk_hasher.encode_bytes(
+        bytes + offset, std::min(chunk_size, len - offset));
+    auto chunk_result{chunk_hasher.get_result()};
+    std::copy(
+        chunk_result.begin(),
+        chunk_result.end(),
+        chunk_results.begin() + ix * unique_hasher::result_size);
+}
+
+// The threads helping to hash the chunks of large byte sequences; shared by
+// all hashes, so that concurrent hashes don't each start their own threads.
+BS::thread_pool&
+get_chunk_hashing_pool()
+{
+    static BS::thread_pool pool{static_cast<BS::concurrency_t>(
+        std::max(std::thread::hardware_concurrency(), 1u))};
+    return pool;
+}
+
+// Hashing the chunks of a large byte sequence, shared between the thread
+// requesting the hash and its helpers on the pool. A helper that starts only
+// after all chunks have been claimed has nothing to do, so the requesting
+// thread need not wait for it.
+struct chunk_hashing_job
+{
+    unique_hash_scheme scheme;
+    unique_hasher::byte_t const* bytes;
+    size_t len;
+    size_t num_chunks;
+    byte_vector chunk_results;
+    std::atomic<size_t> next_chunk{0};
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t num_done{0};
+
+    // Hashes chunks until all have been claimed.
+    void
+    run()
+    {
+        size_t num_hashed{0};
+        size_t ix;
+        while ((ix = next_chunk++) < num_chunks)
+        {
+            hash_chunk(scheme, bytes, len, ix, chunk_results);
+            ++num_hashed;
+        }
+        if (num_hashed > 0)
+        {
+            std::scoped_lock lock{mutex};
+            num_done += num_hashed;
+            if (num_done == num_chunks)
+            {
+                done_cv.notify_all();
+            }
+        }
+    }
+};
+
+// Returns the concatenated hashes over the chunks of a large byte sequence,
+// calculated by the calling thread, helped by the chunk hashing pool
+byte_vector
+hash_chunks_in_parallel(
+    unique_hash_scheme scheme, unique_hasher::byte_t const* bytes, size_t len)
+{
+    auto chunk_size{unique_hasher::parallel_chunk_size};
+    auto num_chunks{(len + chunk_size - 1) / chunk_size};
+    auto job{std::make_shared<chunk_hashing_job>()};
+    job->scheme = scheme;
+    job->bytes = bytes;
+    job->len = len;
+    job->num_chunks = num_chunks;
+    job->chunk_results.resize(num_chunks * unique_hasher::result_size);
+    auto& pool{get_chunk_hashing_pool()};
+    auto num_helpers{
+        std::min<size_t>(pool.get_thread_count(), num_chunks - 1)};
+    for (size_t i = 0; i < num_helpers; ++i)
+    {
+        pool.detach_task([job] { job->run(); });
+    }
+    job->run();
+    std::unique_lock lock{job->mutex};
+    job->done_cv.wait(lock, [&] { return job->num_done == num_chunks; });
+    return std::move(job->chunk_results);
+}
+
+} // namespace
+
+void
+unique_hasher::encode_large_bytes(
+    void const* data, size_t len, data_owner const* owner)
+{
+    if (!hashes_in_parallel(len))
+    {
+        encode_bytes(data, len);
+        return;
+    }
+    data_owner::digest_key key{data, len, static_cast<int>(scheme_)};
+    std::optional<byte_vector> chunk_results;
+    if (owner)
+    {
+        chunk_results = owner->find_digest(key);
+    }
+    if (!chunk_results)
+    {
+        chunk_results = hash_chunks_in_parallel(
+            scheme_, static_cast<byte_t const*>(data), len);
+        if (owner)
+        {
+            owner->memoize_digest(key, *chunk_results);
+        }
+    }
+    // Equivalent to combine() for each chunk result
+    update_unique_hash(*this, static_cast<uint64_t>(len));
+    encode_bytes(chunk_results->data(), chunk_results->size());
+}
+
+void
+memoize_chunk_hashes(blob const& val, unique_hash_scheme scheme)
+{
+    auto const* owner = val.owner();
+    if (!owner || val.mapped_file_data_owner()
+        || !unique_hasher{scheme}.hashes_in_parallel(val.size()))
+    {
+        return;
+    }
+    data_owner::digest_key key{
+        val.data(), val.size(), static_cast<int>(scheme)};
+    if (!owner->find_digest(key))
+    {
+        owner->memoize_digest(
+            key,
+            hash_chunks_in_parallel(
+                scheme,
+                reinterpret_cast<unique_hasher::byte_t const*>(val.data()),
+                val.size()));
+    }
+}
+
 std::string
 unique_hasher::get_string()
 {
     finish();
 
+    // Schemes other than the original one are identified by a prefix.
+    std::string prefix;
+    if (scheme_ != unique_hash_scheme::sha256)
+    {
+        prefix = fmt::format("v{}-", static_cast<int>(scheme_));
+    }
+
     // This low-level code is much (say, 40x) faster than an implementation
     // based on std::ostringstream or fmt::format.
-    std::string s(result_size * 2, '?');
-    char* p = s.data();
+    std::string s(prefix.size() + result_size * 2, '?');
+    std::copy(prefix.begin(), prefix.end(), s.begin());
+    char* p = s.data() + prefix.size();
     // Clang completely unrolls this loop.
     for (std::size_t i = 0; i < result_size; ++i)
     {
@@ -27,6 +299,14 @@ unique_hasher::finish()
 {
     if (!finished_)
     {
+#if defined(CRADLE_HAVE_BLAKE3)
+        if (scheme_ == unique_hash_scheme::blake3)
+        {
+            blake3_hasher_finalize(&blake3_ctx_, result_.data(), result_size);
+            finished_ = true;
+            return;
+        }
+#endif
         SHA256_Final(result_.data(), &ctx_);
         finished_ = true;
     }
@@ -50,6 +330,8 @@ update_unique_hash(unique_hasher& hasher, blob const& val)
     // A tag byte is used to distinguish between:
     // - A plain blob, where the hash is calculated over the blob data.
     // - A blob file, where the hash is calculated over the file path.
+    // - A large plain blob, where the hash is calculated over the hashes of
+    //   its chunks (not with the original sha256 scheme).
     // Without the tag, a hash over a plain blob containing something that
     // looks like a file path might be equal to the hash over a blob file.
     if (auto const* owner = val.mapped_file_data_owner())
@@ -58,6 +340,11 @@ update_unique_hash(unique_hasher& hasher, blob const& val)
         auto path{owner->mapped_file()};
         hasher.encode_bytes(path.data(), path.size());
     }
+    else if (hasher.hashes_in_parallel(val.size()))
+    {
+        update_unique_hash(hasher, uint8_t{0x02});
+        hasher.encode_large_bytes(val.data(), val.size(), val.owner());
+    }
     else
     {
         update_unique_hash(hasher, uint8_t{0x00});
@@ -10,11 +10,66 @@
 #include <vector>
 
 #include <openssl/sha.h>
+#if defined(CRADLE_HAVE_BLAKE3)
+#include <blake3.h>
+#endif
 
 #include <cradle/inner/core/type_definitions.h>
 
 namespace cradle {
 
+// The scheme (hash function plus encoding) used by unique_hasher.
+// Different schemes lead to different unique strings for the same value, so
+// the scheme must be the same for all processes sharing a disk cache.
+// Unique strings from schemes other than the original one carry a version
+// prefix (e.g. "v2-"), so that entries from different schemes never collide,
+// and entries from an old scheme can be recognized (and dropped) when a
+// cache migrates to a new one.
+enum class unique_hash_scheme
+{
+    // SHA-256 over the encoded byte sequence (the original scheme; strings
+    // have no prefix)
+    sha256 = 1,
+    // As sha256, but large blobs are split in chunks that are hashed in
+    // parallel
+    sha256_chunked = 2,
+    // BLAKE3, with large blobs hashed in parallel chunks; only available if
+    // CRADLE_HAVE_BLAKE3 is defined
+    blake3 = 3,
+};
+
+// Parses a scheme name ("sha256", "sha256_chunked" or "blake3").
+// Throws if the name is unknown, or if the scheme is not available in this
+// build.
+unique_hash_scheme
+parse_unique_hash_scheme(std::string const& name);
+
+// Sets the scheme for all unique_hasher objects created afterwards.
+// Should be called during initialization, before any hash is calculated.
+void
+set_unique_hash_scheme(unique_hash_scheme scheme);
+
+unique_hash_scheme
+get_unique_hash_scheme();
+
+// Sets the (process-wide) scheme on behalf of an owner that was configured
+// with it, typically an inner_resources object, for the owner's lifetime.
+// Throws if another live claim is for a different scheme, as the owners
+// would otherwise silently override each other's setting.
+class unique_hash_scheme_claim
+{
+ public:
+    explicit unique_hash_scheme_claim(unique_hash_scheme scheme);
+
+    ~unique_hash_scheme_claim();
+
+    unique_hash_scheme_claim(unique_hash_scheme_claim const&) = delete;
+
+    unique_hash_scheme_claim&
+    operator=(unique_hash_scheme_claim const&)
+        = delete;
+};
+
 // Creates a cryptographic-strength hash value that should prevent collisions
 // between different items written to the disk cache.
 // The hash function is assumed to be so strong that collisions will not occur
@@ -26,18 +81,58 @@ class unique_hasher
     static constexpr size_t result_size = SHA256_DIGEST_LENGTH;
     using result_t = std::array<unsigned char, result_size>;
 
-    unique_hasher()
+    // Inputs of at least this size are hashed in parallel chunks, if the
+    // scheme supports this
+    static constexpr size_t parallel_threshold = 4 * 1024 * 1024;
+    static constexpr size_t parallel_chunk_size = 1024 * 1024;
+
+    unique_hasher() : unique_hasher{get_unique_hash_scheme()}
     {
-        SHA256_Init(&ctx_);
+    }
+
+    explicit unique_hasher(unique_hash_scheme scheme);
+
+    unique_hash_scheme
+    scheme() const
+    {
+        return scheme_;
     }
 
     void
     encode_bytes(void const* data, size_t len)
     {
         assert(!finished_);
+#if defined(CRADLE_HAVE_BLAKE3)
+        if (scheme_ == unique_hash_scheme::blake3)
+        {
+            blake3_hasher_update(&blake3_ctx_, data, len);
+            return;
+        }
+#endif
         SHA256_Update(&ctx_, data, len);
     }
 
+    // Returns true if encode_large_bytes() would hash len bytes in parallel.
+    bool
+    hashes_in_parallel(size_t len) const
+    {
+        return scheme_ != unique_hash_scheme::sha256
+               && len >= parallel_threshold;
+    }
+
+    // Encodes the hash over a possibly large byte sequence. If
+    // hashes_in_parallel(len), the sequence is split in chunks that are
+    // hashed by the calling thread and a pool of helper threads shared by all
+    // hashers, and the length and the chunk hashes are encoded instead of
+    // the bytes themselves. The caller must ensure that this encoding cannot
+    // be confused with a plain byte sequence.
+    // If owner is not null, it should own the (immutable) data; the chunk
+    // hashes are then memoized in owner, so that encoding the same sequence
+    // again takes O(len / parallel_chunk_size) instead of O(len).
+    void
+    encode_large_bytes(
+        void const* data, size_t len, data_owner const* owner = nullptr);
+
     void
     encode_bytes(byte_t const* begin, byte_t const* end)
     {
@@ -77,11 +172,24 @@ class unique_hasher
     void
     finish();
 
+    unique_hash_scheme scheme_;
     SHA256_CTX ctx_;
+#if defined(CRADLE_HAVE_BLAKE3)
+    blake3_hasher blake3_ctx_;
+#endif
     result_t result_;
     bool finished_{false};
 };
 
+// Calculates the chunk hashes that update_unique_hash() needs for a large
+// blob, and memoizes them in the blob's owner, so that hashing the blob later
+// on (e.g., when recording it in a cache) need not process all its bytes.
+// Does nothing if the blob has no owner, or would not be hashed in chunks
+// with scheme; in particular, with the original sha256 scheme, which always
+// hashes the blob in full.
+void
+memoize_chunk_hashes(blob const& val, unique_hash_scheme scheme);
+
 template<typename T>
     requires std::integral<T> || std::floating_point<T>
 void
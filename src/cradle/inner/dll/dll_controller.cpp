@@ -5,7 +5,9 @@
 #include <cradle/inner/dll/dll_exceptions.h>
 #include <cradle/inner/dll/dll_trash.h>
 #include <cradle/inner/requests/function.h>
+#include <cradle/inner/requests/interning.h>
 #include <cradle/inner/resolve/seri_catalog.h>
+#include <cradle/inner/resolve/seri_registry.h>
 #include <cradle/inner/service/resources.h>
 #include <cradle/inner/utilities/logging.h>
 
@@ -28,6 +30,7 @@ dll_controller::dll_controller(
     std::string const& dir_path,
     std::string const& dll_name)
     : resources_{resources},
+      intern_table_{resources.get_request_intern_table()},
       trash_{trash},
       logger_{logger},
       path_{make_dll_path(dir_path, dll_name)},
@@ -122,6 +125,14 @@ dll_controller::unload()
     {
         logger_.info(
             "unload {} (cat_id {})", name_, catalog_->get_cat_id().value());
+        if (intern_table_)
+        {
+            // Interned requests must not share a function from this DLL with
+            // requests created later on (possibly for a reloaded DLL).
+            auto registry{resources_.get_seri_registry()};
+            intern_table_->purge(
+                registry->get_catalog_uuids(catalog_->get_cat_id()));
+        }
     }
     trash_.add(lib_);
     logger_.info("Now have {} inactive DLLs", trash_.size());
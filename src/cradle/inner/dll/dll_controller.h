@@ -12,6 +12,7 @@ namespace cradle {
 class dll_capabilities;
 class dll_trash;
 class inner_resources;
+class request_intern_table;
 class selfreg_seri_catalog;
 
 // Returns the file path for a DLL.
@@ -61,6 +62,8 @@ class dll_controller
 
  private:
     inner_resources& resources_;
+    // The resources' table, if any; outlives this object
+    request_intern_table* intern_table_;
     dll_trash& trash_;
     spdlog::logger& logger_;
     std::string path_;
@@ -5,6 +5,7 @@
 // For official msgpack versions
 
 #include <cstring>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <type_traits>
@@ -18,6 +19,52 @@
 #include <cradle/inner/encodings/msgpack_packer.h>
 #include <cradle/inner/fs/types.h>
 
+namespace cradle {
+
+// While an object of this class exists, blobs that are converted (on the
+// same thread) from msgpack BIN objects referencing data inside source,
+// share source's owner instead of copying the data.
+// The BIN objects will reference source's data only if it was unpacked with
+// a reference function; see deserialize_value().
+class msgpack_blob_source
+{
+ public:
+    explicit msgpack_blob_source(blob const& source) : prev_{current_}
+    {
+        current_ = &source;
+    }
+
+    ~msgpack_blob_source()
+    {
+        current_ = prev_;
+    }
+
+    msgpack_blob_source(msgpack_blob_source const&) = delete;
+    void
+    operator=(msgpack_blob_source const&)
+        = delete;
+
+    // Returns a blob sharing the current source's owner, if the data is
+    // inside that source; otherwise, returns std::nullopt.
+    static std::optional<blob>
+    adopt(std::byte const* data, std::size_t size)
+    {
+        auto const* source = current_;
+        if (!source || !source->shared_owner() || data < source->data()
+            || data + size > source->data() + source->size())
+        {
+            return std::nullopt;
+        }
+        return blob{source->shared_owner(), data, size};
+    }
+
+ private:
+    blob const* prev_;
+    static inline thread_local blob const* current_{nullptr};
+};
+
+} // namespace cradle
+
 namespace msgpack {
 MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS)
 {
@@ -57,6 +104,12 @@ MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS)
                 throw msgpack::type_error();
             }
             std::size_t size = o.via.bin.size;
+            if (auto adopted = cradle::msgpack_blob_source::adopt(
+                    reinterpret_cast<std::byte const*>(o.via.bin.ptr), size))
+            {
+                v = std::move(*adopted);
+                return o;
+            }
             cradle::byte_vector bv(size);
             if (size != 0)
             {
@@ -35,6 +35,18 @@ serialize_value(Value const& value, bool allow_blob_files)
     return std::move(os).get_blob();
 }
 
+// msgpack unpack_reference_func causing BIN objects of at least
+// min_referenced_bin_size bytes to reference the unpacked buffer.
+// Smaller blobs are copied, so that they don't keep a large buffer alive.
+inline constexpr std::size_t min_referenced_bin_size{4096};
+
+inline bool
+reference_large_bins(
+    msgpack::type::object_type type, std::size_t length, void* /*user_data*/)
+{
+    return type == msgpack::type::BIN && length >= min_referenced_bin_size;
+}
+
 // Deserializes a value from a msgpack-encoded byte sequence
 template<typename Value>
 Value
@@ -46,11 +58,25 @@ deserialize_value(blob const& x)
         return x;
     }
     Value resp;
-    // TODO try to apply the ownership handle trick
-    msgpack::object_handle oh
-        = msgpack::unpack(reinterpret_cast<char const*>(x.data()), x.size());
-    msgpack::object obj = oh.get();
-    obj.convert(resp);
+    if (x.shared_owner())
+    {
+        // Large blobs inside x share x's owner, instead of being copied;
+        // e.g., a result that a contained process wrote to shared memory.
+        msgpack_blob_source source{x};
+        msgpack::object_handle oh = msgpack::unpack(
+            reinterpret_cast<char const*>(x.data()),
+            x.size(),
+            reference_large_bins);
+        msgpack::object obj = oh.get();
+        obj.convert(resp);
+    }
+    else
+    {
+        msgpack::object_handle oh = msgpack::unpack(
+            reinterpret_cast<char const*>(x.data()), x.size());
+        msgpack::object obj = oh.get();
+        obj.convert(resp);
+    }
     return resp;
 }
 
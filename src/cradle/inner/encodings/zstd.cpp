@@ -0,0 +1,49 @@
+#include <cradle/inner/encodings/zstd.h>
+
+#include <zstd.h>
+
+#include <cradle/inner/utilities/errors.h>
+
+namespace cradle {
+
+namespace zstd {
+
+static std::size_t
+check_result(std::size_t result)
+{
+    if (ZSTD_isError(result))
+    {
+        CRADLE_THROW(
+            zstd_error()
+            << internal_error_message_info(ZSTD_getErrorName(result)));
+    }
+    return result;
+}
+
+std::size_t
+max_compressed_size(std::size_t original_size)
+{
+    return ZSTD_compressBound(original_size);
+}
+
+std::size_t
+compress(
+    void* dst,
+    std::size_t dst_size,
+    void const* src,
+    std::size_t src_size,
+    int level)
+{
+    return check_result(ZSTD_compress(dst, dst_size, src, src_size, level));
+}
+
+std::size_t
+decompress(
+    void* dst, std::size_t dst_size, void const* src, std::size_t src_size)
+{
+    return check_result(ZSTD_decompress(dst, dst_size, src, src_size));
+}
+
+} // namespace zstd
+
+} // namespace cradle
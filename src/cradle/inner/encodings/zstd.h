@@ -0,0 +1,44 @@
+#ifndef CRADLE_INNER_ENCODINGS_ZSTD_HPP
+#define CRADLE_INNER_ENCODINGS_ZSTD_HPP
+
+#include <cradle/inner/core/exception.h>
+#include <cradle/inner/fs/types.h>
+
+namespace cradle {
+
+namespace zstd {
+
+// Given the size of a block of data, return the worst-case size of that data
+// when it's compressed with zstd.
+std::size_t
+max_compressed_size(std::size_t original_size);
+
+// Compress a block of data with zstd, at the given compression level;
+// 0 selects zstd's default level.
+// Return the actual size of the compressed data.
+std::size_t
+compress(
+    void* dst,
+    std::size_t dst_size,
+    void const* src,
+    std::size_t src_size,
+    int level = 0);
+
+// Decompress a block of data that's been compressed with zstd.
+// As for lz4::decompress(), the caller is expected to allocate the full
+// block of decompressed data, and pass in its size.
+// Returns the actual size of the decompressed data (<= dst_size);
+std::size_t
+decompress(
+    void* dst, std::size_t dst_size, void const* src, std::size_t src_size);
+
+} // namespace zstd
+
+// This is thrown when zstd reports an error.
+CRADLE_DEFINE_EXCEPTION(zstd_error)
+// This exception provides internal_error_message_info, holding zstd's
+// description of the error.
+
+} // namespace cradle
+
+#endif
@@ -2,9 +2,15 @@
 
 #include <cstring>
 #include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/numeric/conversion/cast.hpp>
+#include <cppcoro/single_consumer_event.hpp>
 #include <curl/curl.h>
 #include <fmt/format.h>
 #include <spdlog/fmt/ostr.h>
@@ -13,6 +19,7 @@
 #include <cradle/inner/core/fmt_format.h>
 #include <cradle/inner/core/monitoring.h>
 #include <cradle/inner/core/type_interfaces.h>
+#include <cradle/inner/core/unique_hash.h>
 #include <cradle/inner/fs/file_io.h>
 #include <cradle/inner/io/http_requests_internal.h>
 #include <cradle/inner/utilities/errors.h>
@@ -155,9 +162,8 @@ struct http_connection_impl
 };
 
 static void
-reset_curl_connection(http_connection_impl& connection)
+reset_curl_handle(CURL* curl)
 {
-    CURL* curl = connection.curl;
     curl_easy_reset(curl);
 
     // Allow requests to be redirected.
@@ -230,45 +236,128 @@ struct receive_transmission_state
     size_t buffer_length = 0;
     size_t write_position = 0;
 
+    // The remaining members are used for receiving a response body only.
+    // The handle performing the transfer, for looking up the Content-Length
+    CURL* curl{nullptr};
+    // Creates the owner receiving a body of known size (may be empty)
+    http_body_owner_factory const* owner_factory{nullptr};
+    // If set, the body is received into owner_data, instead of into buffer
+    std::shared_ptr<data_owner> owner;
+    std::uint8_t* owner_data{nullptr};
+
     receive_transmission_state() : buffer(nullptr, free)
     {
     }
+
+    char*
+    data()
+    {
+        return owner ? reinterpret_cast<char*>(owner_data) : buffer.get();
+    }
 };
 
+// Allocates the space for receiving a response body (or headers), based on
+// the Content-Length if it is known.
+static bool
+start_receiving(receive_transmission_state& state)
+{
+    curl_off_t content_length{-1};
+    long status_code{};
+    if (state.curl)
+    {
+        curl_easy_getinfo(
+            state.curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+        curl_easy_getinfo(state.curl, CURLINFO_RESPONSE_CODE, &status_code);
+    }
+    state.write_position = 0;
+    if (content_length <= 0)
+    {
+        state.buffer_length = 4096;
+    }
+    else
+    {
+        // With a Content-Encoding, this is the size of the encoded body; the
+        // decoded body may turn out to be larger.
+        state.buffer_length = static_cast<size_t>(content_length);
+        if (state.owner_factory && *state.owner_factory && status_code >= 200
+            && status_code <= 299)
+        {
+            state.owner = (*state.owner_factory)(state.buffer_length);
+            state.owner_data = state.owner->data();
+            return true;
+        }
+    }
+    char* allocation = reinterpret_cast<char*>(malloc(state.buffer_length));
+    if (!allocation)
+        return false;
+    state.buffer = malloc_buffer_ptr(allocation, free);
+    return true;
+}
+
+// Makes room for at least new_length bytes.
+static bool
+grow_receive_buffer(receive_transmission_state& state, size_t new_length)
+{
+    // Each time the buffer grows, it doubles in size.
+    // This wastes some memory but should be faster in general.
+    size_t new_size = state.buffer_length * 2;
+    while (new_size < new_length)
+        new_size *= 2;
+    if (state.owner)
+    {
+        // The owner's size is fixed; continue in a memory buffer.
+        char* allocation = reinterpret_cast<char*>(malloc(new_size));
+        if (!allocation)
+            return false;
+        std::memcpy(allocation, state.owner_data, state.write_position);
+        state.buffer = malloc_buffer_ptr(allocation, free);
+        // Nothing else refers to a file that the factory created for the
+        // owner, so remove it (once it is unmapped).
+        std::optional<std::string> mapped_file;
+        if (state.owner->maps_file())
+        {
+            mapped_file = state.owner->mapped_file();
+        }
+        state.owner.reset();
+        state.owner_data = nullptr;
+        if (mapped_file)
+        {
+            std::error_code ec;
+            std::filesystem::remove(*mapped_file, ec);
+        }
+    }
+    else
+    {
+        char* allocation = reinterpret_cast<char*>(
+            realloc(state.buffer.release(), new_size));
+        if (!allocation)
+            return false;
+        state.buffer = malloc_buffer_ptr(allocation, free);
+    }
+    state.buffer_length = new_size;
+    return true;
+}
+
 static size_t
 record_http_response(void* ptr, size_t size, size_t nmemb, void* userdata)
 {
     receive_transmission_state& state
         = *reinterpret_cast<receive_transmission_state*>(userdata);
-    if (!state.buffer)
+    if (!state.buffer && !state.owner)
     {
-        char* allocation = reinterpret_cast<char*>(malloc(4096));
-        if (!allocation)
+        if (!start_receiving(state))
             return 0;
-        state.buffer = malloc_buffer_ptr(allocation, free);
-        state.buffer_length = 4096;
-        state.write_position = 0;
     }
 
     // Grow the buffer if necessary.
     size_t n_bytes = size * nmemb;
     if (state.buffer_length < (state.write_position + n_bytes))
     {
-        // Each time the buffer grows, it doubles in size.
-        // This wastes some memory but should be faster in general.
-        size_t new_size = state.buffer_length * 2;
-        while (new_size < state.buffer_length + n_bytes)
-            new_size *= 2;
-        char* allocation = reinterpret_cast<char*>(
-            realloc(state.buffer.release(), new_size));
-        if (!allocation)
+        if (!grow_receive_buffer(state, state.write_position + n_bytes))
             return 0;
-        state.buffer = malloc_buffer_ptr(allocation, free);
-        state.buffer_length = new_size;
     }
 
-    assert(state.buffer);
-    std::memcpy(state.buffer.get() + state.write_position, ptr, n_bytes);
+    std::memcpy(state.data() + state.write_position, ptr, n_bytes);
     state.write_position += n_bytes;
     return n_bytes;
 }
@@ -327,13 +416,28 @@ struct scoped_curl_slist
 static blob
 make_blob(receive_transmission_state&& transmission)
 {
-    auto data{as_bytes(transmission.buffer.get())};
+    auto data{as_bytes(transmission.data())};
     size_t size{transmission.write_position};
-    return blob{
-        std::make_shared<malloc_buffer_ptr_wrapper>(
-            std::move(transmission.buffer)),
-        data,
-        size};
+    std::shared_ptr<data_owner> owner;
+    if (transmission.owner)
+    {
+        owner = std::move(transmission.owner);
+        owner->on_write_completed();
+    }
+    else
+    {
+        owner = std::make_shared<malloc_buffer_ptr_wrapper>(
+            std::move(transmission.buffer));
+    }
+    blob result{std::move(owner), data, size};
+    if (transmission.owner_factory && *transmission.owner_factory)
+    {
+        // The body is likely to be cached, which means hashing it. For a
+        // large body, hash its chunks in parallel here, rather than in the
+        // callbacks on the thread driving the transfers.
+        memoize_chunk_hashes(result, get_unique_hash_scheme());
+    }
+    return result;
 }
 
 http_request
@@ -345,32 +449,29 @@ redact_request(http_request request)
     return request;
 }
 
-http_response
-http_connection::perform_request(
-    check_in_interface& check_in,
-    progress_reporter_interface& reporter,
-    http_request const& request)
+// The state of a single request / response exchange performed by curl
+struct curl_transfer
 {
-    auto logger = spdlog::get("cradle");
-    logger->info("HTTP perform_request");
-    logger->debug("<<< query");
-    logger->debug("{}", redact_request(request));
-    logger->debug(">>> query");
-
-    CURL* curl = impl_->curl;
-    assert(curl);
-    reset_curl_connection(*impl_);
+    scoped_curl_slist headers{nullptr};
+    send_transmission_state send_state;
+    receive_transmission_state body_receive_state;
+    receive_transmission_state header_receive_state;
+};
 
+// Sets the options on curl for performing request; transfer receives the
+// response.
+static void
+set_up_transfer(
+    CURL* curl, curl_transfer& transfer, http_request const& request)
+{
     // Set the headers for the request.
-    scoped_curl_slist curl_headers;
-    curl_headers.list = NULL;
     for (auto const& header : request.headers)
     {
         auto header_string = header.first + ":" + header.second;
-        curl_headers.list
-            = curl_slist_append(curl_headers.list, header_string.c_str());
+        transfer.headers.list
+            = curl_slist_append(transfer.headers.list, header_string.c_str());
     }
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curl_headers.list);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.headers.list);
 
     curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
     if (request.socket)
@@ -380,18 +481,19 @@ http_connection::perform_request(
     }
 
     // Set up for receiving the response body.
-    receive_transmission_state body_receive_state;
+    transfer.body_receive_state.curl = curl;
+    transfer.body_receive_state.owner_factory = &request.body_owner_factory;
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, record_http_response);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body_receive_state);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer.body_receive_state);
 
     // Set up for receiving the response headers.
-    receive_transmission_state header_receive_state;
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, record_http_response);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &header_receive_state);
+    curl_easy_setopt(
+        curl, CURLOPT_HEADERDATA, &transfer.header_receive_state);
 
     // Let CURL know what the method is and set up for sending the body if
     // necessary.
-    send_transmission_state send_state;
+    auto& send_state = transfer.send_state;
     switch (request.method)
     {
         case http_request_method::PUT:
@@ -428,23 +530,17 @@ http_connection::perform_request(
             // This is the default method for Curl.
             break;
     }
+}
 
-    // Set up progress monitoring.
-    curl_progress_data progress_data;
-    progress_data.check_in = &check_in;
-    progress_data.reporter = &reporter;
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0);
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, curl_xfer_callback);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress_data);
-
-    // Perform the request.
-    CURLcode result = curl_easy_perform(curl);
-
-    // Check in again here because if the job was canceled inside the above
-    // call, it will just look like an error. We need the cancellation
-    // exception to be rethrown.
-    check_in();
-
+// Constructs the response for a transfer that curl finished with result.
+// Throws if the transfer failed, or if the status code indicates an error.
+static http_response
+finish_transfer(
+    http_request const& request,
+    curl_transfer& transfer,
+    CURLcode result,
+    long status_code)
+{
     // Check for low-level CURL errors.
     if (result != CURLE_OK)
     {
@@ -455,11 +551,12 @@ http_connection::perform_request(
     }
 
     // Parse the response headers.
+    auto& header_receive_state = transfer.header_receive_state;
     http_header_list response_headers;
     {
         std::istringstream response_header_text(std::string(
             header_receive_state.buffer.get(),
-            header_receive_state.buffer_length));
+            header_receive_state.write_position));
         std::string header_line;
         while (std::getline(response_header_text, header_line)
                && header_line != "\r")
@@ -477,10 +574,8 @@ http_connection::perform_request(
 
     // Construct the response.
     http_response response;
-    response.body = make_blob(std::move(body_receive_state));
+    response.body = make_blob(std::move(transfer.body_receive_state));
     response.headers = std::move(response_headers);
-    long status_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
     response.status_code = boost::numeric_cast<int>(status_code);
 
     // Check the status code.
@@ -492,6 +587,48 @@ http_connection::perform_request(
             << http_response_info(response));
     }
 
+    return response;
+}
+
+http_response
+http_connection::perform_request(
+    check_in_interface& check_in,
+    progress_reporter_interface& reporter,
+    http_request const& request)
+{
+    auto logger = spdlog::get("cradle");
+    logger->info("HTTP perform_request");
+    logger->debug("<<< query");
+    logger->debug("{}", redact_request(request));
+    logger->debug(">>> query");
+
+    CURL* curl = impl_->curl;
+    assert(curl);
+    reset_curl_handle(curl);
+
+    curl_transfer transfer;
+    set_up_transfer(curl, transfer, request);
+
+    // Set up progress monitoring.
+    curl_progress_data progress_data;
+    progress_data.check_in = &check_in;
+    progress_data.reporter = &reporter;
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, curl_xfer_callback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress_data);
+
+    // Perform the request.
+    CURLcode result = curl_easy_perform(curl);
+
+    // Check in again here because if the job was canceled inside the above
+    // call, it will just look like an error. We need the cancellation
+    // exception to be rethrown.
+    check_in();
+
+    long status_code{};
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
+    auto response = finish_transfer(request, transfer, result, status_code);
+
     logger->debug("<<< response");
     logger->debug("{}", response);
     logger->debug(">>> response");
@@ -499,4 +636,280 @@ http_connection::perform_request(
     return response;
 }
 
+// ASYNC HTTP ENGINE
+
+// A request being performed by an async_http_engine. The object lives in the
+// frame of the perform_request() coroutine; the engine's thread accesses it
+// until it sets done.
+struct async_http_transfer
+{
+    http_request request;
+    curl_transfer state;
+    CURLcode result{CURLE_OK};
+    long status_code{};
+    // Set if the engine was destroyed before the transfer finished
+    bool aborted{false};
+    cppcoro::single_consumer_event done;
+};
+
+struct async_http_engine_impl
+{
+    async_http_engine_impl(
+        async_http_engine_config const& config,
+        work_stealing_pool& completion_pool)
+        : config{config}, completion_pool{completion_pool}
+    {
+    }
+
+    async_http_engine_config config;
+    work_stealing_pool& completion_pool;
+    CURLM* multi{nullptr};
+
+    // Transfers submitted by perform_request(), not yet seen by the engine's
+    // thread; protected by mutex
+    std::vector<async_http_transfer*> submitted;
+    // Set when the engine is being destroyed; protected by mutex
+    bool stopping{false};
+    std::mutex mutex;
+
+    // Accessed by the engine's thread only:
+    // the easy handles of the transfers in progress
+    std::unordered_set<CURL*> active_handles;
+    // easy handles that can be reused for new transfers
+    std::vector<CURL*> idle_handles;
+
+    std::thread thread;
+};
+
+static void
+start_async_transfer(
+    async_http_engine_impl& impl, async_http_transfer& transfer)
+{
+    CURL* curl{};
+    if (!impl.idle_handles.empty())
+    {
+        curl = impl.idle_handles.back();
+        impl.idle_handles.pop_back();
+    }
+    else
+    {
+        curl = curl_easy_init();
+        if (!curl)
+        {
+            transfer.result = CURLE_FAILED_INIT;
+            transfer.done.set();
+            return;
+        }
+    }
+    reset_curl_handle(curl);
+    // Wait for a connection that can multiplex this request, rather than
+    // opening a new one.
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(
+        curl,
+        CURLOPT_HTTP_VERSION,
+        impl.config.http2_prior_knowledge
+            ? CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE
+            : CURL_HTTP_VERSION_2TLS);
+    set_up_transfer(curl, transfer.state, transfer.request);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, &transfer);
+    curl_multi_add_handle(impl.multi, curl);
+    impl.active_handles.insert(curl);
+}
+
+// Keeps curl for reuse, so that a new transfer doesn't need to set up an
+// easy handle. (Connections belong to the multi handle, so they are reused
+// anyway.)
+static void
+release_easy_handle(async_http_engine_impl& impl, CURL* curl)
+{
+    curl_multi_remove_handle(impl.multi, curl);
+    impl.active_handles.erase(curl);
+    if (impl.idle_handles.size() < impl.config.max_idle_handles)
+    {
+        impl.idle_handles.push_back(curl);
+    }
+    else
+    {
+        curl_easy_cleanup(curl);
+    }
+}
+
+static void
+finish_async_transfers(async_http_engine_impl& impl)
+{
+    CURLMsg* msg{};
+    int num_msgs_left{};
+    while ((msg = curl_multi_info_read(impl.multi, &num_msgs_left)))
+    {
+        if (msg->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        char* private_data{};
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, &private_data);
+        auto& transfer = *reinterpret_cast<async_http_transfer*>(private_data);
+        transfer.result = result;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &transfer.status_code);
+        release_easy_handle(impl, curl);
+        // The transfer object may be gone once this returns.
+        transfer.done.set();
+    }
+}
+
+static void
+abort_async_transfers(
+    async_http_engine_impl& impl,
+    std::vector<async_http_transfer*> const& submitted)
+{
+    for (auto* transfer : submitted)
+    {
+        transfer->result = CURLE_ABORTED_BY_CALLBACK;
+        transfer->aborted = true;
+        transfer->done.set();
+    }
+    auto active_handles = impl.active_handles;
+    for (CURL* curl : active_handles)
+    {
+        char* private_data{};
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, &private_data);
+        auto& transfer = *reinterpret_cast<async_http_transfer*>(private_data);
+        release_easy_handle(impl, curl);
+        transfer.result = CURLE_ABORTED_BY_CALLBACK;
+        transfer.aborted = true;
+        transfer.done.set();
+    }
+}
+
+// The engine's thread: starts submitted transfers, drives all transfers
+// using curl's multi interface, and signals the ones that have finished.
+static void
+run_async_http_engine(async_http_engine_impl& impl)
+{
+    std::vector<async_http_transfer*> submitted;
+    while (true)
+    {
+        {
+            std::scoped_lock<std::mutex> lock(impl.mutex);
+            submitted.swap(impl.submitted);
+            if (impl.stopping)
+            {
+                break;
+            }
+        }
+        for (auto* transfer : submitted)
+        {
+            start_async_transfer(impl, *transfer);
+        }
+        submitted.clear();
+        int num_running{};
+        curl_multi_perform(impl.multi, &num_running);
+        finish_async_transfers(impl);
+        // perform_request() and the destructor wake this up.
+        curl_multi_poll(impl.multi, nullptr, 0, 1000, nullptr);
+    }
+    abort_async_transfers(impl, submitted);
+}
+
+async_http_engine::async_http_engine(
+    http_request_system&,
+    async_http_engine_config const& config,
+    work_stealing_pool& completion_pool)
+    : impl_{std::make_unique<async_http_engine_impl>(config, completion_pool)}
+{
+    auto& impl{*impl_};
+    impl.multi = curl_multi_init();
+    if (!impl.multi)
+    {
+        CRADLE_THROW(http_request_system_error());
+    }
+    curl_multi_setopt(impl.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(
+        impl.multi,
+        CURLMOPT_MAX_HOST_CONNECTIONS,
+        static_cast<long>(config.max_host_connections));
+    curl_multi_setopt(
+        impl.multi,
+        CURLMOPT_MAX_TOTAL_CONNECTIONS,
+        static_cast<long>(config.max_total_connections));
+    curl_multi_setopt(
+        impl.multi,
+        CURLMOPT_MAXCONNECTS,
+        static_cast<long>(config.max_idle_connections));
+    impl.thread = std::thread{run_async_http_engine, std::ref(impl)};
+}
+
+async_http_engine::~async_http_engine()
+{
+    auto& impl{*impl_};
+    {
+        std::scoped_lock<std::mutex> lock(impl.mutex);
+        impl.stopping = true;
+    }
+    curl_multi_wakeup(impl.multi);
+    impl.thread.join();
+    for (CURL* curl : impl.idle_handles)
+    {
+        curl_easy_cleanup(curl);
+    }
+    curl_multi_cleanup(impl.multi);
+}
+
+cppcoro::task<http_response>
+async_http_engine::perform_request(http_request request, schedule_hint hint)
+{
+    auto& impl{*impl_};
+    auto logger = spdlog::get("cradle");
+    logger->info("HTTP async perform_request");
+    logger->debug("<<< query");
+    logger->debug("{}", redact_request(request));
+    logger->debug(">>> query");
+
+    async_http_transfer transfer;
+    transfer.request = std::move(request);
+    {
+        std::scoped_lock<std::mutex> lock(impl.mutex);
+        if (impl.stopping)
+        {
+            CRADLE_THROW(
+                http_request_failure()
+                << attempted_http_request_info(
+                       redact_request(transfer.request))
+                << internal_error_message_info("HTTP engine is stopping"));
+        }
+        impl.submitted.push_back(&transfer);
+    }
+    curl_multi_wakeup(impl.multi);
+
+    auto& completion_pool{impl.completion_pool};
+    co_await transfer.done;
+    if (transfer.aborted)
+    {
+        // The engine is being destroyed, and completion_pool probably will
+        // be soon, so fail right here, on the engine's thread, rather than
+        // rescheduling on a pool that may never resume this coroutine.
+        // (impl may be gone by now.)
+        CRADLE_THROW(
+            http_request_failure()
+            << attempted_http_request_info(redact_request(transfer.request))
+            << internal_error_message_info("HTTP engine was stopped"));
+    }
+    // Don't hold up the engine's thread.
+    co_await completion_pool.schedule(hint);
+
+    auto response = finish_transfer(
+        transfer.request,
+        transfer.state,
+        transfer.result,
+        transfer.status_code);
+
+    logger->debug("<<< response");
+    logger->debug("{}", response);
+    logger->debug(">>> response");
+
+    co_return response;
+}
+
 } // namespace cradle
@@ -1,16 +1,19 @@
 #ifndef CRADLE_INNER_IO_HTTP_REQUESTS_H
 #define CRADLE_INNER_IO_HTTP_REQUESTS_H
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <optional>
 #include <string>
 
+#include <cppcoro/task.hpp>
 #include <fmt/ostream.h>
 
 #include <cradle/inner/core/type_definitions.h>
 #include <cradle/inner/fs/types.h>
+#include <cradle/inner/service/work_stealing_pool.h>
 
 // This file defines a low-level facility for doing authenticated HTTP
 // requests.
@@ -47,6 +50,11 @@ get_value_id(http_request_method value);
 std::ostream&
 operator<<(std::ostream& s, http_request_method const& x);
 
+// Creates the data owner that will receive a response body of the given size;
+// e.g., local_context_intf::make_data_owner().
+typedef std::function<std::shared_ptr<data_owner>(std::size_t size)>
+    http_body_owner_factory;
+
 struct http_request
 {
     http_request_method method;
@@ -54,6 +62,16 @@ struct http_request
     http_header_list headers;
     blob body;
     std::optional<std::string> socket;
+    // If set, and the response specifies its Content-Length, the response
+    // body is received directly into a data owner created by this function
+    // (e.g., a blob file), instead of into a memory buffer. The owner's
+    // data() must be writable. If the body turns out larger than announced,
+    // the owner is dropped (removing the file it maps, if any), and the
+    // body continues in a memory buffer. Either way, the chunk hashes of a
+    // large body are memoized (see memoize_chunk_hashes()).
+    // This does not affect the request itself, so it is ignored when
+    // comparing or printing requests.
+    http_body_owner_factory body_owner_factory{};
 };
 
 bool
@@ -191,6 +209,61 @@ struct http_connection : http_connection_interface
     std::unique_ptr<http_connection_impl> impl_;
 };
 
+struct async_http_engine_config
+{
+    // Maximum number of connections to a single host; further requests to
+    // the host are multiplexed over these (HTTP/2), or wait for one to
+    // become available (HTTP/1.1)
+    std::size_t max_host_connections{32};
+    // Maximum number of connections in total (0: no limit)
+    std::size_t max_total_connections{0};
+    // Maximum number of connections kept open for reuse
+    std::size_t max_idle_connections{64};
+    // Maximum number of curl handles kept for reuse
+    std::size_t max_idle_handles{64};
+    // If true, http:// URLs are requested over HTTP/2 without negotiation
+    // ("h2c with prior knowledge"); only set this if all servers support it.
+    // https:// URLs negotiate HTTP/2 anyway.
+    bool http2_prior_knowledge{false};
+};
+
+struct async_http_engine_impl;
+
+// async_http_engine performs any number of HTTP requests concurrently, on a
+// single thread, using persistent connections: requests to the same host
+// reuse the connections of earlier requests, and are multiplexed over them
+// when the server speaks HTTP/2.
+//
+// Unlike http_connection, it doesn't need a thread per in-flight request.
+// Responses are processed on completion_pool, which must outlive the engine;
+// in the order given by their requests' schedule hints.
+// Requests still in flight when the engine is destroyed fail with
+// http_request_failure; their coroutines are resumed on the engine's thread,
+// during the destructor, not on completion_pool.
+class async_http_engine
+{
+ public:
+    async_http_engine(
+        http_request_system& system,
+        async_http_engine_config const& config,
+        work_stealing_pool& completion_pool);
+    ~async_http_engine();
+
+    async_http_engine(async_http_engine const&) = delete;
+    async_http_engine&
+    operator=(async_http_engine const&)
+        = delete;
+
+    // Performs an HTTP request and returns the response; see
+    // http_connection_interface::perform_request().
+    // hint determines when the response is processed on completion_pool.
+    cppcoro::task<http_response>
+    perform_request(http_request request, schedule_hint hint = {});
+
+ private:
+    std::unique_ptr<async_http_engine_impl> impl_;
+};
+
 } // namespace cradle
 
 template<>
@@ -6,22 +6,56 @@
 #include <cradle/inner/remote/async_db.h>
 #include <cradle/inner/remote/async_exceptions.h>
 #include <cradle/inner/requests/cast_ctx.h>
+#include <cradle/inner/requests/context_base.h>
 
 namespace cradle {
 
 void
 async_db::add(std::shared_ptr<local_async_context_intf> ctx)
 {
-    std::scoped_lock lock{mutex_};
     auto aid = ctx->get_id();
-    entries_.emplace(aid, std::move(ctx));
+    // A context without a tree context forms a tree by itself.
+    void const* tree_key = ctx.get();
+    if (auto* base = dynamic_cast<local_async_context_base*>(ctx.get()))
+    {
+        tree_key = &base->get_tree_context();
+    }
+    // The tree shard stays locked until the entry has been inserted, so that
+    // remove_tree() either sees the new member, or has already erased the
+    // tree record.
+    auto& tree_shard{tree_shard_for(tree_key)};
+    std::scoped_lock tree_lock{tree_shard.mutex};
+    auto it = tree_shard.trees.find(tree_key);
+    if (it == tree_shard.trees.end())
+    {
+        // A root context (which is added before its sub contexts) starts a
+        // new tree. Any other context belongs to a tree that was removed
+        // (e.g., after cancellation) and must not be added: nothing would
+        // erase it anymore.
+        if (tree_key != ctx.get()
+            && !dynamic_cast<root_local_async_context_intf*>(ctx.get()))
+        {
+            auto logger = spdlog::get("cradle");
+            logger->debug("async_db::add({}) ignored: tree was removed", aid);
+            return;
+        }
+        auto new_tree{std::make_shared<tree>()};
+        it = tree_shard.trees.emplace(tree_key, std::move(new_tree)).first;
+    }
+    auto owner{it->second};
+    {
+        std::scoped_lock lock{owner->mutex};
+        owner->members.push_back(aid);
+    }
+    auto& shard{entry_shard_for(aid)};
+    std::unique_lock lock{shard.mutex};
+    shard.entries.emplace(aid, entry{std::move(ctx), std::move(owner)});
 }
 
 std::shared_ptr<local_async_context_intf>
 async_db::find(async_id aid)
 {
-    std::scoped_lock lock{mutex_};
-    return find_no_lock(aid);
+    return find_entry(aid).ctx;
 }
 
 std::shared_ptr<root_local_async_context_intf>
@@ -36,43 +70,70 @@ async_db::find_root(async_id aid)
     return ctx;
 }
 
-std::shared_ptr<local_async_context_intf>
-async_db::find_no_lock(async_id aid)
-{
-    auto it = entries_.find(aid);
-    if (it == entries_.end())
-    {
-        throw bad_async_id_error{fmt::format("unknown async_id {}", aid)};
-    }
-    return it->second;
-}
-
-// Traverses the tree, recursively removing a node's children, then the node
-// itself; the root node is removed last.
+// Detaches the tree, so that none of its contexts can be found anymore, then
+// erases their entries.
 void
 async_db::remove_tree(async_id root_aid)
 {
-    std::scoped_lock lock{mutex_};
-    auto size_before = entries_.size();
-    remove_subtree(*find_no_lock(root_aid));
-    auto size_after = entries_.size();
+    auto root{find_entry(root_aid)};
+    auto& owner{*root.owner};
+    if (owner.detached.exchange(true))
+    {
+        // Concurrent remove_tree() call for the same tree
+        return;
+    }
+    void const* tree_key = root.ctx.get();
+    if (auto* base = dynamic_cast<local_async_context_base*>(root.ctx.get()))
+    {
+        tree_key = &base->get_tree_context();
+    }
+    {
+        // Any add() to this tree has completed or will not find it anymore
+        auto& shard{tree_shard_for(tree_key)};
+        std::scoped_lock lock{shard.mutex};
+        shard.trees.erase(tree_key);
+    }
+    std::vector<async_id> members;
+    {
+        std::scoped_lock lock{owner.mutex};
+        members.swap(owner.members);
+    }
+    for (auto aid : members)
+    {
+        auto& shard{entry_shard_for(aid)};
+        std::unique_lock lock{shard.mutex};
+        shard.entries.erase(aid);
+    }
     auto logger = spdlog::get("cradle");
     logger->debug(
-        "async_db::remove_tree({}) removed {} entries, {} remaining",
+        "async_db::remove_tree({}) removed {} entries",
         root_aid,
-        size_before - size_after,
-        size_after);
+        members.size());
 }
 
-void
-async_db::remove_subtree(local_async_context_intf& node_ctx)
+std::size_t
+async_db::size() const
+{
+    std::size_t result{};
+    for (auto const& shard : entry_shards_)
+    {
+        std::shared_lock lock{shard.mutex};
+        result += shard.entries.size();
+    }
+    return result;
+}
+
+async_db::entry
+async_db::find_entry(async_id aid)
 {
-    auto nsubs = node_ctx.get_local_num_subs();
-    for (decltype(nsubs) i = 0; i < nsubs; ++i)
+    auto& shard{entry_shard_for(aid)};
+    std::shared_lock lock{shard.mutex};
+    auto it = shard.entries.find(aid);
+    if (it == shard.entries.end() || it->second.owner->detached)
     {
-        remove_subtree(node_ctx.get_local_sub(i));
+        throw bad_async_id_error{fmt::format("unknown async_id {}", aid)};
     }
-    entries_.erase(node_ctx.get_id());
+    return it->second;
 }
 
 } // namespace cradle
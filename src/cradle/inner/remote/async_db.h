@@ -1,9 +1,15 @@
 #ifndef CRADLE_INNER_REMOTE_ASYNC_DB_H
 #define CRADLE_INNER_REMOTE_ASYNC_DB_H
 
-#include <map>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <cradle/inner/requests/generic.h>
 
@@ -15,10 +21,19 @@ namespace cradle {
 // context objects.
 // Apart from the (implicit) default ctor and dtor, all functions are
 // thread-safe.
+//
+// The entries are spread over a fixed number of shards, each with its own
+// reader/writer lock, so that lookups (e.g., from clients polling the status
+// of contexts in large trees) don't contend with each other, and hardly with
+// additions.
+// Each context belongs to the tree formed by its root context. A whole tree
+// is detached by a single flag update, after which its contexts can no longer
+// be found; the entries are then erased one shard at a time.
 class async_db
 {
  public:
     // Adds a context object to the database.
+    // A non-root context whose tree was already removed is not added.
     void
     add(std::shared_ptr<local_async_context_intf> ctx);
 
@@ -41,15 +56,57 @@ class async_db
     void
     remove_tree(async_id root_id);
 
+    // Returns the number of context objects in the database.
+    std::size_t
+    size() const;
+
  private:
-    std::mutex mutex_;
-    std::map<async_id, std::shared_ptr<local_async_context_intf>> entries_;
+    // The contexts in a tree
+    struct tree
+    {
+        std::atomic<bool> detached{false};
+        std::mutex mutex;
+        std::vector<async_id> members;
+    };
 
-    std::shared_ptr<local_async_context_intf>
-    find_no_lock(async_id aid);
+    struct entry
+    {
+        std::shared_ptr<local_async_context_intf> ctx;
+        std::shared_ptr<tree> owner;
+    };
 
-    void
-    remove_subtree(local_async_context_intf& node_ctx);
+    static constexpr std::size_t num_shards_{64};
+
+    struct entry_shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<async_id, entry> entries;
+    };
+
+    // Trees are identified by their local_tree_context_base object
+    struct tree_shard
+    {
+        std::mutex mutex;
+        std::unordered_map<void const*, std::shared_ptr<tree>> trees;
+    };
+
+    std::array<entry_shard, num_shards_> entry_shards_;
+    std::array<tree_shard, num_shards_> tree_shards_;
+
+    entry_shard&
+    entry_shard_for(async_id aid)
+    {
+        return entry_shards_[aid % num_shards_];
+    }
+
+    tree_shard&
+    tree_shard_for(void const* tree_key)
+    {
+        return tree_shards_[std::hash<void const*>{}(tree_key) % num_shards_];
+    }
+
+    entry
+    find_entry(async_id aid);
 };
 
 } // namespace cradle
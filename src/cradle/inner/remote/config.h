@@ -21,6 +21,16 @@ struct remote_config_keys
     // be locked on behalf of the caller, until the caller releases the lock.
     inline static std::string const NEED_RECORD_LOCK{
         "remote/need_record_lock"};
+
+    // (Optional string)
+    // Scheduling priority for resolving the request (schedule_hint::priority,
+    // as a decimal integer; cf. request_priority)
+    inline static std::string const PRIORITY{"remote/priority"};
+
+    // (Optional number)
+    // Milliseconds until the deadline for resolving the request
+    // (schedule_hint::deadline)
+    inline static std::string const DEADLINE_MS{"remote/deadline_ms"};
 };
 
 } // namespace cradle
@@ -44,6 +44,12 @@ loopback_service::get_logger()
     return *logger_;
 }
 
+request_format
+loopback_service::get_request_format() const
+{
+    return request_format::msgpack;
+}
+
 void
 loopback_service::store_request(
     std::string storage_name, std::string key, std::string seri_req)
@@ -250,6 +256,19 @@ loopback_service::get_async_status(async_id aid)
     return status;
 }
 
+async_status
+loopback_service::wait_async_status(
+    async_id aid,
+    async_status known_status,
+    std::chrono::milliseconds timeout)
+{
+    logger_->debug("wait_async_status {} {}", aid, known_status);
+    auto actx{get_async_db().find(aid)};
+    auto status = actx->wait_status_change(known_status, timeout);
+    logger_->debug("wait_async_status -> {}", status);
+    return status;
+}
+
 std::string
 loopback_service::get_async_error_message(async_id aid)
 {
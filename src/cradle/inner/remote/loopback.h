@@ -38,6 +38,9 @@ class loopback_service : public remote_proxy
     spdlog::logger&
     get_logger() override;
 
+    request_format
+    get_request_format() const override;
+
     void
     store_request(
         std::string storage_name,
@@ -62,6 +65,12 @@ class loopback_service : public remote_proxy
     async_status
     get_async_status(async_id aid) override;
 
+    async_status
+    wait_async_status(
+        async_id aid,
+        async_status known_status,
+        std::chrono::milliseconds timeout) override;
+
     std::string
     get_async_error_message(async_id aid) override;
 
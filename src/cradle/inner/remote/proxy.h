@@ -1,6 +1,7 @@
 #ifndef CRADLE_INNER_REMOTE_PROXY_H
 #define CRADLE_INNER_REMOTE_PROXY_H
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -9,6 +10,7 @@
 
 #include <cradle/inner/introspection/tasklet_info.h>
 #include <cradle/inner/remote/types.h>
+#include <cradle/inner/requests/serialization.h>
 #include <cradle/inner/requests/types.h>
 #include <cradle/inner/resolve/seri_result.h>
 #include <cradle/inner/service/config.h>
@@ -78,6 +80,13 @@ class remote_proxy
     get_logger()
         = 0;
 
+    // Returns the format in which requests should be serialized for this
+    // proxy's remote. Request types that do not support this format are
+    // serialized to JSON, which every remote understands.
+    virtual request_format
+    get_request_format() const
+        = 0;
+
     // Stores a request in the named storage, under key (which should be the
     // request's unique hash).
     virtual void
@@ -120,6 +129,18 @@ class remote_proxy
     get_async_status(async_id aid)
         = 0;
 
+    // Waits until the status of the remote context specified by aid differs
+    // from known_status, or until timeout has passed; returns the (possibly
+    // unchanged) status. The remote may return early, without a change, e.g.
+    // if it has no thread available for waiting.
+    // This is a long-polling alternative to repeated get_async_status() calls.
+    virtual async_status
+    wait_async_status(
+        async_id aid,
+        async_status known_status,
+        std::chrono::milliseconds timeout)
+        = 0;
+
     // Returns an error message
     // Should be called only when status == FAILED
     virtual std::string
@@ -1,15 +1,169 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <thread>
 
+#include <BS_thread_pool.hpp>
+#include <cppcoro/single_consumer_event.hpp>
 #include <fmt/format.h>
 
 #include <cradle/inner/core/fmt_format.h>
 #include <cradle/inner/remote/wait_async.h>
 #include <cradle/inner/requests/generic.h>
+#include <cradle/inner/service/resources.h>
 
 namespace cradle {
 
+namespace {
+
+// The maximum time that a single wait_async_status() call waits on the
+// remote
+constexpr std::chrono::milliseconds long_poll_timeout{1000};
+
+// The maximum time to back off if the remote returns without waiting
+constexpr std::chrono::milliseconds max_backoff{100};
+
+// The number of threads that block in wait_async_status() on behalf of
+// coroutines, so that those don't block a thread of the async pool
+constexpr BS::concurrency_t num_long_poll_threads{16};
+
+BS::thread_pool&
+get_long_poll_pool()
+{
+    static BS::thread_pool pool{num_long_poll_threads};
+    return pool;
+}
+
+// The number of long polls claiming a thread in the pool
+std::atomic<BS::concurrency_t> num_long_polls{0};
+
+// Tracks the last known status of a remote context, while waiting until it
+// passes a matcher's condition.
+class remote_status_waiter
+{
+ public:
+    remote_status_waiter(
+        remote_proxy& proxy,
+        async_id remote_id,
+        async_status_matcher const& matcher)
+        : proxy_{proxy},
+          remote_id_{remote_id},
+          matcher_{matcher},
+          status_{proxy.get_async_status(remote_id)}
+    {
+    }
+
+    // Returns true if the last known status passes the matcher's condition.
+    // Throws if the remote operation was cancelled or ran into an error.
+    bool
+    done() const
+    {
+        if (matcher_(status_))
+        {
+            return true;
+        }
+        else if (status_ == async_status::CANCELLED)
+        {
+            throw async_cancelled(
+                fmt::format("remote async {} cancelled", remote_id_));
+        }
+        else if (status_ == async_status::FAILED)
+        {
+            std::string errmsg = proxy_.get_async_error_message(remote_id_);
+            throw async_error(errmsg);
+        }
+        return false;
+    }
+
+    // Asks the remote to report the next status change.
+    // Returns the time to back off before calling this function again:
+    // zero, unless the remote returned without waiting.
+    std::chrono::milliseconds
+    wait_for_change()
+    {
+        auto start{std::chrono::steady_clock::now()};
+        auto new_status
+            = proxy_.wait_async_status(remote_id_, status_, long_poll_timeout);
+        return on_new_status(new_status, timed_out_since(start));
+    }
+
+    // Coroutine version of wait_for_change(). The call to the remote blocks
+    // a thread of the long-poll pool, not the caller's thread; the coroutine
+    // resumes on the async pool. If all long-poll threads are busy, the
+    // remote is only asked for the current status.
+    cppcoro::task<std::chrono::milliseconds>
+    wait_for_change_coro(context_intf& ctx)
+    {
+        if (num_long_polls.fetch_add(1) >= num_long_poll_threads)
+        {
+            num_long_polls -= 1;
+            co_return on_new_status(
+                proxy_.get_async_status(remote_id_), false);
+        }
+        auto start{std::chrono::steady_clock::now()};
+        async_status new_status{};
+        std::exception_ptr error;
+        cppcoro::single_consumer_event done;
+        get_long_poll_pool().detach_task([&] {
+            try
+            {
+                new_status = proxy_.wait_async_status(
+                    remote_id_, status_, long_poll_timeout);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            num_long_polls -= 1;
+            // May resume the coroutine on this thread; it immediately moves
+            // on to the async pool.
+            done.set();
+        });
+        co_await done;
+        co_await ctx.get_resources().get_async_thread_pool().schedule();
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        co_return on_new_status(new_status, timed_out_since(start));
+    }
+
+ private:
+    static bool
+    timed_out_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::steady_clock::now() - start >= long_poll_timeout;
+    }
+
+    // Records new_status, returning the time to back off. timed_out tells
+    // whether the remote waited for the full long_poll_timeout.
+    std::chrono::milliseconds
+    on_new_status(async_status new_status, bool timed_out)
+    {
+        bool waited{new_status != status_ || timed_out};
+        status_ = new_status;
+        if (waited)
+        {
+            backoff_ = std::chrono::milliseconds{1};
+            return std::chrono::milliseconds{0};
+        }
+        auto result{backoff_};
+        backoff_ = std::min(
+            backoff_ + backoff_ / 2 + std::chrono::milliseconds{1},
+            max_backoff);
+        return result;
+    }
+
+    remote_proxy& proxy_;
+    async_id remote_id_;
+    async_status_matcher const& matcher_;
+    async_status status_;
+    std::chrono::milliseconds backoff_{1};
+};
+
+} // namespace
+
 async_status_matcher::async_status_matcher(
     std::string name, spdlog::logger& logger)
     : name_{std::move(name)}, logger_{logger}
@@ -35,26 +189,35 @@ wait_until_async_status_matches(
     async_id remote_id,
     async_status_matcher const& matcher)
 {
-    int sleep_time{1};
-    for (;;)
+    remote_status_waiter waiter{proxy, remote_id, matcher};
+    while (!waiter.done())
     {
-        auto status = proxy.get_async_status(remote_id);
-        if (matcher(status))
-        {
-            break;
-        }
-        else if (status == async_status::CANCELLED)
+        auto backoff{waiter.wait_for_change()};
+        if (backoff.count() > 0)
         {
-            throw async_cancelled(
-                fmt::format("remote async {} cancelled", remote_id));
+            std::this_thread::sleep_for(backoff);
         }
-        else if (status == async_status::FAILED)
+    }
+}
+
+cppcoro::task<void>
+wait_until_async_status_matches_coro(
+    context_intf& ctx,
+    remote_proxy& proxy,
+    async_id remote_id,
+    async_status_matcher const& matcher)
+{
+    remote_status_waiter waiter{proxy, remote_id, matcher};
+    while (!waiter.done())
+    {
+        auto backoff{co_await waiter.wait_for_change_coro(ctx)};
+        if (backoff.count() > 0)
         {
-            std::string errmsg = proxy.get_async_error_message(remote_id);
-            throw async_error(errmsg);
+            co_await ctx.schedule_after(backoff);
+            // Resume on a pool thread: the next wait_async_status() call
+            // should not block the I/O service thread.
+            co_await ctx.get_resources().get_async_thread_pool().schedule();
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
-        sleep_time = std::min((sleep_time + 1) * 3 / 2, 100);
     }
 }
 
@@ -3,13 +3,19 @@
 
 #include <string>
 
+#include <cppcoro/task.hpp>
 #include <spdlog/spdlog.h>
 
 #include <cradle/inner/remote/proxy.h>
 #include <cradle/inner/requests/generic.h>
 
-// Functionality to block the caller until the context on a remote has reached
-// a state corresponding to the passed matcher.
+// Functionality to wait until the context on a remote has reached a state
+// corresponding to the passed matcher.
+//
+// The remote is asked to report a status change as soon as it happens
+// (remote_proxy::wait_async_status()), so there is no polling delay. Only if
+// the remote returns without waiting, the caller backs off before asking
+// again.
 
 namespace cradle {
 
@@ -30,15 +36,27 @@ class async_status_matcher
     spdlog::logger& logger_;
 };
 
-// Polls the status of the remote context for remote_id until it passes the
-// matcher's condition. Throws if the remote operation was cancelled or ran
-// into an error.
+// Blocks the caller until the status of the remote context for remote_id
+// passes the matcher's condition. Throws if the remote operation was
+// cancelled or ran into an error.
 void
 wait_until_async_status_matches(
     remote_proxy& proxy,
     async_id remote_id,
     async_status_matcher const& matcher);
 
+// Coroutine version of wait_until_async_status_matches(). It doesn't block
+// the caller's thread: the long polls block threads in a dedicated pool, and
+// backing off happens through ctx.schedule_after(). The coroutine resumes on
+// the async thread pool.
+// The matcher must remain alive until the coroutine has finished.
+cppcoro::task<void>
+wait_until_async_status_matches_coro(
+    context_intf& ctx,
+    remote_proxy& proxy,
+    async_id remote_id,
+    async_status_matcher const& matcher);
+
 } // namespace cradle
 
 #endif
@@ -1,12 +1,15 @@
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <stdexcept>
+#include <string>
 
 #include <cppcoro/sync_wait.hpp>
 #include <fmt/format.h>
 
 #include <cradle/inner/core/fmt_format.h>
 #include <cradle/inner/remote/async_db.h>
+#include <cradle/inner/remote/config.h>
 #include <cradle/inner/remote/wait_async.h>
 #include <cradle/inner/requests/context_base.h>
 #include <cradle/inner/requests/test_context.h>
@@ -75,6 +78,24 @@ data_owner_factory::on_value_complete()
     blob_file_writers_.clear();
 }
 
+schedule_hint
+read_schedule_hint(service_config const& config)
+{
+    schedule_hint hint;
+    if (auto priority = config.get_optional_string(
+            remote_config_keys::PRIORITY))
+    {
+        hint.priority = std::stoi(*priority);
+    }
+    if (auto deadline_ms = config.get_optional_number(
+            remote_config_keys::DEADLINE_MS))
+    {
+        hint.deadline = std::chrono::steady_clock::now()
+                        + std::chrono::milliseconds(*deadline_ms);
+    }
+    return hint;
+}
+
 sync_context_base::sync_context_base(
     inner_resources& resources,
     tasklet_tracker* tasklet,
@@ -135,6 +156,27 @@ sync_context_base::pop_tasklet()
     tasklets_.pop_back();
 }
 
+void
+sync_context_base::update_config_map_with_schedule_hint(
+    service_config_map& config_map) const
+{
+    schedule_hint const default_hint;
+    if (schedule_hint_.priority != default_hint.priority)
+    {
+        config_map[remote_config_keys::PRIORITY]
+            = std::to_string(schedule_hint_.priority);
+    }
+    if (schedule_hint_.deadline != default_hint.deadline)
+    {
+        // steady_clock time points don't carry over to another process
+        auto remaining{std::chrono::duration_cast<std::chrono::milliseconds>(
+            schedule_hint_.deadline - std::chrono::steady_clock::now())};
+        remaining = std::max(remaining, std::chrono::milliseconds::zero());
+        config_map[remote_config_keys::DEADLINE_MS]
+            = static_cast<std::size_t>(remaining.count());
+    }
+}
+
 namespace {
 
 async_id
@@ -202,6 +244,30 @@ local_tree_context_base::on_value_complete()
     the_data_owner_factory_.on_value_complete();
 }
 
+void
+local_tree_context_base::notify_status_change()
+{
+    // The status was updated without holding status_mutex_; acquiring the
+    // mutex here ensures that a waiter either sees the new status, or is
+    // already waiting and will be woken up.
+    {
+        std::scoped_lock lock(status_mutex_);
+    }
+    status_changed_.notify_all();
+}
+
+async_status
+local_tree_context_base::wait_status_change(
+    std::atomic<async_status> const& status,
+    async_status known_status,
+    std::chrono::milliseconds timeout)
+{
+    std::unique_lock lock(status_mutex_);
+    status_changed_.wait_for(
+        lock, timeout, [&] { return status.load() != known_status; });
+    return status.load();
+}
+
 local_async_context_base::local_async_context_base(
     local_tree_context_base& tree_ctx,
     local_async_context_base* parent,
@@ -347,7 +413,9 @@ local_async_context_base::reschedule_if_opportune()
     else
     {
         // Let the parent decide: its last subrequest to start running can
-        // continue on the parent's thread, the other ones should reschedule
+        // continue on the parent's thread, the other ones should reschedule.
+        // On a pool thread, a rescheduled subrequest stays with that thread
+        // unless another, idle, thread steals it.
         bool reschedule = parent_->decide_reschedule_sub();
         logger.debug(
             "local_async_context_base {} reschedule_if_opportune(): {} due to "
@@ -357,7 +425,7 @@ local_async_context_base::reschedule_if_opportune()
         if (reschedule)
         {
             auto& thread_pool{get_resources().get_async_thread_pool()};
-            co_await thread_pool.schedule();
+            co_await thread_pool.schedule(tree_ctx_.get_schedule_hint());
         }
     }
     co_return;
@@ -395,6 +463,14 @@ local_async_context_base::update_status(async_status status)
         }
     }
     status_ = status;
+    tree_ctx_.notify_status_change();
+}
+
+async_status
+local_async_context_base::wait_status_change(
+    async_status known_status, std::chrono::milliseconds timeout)
+{
+    return tree_ctx_.wait_status_change(status_, known_status, timeout);
 }
 
 void
@@ -406,8 +482,9 @@ local_async_context_base::update_status_error(std::string const& errmsg)
         id_,
         status_.load(std::memory_order_relaxed),
         errmsg);
-    status_ = async_status::FAILED;
     errmsg_ = errmsg;
+    status_ = async_status::FAILED;
+    tree_ctx_.notify_status_change();
 }
 
 bool
@@ -489,10 +566,19 @@ root_local_async_context_base::root_local_async_context_base(
 {
 }
 
+root_local_async_context_base::root_local_async_context_base(
+    local_tree_context_base& tree_ctx, service_config const& config)
+    : local_async_context_base{tree_ctx, nullptr, true}
+{
+    tree_ctx.set_schedule_hint(read_schedule_hint(config));
+}
+
 void
 root_local_async_context_base::update_status(async_status status)
 {
-    local_async_context_base::update_status(status);
+    // Go directly to AWAITING_RESULT, without passing through FINISHED:
+    // a client waiting for FINISHED would otherwise try to get the result
+    // before it has been set.
     if (using_result_ && status == async_status::FINISHED)
     {
         status = async_status::AWAITING_RESULT;
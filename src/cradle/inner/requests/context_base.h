@@ -2,6 +2,8 @@
 #define CRADLE_INNER_REQUEST_CONTEXT_BASE_H
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <future>
 #include <memory>
 #include <mutex>
@@ -55,6 +57,11 @@ class data_owner_factory
     std::vector<std::shared_ptr<blob_file_writer>> blob_file_writers_;
 };
 
+// Returns the schedule hint passed in a config created by a client context
+// (cf. sync_context_base::update_config_map_with_schedule_hint()).
+schedule_hint
+read_schedule_hint(service_config const& config);
+
 /*
  * An abstract base class that can be used to synchronously resolve requests.
  * It offers all context features other than the asynchronous functionality
@@ -126,9 +133,31 @@ class sync_context_base : public virtual local_sync_context_intf,
     void
     pop_tasklet() override;
 
+    // Other
+    // Sets the priority and deadline for the work (e.g., HTTP requests)
+    // done on behalf of this context.
+    void
+    set_schedule_hint(schedule_hint hint)
+    {
+        schedule_hint_ = hint;
+    }
+
+    schedule_hint const&
+    get_schedule_hint() const
+    {
+        return schedule_hint_;
+    }
+
  protected:
+    // Passes the schedule hint on to the root context that a remote service
+    // creates from the config
+    void
+    update_config_map_with_schedule_hint(
+        service_config_map& config_map) const;
+
     inner_resources& resources_;
     std::string proxy_name_;
+    schedule_hint schedule_hint_;
     std::vector<tasklet_tracker*> tasklets_;
     data_owner_factory the_data_owner_factory_;
 };
@@ -138,7 +167,8 @@ class sync_context_base : public virtual local_sync_context_intf,
  * same context tree (relating to the same root request).
  *
  * In particular, it owns a cppcoro::cancellation_source object, which is
- * shared by all contexts in the tree.
+ * shared by all contexts in the tree. It also lets threads wait for status
+ * changes of contexts in the tree.
  *
  * Note that an object of this class must not be re-used across multiple
  * context trees.
@@ -192,12 +222,43 @@ class local_tree_context_base
     void
     on_value_complete();
 
+    // Wakes up the threads waiting in wait_status_change(); should be called
+    // after the status of a context in this tree has changed.
+    void
+    notify_status_change();
+
+    // Blocks until status differs from known_status, or until timeout has
+    // passed; returns the (possibly unchanged) status.
+    async_status
+    wait_status_change(
+        std::atomic<async_status> const& status,
+        async_status known_status,
+        std::chrono::milliseconds timeout);
+
+    // Sets the priority and deadline for resolving the subrequests in this
+    // tree; should be called before the resolution starts. A root context
+    // created from a remote config does this itself.
+    void
+    set_schedule_hint(schedule_hint hint)
+    {
+        schedule_hint_ = hint;
+    }
+
+    schedule_hint const&
+    get_schedule_hint() const
+    {
+        return schedule_hint_;
+    }
+
  private:
     inner_resources& resources_;
+    schedule_hint schedule_hint_;
     cppcoro::cancellation_source csource_;
     cppcoro::cancellation_token ctoken_;
     std::shared_ptr<spdlog::logger> logger_;
     data_owner_factory the_data_owner_factory_;
+    std::mutex status_mutex_;
+    std::condition_variable status_changed_;
 };
 
 /*
@@ -318,6 +379,10 @@ class local_async_context_base : public virtual local_async_context_intf,
         return status_;
     }
 
+    async_status
+    wait_status_change(
+        async_status known_status, std::chrono::milliseconds timeout) override;
+
     std::string
     get_error_message() override
     {
@@ -368,6 +433,13 @@ class local_async_context_base : public virtual local_async_context_intf,
         return tree_ctx_;
     }
 
+    // The hint is shared by all contexts in the tree.
+    schedule_hint const&
+    get_schedule_hint() const
+    {
+        return tree_ctx_.get_schedule_hint();
+    }
+
  private:
     local_tree_context_base& tree_ctx_;
     local_async_context_base* parent_;
@@ -407,6 +479,10 @@ class root_local_async_context_base : public local_async_context_base,
  public:
     root_local_async_context_base(local_tree_context_base& tree_ctx);
 
+    // Sets the tree's schedule hint from the remote_config_keys in config
+    root_local_async_context_base(
+        local_tree_context_base& tree_ctx, service_config const& config);
+
     // local_async_context_intf
     void
     update_status(async_status status) override;
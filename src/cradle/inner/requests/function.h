@@ -27,12 +27,14 @@
 #include <cradle/inner/encodings/msgpack_packer.h>
 #include <cradle/inner/requests/containment_data.h>
 #include <cradle/inner/requests/generic.h>
+#include <cradle/inner/requests/interning.h>
 #include <cradle/inner/requests/normalization_uuid.h>
 #include <cradle/inner/requests/request_props.h>
 #include <cradle/inner/requests/types.h>
 #include <cradle/inner/requests/uuid.h>
 #include <cradle/inner/requests/value.h>
 #include <cradle/inner/resolve/creq_controller.h>
+#include <cradle/inner/resolve/prefetch.h>
 #include <cradle/inner/resolve/resolve_impl.h>
 #include <cradle/inner/resolve/resolve_request.h>
 #include <cradle/inner/resolve/seri_registry.h>
@@ -90,6 +92,27 @@ visit_args(
     (visit_arg(visitor, Ix, std::get<Ix>(args)), ...);
 }
 
+// Collects prefetch items for a request's argument; a no-op unless the
+// argument is a subrequest supporting prefetching (a function_request).
+template<typename Arg>
+void
+collect_prefetch_arg(prefetch_item_list& items, Arg const& arg)
+{
+    if constexpr (requires { arg.collect_prefetch_items(items); })
+    {
+        arg.collect_prefetch_items(items);
+    }
+}
+
+// Recursively collects prefetch items for all arguments of a request.
+template<typename Args, std::size_t... Ix>
+void
+collect_prefetch_args(
+    prefetch_item_list& items, Args const& args, std::index_sequence<Ix...>)
+{
+    (collect_prefetch_arg(items, std::get<Ix>(args)), ...);
+}
+
 // Common functions between function_request_intf and proxy_request_intf.
 //
 // Currently, there is much code duplicated between function_request_impl and
@@ -126,6 +149,11 @@ class base_request_intf : public id_interface
     virtual void
     load(JSONRequestInputArchive& archive)
         = 0;
+
+    // Called by request_intern_table when this object is interned.
+    virtual void
+    mark_interned(request_intern_mark const& mark)
+        = 0;
 };
 
 // The function_request_impl functionality required by function_request outside
@@ -155,6 +183,12 @@ class function_request_intf : public base_request_intf
     accept(req_visitor_intf& visitor) const
         = 0;
 
+    // Adds prefetch items for this request (if it is fully cached) and its
+    // subrequests to items (see prefetch.h).
+    virtual void
+    collect_prefetch_items(prefetch_item_list& items) const
+        = 0;
+
     // Should be moved to base_request_intf if the server can create
     // proxy_request objects
     virtual void
@@ -165,8 +199,24 @@ class function_request_intf : public base_request_intf
     load_msgpack(msgpack::object const msgpack_objs[3])
         = 0;
 
+    virtual bool
+    is_interned() const
+        = 0;
+
+    // Returns a copy of this object that is not interned, and can therefore
+    // be modified (e.g., by set_containment()).
+    virtual std::shared_ptr<function_request_intf>
+    copy_uninterned() const
+        = 0;
+
     virtual cppcoro::task<Value>
     resolve(local_context_intf& ctx, cache_record_lock* lock_ptr) const = 0;
+
+    // Like resolve(), but returning a shared pointer to the value in the
+    // memory cache, instead of a copy of that value.
+    virtual cppcoro::task<std::shared_ptr<Value const>>
+    resolve_shared(
+        local_context_intf& ctx, cache_record_lock* lock_ptr) const = 0;
 };
 
 template<typename Ctx, typename Args, std::size_t... Ix>
@@ -427,6 +477,34 @@ class function_request_impl final
         return std::make_shared<this_type>(std::move(uuid));
     }
 
+    // Copies everything other than the containment data and the interned
+    // state; cf. copy_uninterned().
+    function_request_impl(function_request_impl const& other)
+        : intf_type(),
+          intrsp_mixin_type{static_cast<intrsp_mixin_type const&>(other)},
+          std::enable_shared_from_this<function_request_impl>{},
+          uuid_{other.uuid_},
+          function_{other.function_},
+          args_{other.args_},
+          hash_{other.hash_},
+          unique_hash_{other.unique_hash_},
+          have_unique_hash_{other.have_unique_hash_}
+    {
+    }
+
+    // Calculates the hashes that would otherwise be calculated lazily; must
+    // be called before this object is interned (and possibly shared between
+    // threads).
+    void
+    prepare_interning() const
+    {
+        hash();
+        if (!have_unique_hash_)
+        {
+            calc_unique_hash();
+        }
+    }
+
  public: // id_interface
     // other will be a function_request_impl, but possibly instantiated from
     // different template arguments.
@@ -447,6 +525,12 @@ class function_request_impl final
             {
                 return true;
             }
+            if (intern_mark_.table && intern_mark_ == other_impl->intern_mark_)
+            {
+                // Distinct objects interned in the same table generation are
+                // never equal
+                return false;
+            }
             if (uuid_ != other_impl->uuid_)
             {
                 return false;
@@ -562,6 +646,12 @@ class function_request_impl final
             = the_seri_registry->find_function<stored_function_t>(uuid_.str());
     }
 
+    void
+    mark_interned(request_intern_mark const& mark) override
+    {
+        intern_mark_ = mark;
+    }
+
  public: // function_request_intf
     caching_level_type
     get_caching_level() const override
@@ -576,6 +666,26 @@ class function_request_impl final
         return sizeof(*this) + sizeof(containment_data);
     }
 
+    bool
+    is_interned() const override
+    {
+        return intern_mark_.table != nullptr;
+    }
+
+    std::shared_ptr<intf_type>
+    copy_uninterned() const override
+    {
+        if constexpr (std::is_copy_constructible_v<std::tuple<Args...>>)
+        {
+            return std::make_shared<this_type>(*this);
+        }
+        else
+        {
+            throw not_implemented_error{
+                "function_request_impl::copy_uninterned()"};
+        }
+    }
+
     // Registers this instantiation to be identified by its uuid, so that the
     // deserialization will translate an input containing that same uuid to an
     // object of the same type, with the same function_ value.
@@ -599,6 +709,19 @@ class function_request_impl final
         visit_args(visitor, args_, ArgIndices{});
     }
 
+    // A value-based request's cache key depends on its subrequests' values,
+    // so only its subrequests can be prefetched.
+    void
+    collect_prefetch_items(prefetch_item_list& items) const override
+    {
+        if constexpr (is_fully_cached(caching_level) && !value_based_caching)
+        {
+            items.push_back(
+                std::make_unique<prefetch_item<Value>>(get_captured_id()));
+        }
+        collect_prefetch_args(items, args_, ArgIndices{});
+    }
+
     void
     save_msgpack(msgpack_packer& packer) override
     {
@@ -634,6 +757,13 @@ class function_request_impl final
         return resolve_impl(ctx, *this, lock_ptr);
     }
 
+    cppcoro::task<std::shared_ptr<Value const>>
+    resolve_shared(
+        local_context_intf& ctx, cache_record_lock* lock_ptr) const override
+    {
+        return resolve_impl<true>(ctx, *this, lock_ptr);
+    }
+
  public: // called from resolve_impl.h
     // TODO should these be in some interface or concept?
 
@@ -746,19 +876,23 @@ class function_request_impl final
         co_return result;
     }
 
+    // Serializes the plain counterpart of this request, with the values of
+    // its subrequests as arguments. The result is equivalent to what
+    // function_request::serialize_msgpack() would give.
     std::string
     serialize_contained_request(auto const& sub_results) const
     {
-        std::stringstream os;
-        {
-            JSONRequestOutputArchive oarchive(os);
-            containment_->plain_uuid_.save_with_name(oarchive, "uuid");
-            // no_retrier state
-            this->save_intrsp_state(oarchive);
-            // No containment data
-            containment_data::save_nothing(oarchive);
-            oarchive(cereal::make_nvp("args", sub_results));
-        }
+        msgpack_ostream os;
+        msgpack_packer packer(os, false);
+        // Same layout as in function_request::msgpack_pack()
+        packer.pack_array(5);
+        containment_->plain_uuid_.save(packer);
+        // no_retrier state
+        packer.pack_nil();
+        this->save_intrsp_state(packer);
+        packer.pack(sub_results);
+        // No containment data
+        containment_data::save_nothing(packer);
         return os.str();
     }
 
@@ -963,6 +1097,10 @@ class function_request_impl final
     mutable unique_hasher::result_t unique_hash_;
     mutable bool have_unique_hash_{false};
 
+    // Set if this object was interned in a request_intern_table; if so, it
+    // is immutable.
+    request_intern_mark intern_mark_;
+
     bool
     is_normalizer() const
     {
@@ -1036,15 +1174,31 @@ class function_request : public ObjectProps::retrier_type
             make_request_impl_props_type<Props>,
             std::remove_cvref_t<Function>,
             std::remove_cvref_t<Args>...>;
-        impl_ = std::make_shared<impl_type>(
+        auto impl{std::make_shared<impl_type>(
             make_request_impl_props(std::forward<Props>(props)),
             std::forward<Function>(function),
-            std::forward<Args>(args)...);
+            std::forward<Args>(args)...)};
+        if (auto* intern_table = current_request_intern_table())
+        {
+            impl->prepare_interning();
+            impl_ = std::static_pointer_cast<impl_type>(
+                intern_table->intern(std::move(impl)));
+        }
+        else
+        {
+            impl_ = std::move(impl);
+        }
     }
 
     void
     set_containment(containment_data const& containment)
     {
+        // An interned object may be shared with other requests, which should
+        // not become contained.
+        if (impl_->is_interned())
+        {
+            impl_ = impl_->copy_uninterned();
+        }
         impl_->set_containment(containment);
     }
 
@@ -1134,12 +1288,24 @@ class function_request : public ObjectProps::retrier_type
         impl_->accept(visitor);
     }
 
+    void
+    collect_prefetch_items(prefetch_item_list& items) const
+    {
+        impl_->collect_prefetch_items(items);
+    }
+
     cppcoro::task<Value>
     resolve(local_context_intf& ctx, cache_record_lock* lock_ptr) const
     {
         return impl_->resolve(ctx, lock_ptr);
     }
 
+    cppcoro::task<std::shared_ptr<Value const>>
+    resolve_shared(local_context_intf& ctx, cache_record_lock* lock_ptr) const
+    {
+        return impl_->resolve_shared(ctx, lock_ptr);
+    }
+
  public: // Interface for cereal + msgpack
     // Used for creating placeholder subrequests in the catalog;
     // also called when deserializing a subrequest.
@@ -1227,6 +1393,33 @@ class function_request : public ObjectProps::retrier_type
         impl_->load_msgpack(&subobjs[2]);
     }
 
+    // Serializes this object to a msgpack-encoded string; see
+    // serialize_request(). Blobs are embedded in the string, as the request
+    // is likely to be resolved in another process.
+    std::string
+    serialize_msgpack() const
+    {
+        msgpack_ostream os;
+        msgpack_packer(os, false).pack(*this);
+        return os.str();
+    }
+
+    // Deserializes an object from a serialize_msgpack() result; uuids are
+    // looked up in resources' seri_registry.
+    static function_request
+    deserialize_msgpack(
+        inner_resources& resources, std::string const& seri_req)
+    {
+        msgpack::object_handle oh
+            = msgpack::unpack(seri_req.data(), seri_req.size());
+        // msgpack_unpack() gets no context, so finds resources through
+        // get_current_inner_resources().
+        current_inner_resources_scope scope{resources};
+        function_request req;
+        oh.get().convert(req);
+        return req;
+    }
+
  private:
     std::shared_ptr<intf_type> impl_;
 };
@@ -1480,6 +1673,13 @@ class proxy_request_impl final
         containment_ = containment_data::load(archive);
     }
 
+    // Proxy requests are not interned.
+    void
+    mark_interned(request_intern_mark const&) override
+    {
+        throw not_implemented_error{"proxy_request_impl::mark_interned()"};
+    }
+
  public: // proxy_request_intf
     // Registers this instantiation to be identified by its uuid, so that the
     // deserialization will translate an input containing that same uuid to an
@@ -5,6 +5,7 @@
 #include <concepts>
 #include <memory>
 #include <string>
+#include <type_traits>
 
 #include <cppcoro/task.hpp>
 
@@ -514,6 +515,13 @@ class local_async_context_intf : public virtual local_context_intf,
     get_status()
         = 0;
 
+    // Blocks until the status of this task differs from known_status, or
+    // until timeout has passed; returns the (possibly unchanged) status.
+    virtual async_status
+    wait_status_change(
+        async_status known_status, std::chrono::milliseconds timeout)
+        = 0;
+
     // Gets the error message for this task.
     // Should be called only when get_status() returns FAILED.
     virtual std::string
@@ -900,6 +908,14 @@ concept Request = requires {
     } -> std::same_as<std::unique_ptr<request_essentials>>;
 };
 
+// The result of resolving a request: a copy of the value, or, if Shared,
+// a shared pointer to the immutable value (see resolve_request_shared()).
+template<typename Req, bool Shared>
+using resolve_result_t = std::conditional_t<
+    Shared,
+    std::shared_ptr<typename Req::value_type const>,
+    typename Req::value_type>;
+
 // By having retryable=true, a request advertises itself as being retryable...
 template<typename Req>
 concept RetryableRequest = Request<Req> && Req::retryable;
@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include <cradle/inner/requests/function.h>
+#include <cradle/inner/requests/interning.h>
+
+namespace cradle {
+
+std::shared_ptr<base_request_intf>
+request_intern_table::intern(std::shared_ptr<base_request_intf> req)
+{
+    auto hash{req->hash()};
+    auto& the_shard{shards_[hash % num_shards_]};
+    std::scoped_lock lock{the_shard.mutex};
+    auto& entries{the_shard.entries};
+    auto [it, end] = entries.equal_range(hash);
+    while (it != end)
+    {
+        if (auto existing = it->second.lock())
+        {
+            if (existing->equals(*req))
+            {
+                return existing;
+            }
+            ++it;
+        }
+        else
+        {
+            it = entries.erase(it);
+        }
+    }
+    req->mark_interned(request_intern_mark{this, generation_});
+    entries.emplace(hash, req);
+    if (entries.size() >= the_shard.sweep_size)
+    {
+        std::erase_if(
+            entries, [](auto const& entry) { return entry.second.expired(); });
+        the_shard.sweep_size
+            = std::max(std::size_t{64}, entries.size() * 2);
+    }
+    return req;
+}
+
+void
+request_intern_table::purge(std::unordered_set<std::string> const& uuid_strs)
+{
+    // Lock all shards, in a fixed order, so that no object is interned while
+    // the generation changes.
+    std::array<std::unique_lock<std::mutex>, num_shards_> locks;
+    for (std::size_t i = 0; i < num_shards_; ++i)
+    {
+        locks[i] = std::unique_lock{shards_[i].mutex};
+    }
+    for (auto& the_shard : shards_)
+    {
+        std::erase_if(the_shard.entries, [&](auto const& entry) {
+            auto existing{entry.second.lock()};
+            return !existing
+                   || uuid_strs.contains(existing->get_uuid().str());
+        });
+    }
+    generation_ += 1;
+}
+
+std::size_t
+request_intern_table::size() const
+{
+    std::size_t result{};
+    for (auto const& the_shard : shards_)
+    {
+        std::scoped_lock lock{the_shard.mutex};
+        result += the_shard.entries.size();
+    }
+    return result;
+}
+
+namespace {
+
+thread_local request_intern_table* the_current_request_intern_table{nullptr};
+
+} // namespace
+
+request_intern_table*
+current_request_intern_table()
+{
+    return the_current_request_intern_table;
+}
+
+request_interning_scope::request_interning_scope(request_intern_table* table)
+    : previous_{the_current_request_intern_table}
+{
+    the_current_request_intern_table = table;
+}
+
+request_interning_scope::~request_interning_scope()
+{
+    the_current_request_intern_table = previous_;
+}
+
+} // namespace cradle
@@ -0,0 +1,122 @@
+#ifndef CRADLE_INNER_REQUESTS_INTERNING_H
+#define CRADLE_INNER_REQUESTS_INTERNING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace cradle {
+
+class base_request_intf;
+class request_intern_table;
+
+// Identifies the table, and the generation of that table, in which a request
+// object was interned. Two distinct objects with equal marks are never equal.
+struct request_intern_mark
+{
+    request_intern_table const* table{nullptr};
+    std::uint64_t generation{0};
+
+    bool
+    operator==(request_intern_mark const& other) const
+        = default;
+};
+
+/*
+ * A table of interned (hash-consed) request implementation objects.
+ *
+ * A function_request constructor running inside a request_interning_scope
+ * looks up its new function_request_impl object in the scope's table. If the
+ * table already holds an equal object, the request shares that one, and the
+ * new object is discarded; otherwise, the new object is added to the table
+ * and marked as interned.
+ * As the subrequests of a new object will already be interned, looking it up
+ * means comparing their pointers, and combining their precomputed hashes.
+ * Two distinct objects interned in the same generation of a table are never
+ * equal, so comparing them is O(1).
+ *
+ * The table holds weak references only, so it does not keep any request
+ * alive. The entries are spread over independently locked shards.
+ *
+ * Interning relies on the uuid identifying the function: two requests with
+ * equal uuids and arguments will share the function object of whichever was
+ * created first. When a DLL is unloaded, the entries for its uuids must be
+ * purged, so that requests created afterwards will not share a function from
+ * the unloaded DLL.
+ *
+ * Each inner_resources object with interning enabled owns a table.
+ */
+class request_intern_table
+{
+ public:
+    // Returns the interned object equal to req; if there is none, interns req
+    // and returns it.
+    // req's hash() should be cheap; i.e., it should have been calculated
+    // before.
+    std::shared_ptr<base_request_intf>
+    intern(std::shared_ptr<base_request_intf> req);
+
+    // Removes the entries for the requests having one of the given uuids, and
+    // starts a new generation: objects interned from now on may be equal to
+    // the removed ones.
+    void
+    purge(std::unordered_set<std::string> const& uuid_strs);
+
+    // Returns the number of entries, including any that have expired but not
+    // been removed yet.
+    std::size_t
+    size() const;
+
+ private:
+    static constexpr std::size_t num_shards_{16};
+
+    struct shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_multimap<std::size_t, std::weak_ptr<base_request_intf>>
+            entries;
+        // Expired entries are removed when the number of entries reaches this
+        // value.
+        std::size_t sweep_size{64};
+    };
+
+    std::array<shard, num_shards_> shards_;
+    // Read with one shard locked; changed with all shards locked
+    std::uint64_t generation_{0};
+};
+
+// Returns the table used by function_request constructors on the current
+// thread, or nullptr if requests are not interned.
+request_intern_table*
+current_request_intern_table();
+
+// Makes function_request constructors on the current thread intern their
+// objects in table, for the lifetime of this object. table is normally that
+// of an inner_resources object (see get_request_intern_table()); nullptr
+// disables interning. Requests created on other threads (e.g., in a
+// coroutine that resumed on a thread pool) are not affected.
+class request_interning_scope
+{
+ public:
+    request_interning_scope(request_intern_table* table);
+
+    ~request_interning_scope();
+
+    request_interning_scope(request_interning_scope const&) = delete;
+
+    request_interning_scope&
+    operator=(request_interning_scope const&)
+        = delete;
+
+ private:
+    request_intern_table* previous_;
+};
+
+} // namespace cradle
+
+#endif
@@ -1,12 +1,21 @@
 #ifndef CRADLE_INNER_REQUESTS_SERIALIZATION_H
 #define CRADLE_INNER_REQUESTS_SERIALIZATION_H
 
-// Requests are always serialized to/from JSON, via cereal.
+// Requests are serialized to/from JSON, via cereal, or to/from msgpack.
+// All requests support JSON; requests that also support msgpack have
+//   std::string serialize_msgpack() const;
+//   static Req deserialize_msgpack(
+//       inner_resources& resources, std::string const& seri_req);
+// This header does not #include <msgpack.hpp>, because of conflicts with the
+// msgpack implementation inside rpclib.
 
+#include <concepts>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 
 #include <cereal/archives/json.hpp>
+#include <fmt/format.h>
 
 namespace cradle {
 
@@ -32,10 +41,63 @@ class JSONRequestInputArchive : public cereal::JSONInputArchive
 
 using JSONRequestOutputArchive = cereal::JSONOutputArchive;
 
+// The wire format of a serialized request
+enum class request_format
+{
+    // Text; supported by all request types
+    json,
+    // Binary; smaller and faster to (de)serialize, but supported by
+    // function_request only
+    msgpack,
+};
+
+template<typename Req>
+concept MsgpackSerializableRequest
+    = requires(
+        Req const& req,
+        inner_resources& resources,
+        std::string const& seri_req) {
+          {
+              req.serialize_msgpack()
+          } -> std::same_as<std::string>;
+          {
+              Req::deserialize_msgpack(resources, seri_req)
+          } -> std::same_as<Req>;
+      };
+
+// Returns the format in which seri_req was serialized. A JSON request is an
+// object, so starts with '{'; a msgpack request is an array, and never does.
+inline request_format
+detect_request_format(std::string const& seri_req)
+{
+    return !seri_req.empty() && seri_req[0] == '{' ? request_format::json
+                                                   : request_format::msgpack;
+}
+
+// Returns a representation of seri_req that is suitable for logging
+inline std::string
+describe_serialized_request(std::string const& seri_req)
+{
+    if (detect_request_format(seri_req) == request_format::json)
+    {
+        return seri_req;
+    }
+    return fmt::format("<msgpack request, {} bytes>", seri_req.size());
+}
+
+// Serializes req in the requested format. Falls back to JSON if Req does not
+// support msgpack.
 template<typename Req>
 std::string
-serialize_request(Req const& req)
+serialize_request(Req const& req, request_format format = request_format::json)
 {
+    if constexpr (MsgpackSerializableRequest<Req>)
+    {
+        if (format == request_format::msgpack)
+        {
+            return req.serialize_msgpack();
+        }
+    }
     std::stringstream os;
     {
         JSONRequestOutputArchive oarchive(os);
@@ -47,10 +109,23 @@ serialize_request(Req const& req)
     return os.str();
 }
 
+// Deserializes a request, in either format
 template<typename Req>
-auto
+Req
 deserialize_request(inner_resources& resources, std::string const& seri_req)
 {
+    if (detect_request_format(seri_req) == request_format::msgpack)
+    {
+        if constexpr (MsgpackSerializableRequest<Req>)
+        {
+            return Req::deserialize_msgpack(resources, seri_req);
+        }
+        else
+        {
+            throw std::invalid_argument{
+                "request type cannot be deserialized from msgpack"};
+        }
+    }
     std::istringstream is(seri_req);
     JSONRequestInputArchive iarchive(is, resources);
     return Req(iarchive);
@@ -1,8 +1,14 @@
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include <cradle/inner/blob_file/blob_file.h>
 #include <cradle/inner/core/exception.h>
 #include <cradle/inner/remote/config.h>
 #include <cradle/inner/resolve/creq_context.h>
 #include <cradle/inner/service/resources.h>
 #include <cradle/rpclib/client/proxy.h>
+#include <cradle/rpclib/common/config.h>
 
 namespace cradle {
 
@@ -13,7 +19,9 @@ creq_context::creq_context(
     : resources_{resources},
       logger_{logger},
       domain_name_{std::move(domain_name)},
-      proxy_{resources.alloc_contained_proxy(logger)}
+      proxy_{resources.alloc_contained_proxy(logger)},
+      shared_memory_threshold_{resources.config().get_number_or_default(
+          rpclib_config_keys::SHARED_MEMORY_THRESHOLD, 0x1'00'00)}
 {
 }
 
@@ -21,6 +29,32 @@ creq_context::~creq_context()
 {
     finish_remote();
     resources_.free_contained_proxy(std::move(proxy_), succeeded_);
+    if (shared_request_)
+    {
+        // The contained process is done with the request.
+        auto path{shared_request_->mapped_file()};
+        shared_request_.reset();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+}
+
+void
+creq_context::share_request(std::string& seri_req)
+{
+    if (shared_memory_threshold_ == 0
+        || seri_req.size() < shared_memory_threshold_)
+    {
+        return;
+    }
+    shared_request_ = resources_.make_blob_file_writer(seri_req.size());
+    std::memcpy(shared_request_->data(), seri_req.data(), seri_req.size());
+    shared_request_->on_write_completed();
+    logger_->debug(
+        "passing {} bytes request via {}",
+        seri_req.size(),
+        shared_request_->mapped_file());
+    seri_req.clear();
 }
 
 void
@@ -42,7 +76,14 @@ creq_context::make_config(bool need_record_lock) const
     // Config for the rpclib server
     service_config_map config_map{
         {remote_config_keys::DOMAIN_NAME, domain_name_},
+        {rpclib_config_keys::SHARED_MEMORY_THRESHOLD,
+         shared_memory_threshold_},
     };
+    if (shared_request_)
+    {
+        config_map[rpclib_config_keys::SHARED_REQUEST_FILE]
+            = shared_request_->mapped_file();
+    }
     update_config_map_with_test_params(config_map);
     return service_config{config_map};
 }
@@ -2,6 +2,7 @@
 #define CRADLE_INNER_RESOLVE_CREQ_CONTEXT_H
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -14,6 +15,7 @@
 
 namespace cradle {
 
+class blob_file_writer;
 class inner_resources;
 
 // Context used for resolving a function request in a contained process.
@@ -127,12 +129,21 @@ class creq_context : public remote_async_context_intf,
     void
     throw_if_cancelled();
 
+    // If seri_req is large enough, moves it into shared memory (a blob file)
+    // that the contained process will read it from, leaving it empty.
+    void
+    share_request(std::string& seri_req);
+
  private:
     inner_resources& resources_;
     std::shared_ptr<spdlog::logger> logger_;
     std::string const domain_name_;
     std::string const proxy_name_{"creq"};
     std::unique_ptr<rpclib_client> proxy_;
+    std::size_t const shared_memory_threshold_;
+    // The shared memory holding the serialized request, if any; removed when
+    // this object is destroyed.
+    std::shared_ptr<blob_file_writer> shared_request_;
 
     // Unless succeeded_ was set to true, this object's destructor terminates
     // the proxy process.
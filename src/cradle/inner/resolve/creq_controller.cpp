@@ -49,7 +49,9 @@ creq_controller::resolve(local_context_intf& ctx, std::string seri_req)
     }
     auto& proxy{ctx_->get_proxy()};
     proxy.load_shared_library(dll_dir_, dll_name_);
-    auto seri_resp = resolve_remote(*ctx_, std::move(seri_req), nullptr);
+    ctx_->share_request(seri_req);
+    auto seri_resp
+        = co_await resolve_remote(*ctx_, std::move(seri_req), nullptr);
     ctx_->mark_succeeded();
     co_return seri_resp;
 }
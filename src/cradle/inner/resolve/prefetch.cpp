@@ -0,0 +1,68 @@
+#include <exception>
+#include <unordered_set>
+
+#include <cradle/inner/resolve/prefetch.h>
+#include <cradle/inner/service/resources.h>
+#include <cradle/inner/service/secondary_storage_intf.h>
+#include <cradle/inner/utilities/logging.h>
+
+namespace cradle {
+
+cppcoro::task<prefetch_item_list>
+prefetch_secondary_cached(
+    inner_resources& resources, prefetch_item_list items)
+{
+    auto logger{ensure_logger("cradle")};
+    // A subrequest can occur more than once in a tree.
+    prefetch_item_list unique_items;
+    std::vector<std::string> keys;
+    std::unordered_set<std::string> seen_keys;
+    for (auto& item : items)
+    {
+        if (seen_keys.insert(item->key()).second)
+        {
+            keys.push_back(item->key());
+            unique_items.push_back(std::move(item));
+        }
+    }
+    if (keys.empty())
+    {
+        co_return prefetch_item_list{};
+    }
+
+    std::vector<std::optional<blob>> values;
+    try
+    {
+        values = co_await resources.secondary_cache().read_many(keys);
+    }
+    catch (std::exception const& e)
+    {
+        logger->warn("prefetch of {} keys failed: {}", keys.size(), e.what());
+        co_return prefetch_item_list{};
+    }
+
+    prefetch_item_list stored_items;
+    auto& memory_cache = resources.memory_cache();
+    for (std::size_t i = 0; i < unique_items.size(); ++i)
+    {
+        if (!values[i])
+        {
+            continue;
+        }
+        try
+        {
+            unique_items[i]->store(memory_cache, *values[i]);
+            stored_items.push_back(std::move(unique_items[i]));
+        }
+        catch (std::exception const& e)
+        {
+            logger->warn(
+                "prefetch of {} failed: {}", unique_items[i]->key(), e.what());
+        }
+    }
+    logger->debug(
+        "prefetched {} of {} values", stored_items.size(), keys.size());
+    co_return stored_items;
+}
+
+} // namespace cradle
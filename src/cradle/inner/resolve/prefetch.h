@@ -0,0 +1,121 @@
+#ifndef CRADLE_INNER_RESOLVE_PREFETCH_H
+#define CRADLE_INNER_RESOLVE_PREFETCH_H
+
+// Prefetching the values of the fully-cached requests in a request tree from
+// the secondary cache, in a single batch.
+//
+// Normally, each fully-cached request that misses the memory cache costs one
+// secondary cache read, so resolving a large tree against e.g. a remote
+// cache costs one round trip per node. Prefetching collects the keys of all
+// fully-cached requests in the tree, reads them with a single read_many()
+// call, and puts the values that were found in the memory cache. Resolving
+// the tree afterwards then finds them there.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cppcoro/shared_task.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
+
+#include <cradle/inner/caching/immutable/cache.h>
+#include <cradle/inner/caching/immutable/ptr.h>
+#include <cradle/inner/core/get_unique_string.h>
+#include <cradle/inner/core/id.h>
+#include <cradle/inner/core/type_definitions.h>
+#include <cradle/inner/encodings/msgpack_value.h>
+
+namespace cradle {
+
+class inner_resources;
+
+/*
+ * A fully-cached request whose value could be prefetched
+ */
+class prefetch_item_intf
+{
+ public:
+    virtual ~prefetch_item_intf() = default;
+
+    // The request's key in the secondary cache
+    virtual std::string const&
+    key() const
+        = 0;
+
+    // Puts the value, read from the secondary cache, in the memory cache.
+    // The memory cache record stays alive until this object is destroyed.
+    virtual void
+    store(immutable_cache& cache, blob const& value)
+        = 0;
+};
+
+using prefetch_item_list = std::vector<std::unique_ptr<prefetch_item_intf>>;
+
+template<typename Value>
+class prefetch_item : public prefetch_item_intf
+{
+ public:
+    explicit prefetch_item(captured_id id)
+        : id_{std::move(id)}, key_{get_unique_string(*id_)}
+    {
+    }
+
+    std::string const&
+    key() const override
+    {
+        return key_;
+    }
+
+    void
+    store(immutable_cache& cache, blob const& value) override
+    {
+        bool created{false};
+        ptr_ = std::make_unique<immutable_cache_ptr<Value>>(
+            cache, id_, [&](untyped_immutable_cache_ptr& ptr) {
+                created = true;
+                return deserialize_task(ptr, value);
+            });
+        // Deserialize the value now, so that the record's task does not
+        // outlive ptr_. If the record already existed, there is no need to
+        // wait for it.
+        if (created)
+        {
+            cppcoro::sync_wait(ptr_->ensure_value_task());
+        }
+    }
+
+ private:
+    captured_id id_;
+    std::string key_;
+    std::unique_ptr<immutable_cache_ptr<Value>> ptr_;
+
+    static cppcoro::shared_task<void>
+    deserialize_task(untyped_immutable_cache_ptr& untyped_ptr, blob value)
+    {
+        auto& ptr = static_cast<immutable_cache_ptr<Value>&>(untyped_ptr);
+        try
+        {
+            ptr.record_value(deserialize_value<Value>(value));
+        }
+        catch (...)
+        {
+            ptr.record_failure();
+            throw;
+        }
+        co_return;
+    }
+};
+
+// Reads the values for :items from the secondary cache, with a single
+// read_many() call, and stores the ones that were found in the memory cache.
+// Returns the items whose values were stored; their memory cache records
+// stay alive while the returned items exist.
+// Errors are logged, and otherwise ignored: prefetching is an optimization.
+cppcoro::task<prefetch_item_list>
+prefetch_secondary_cached(
+    inner_resources& resources, prefetch_item_list items);
+
+} // namespace cradle
+
+#endif
@@ -35,12 +35,13 @@ async_finished_matcher::operator()(async_status status) const
     return done;
 }
 
-void
-wait_until_async_finished(remote_proxy& proxy, async_id remote_id)
+cppcoro::task<void>
+wait_until_async_finished(
+    context_intf& ctx, remote_proxy& proxy, async_id remote_id)
 {
-    auto& logger = proxy.get_logger();
-    wait_until_async_status_matches(
-        proxy, remote_id, async_finished_matcher(logger));
+    async_finished_matcher matcher{proxy.get_logger()};
+    co_await wait_until_async_status_matches_coro(
+        ctx, proxy, remote_id, matcher);
 }
 
 void
@@ -62,7 +63,7 @@ set_lock_ptr_record(
     }
 }
 
-serialized_result
+cppcoro::task<serialized_result>
 resolve_async(
     remote_async_context_intf& ctx,
     std::string seri_req,
@@ -92,13 +93,13 @@ resolve_async(
         ctx.fail_remote_id();
         throw;
     }
-    wait_until_async_finished(*proxy, remote_id);
+    co_await wait_until_async_finished(ctx, *proxy, remote_id);
     auto seri_resp = proxy->get_async_response(remote_id);
     set_lock_ptr_record(lock_ptr, *proxy, seri_resp);
-    return seri_resp;
+    co_return seri_resp;
 }
 
-serialized_result
+cppcoro::task<serialized_result>
 resolve_sync(
     remote_context_intf& ctx,
     std::string seri_req,
@@ -112,7 +113,7 @@ resolve_sync(
     auto seri_resp = proxy.resolve_sync(
         ctx.make_config(need_record_lock), std::move(seri_req));
     set_lock_ptr_record(lock_ptr, proxy, seri_resp);
-    return seri_resp;
+    co_return seri_resp;
 }
 
 } // namespace
@@ -128,7 +129,7 @@ remote_locked_cache_record::~remote_locked_cache_record()
     proxy_.release_cache_record_lock(record_id_);
 }
 
-serialized_result
+cppcoro::task<serialized_result>
 resolve_remote(
     remote_context_intf& ctx,
     std::string seri_req,
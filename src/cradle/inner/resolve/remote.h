@@ -2,12 +2,14 @@
 #define CRADLE_INNER_RESOLVE_REMOTE_H
 
 // Service to remotely resolve requests
-// No coroutines needed here
 
 #include <string>
 
+#include <cppcoro/task.hpp>
+
 #include <cradle/inner/caching/immutable/lock.h>
 #include <cradle/inner/encodings/msgpack_value.h>
+#include <cradle/inner/remote/proxy.h>
 #include <cradle/inner/remote/types.h>
 #include <cradle/inner/requests/generic.h>
 #include <cradle/inner/requests/serialization.h>
@@ -40,8 +42,11 @@ class remote_locked_cache_record : public locked_cache_record
  * lock_ptr, if not nullptr, refers to the memory cache lock that should be
  * set while resolving the request. The lock will refer to a memory cache
  * record on the remote.
+ *
+ * For an asynchronous context, the coroutine suspends while waiting for the
+ * remote to finish, instead of blocking the thread.
  */
-serialized_result
+cppcoro::task<serialized_result>
 resolve_remote(
     remote_context_intf& ctx,
     std::string seri_req,
@@ -56,16 +61,18 @@ resolve_remote(
  * record on the remote.
  */
 template<Request Req>
-typename Req::value_type
+cppcoro::task<typename Req::value_type>
 resolve_remote_to_value(
     remote_context_intf& ctx, Req const& req, cache_record_lock* lock_ptr)
 {
     using Value = typename Req::value_type;
-    std::string seri_req{serialize_request(req)};
-    auto seri_resp = resolve_remote(ctx, std::move(seri_req), lock_ptr);
+    std::string seri_req{
+        serialize_request(req, ctx.get_proxy().get_request_format())};
+    auto seri_resp
+        = co_await resolve_remote(ctx, std::move(seri_req), lock_ptr);
     Value result = deserialize_value<Value>(seri_resp.value());
     seri_resp.on_deserialized();
-    return result;
+    co_return result;
 }
 
 } // namespace cradle
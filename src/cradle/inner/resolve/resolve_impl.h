@@ -119,9 +119,11 @@ cppcoro::shared_task<void> resolve_request_on_memory_cache_miss(
 
 // Resolves a request, with caching, and with or without introspection,
 // depending on the request's compile-time attributes.
-template<typename Req>
+// If Shared, the result is a shared pointer to the value in the memory cache;
+// otherwise, it is a copy of that value.
+template<bool Shared, typename Req>
     requires(is_cached(Req::caching_level) && !Req::value_based_caching)
-cppcoro::task<typename Req::value_type> resolve_request_cached(
+cppcoro::task<resolve_result_t<Req, Shared>> resolve_request_cached(
     caching_context_intf& ctx, Req const& req, cache_record_lock* lock_ptr)
 {
     using value_type = typename Req::value_type;
@@ -166,43 +168,61 @@ cppcoro::task<typename Req::value_type> resolve_request_cached(
         actx->update_status(async_status::FINISHED);
     }
     // Finally, return the shared_task's value.
-    co_return ptr.get_value();
+    if constexpr (Shared)
+    {
+        co_return ptr.get_shared_value();
+    }
+    else
+    {
+        co_return ptr.get_value();
+    }
 }
 
-template<typename Req>
+template<bool Shared, typename Req>
     requires(is_cached(Req::caching_level) && Req::value_based_caching)
-cppcoro::task<typename Req::value_type> resolve_request_cached(
+cppcoro::task<resolve_result_t<Req, Shared>> resolve_request_cached(
     caching_context_intf& ctx, Req const& req, cache_record_lock* lock_ptr)
 {
     // Make a composition-based variant of req that has all
     // subrequests resolved and replaced by resulting values; then resolve
     // that request as any other request, using composition-based caching.
     auto clone{co_await req.make_flattened_clone(ctx)};
-    co_return co_await resolve_request_cached(ctx, *clone, lock_ptr);
+    co_return co_await resolve_request_cached<Shared>(ctx, *clone, lock_ptr);
 }
 
 // Resolves a request, with or without caching, with or without introspection,
 // depending on the request's compile-time attributes.
-// Called from function_request_impl::resolve().
-template<typename Req>
-cppcoro::task<typename Req::value_type>
+// Called from function_request_impl::resolve() (Shared == false) and
+// function_request_impl::resolve_shared() (Shared == true).
+template<bool Shared = false, typename Req>
+cppcoro::task<resolve_result_t<Req, Shared>>
 resolve_impl(
     local_context_intf& ctx, Req const& req, cache_record_lock* lock_ptr)
 {
+    auto resolve_uncached = [&]() {
+        if constexpr (Shared)
+        {
+            return make_shared_result(resolve_request_direct(ctx, req));
+        }
+        else
+        {
+            return resolve_request_direct(ctx, req);
+        }
+    };
     // Second decision: cached or not
     if constexpr (is_uncached(Req::caching_level))
     {
-        return resolve_request_direct(ctx, req);
+        return resolve_uncached();
     }
     else
     {
         if (!ctx.get_resources().support_caching())
         {
             // No caching in contained mode
-            return resolve_request_direct(ctx, req);
+            return resolve_uncached();
         }
         auto& cac_ctx = cast_ctx_to_ref<caching_context_intf>(ctx);
-        return resolve_request_cached(cac_ctx, req, lock_ptr);
+        return resolve_request_cached<Shared>(cac_ctx, req, lock_ptr);
     }
 }
 
@@ -16,6 +16,7 @@
 #include <cradle/inner/introspection/tasklet.h>
 #include <cradle/inner/requests/cast_ctx.h>
 #include <cradle/inner/requests/generic.h>
+#include <cradle/inner/resolve/prefetch.h>
 #include <cradle/inner/resolve/remote.h>
 #include <cradle/inner/resolve/util.h>
 #include <cradle/inner/service/resources.h>
@@ -26,7 +27,8 @@
 /*
  * Service resolving a request to a value
  *
- * The public interface is resolve_request().
+ * The public interface is resolve_request(), with variants
+ * resolve_request_shared() and resolve_request_prefetched().
  */
 
 namespace cradle {
@@ -120,8 +122,8 @@ cppcoro::task<Val> resolve_request_local(
     co_return val;
 }
 
-template<Request Req, typename Constraints>
-cppcoro::task<typename Req::value_type>
+template<bool Shared, Request Req, typename Constraints>
+cppcoro::task<resolve_result_t<Req, Shared>>
 resolve_request_local(
     local_context_intf& ctx,
     Req const& req,
@@ -169,20 +171,42 @@ resolve_request_local(
         }
     }
 
-    return req.resolve(*new_ctx, lock_ptr);
+    if constexpr (!Shared)
+    {
+        return req.resolve(*new_ctx, lock_ptr);
+    }
+    else if constexpr (requires { req.resolve_shared(*new_ctx, lock_ptr); })
+    {
+        return req.resolve_shared(*new_ctx, lock_ptr);
+    }
+    else
+    {
+        // E.g. a value_request
+        return make_shared_result(req.resolve(*new_ctx, lock_ptr));
+    }
 }
 
-template<Request Req>
-cppcoro::task<typename Req::value_type>
+template<bool Shared, Request Req>
+cppcoro::task<resolve_result_t<Req, Shared>>
 resolve_request_remote_coro(
     remote_context_intf& ctx, Req const& req, cache_record_lock* lock_ptr)
 {
     // This runs in co_await resolve_request().
-    co_return resolve_remote_to_value(ctx, req, lock_ptr);
+    // A remote result is deserialized into a new value, so there is nothing
+    // to share.
+    if constexpr (Shared)
+    {
+        co_return std::make_shared<typename Req::value_type const>(
+            co_await resolve_remote_to_value(ctx, req, lock_ptr));
+    }
+    else
+    {
+        co_return co_await resolve_remote_to_value(ctx, req, lock_ptr);
+    }
 }
 
-template<Request Req>
-cppcoro::task<typename Req::value_type>
+template<bool Shared, Request Req>
+cppcoro::task<resolve_result_t<Req, Shared>>
 resolve_request_remote(
     remote_context_intf& ctx, Req const& req, cache_record_lock* lock_ptr)
 {
@@ -191,14 +215,15 @@ resolve_request_remote(
         // (Re-)create ctx tree and root ctx
         owner->prepare_for_remote_resolution();
     }
-    return resolve_request_remote_coro(ctx, req, lock_ptr);
+    return resolve_request_remote_coro<Shared>(ctx, req, lock_ptr);
 }
 
 template<
+    bool Shared,
     Context Ctx,
     Request Req,
     typename Constraints = DefaultResolutionConstraints<Ctx>>
-cppcoro::task<typename Req::value_type>
+cppcoro::task<resolve_result_t<Req, Shared>>
 resolve_request_one_try(
     Ctx& ctx,
     Req const& req,
@@ -213,14 +238,12 @@ resolve_request_one_try(
         // TODO if ctx is local and preparing, this throws without failing
         // ctx's preparation, leading to hangups
         auto& rem_ctx{cast_ctx_to_ref<remote_context_intf>(ctx)};
-        return resolve_request_remote(rem_ctx, req, lock_ptr);
+        return resolve_request_remote<Shared>(rem_ctx, req, lock_ptr);
     }
     else if constexpr (constraints.force_local)
     {
-        // Call one of the two resolve_request_local() versions, depending on
-        // Req being a plain value or a Request
         auto& loc_ctx{cast_ctx_to_ref<local_context_intf>(ctx)};
-        return resolve_request_local(
+        return resolve_request_local<Shared>(
             loc_ctx, req, retrying, lock_ptr, constraints);
     }
     else
@@ -228,22 +251,23 @@ resolve_request_one_try(
         if (ctx.remotely())
         {
             auto& rem_ctx = cast_ctx_to_ref<remote_context_intf>(ctx);
-            return resolve_request_remote(rem_ctx, req, lock_ptr);
+            return resolve_request_remote<Shared>(rem_ctx, req, lock_ptr);
         }
         else
         {
             auto& loc_ctx{cast_ctx_to_ref<local_context_intf>(ctx)};
-            return resolve_request_local(
+            return resolve_request_local<Shared>(
                 loc_ctx, req, retrying, lock_ptr, constraints);
         }
     }
 }
 
 template<
+    bool Shared,
     Context Ctx,
     RetryableRequest Req,
     typename Constraints = DefaultResolutionConstraints<Ctx>>
-cppcoro::task<typename Req::value_type>
+cppcoro::task<resolve_result_t<Req, Shared>>
 resolve_request_with_retry(
     Ctx& ctx,
     Req const& req,
@@ -257,7 +281,7 @@ resolve_request_with_retry(
         std::chrono::milliseconds delay{};
         try
         {
-            co_return co_await resolve_request_one_try(
+            co_return co_await resolve_request_one_try<Shared>(
                 ctx, req, attempt > 0, lock_ptr, constraints);
         }
         catch (std::exception const& exc)
@@ -346,11 +370,13 @@ resolve_request(
 
     if constexpr (Req::retryable)
     {
-        return resolve_request_with_retry(ctx, req, lock_ptr, constraints);
+        return resolve_request_with_retry<false>(
+            ctx, req, lock_ptr, constraints);
     }
     else
     {
-        return resolve_request_one_try(ctx, req, false, lock_ptr, constraints);
+        return resolve_request_one_try<false>(
+            ctx, req, false, lock_ptr, constraints);
     }
 }
 
@@ -370,6 +396,83 @@ resolve_request(
     return resolve_request(ctx, req, constraints, lock_ptr);
 }
 
+/*
+ * Resolves a request like resolve_request(), but returns a shared pointer to
+ * the (immutable) value instead of a copy of it.
+ *
+ * If the request is resolved locally, and its result is stored in the memory
+ * cache, the pointer refers to the value in that cache; no copy is made, so
+ * the costs of a cache hit are independent of the size of the value.
+ * The value stays alive while the pointer exists, even if the cache record is
+ * evicted. In all other cases, the pointer refers to a newly created value.
+ */
+template<
+    Context Ctx,
+    Request Req,
+    typename Constraints = DefaultResolutionConstraints<Ctx>>
+cppcoro::task<std::shared_ptr<typename Req::value_type const>>
+resolve_request_shared(
+    Ctx& ctx,
+    Req const& req,
+    Constraints constraints = Constraints(),
+    cache_record_lock* lock_ptr = nullptr)
+{
+    static_assert(ValidContext<Ctx>);
+    static_assert(MatchingContextRequest<Ctx, Req>);
+    static_assert(MatchingContextConstraints<Ctx, Constraints>);
+    static_assert(MatchingRequestConstraints<Req, Constraints>);
+
+    if constexpr (Req::retryable)
+    {
+        return resolve_request_with_retry<true>(
+            ctx, req, lock_ptr, constraints);
+    }
+    else
+    {
+        return resolve_request_one_try<true>(
+            ctx, req, false, lock_ptr, constraints);
+    }
+}
+
+/*
+ * Resolves a request like resolve_request(), but first prefetches the values
+ * of all fully-cached requests in the request tree from the secondary cache,
+ * with a single read_many() call (see prefetch.h).
+ *
+ * This is worthwhile if the tree is likely to miss the memory cache, and the
+ * secondary cache has a high per-call latency (e.g., a remote cache). There
+ * is no prefetching if the request is resolved remotely.
+ */
+template<
+    Context Ctx,
+    Request Req,
+    typename Constraints = DefaultResolutionConstraints<Ctx>>
+cppcoro::task<typename Req::value_type>
+resolve_request_prefetched(
+    Ctx& ctx,
+    Req const& req,
+    Constraints constraints = Constraints(),
+    cache_record_lock* lock_ptr = nullptr)
+{
+    // The prefetched memory cache records stay alive until the request has
+    // been resolved.
+    prefetch_item_list prefetched;
+    if constexpr (
+        !constraints.force_remote
+        && requires { req.collect_prefetch_items(prefetched); })
+    {
+        auto& resources{ctx.get_resources()};
+        if (!ctx.remotely() && resources.support_caching())
+        {
+            prefetch_item_list items;
+            req.collect_prefetch_items(items);
+            prefetched = co_await prefetch_secondary_cached(
+                resources, std::move(items));
+        }
+    }
+    co_return co_await resolve_request(ctx, req, constraints, lock_ptr);
+}
+
 } // namespace cradle
 
 #endif
@@ -121,6 +121,24 @@ seri_registry::make_uuid_error_message(
     return oss.str();
 }
 
+std::unordered_set<std::string>
+seri_registry::get_catalog_uuids(catalog_id cat_id)
+{
+    std::scoped_lock lock{mutex_};
+    std::unordered_set<std::string> result;
+    for (auto const& [uuid_str, inner_list] : entries_)
+    {
+        for (auto const& entry : inner_list)
+        {
+            if (entry.cat_id == cat_id)
+            {
+                result.insert(uuid_str);
+            }
+        }
+    }
+    return result;
+}
+
 std::size_t
 seri_registry::size() const
 {
@@ -7,6 +7,7 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <spdlog/spdlog.h>
 
@@ -108,6 +109,10 @@ class seri_registry
     void
     unregister_catalog(catalog_id cat_id);
 
+    // Returns the uuids registered by the given catalog.
+    std::unordered_set<std::string>
+    get_catalog_uuids(catalog_id cat_id);
+
     // Creates a function_request_impl object whose class derives from Intf,
     // if Intf is a function_request_intf instantiation.
     // Creates a proxy_request_impl object whose class derives from Intf,
@@ -1,7 +1,9 @@
+#include <cstdint>
 #include <regex>
 
 #include <cradle/inner/requests/cast_ctx.h>
 #include <cradle/inner/requests/generic.h>
+#include <cradle/inner/requests/serialization.h>
 #include <cradle/inner/requests/uuid.h>
 #include <cradle/inner/resolve/remote.h>
 #include <cradle/inner/resolve/seri_registry.h>
@@ -13,7 +15,7 @@ namespace cradle {
 namespace {
 
 std::string
-extract_uuid_str(std::string const& seri_req)
+extract_uuid_str_from_json(std::string const& seri_req)
 {
     // The uuid appears in the JSON like
     //   "uuid": "rq_retrieve_immutable_object_func+gb6df901-dirty"
@@ -27,6 +29,73 @@ extract_uuid_str(std::string const& seri_req)
     return deproxy_uuid_str(match[1].str());
 }
 
+std::string
+extract_uuid_str_from_msgpack(std::string const& seri_req)
+{
+    // The request is a msgpack array whose first element is the uuid string.
+    // Decoding just the headers is much cheaper than unpacking the entire
+    // request (which would also require the request's type).
+    auto const* data = reinterpret_cast<uint8_t const*>(seri_req.data());
+    std::size_t size{seri_req.size()};
+    std::size_t pos{0};
+    auto read_be = [&](std::size_t num_bytes) {
+        if (pos + num_bytes > size)
+        {
+            throw uuid_error{"truncated msgpack request"};
+        }
+        std::size_t result{0};
+        for (std::size_t i = 0; i < num_bytes; ++i)
+        {
+            result = (result << 8) | data[pos++];
+        }
+        return result;
+    };
+    // Array header: fixarray, array 16 or array 32
+    auto array_tag = read_be(1);
+    if (array_tag == 0xdc)
+    {
+        read_be(2);
+    }
+    else if (array_tag == 0xdd)
+    {
+        read_be(4);
+    }
+    else if ((array_tag & 0xf0) != 0x90)
+    {
+        throw uuid_error{"msgpack request is not an array"};
+    }
+    // String header: fixstr, str 8, str 16 or str 32
+    auto str_tag = read_be(1);
+    std::size_t str_size{};
+    if ((str_tag & 0xe0) == 0xa0)
+    {
+        str_size = str_tag & 0x1f;
+    }
+    else if (str_tag >= 0xd9 && str_tag <= 0xdb)
+    {
+        str_size = read_be(std::size_t{1} << (str_tag - 0xd9));
+    }
+    else
+    {
+        throw uuid_error{"no uuid found in msgpack request"};
+    }
+    if (pos + str_size > size)
+    {
+        throw uuid_error{"truncated msgpack request"};
+    }
+    return deproxy_uuid_str(seri_req.substr(pos, str_size));
+}
+
+std::string
+extract_uuid_str(std::string const& seri_req)
+{
+    if (detect_request_format(seri_req) == request_format::json)
+    {
+        return extract_uuid_str_from_json(seri_req);
+    }
+    return extract_uuid_str_from_msgpack(seri_req);
+}
+
 } // namespace
 
 cppcoro::task<serialized_result>
@@ -35,7 +104,8 @@ resolve_serialized_remote(
     std::string seri_req,
     seri_cache_record_lock_t seri_lock)
 {
-    co_return resolve_remote(ctx, std::move(seri_req), seri_lock.lock_ptr);
+    co_return co_await resolve_remote(
+        ctx, std::move(seri_req), seri_lock.lock_ptr);
 }
 
 cppcoro::task<serialized_result>
@@ -1,7 +1,9 @@
 #ifndef CRADLE_INNER_RESOLVE_UTIL_H
 #define CRADLE_INNER_RESOLVE_UTIL_H
 
+#include <memory>
 #include <string>
+#include <utility>
 
 #include <cppcoro/task.hpp>
 
@@ -35,6 +37,15 @@ dummy_coroutine()
     co_return;
 }
 
+// Wraps a task resolving to a value in one resolving to a shared pointer to
+// that value. For results that do not come from the memory cache.
+template<typename Value>
+cppcoro::task<std::shared_ptr<Value const>>
+make_shared_result(cppcoro::task<Value> task)
+{
+    co_return std::make_shared<Value const>(co_await std::move(task));
+}
+
 cppcoro::task<serialized_result>
 resolve_serialized_introspective(
     introspective_context_intf& ctx,
@@ -9,8 +9,10 @@
 #include <cradle/inner/blob_file/blob_file.h>
 #include <cradle/inner/blob_file/blob_file_dir.h>
 #include <cradle/inner/caching/immutable/cache.h>
+#include <cradle/inner/caching/immutable/eviction.h>
 #include <cradle/inner/core/monitoring.h>
 #include <cradle/inner/core/type_definitions.h>
+#include <cradle/inner/core/unique_hash.h>
 #include <cradle/inner/fs/file_io.h>
 #include <cradle/inner/fs/types.h>
 #include <cradle/inner/fs/utilities.h>
@@ -20,6 +22,7 @@
 #include <cradle/inner/remote/async_db.h>
 #include <cradle/inner/remote/proxy.h>
 #include <cradle/inner/requests/domain.h>
+#include <cradle/inner/requests/interning.h>
 #include <cradle/inner/service/resources.h>
 #include <cradle/inner/service/resources_impl.h>
 #include <cradle/inner/service/secondary_storage_intf.h>
@@ -34,7 +37,11 @@ make_immutable_cache_config(service_config const& config)
 {
     return immutable_cache_config{
         .unused_size_limit = config.get_number_or_default(
-            inner_config_keys::MEMORY_CACHE_UNUSED_SIZE_LIMIT, 0x40'00'00'00)};
+            inner_config_keys::MEMORY_CACHE_UNUSED_SIZE_LIMIT, 0x40'00'00'00),
+        .num_shards = static_cast<int>(config.get_number_or_default(
+            inner_config_keys::MEMORY_CACHE_NUM_SHARDS, 16)),
+        .eviction_policy = make_eviction_policy(config.get_string_or_default(
+            inner_config_keys::MEMORY_CACHE_EVICTION_POLICY, "lru"))};
 }
 
 static std::unique_ptr<cradle::immutable_cache>
@@ -51,9 +58,16 @@ create_memory_cache(service_config const& config)
 
 static inner_resources* current_inner_resources{nullptr};
 
+// Set by current_inner_resources_scope; overrides current_inner_resources
+static thread_local inner_resources* scoped_inner_resources{nullptr};
+
 inner_resources&
 get_current_inner_resources()
 {
+    if (scoped_inner_resources)
+    {
+        return *scoped_inner_resources;
+    }
     if (!current_inner_resources)
     {
         throw std::logic_error{"no current_inner_resources"};
@@ -61,6 +75,18 @@ get_current_inner_resources()
     return *current_inner_resources;
 }
 
+current_inner_resources_scope::current_inner_resources_scope(
+    inner_resources& resources)
+    : previous_{scoped_inner_resources}
+{
+    scoped_inner_resources = &resources;
+}
+
+current_inner_resources_scope::~current_inner_resources_scope()
+{
+    scoped_inner_resources = previous_;
+}
+
 inner_resources::inner_resources(service_config const& config)
     : impl_{std::make_unique<inner_resources_impl>(*this, config)}
 {
@@ -200,16 +226,21 @@ inner_resources::http_connection_for_thread()
 
 cppcoro::task<http_response>
 inner_resources::async_http_request(
-    http_request request, tasklet_tracker* client)
+    http_request request, tasklet_tracker* client, schedule_hint hint)
 {
     auto& impl{*impl_};
     std::ostringstream s;
     s << "HTTP: " << request.method << " " << request.url;
     auto tasklet
         = create_tasklet_tracker(the_tasklet_admin(), "HTTP", s.str(), client);
+    if (auto* engine = impl.http_engine_for(request))
+    {
+        tasklet_run tasklet_run(tasklet);
+        co_return co_await engine->perform_request(std::move(request), hint);
+    }
     if (!impl.http_is_synchronous_)
     {
-        co_await impl.http_pool_.schedule();
+        co_await impl.http_pool_.schedule(hint);
     }
     tasklet_run tasklet_run(tasklet);
     null_check_in check_in;
@@ -254,7 +285,7 @@ inner_resources::get_async_db()
     return impl_->the_async_db_.get();
 }
 
-cppcoro::static_thread_pool&
+work_stealing_pool&
 inner_resources::get_async_thread_pool()
 {
     return impl_->async_pool_;
@@ -328,6 +359,12 @@ inner_resources::get_seri_registry()
     return impl_->the_seri_registry_;
 }
 
+request_intern_table*
+inner_resources::get_request_intern_table()
+{
+    return impl_->request_intern_table_.get();
+}
+
 seri_cache_record_lock_t
 inner_resources::alloc_cache_record_lock()
 {
@@ -378,6 +415,12 @@ inner_resources::free_contained_proxy(
     impl_->contained_proxy_pool_.free_proxy(std::move(proxy), succeeded);
 }
 
+contained_proxy_pool_info
+inner_resources::get_contained_proxy_pool_info() const
+{
+    return impl_->contained_proxy_pool_.get_info();
+}
+
 int
 inner_resources::get_num_contained_calls() const
 {
@@ -400,10 +443,24 @@ io_svc_func(inner_resources_impl& impl)
     logger.info("io_svc_func stop; got {} events", num_events);
 }
 
+static std::unique_ptr<unique_hash_scheme_claim>
+claim_unique_hash_scheme(service_config const& config)
+{
+    auto hash_scheme{
+        config.get_optional_string(inner_config_keys::UNIQUE_HASH_SCHEME)};
+    if (!hash_scheme)
+    {
+        return nullptr;
+    }
+    return std::make_unique<unique_hash_scheme_claim>(
+        parse_unique_hash_scheme(*hash_scheme));
+}
+
 inner_resources_impl::inner_resources_impl(
     inner_resources& wrapper, service_config const& config)
     : config_{config},
       logger_{ensure_logger("svc")},
+      hash_scheme_claim_{claim_unique_hash_scheme(config)},
       memory_cache_{create_memory_cache(config)},
       blob_dir_{std::make_unique<blob_file_directory>(config)},
       the_seri_registry_{std::make_unique<seri_registry>()},
@@ -411,13 +468,23 @@ inner_resources_impl::inner_resources_impl(
       the_tasklet_admin_{config.get_bool_or_default(
           introspection_config_keys::FORCE_FINISH, false)},
       io_svc_thread_{io_svc_func, std::ref(*this)},
-      http_pool_{cppcoro::static_thread_pool(
+      http_pool_{
           static_cast<uint32_t>(config.get_number_or_default(
-              inner_config_keys::HTTP_CONCURRENCY, 36)))},
-      async_pool_{cppcoro::static_thread_pool(
+              inner_config_keys::HTTP_CONCURRENCY, 36)),
           static_cast<uint32_t>(config.get_number_or_default(
-              inner_config_keys::ASYNC_CONCURRENCY, 20)))}
+              inner_config_keys::HTTP_INTERACTIVE_THREADS, 0))},
+      async_pool_{
+          static_cast<uint32_t>(config.get_number_or_default(
+              inner_config_keys::ASYNC_CONCURRENCY, 20)),
+          static_cast<uint32_t>(config.get_number_or_default(
+              inner_config_keys::ASYNC_INTERACTIVE_THREADS, 0))},
+      contained_proxy_pool_{config}
 {
+    if (config.get_bool_or_default(
+            inner_config_keys::REQUEST_INTERNING, false))
+    {
+        request_intern_table_ = std::make_unique<request_intern_table>();
+    }
 }
 
 inner_resources_impl::~inner_resources_impl()
@@ -446,6 +513,13 @@ inner_resources_impl::check_support_caching()
     }
 }
 
+static http_request_system&
+the_http_request_system()
+{
+    static http_request_system the_system;
+    return the_system;
+}
+
 http_connection_interface&
 inner_resources_impl::http_connection_for_thread(http_request const* request)
 {
@@ -464,10 +538,33 @@ inner_resources_impl::http_connection_for_thread(http_request const* request)
     }
     else
     {
-        static http_request_system the_system;
-        thread_local http_connection the_connection(the_system);
+        thread_local http_connection the_connection(
+            the_http_request_system());
         return the_connection;
     }
 }
 
+async_http_engine*
+inner_resources_impl::http_engine_for(http_request const& request)
+{
+    if ((mock_http_ && mock_http_->enabled_for(request))
+        || !config_.get_bool_or_default(
+            inner_config_keys::HTTP_ASYNC_ENGINE, true))
+    {
+        return nullptr;
+    }
+    std::call_once(http_engine_once_, [this] {
+        async_http_engine_config engine_config;
+        engine_config.max_host_connections = config_.get_number_or_default(
+            inner_config_keys::HTTP_MAX_HOST_CONNECTIONS,
+            engine_config.max_host_connections);
+        engine_config.http2_prior_knowledge = config_.get_bool_or_default(
+            inner_config_keys::HTTP2_PRIOR_KNOWLEDGE,
+            engine_config.http2_prior_knowledge);
+        http_engine_ = std::make_unique<async_http_engine>(
+            the_http_request_system(), engine_config, http_pool_);
+    });
+    return http_engine_.get();
+}
+
 } // namespace cradle
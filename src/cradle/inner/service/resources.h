@@ -13,17 +13,20 @@
 #include <cradle/inner/remote/types.h>
 #include <cradle/inner/resolve/seri_lock.h>
 #include <cradle/inner/service/config.h>
+#include <cradle/inner/service/work_stealing_pool.h>
 
 namespace cradle {
 
 class async_db;
 class blob_file_writer;
+struct contained_proxy_pool_info;
 class dll_collection;
 class domain;
 struct immutable_cache;
 class inner_resources_impl;
 struct mock_http_session;
 class remote_proxy;
+class request_intern_table;
 class rpclib_client;
 class secondary_storage_intf;
 class seri_registry;
@@ -39,6 +42,17 @@ struct inner_config_keys
     inline static std::string const MEMORY_CACHE_UNUSED_SIZE_LIMIT{
         "memory_cache/unused_size_limit"};
 
+    // (Optional integer)
+    // The number of independently locked shards in the memory cache.
+    inline static std::string const MEMORY_CACHE_NUM_SHARDS{
+        "memory_cache/num_shards"};
+
+    // (Optional string)
+    // The memory cache eviction policy: "lru" (default), "gdsf" or
+    // "w_tinylfu".
+    inline static std::string const MEMORY_CACHE_EVICTION_POLICY{
+        "memory_cache/eviction_policy"};
+
     // (Optional string)
     // Specifies the factory to use to create a secondary cache implementation.
     // The string should equal a key passed to
@@ -49,13 +63,57 @@ struct inner_config_keys
         "secondary_cache/factory"};
 
     // (Optional integer)
-    // How many concurrent threads to use for HTTP requests
+    // How many concurrent threads to use for HTTP requests; with the async
+    // HTTP engine, for processing HTTP responses
     inline static std::string const HTTP_CONCURRENCY{"http_concurrency"};
 
+    // (Optional integer)
+    // How many of the HTTP threads are reserved for interactive requests
+    inline static std::string const HTTP_INTERACTIVE_THREADS{
+        "http_interactive_threads"};
+
+    // (Optional boolean)
+    // Whether to perform HTTP requests on a single async engine thread that
+    // multiplexes them over persistent connections (default), rather than
+    // on a thread per request
+    inline static std::string const HTTP_ASYNC_ENGINE{"http_async_engine"};
+
+    // (Optional integer)
+    // The maximum number of connections that the async HTTP engine opens to
+    // a single host
+    inline static std::string const HTTP_MAX_HOST_CONNECTIONS{
+        "http_max_host_connections"};
+
+    // (Optional boolean)
+    // Whether the async HTTP engine requests http:// URLs over HTTP/2
+    // without negotiation (h2c); all servers must support this
+    inline static std::string const HTTP2_PRIOR_KNOWLEDGE{
+        "http2_prior_knowledge"};
+
     // (Optional integer)
     // How many concurrent threads to use for locally resolving asynchronous
-    // requests in parallel
+    // requests in parallel; these threads steal work from each other
     inline static std::string const ASYNC_CONCURRENCY{"async_concurrency"};
+
+    // (Optional integer)
+    // How many of the async threads are reserved for interactive requests
+    inline static std::string const ASYNC_INTERACTIVE_THREADS{
+        "async_interactive_threads"};
+
+    // (Optional string)
+    // The scheme for calculating unique hashes (disk cache keys and
+    // digests): "sha256" (default), "sha256_chunked" or "blake3".
+    // All processes sharing a disk cache should use the same scheme.
+    // The scheme is process-wide: creating resources specifying a scheme
+    // throws while other live resources specify a different one.
+    inline static std::string const UNIQUE_HASH_SCHEME{"unique_hash_scheme"};
+
+    // (Optional boolean)
+    // Whether the resources provide a table for interning function requests,
+    // so that equal requests share their implementation objects (default
+    // false). Only requests created inside a request_interning_scope for the
+    // table are interned.
+    inline static std::string const REQUEST_INTERNING{"request_interning"};
 };
 
 /*
@@ -151,9 +209,13 @@ class inner_resources
     http_connection_interface&
     http_connection_for_thread();
 
+    // hint determines the order in which pending requests are dispatched
+    // to the HTTP thread pool.
     cppcoro::task<http_response>
     async_http_request(
-        http_request request, tasklet_tracker* client = nullptr);
+        http_request request,
+        tasklet_tracker* client = nullptr,
+        schedule_hint hint = {});
 
     // Set up HTTP mocking.
     // This returns the mock_http_session that's been associated with these
@@ -176,7 +238,9 @@ class inner_resources
     async_db*
     get_async_db();
 
-    cppcoro::static_thread_pool&
+    // Returns the pool on which subrequests of asynchronous requests are
+    // resolved.
+    work_stealing_pool&
     get_async_thread_pool();
 
     void
@@ -198,6 +262,11 @@ class inner_resources
     std::shared_ptr<seri_registry>
     get_seri_registry();
 
+    // Returns the table for interning function requests; nullptr if
+    // interning is disabled (see inner_config_keys::REQUEST_INTERNING).
+    request_intern_table*
+    get_request_intern_table();
+
     // Allocates an object that can lock a memory cache record.
     // Will be called only on a server; the client will use the record_id
     // member in the returned value to identify the record.
@@ -221,6 +290,9 @@ class inner_resources
     void
     free_contained_proxy(std::unique_ptr<rpclib_client> proxy, bool succeeded);
 
+    contained_proxy_pool_info
+    get_contained_proxy_pool_info() const;
+
     // Retrieve the total number of contained calls initiated through these
     // resources (so failed contained calls also count).
     int
@@ -236,8 +308,9 @@ class inner_resources
 // Returns a best-effort reference to a "current resources" object; throws if
 // no such object exists.
 //
-// If more than one inner_resources object is alive, the function may not
-// return the intended one.
+// Inside a current_inner_resources_scope, returns that scope's resources.
+// Otherwise, if more than one inner_resources object is alive, the function
+// may not return the intended one.
 //
 // The function should not be called unless really necessary. This necessity
 // exists for deserializing a msgpack-encoded function_request object: a
@@ -248,6 +321,28 @@ class inner_resources
 inner_resources&
 get_current_inner_resources();
 
+// Makes get_current_inner_resources() return resources on the current thread,
+// for the lifetime of this object. This is how a function that was passed
+// the resources (e.g., function_request::deserialize_msgpack()) hands them
+// over to the msgpack unpacking code.
+class current_inner_resources_scope
+{
+ public:
+    current_inner_resources_scope(inner_resources& resources);
+
+    ~current_inner_resources_scope();
+
+    current_inner_resources_scope(current_inner_resources_scope const&)
+        = delete;
+
+    current_inner_resources_scope&
+    operator=(current_inner_resources_scope const&)
+        = delete;
+
+ private:
+    inner_resources* previous_;
+};
+
 } // namespace cradle
 
 #endif
@@ -10,15 +10,17 @@
 #include <unordered_map>
 
 #include <cppcoro/io_service.hpp>
-#include <cppcoro/static_thread_pool.hpp>
 #include <spdlog/spdlog.h>
 
+#include <cradle/inner/core/unique_hash.h>
 #include <cradle/inner/dll/dll_collection.h>
 #include <cradle/inner/introspection/tasklet_impl.h>
 #include <cradle/inner/io/http_requests.h>
 #include <cradle/inner/remote/types.h>
+#include <cradle/inner/requests/interning.h>
 #include <cradle/inner/resolve/seri_registry.h>
 #include <cradle/inner/service/config.h>
+#include <cradle/inner/service/work_stealing_pool.h>
 #include <cradle/rpclib/client/contained_proxy_pool.h>
 
 namespace cradle {
@@ -64,9 +66,19 @@ class inner_resources_impl
     http_connection_interface&
     http_connection_for_thread(http_request const* request);
 
+    // Returns the async HTTP engine to use for request, or nullptr if the
+    // request should be performed on a connection from
+    // http_connection_for_thread().
+    async_http_engine*
+    http_engine_for(http_request const& request);
+
     std::mutex mutex_;
     service_config config_;
     std::shared_ptr<spdlog::logger> logger_;
+    // Set if config_ specifies a unique hash scheme; claimed before any
+    // thread is started, so that a conflicting scheme fails construction
+    // cleanly
+    std::unique_ptr<unique_hash_scheme_claim> hash_scheme_claim_;
     std::unique_ptr<immutable_cache> memory_cache_;
     std::unique_ptr<secondary_storage_intf> secondary_cache_;
     std::map<std::string, std::unique_ptr<secondary_storage_intf>>
@@ -80,6 +92,9 @@ class inner_resources_impl
     // seri_catalog's, which could be owned (at least) by domain and
     // dll_collection objects.
     std::shared_ptr<seri_registry> the_seri_registry_;
+    // Set if request interning is enabled. Unloading a DLL purges its
+    // entries, so this must outlive the_dlls_.
+    std::unique_ptr<request_intern_table> request_intern_table_;
     dll_collection the_dlls_;
     remote_cache_record_id next_remote_record_id_{
         remote_cache_record_id::first_tag{}};
@@ -93,8 +108,14 @@ class inner_resources_impl
     cppcoro::io_service io_svc_;
     std::jthread io_svc_thread_;
 
-    cppcoro::static_thread_pool http_pool_;
-    cppcoro::static_thread_pool async_pool_;
+    // Both pools resume interactive work before other work, and may reserve
+    // threads for it.
+    work_stealing_pool http_pool_;
+    work_stealing_pool async_pool_;
+
+    // Created on first use; destroyed before http_pool_, its completion pool
+    std::unique_ptr<async_http_engine> http_engine_;
+    std::once_flag http_engine_once_;
 
     std::unique_ptr<mock_http_session> mock_http_;
 
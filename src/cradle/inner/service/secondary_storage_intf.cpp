@@ -0,0 +1,39 @@
+#include <cradle/inner/service/secondary_storage_intf.h>
+
+namespace cradle {
+
+cppcoro::task<std::vector<std::optional<blob>>>
+secondary_storage_intf::read_many(std::vector<std::string> keys)
+{
+    std::vector<std::optional<blob>> results;
+    results.reserve(keys.size());
+    for (auto& key : keys)
+    {
+        results.push_back(co_await read(std::move(key)));
+    }
+    co_return results;
+}
+
+cppcoro::task<void>
+secondary_storage_intf::write_many(
+    std::vector<std::pair<std::string, blob>> entries)
+{
+    for (auto& [key, value] : entries)
+    {
+        co_await write(std::move(key), std::move(value));
+    }
+}
+
+cppcoro::task<std::vector<bool>>
+secondary_storage_intf::contains_many(std::vector<std::string> keys)
+{
+    std::vector<bool> results;
+    results.reserve(keys.size());
+    for (auto& key : keys)
+    {
+        results.push_back((co_await read(std::move(key))).has_value());
+    }
+    co_return results;
+}
+
+} // namespace cradle
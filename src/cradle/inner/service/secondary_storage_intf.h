@@ -6,6 +6,8 @@
 
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <cppcoro/task.hpp>
 
@@ -41,6 +43,27 @@ class secondary_storage_intf
     virtual cppcoro::task<void>
     write(std::string key, blob value) = 0;
 
+    // Batched operations
+    //
+    // The default implementations perform one single-key operation per key.
+    // An implementation should override them if it can do better, e.g. by
+    // using a single database transaction, or by overlapping network round
+    // trips.
+
+    // Reads the serialized values for keys; result[i] corresponds to keys[i],
+    // and is std::nullopt if that value is not in the storage.
+    virtual cppcoro::task<std::vector<std::optional<blob>>>
+    read_many(std::vector<std::string> keys);
+
+    // Writes serialized values under the given keys (first in each pair).
+    // Same error semantics as write().
+    virtual cppcoro::task<void>
+    write_many(std::vector<std::pair<std::string, blob>> entries);
+
+    // Returns, for each key, whether the storage has a value for it.
+    virtual cppcoro::task<std::vector<bool>>
+    contains_many(std::vector<std::string> keys);
+
     // Returns true if this storage medium allows a serialized value to
     // contain references to blob files.
     // If this returns false, a write() caller should ensure that any blob
@@ -0,0 +1,237 @@
+#include <algorithm>
+
+#include <cradle/inner/service/work_stealing_pool.h>
+
+namespace cradle {
+
+namespace {
+
+// Identifies the pool and worker that the current thread belongs to, if any
+thread_local work_stealing_pool* current_pool{nullptr};
+thread_local std::size_t current_worker_ix{0};
+
+} // namespace
+
+work_stealing_pool::work_stealing_pool(
+    std::uint32_t num_threads, std::uint32_t num_reserved_threads)
+{
+    if (num_threads == 0)
+    {
+        num_threads = 1;
+    }
+    num_reserved_ = std::min(num_reserved_threads, num_threads - 1);
+    workers_.reserve(num_threads);
+    for (std::uint32_t i = 0; i < num_threads; ++i)
+    {
+        workers_.push_back(std::make_unique<worker>());
+        workers_.back()->reserved = i < num_reserved_;
+    }
+    // Start the threads only when all deques exist, as they may steal from
+    // each other.
+    for (std::size_t ix = 0; ix < workers_.size(); ++ix)
+    {
+        workers_[ix]->thread = std::thread{[this, ix] { run_worker(ix); }};
+    }
+}
+
+work_stealing_pool::~work_stealing_pool()
+{
+    {
+        std::scoped_lock lock{sleep_mutex_};
+        stopping_ = true;
+    }
+    wake_up_.notify_all();
+    wake_up_reserved_.notify_all();
+    for (auto& w : workers_)
+    {
+        w->thread.join();
+    }
+}
+
+void
+work_stealing_pool::enqueue(
+    std::coroutine_handle<> handle, schedule_hint hint)
+{
+    if (current_pool == this)
+    {
+        auto& w{*workers_[current_worker_ix]};
+        std::scoped_lock lock{w.mutex};
+        w.items.push_back(work_item{handle, hint, 0});
+    }
+    else
+    {
+        std::scoped_lock lock{shared_mutex_};
+        shared_items_.push(work_item{handle, hint, next_seqno_++});
+        num_shared_ += 1;
+    }
+    bool interactive{is_interactive(hint)};
+    if (interactive)
+    {
+        num_pending_interactive_ += 1;
+    }
+    num_pending_ += 1;
+    bool wake_normal{num_sleeping_ > 0};
+    bool wake_reserved{interactive && num_sleeping_reserved_ > 0};
+    if (wake_normal || wake_reserved)
+    {
+        // Taking the lock ensures that a worker that is about to sleep sees
+        // the increased counters, or receives the notification.
+        {
+            std::scoped_lock lock{sleep_mutex_};
+        }
+        if (wake_normal)
+        {
+            wake_up_.notify_one();
+        }
+        if (wake_reserved)
+        {
+            wake_up_reserved_.notify_one();
+        }
+    }
+}
+
+void
+work_stealing_pool::run_worker(std::size_t ix)
+{
+    current_pool = this;
+    current_worker_ix = ix;
+    while (!stopping_)
+    {
+        work_item item;
+        if (try_take(ix, item) || try_steal(ix, item))
+        {
+            item.handle.resume();
+        }
+        else
+        {
+            sleep_until_work(ix);
+        }
+    }
+}
+
+// Takes the most recently pushed item from the worker's own deque, unless the
+// shared queue has an item that should be resumed first.
+// A reserved worker takes interactive items only, so it skips any others in
+// its deque; these are left to be stolen.
+bool
+work_stealing_pool::try_take(std::size_t ix, work_item& item)
+{
+    auto& w{*workers_[ix]};
+    std::scoped_lock lock{w.mutex};
+    auto own{w.items.rbegin()};
+    if (w.reserved)
+    {
+        own = std::find_if(
+            w.items.rbegin(), w.items.rend(), [](auto const& candidate) {
+                return is_interactive(candidate.hint);
+            });
+    }
+    bool have_own{own != w.items.rend()};
+    if (num_shared_ > 0)
+    {
+        std::scoped_lock shared_lock{shared_mutex_};
+        if (!shared_items_.empty()
+            && (!w.reserved || is_interactive(shared_items_.top().hint))
+            && (!have_own || precedes(shared_items_.top().hint, own->hint)))
+        {
+            item = shared_items_.top();
+            shared_items_.pop();
+            num_shared_ -= 1;
+            on_taken(item);
+            return true;
+        }
+    }
+    if (!have_own)
+    {
+        return false;
+    }
+    item = *own;
+    w.items.erase(std::next(own).base());
+    on_taken(item);
+    return true;
+}
+
+// Takes the oldest item from another worker's deque; of the candidates from
+// all other workers, the one whose hint precedes the others. A reserved
+// worker's candidate is the oldest interactive item in a deque.
+bool
+work_stealing_pool::try_steal(std::size_t ix, work_item& item)
+{
+    bool reserved{workers_[ix]->reserved};
+    auto find_candidate = [&](worker& victim) {
+        if (!reserved)
+        {
+            return victim.items.begin();
+        }
+        return std::find_if(
+            victim.items.begin(), victim.items.end(), [](auto const& i) {
+                return is_interactive(i.hint);
+            });
+    };
+    auto num_workers{workers_.size()};
+    std::size_t best_ix{ix};
+    schedule_hint best_hint;
+    for (std::size_t i = 1; i < num_workers; ++i)
+    {
+        auto victim_ix{(ix + i) % num_workers};
+        auto& victim{*workers_[victim_ix]};
+        std::scoped_lock lock{victim.mutex};
+        auto it{find_candidate(victim)};
+        if (it != victim.items.end()
+            && (best_ix == ix || precedes(it->hint, best_hint)))
+        {
+            best_ix = victim_ix;
+            best_hint = it->hint;
+        }
+    }
+    if (best_ix == ix)
+    {
+        return false;
+    }
+    // The victim's deque may have changed in the meantime; if so, the
+    // candidate may be a different one, or there may be none.
+    auto& victim{*workers_[best_ix]};
+    std::scoped_lock lock{victim.mutex};
+    auto it{find_candidate(victim)};
+    if (it == victim.items.end())
+    {
+        return false;
+    }
+    item = *it;
+    victim.items.erase(it);
+    on_taken(item);
+    num_steals_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void
+work_stealing_pool::on_taken(work_item const& item)
+{
+    if (is_interactive(item.hint))
+    {
+        num_pending_interactive_ -= 1;
+    }
+    num_pending_ -= 1;
+}
+
+void
+work_stealing_pool::sleep_until_work(std::size_t ix)
+{
+    std::unique_lock lock{sleep_mutex_};
+    if (workers_[ix]->reserved)
+    {
+        num_sleeping_reserved_ += 1;
+        wake_up_reserved_.wait(lock, [this] {
+            return num_pending_interactive_ > 0 || stopping_;
+        });
+        num_sleeping_reserved_ -= 1;
+    }
+    else
+    {
+        num_sleeping_ += 1;
+        wake_up_.wait(lock, [this] { return num_pending_ > 0 || stopping_; });
+        num_sleeping_ -= 1;
+    }
+}
+
+} // namespace cradle
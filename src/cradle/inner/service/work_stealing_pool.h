@@ -0,0 +1,238 @@
+#ifndef CRADLE_INNER_SERVICE_WORK_STEALING_POOL_H
+#define CRADLE_INNER_SERVICE_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace cradle {
+
+// Priority classes for schedule_hint::priority. Other values are allowed;
+// anything at or above interactive counts as interactive.
+struct request_priority
+{
+    // Precomputations and other work that nobody is waiting for
+    static constexpr int background{-1};
+    static constexpr int normal{0};
+    // Work that a user (e.g., of the desktop app) is waiting for
+    static constexpr int interactive{1};
+};
+
+// Scheduling hints for the coroutines resolving a request (tree).
+// Work with a higher priority is resumed before work with a lower one; for
+// equal priorities, work with an earlier deadline goes first.
+struct schedule_hint
+{
+    int priority{request_priority::normal};
+    std::chrono::steady_clock::time_point deadline{
+        std::chrono::steady_clock::time_point::max()};
+};
+
+// Returns true if a should be resumed before b.
+inline bool
+precedes(schedule_hint const& a, schedule_hint const& b)
+{
+    if (a.priority != b.priority)
+    {
+        return a.priority > b.priority;
+    }
+    return a.deadline < b.deadline;
+}
+
+inline bool
+is_interactive(schedule_hint const& hint)
+{
+    return hint.priority >= request_priority::interactive;
+}
+
+/*
+ * A thread pool resuming coroutines, like cppcoro::static_thread_pool, but
+ * with a work-stealing scheduler:
+ * - Each worker thread has its own deque. A coroutine scheduled from a
+ *   worker thread is pushed onto that worker's deque; the worker resumes the
+ *   most recently pushed coroutine first, so subrequests tend to run on the
+ *   same thread as their parent (and the data they produce stays in its
+ *   caches).
+ * - An idle worker steals the oldest coroutine from another worker's deque;
+ *   in a request tree, that is the one closest to the root, so it likely
+ *   represents the largest amount of work. Of the other workers' oldest
+ *   coroutines, it takes the one whose schedule_hint precedes the others.
+ * - A coroutine scheduled from a thread outside the pool goes into a shared
+ *   queue, ordered by its schedule_hint. A worker prefers that queue over
+ *   its own deque if the former's first coroutine precedes the latter's.
+ * - Optionally, some workers are reserved for interactive work: they resume
+ *   only coroutines with an interactive schedule_hint, so that interactive
+ *   requests need not wait for background ones occupying all other
+ *   threads. A reserved worker may steal an interactive coroutine from
+ *   anywhere in another worker's deque.
+ *
+ * The deques are guarded by a mutex each; as the coroutines being scheduled
+ * resolve requests, contention on these locks is negligible.
+ */
+class work_stealing_pool
+{
+ public:
+    class schedule_operation
+    {
+     public:
+        schedule_operation(work_stealing_pool& pool, schedule_hint hint)
+            : pool_{pool}, hint_{hint}
+        {
+        }
+
+        bool
+        await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void
+        await_suspend(std::coroutine_handle<> awaiting_coroutine)
+        {
+            pool_.enqueue(awaiting_coroutine, hint_);
+        }
+
+        void
+        await_resume() const noexcept
+        {
+        }
+
+     private:
+        work_stealing_pool& pool_;
+        schedule_hint hint_;
+    };
+
+    // Starts num_threads worker threads, num_reserved_threads of which are
+    // reserved for interactive work. At least one thread is not reserved.
+    explicit work_stealing_pool(
+        std::uint32_t num_threads, std::uint32_t num_reserved_threads = 0);
+
+    // Stops and joins the worker threads; coroutines that were scheduled but
+    // did not start running yet, are not resumed.
+    ~work_stealing_pool();
+
+    work_stealing_pool(work_stealing_pool const&) = delete;
+    work_stealing_pool&
+    operator=(work_stealing_pool const&)
+        = delete;
+
+    std::uint32_t
+    thread_count() const noexcept
+    {
+        return static_cast<std::uint32_t>(workers_.size());
+    }
+
+    std::uint32_t
+    reserved_thread_count() const noexcept
+    {
+        return num_reserved_;
+    }
+
+    // Returns an awaitable that reschedules the awaiting coroutine on one of
+    // the pool's threads.
+    [[nodiscard]] schedule_operation
+    schedule(schedule_hint hint = {}) noexcept
+    {
+        return schedule_operation{*this, hint};
+    }
+
+    // Returns the number of coroutines resumed by a thread that stole them
+    // from another thread's deque.
+    std::uint64_t
+    get_num_steals() const noexcept
+    {
+        return num_steals_.load(std::memory_order_relaxed);
+    }
+
+ private:
+    struct work_item
+    {
+        std::coroutine_handle<> handle;
+        schedule_hint hint;
+        // Keeps the shared queue FIFO for equal hints
+        std::uint64_t seqno;
+    };
+
+    struct later_item
+    {
+        bool
+        operator()(work_item const& a, work_item const& b) const
+        {
+            if (precedes(a.hint, b.hint))
+            {
+                return false;
+            }
+            if (precedes(b.hint, a.hint))
+            {
+                return true;
+            }
+            return a.seqno > b.seqno;
+        }
+    };
+
+    struct worker
+    {
+        std::mutex mutex;
+        std::deque<work_item> items;
+        std::thread thread;
+        // If true, only resumes interactive work
+        bool reserved{false};
+    };
+
+    // The first num_reserved_ workers are the reserved ones.
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::uint32_t num_reserved_{0};
+
+    std::mutex shared_mutex_;
+    std::priority_queue<work_item, std::vector<work_item>, later_item>
+        shared_items_;
+    std::uint64_t next_seqno_{0};
+    // Lets workers skip locking shared_mutex_ while the queue is empty
+    std::atomic<std::size_t> num_shared_{0};
+
+    // Number of scheduled coroutines not yet taken by a worker
+    std::atomic<std::size_t> num_pending_{0};
+    // Number of those that are interactive
+    std::atomic<std::size_t> num_pending_interactive_{0};
+    std::atomic<std::uint64_t> num_steals_{0};
+
+    std::mutex sleep_mutex_;
+    // Wakes up non-reserved workers
+    std::condition_variable wake_up_;
+    std::atomic<int> num_sleeping_{0};
+    // Wakes up reserved workers
+    std::condition_variable wake_up_reserved_;
+    std::atomic<int> num_sleeping_reserved_{0};
+    std::atomic<bool> stopping_{false};
+
+    void
+    enqueue(std::coroutine_handle<> handle, schedule_hint hint);
+
+    void
+    run_worker(std::size_t ix);
+
+    bool
+    try_take(std::size_t ix, work_item& item);
+
+    bool
+    try_steal(std::size_t ix, work_item& item);
+
+    void
+    on_taken(work_item const& item);
+
+    void
+    sleep_until_work(std::size_t ix);
+};
+
+} // namespace cradle
+
+#endif
@@ -38,6 +38,7 @@ testing_request_context::make_config(bool need_record_lock) const
         {remote_config_keys::DOMAIN_NAME, the_domain_name},
         {remote_config_keys::NEED_RECORD_LOCK, need_record_lock},
     };
+    update_config_map_with_schedule_hint(config_map);
     if (!tasklets_.empty())
     {
         config_map.insert(std::pair{
@@ -50,7 +51,7 @@ testing_request_context::make_config(bool need_record_lock) const
 root_local_atst_context::root_local_atst_context(
     std::unique_ptr<local_tree_context_base> tree_ctx,
     service_config const& config)
-    : root_local_async_context_base{*tree_ctx},
+    : root_local_async_context_base{*tree_ctx, config},
       test_params_context_mixin{config},
       owning_tree_ctx_{std::move(tree_ctx)}
 {
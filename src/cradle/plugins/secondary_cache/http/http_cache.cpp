@@ -1,3 +1,4 @@
+#include <cppcoro/when_all.hpp>
 #include <fmt/format.h>
 
 #include <cradle/inner/core/exception.h>
@@ -64,6 +65,17 @@ make_cas_get_request(int port, std::string const& digest)
     return make_cache_get_request(port, "cas", digest);
 }
 
+http_request
+make_cas_head_request(int port, std::string const& digest)
+{
+    return http_request{
+        http_request_method::HEAD,
+        make_url(port, "cas", digest),
+        {{"Accept", "*/*"}},
+        blob(),
+        none};
+}
+
 http_request
 make_cache_put_request(
     int port,
@@ -171,6 +183,100 @@ http_cache_impl::write(std::string key, blob value)
     co_return;
 }
 
+cppcoro::task<std::vector<std::optional<blob>>>
+http_cache_impl::read_many(std::vector<std::string> keys)
+{
+    logger_->info("read_many ({} keys)", keys.size());
+    auto digests = co_await get_digests_via_http(keys);
+    std::vector<cppcoro::task<std::optional<blob>>> cas_tasks;
+    cas_tasks.reserve(digests.size());
+    for (auto& digest : digests)
+    {
+        cas_tasks.push_back(get_cas_blob_via_http(std::move(digest)));
+    }
+    co_return co_await cppcoro::when_all(std::move(cas_tasks));
+}
+
+cppcoro::task<std::vector<bool>>
+http_cache_impl::contains_many(std::vector<std::string> keys)
+{
+    logger_->info("contains_many ({} keys)", keys.size());
+    auto digests = co_await get_digests_via_http(keys);
+    std::vector<cppcoro::task<bool>> cas_tasks;
+    cas_tasks.reserve(digests.size());
+    for (auto& digest : digests)
+    {
+        cas_tasks.push_back(has_cas_blob_via_http(std::move(digest)));
+    }
+    co_return co_await cppcoro::when_all(std::move(cas_tasks));
+}
+
+// Looks up all keys in the AC, concurrently.
+cppcoro::task<std::vector<std::optional<std::string>>>
+http_cache_impl::get_digests_via_http(std::vector<std::string> const& keys)
+{
+    std::vector<cppcoro::task<std::optional<std::string>>> ac_tasks;
+    ac_tasks.reserve(keys.size());
+    for (auto const& key : keys)
+    {
+        ac_tasks.push_back(
+            get_string_via_http(make_ac_get_request(port_, key)));
+    }
+    co_return co_await cppcoro::when_all(std::move(ac_tasks));
+}
+
+cppcoro::task<std::optional<blob>>
+http_cache_impl::get_cas_blob_via_http(std::optional<std::string> digest)
+{
+    if (!digest)
+    {
+        co_return std::nullopt;
+    }
+    co_return co_await get_blob_via_http(
+        make_cas_get_request(port_, *digest));
+}
+
+// A HEAD request avoids transferring the value.
+cppcoro::task<bool>
+http_cache_impl::has_cas_blob_via_http(std::optional<std::string> digest)
+{
+    if (!digest)
+    {
+        co_return false;
+    }
+    auto response
+        = co_await get_blob_via_http(make_cas_head_request(port_, *digest));
+    co_return response.has_value();
+}
+
+// All CAS entries are written before any AC entry, so that a concurrent
+// reader never finds an AC entry without its CAS entry.
+cppcoro::task<void>
+http_cache_impl::write_many(std::vector<std::pair<std::string, blob>> entries)
+{
+    logger_->info("write_many ({} entries)", entries.size());
+    std::vector<std::string> digests;
+    std::vector<cppcoro::task<void>> cas_tasks;
+    digests.reserve(entries.size());
+    cas_tasks.reserve(entries.size());
+    for (auto& [key, value] : entries)
+    {
+        digests.push_back(get_unique_string_tmpl(value));
+        cas_tasks.push_back(put_via_http(
+            make_cas_put_request(port_, digests.back(), std::move(value))));
+    }
+    co_await cppcoro::when_all(std::move(cas_tasks));
+
+    std::vector<cppcoro::task<void>> ac_tasks;
+    ac_tasks.reserve(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        ac_tasks.push_back(put_via_http(make_ac_put_request(
+            port_, entries[i].first, std::move(digests[i]))));
+    }
+    co_await cppcoro::when_all(std::move(ac_tasks));
+}
+
 cppcoro::task<void>
 http_cache_impl::put_via_http(http_request query)
 {
@@ -215,4 +321,22 @@ http_cache::write(std::string key, blob value)
     return impl_->write(std::move(key), std::move(value));
 }
 
+cppcoro::task<std::vector<std::optional<blob>>>
+http_cache::read_many(std::vector<std::string> keys)
+{
+    return impl_->read_many(std::move(keys));
+}
+
+cppcoro::task<void>
+http_cache::write_many(std::vector<std::pair<std::string, blob>> entries)
+{
+    return impl_->write_many(std::move(entries));
+}
+
+cppcoro::task<std::vector<bool>>
+http_cache::contains_many(std::vector<std::string> keys)
+{
+    return impl_->contains_many(std::move(keys));
+}
+
 } // namespace cradle
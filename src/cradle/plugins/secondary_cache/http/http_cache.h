@@ -53,6 +53,17 @@ class http_cache : public secondary_storage_intf
     cppcoro::task<void>
     write(std::string key, blob value) override;
 
+    // The batched operations issue all HTTP requests for a phase (AC, then
+    // CAS) concurrently, so a batch costs two round trips, not two per key.
+    cppcoro::task<std::vector<std::optional<blob>>>
+    read_many(std::vector<std::string> keys) override;
+
+    cppcoro::task<void>
+    write_many(std::vector<std::pair<std::string, blob>> entries) override;
+
+    cppcoro::task<std::vector<bool>>
+    contains_many(std::vector<std::string> keys) override;
+
     bool
     allow_blob_files() const override
     {
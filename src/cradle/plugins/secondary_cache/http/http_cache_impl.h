@@ -4,6 +4,8 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <cppcoro/task.hpp>
 #include <spdlog/spdlog.h>
@@ -28,6 +30,15 @@ class http_cache_impl
     cppcoro::task<void>
     write(std::string key, blob value);
 
+    cppcoro::task<std::vector<std::optional<blob>>>
+    read_many(std::vector<std::string> keys);
+
+    cppcoro::task<void>
+    write_many(std::vector<std::pair<std::string, blob>> entries);
+
+    cppcoro::task<std::vector<bool>>
+    contains_many(std::vector<std::string> keys);
+
  private:
     inner_resources& resources_;
     int port_;
@@ -39,6 +50,15 @@ class http_cache_impl
     cppcoro::task<std::optional<blob>>
     get_blob_via_http(http_request query);
 
+    cppcoro::task<std::vector<std::optional<std::string>>>
+    get_digests_via_http(std::vector<std::string> const& keys);
+
+    cppcoro::task<std::optional<blob>>
+    get_cas_blob_via_http(std::optional<std::string> digest);
+
+    cppcoro::task<bool>
+    has_cas_blob_via_http(std::optional<std::string> digest);
+
     cppcoro::task<void>
     put_via_http(http_request query);
 };
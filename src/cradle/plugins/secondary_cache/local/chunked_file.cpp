@@ -0,0 +1,471 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <utility>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/when_all.hpp>
+#include <fmt/format.h>
+
+#include <cradle/inner/blob_file/blob_file.h>
+#include <cradle/inner/core/type_interfaces.h>
+#include <cradle/inner/encodings/lz4.h>
+#include <cradle/inner/encodings/zstd.h>
+#include <cradle/inner/fs/file_io.h>
+#include <cradle/inner/utilities/errors.h>
+#include <cradle/plugins/secondary_cache/local/chunked_file.h>
+
+namespace cradle {
+
+namespace {
+
+constexpr std::array<uint8_t, 4> magic{0x00, 'C', 'D', 'C'};
+constexpr uint8_t format_version{1};
+constexpr std::size_t header_size{32};
+// The compressed sizes in the chunk table are 32-bit.
+constexpr std::size_t max_chunk_size{std::size_t{1} << 30};
+
+using header_bytes = std::array<uint8_t, header_size>;
+
+template<typename T>
+void
+store_le(uint8_t* dst, T value)
+{
+    boost::endian::native_to_little_inplace(value);
+    std::memcpy(dst, &value, sizeof(T));
+}
+
+template<typename T>
+T
+load_le(uint8_t const* src)
+{
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    boost::endian::little_to_native_inplace(value);
+    return value;
+}
+
+[[noreturn]] void
+throw_chunked_file_error(file_path const& path, std::string const& msg)
+{
+    CRADLE_THROW(
+        chunked_file_error() << file_path_info(path)
+                             << internal_error_message_info(msg));
+}
+
+std::size_t
+max_compressed_size(disk_cache_codec codec, std::size_t original_size)
+{
+    return codec == disk_cache_codec::zstd
+               ? zstd::max_compressed_size(original_size)
+               : lz4::max_compressed_size(original_size);
+}
+
+std::size_t
+copy_stored(
+    void* dst, std::size_t dst_size, void const* src, std::size_t src_size)
+{
+    auto size = std::min(dst_size, src_size);
+    std::memcpy(dst, src, size);
+    return size;
+}
+
+std::size_t
+compress(
+    chunked_file_options const& options,
+    void* dst,
+    std::size_t dst_size,
+    void const* src,
+    std::size_t src_size)
+{
+    if (options.codec == disk_cache_codec::zstd)
+    {
+        return zstd::compress(dst, dst_size, src, src_size, options.level);
+    }
+    return lz4::compress(dst, dst_size, src, src_size);
+}
+
+std::size_t
+decompress(
+    disk_cache_codec codec,
+    void* dst,
+    std::size_t dst_size,
+    void const* src,
+    std::size_t src_size)
+{
+    switch (codec)
+    {
+        case disk_cache_codec::store:
+            return copy_stored(dst, dst_size, src, src_size);
+        case disk_cache_codec::zstd:
+            return zstd::decompress(dst, dst_size, src, src_size);
+        default:
+            return lz4::decompress(dst, dst_size, src, src_size);
+    }
+}
+
+// This is a coroutine so takes its arguments by value.
+cppcoro::task<byte_vector>
+compress_chunk(
+    cppcoro::static_thread_pool& pool,
+    chunked_file_options options,
+    std::byte const* src,
+    std::size_t src_size)
+{
+    co_await pool.schedule();
+    byte_vector compressed(max_compressed_size(options.codec, src_size));
+    compressed.resize(compress(
+        options, compressed.data(), compressed.size(), src, src_size));
+    co_return compressed;
+}
+
+// This is a coroutine so takes its arguments by value.
+cppcoro::task<void>
+decompress_chunks(
+    cppcoro::static_thread_pool& pool,
+    chunked_file_reader const& reader,
+    std::size_t first,
+    std::size_t last,
+    void* dst)
+{
+    co_await pool.schedule();
+    reader.read_chunks(first, last, dst);
+}
+
+// Owns the value stored inside a mapped chunked file.
+//
+// The value is only part of the file, so the owner must not present itself
+// as mapping a file: code storing or sharing a blob by its mapped file would
+// pick up the whole file (header included), and refer to a file that the
+// disk cache may evict at any time.
+class stored_value_owner : public data_owner
+{
+ public:
+    stored_value_owner(file_path const& path, std::size_t offset)
+        : file_{path}, offset_{offset}
+    {
+    }
+
+    std::uint8_t*
+    data() override
+    {
+        return file_.data() + offset_;
+    }
+
+    std::byte const*
+    bytes()
+    {
+        return file_.bytes() + offset_;
+    }
+
+ private:
+    blob_file_reader file_;
+    std::size_t offset_;
+};
+
+} // namespace
+
+disk_cache_codec
+parse_disk_cache_codec(std::string const& name)
+{
+    if (name == "store")
+    {
+        return disk_cache_codec::store;
+    }
+    if (name == "lz4")
+    {
+        return disk_cache_codec::lz4;
+    }
+    if (name == "zstd")
+    {
+        return disk_cache_codec::zstd;
+    }
+    throw std::invalid_argument(
+        fmt::format("unknown disk cache codec {}", name));
+}
+
+bool
+is_chunked_file(file_path const& path)
+{
+    std::ifstream input;
+    open_file(input, path, std::ios::in | std::ios::binary);
+    std::array<uint8_t, magic.size()> bytes{};
+    input.exceptions(std::ios::badbit);
+    input.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+    return input.gcount() == static_cast<std::streamsize>(bytes.size())
+           && bytes == magic;
+}
+
+// Writes value to path, which should not yet exist, in the chunked format
+static std::size_t
+write_new_chunked_file(
+    cppcoro::static_thread_pool& pool,
+    file_path const& path,
+    blob const& value,
+    chunked_file_options const& options)
+{
+    std::size_t chunk_size{options.chunk_size};
+    if (chunk_size == 0 || chunk_size > max_chunk_size)
+    {
+        throw_chunked_file_error(
+            path, fmt::format("invalid chunk size {}", chunk_size));
+    }
+    std::size_t num_chunks{(value.size() + chunk_size - 1) / chunk_size};
+    auto codec{options.codec};
+    if (options.store_threshold && value.size() >= *options.store_threshold)
+    {
+        codec = disk_cache_codec::store;
+    }
+
+    header_bytes header{};
+    std::copy(magic.begin(), magic.end(), header.begin());
+    header[4] = format_version;
+    header[5] = static_cast<uint8_t>(codec);
+    store_le(&header[8], static_cast<uint32_t>(chunk_size));
+    store_le(&header[12], boost::numeric_cast<uint32_t>(num_chunks));
+    store_le(&header[16], static_cast<uint64_t>(value.size()));
+
+    std::ofstream output;
+    open_file(
+        output, path, std::ios::out | std::ios::trunc | std::ios::binary);
+    output.write(reinterpret_cast<char const*>(header.data()), header.size());
+    std::vector<uint8_t> table(num_chunks * sizeof(uint32_t));
+    std::size_t file_size{header.size() + table.size()};
+
+    if (codec == disk_cache_codec::store)
+    {
+        for (std::size_t i = 0; i < num_chunks; ++i)
+        {
+            std::size_t begin{i * chunk_size};
+            std::size_t end{std::min(begin + chunk_size, value.size())};
+            store_le(
+                &table[i * sizeof(uint32_t)],
+                static_cast<uint32_t>(end - begin));
+        }
+        output.write(
+            reinterpret_cast<char const*>(table.data()), table.size());
+        output.write(
+            reinterpret_cast<char const*>(value.data()), value.size());
+        return file_size + value.size();
+    }
+
+    // Placeholder for the chunk table, which is filled in at the end
+    output.write(reinterpret_cast<char const*>(table.data()), table.size());
+
+    // Compress a window of chunks in parallel, then write them in order.
+    // The window bounds the memory taken by compressed data.
+    std::size_t window{std::max<std::size_t>(2 * pool.thread_count(), 1)};
+    for (std::size_t first = 0; first < num_chunks; first += window)
+    {
+        std::size_t last{std::min(first + window, num_chunks)};
+        std::vector<cppcoro::task<byte_vector>> tasks;
+        tasks.reserve(last - first);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            std::size_t begin{i * chunk_size};
+            std::size_t end{std::min(begin + chunk_size, value.size())};
+            tasks.push_back(compress_chunk(
+                pool, options, value.data() + begin, end - begin));
+        }
+        auto compressed_chunks
+            = cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
+        for (std::size_t i = first; i < last; ++i)
+        {
+            auto const& compressed{compressed_chunks[i - first]};
+            output.write(
+                reinterpret_cast<char const*>(compressed.data()),
+                compressed.size());
+            store_le(
+                &table[i * sizeof(uint32_t)],
+                static_cast<uint32_t>(compressed.size()));
+            file_size += compressed.size();
+        }
+    }
+
+    output.seekp(header.size());
+    output.write(reinterpret_cast<char const*>(table.data()), table.size());
+    return file_size;
+}
+
+std::size_t
+write_chunked_file(
+    cppcoro::static_thread_pool& pool,
+    file_path const& path,
+    blob const& value,
+    chunked_file_options const& options)
+{
+    // The random suffix keeps concurrent writers (possibly in other
+    // processes sharing the directory) from clashing.
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    file_path temp_path{path};
+    temp_path += fmt::format(".{:016x}.tmp", rng());
+    std::size_t file_size{};
+    try
+    {
+        file_size = write_new_chunked_file(pool, temp_path, value, options);
+        std::filesystem::rename(temp_path, path);
+    }
+    catch (...)
+    {
+        std::error_code ec;
+        std::filesystem::remove(temp_path, ec);
+        throw;
+    }
+    return file_size;
+}
+
+chunked_file_reader::chunked_file_reader(file_path path)
+    : path_{std::move(path)}
+{
+    std::ifstream input;
+    open_file(input, path_, std::ios::in | std::ios::binary);
+    input.seekg(0, std::ios::end);
+    uint64_t file_size{static_cast<uint64_t>(input.tellg())};
+    input.seekg(0);
+    if (file_size < header_size)
+    {
+        throw_chunked_file_error(path_, "file too small for header");
+    }
+
+    header_bytes header;
+    input.read(reinterpret_cast<char*>(header.data()), header.size());
+    if (!std::equal(magic.begin(), magic.end(), header.begin()))
+    {
+        throw_chunked_file_error(path_, "not a chunked file");
+    }
+    if (header[4] != format_version)
+    {
+        throw_chunked_file_error(
+            path_, fmt::format("unsupported format version {}", header[4]));
+    }
+    codec_ = static_cast<disk_cache_codec>(header[5]);
+    if (header[5] > static_cast<uint8_t>(disk_cache_codec::zstd))
+    {
+        throw_chunked_file_error(
+            path_, fmt::format("unknown codec {}", header[5]));
+    }
+    chunk_size_ = load_le<uint32_t>(&header[8]);
+    std::size_t num_chunks{load_le<uint32_t>(&header[12])};
+    original_size_ = boost::numeric_cast<std::size_t>(
+        load_le<uint64_t>(&header[16]));
+    if (chunk_size_ == 0
+        || num_chunks != (original_size_ + chunk_size_ - 1) / chunk_size_)
+    {
+        throw_chunked_file_error(path_, "inconsistent header");
+    }
+
+    data_offset_ = header_size + num_chunks * sizeof(uint32_t);
+    uint64_t offset{data_offset_};
+    if (file_size < offset)
+    {
+        throw_chunked_file_error(path_, "file too small for chunk table");
+    }
+    std::vector<uint8_t> table(num_chunks * sizeof(uint32_t));
+    input.read(reinterpret_cast<char*>(table.data()), table.size());
+    compressed_sizes_.resize(num_chunks);
+    offsets_.resize(num_chunks);
+    for (std::size_t i = 0; i < num_chunks; ++i)
+    {
+        compressed_sizes_[i] = load_le<uint32_t>(&table[i * sizeof(uint32_t)]);
+        if (codec_ == disk_cache_codec::store
+            && compressed_sizes_[i] != chunk_original_size(i))
+        {
+            throw_chunked_file_error(path_, "inconsistent chunk table");
+        }
+        offsets_[i] = offset;
+        offset += compressed_sizes_[i];
+    }
+    // The file might be truncated if the write operation was interrupted.
+    if (file_size != offset)
+    {
+        throw_chunked_file_error(
+            path_,
+            fmt::format("file size is {}, expected {}", file_size, offset));
+    }
+}
+
+std::size_t
+chunked_file_reader::chunk_original_size(std::size_t chunk) const
+{
+    std::size_t begin{chunk * chunk_size_};
+    return std::min(begin + chunk_size_, original_size_) - begin;
+}
+
+void
+chunked_file_reader::read_chunks(
+    std::size_t first, std::size_t last, void* dst) const
+{
+    if (first > last || last > num_chunks())
+    {
+        throw std::out_of_range(fmt::format(
+            "chunks [{}, {}) out of range {}", first, last, num_chunks()));
+    }
+    if (first == last)
+    {
+        return;
+    }
+    std::ifstream input;
+    open_file(input, path_, std::ios::in | std::ios::binary);
+    input.seekg(static_cast<std::streamoff>(offsets_[first]));
+    byte_vector compressed;
+    auto* out = static_cast<uint8_t*>(dst);
+    for (std::size_t i = first; i < last; ++i)
+    {
+        compressed.resize(compressed_sizes_[i]);
+        input.read(
+            reinterpret_cast<char*>(compressed.data()), compressed.size());
+        std::size_t original_size{chunk_original_size(i)};
+        auto decompressed_size = decompress(
+            codec_, out, original_size, compressed.data(), compressed.size());
+        if (decompressed_size != original_size)
+        {
+            throw_chunked_file_error(
+                path_,
+                fmt::format(
+                    "chunk {} decompressed to {} bytes, expected {}",
+                    i,
+                    decompressed_size,
+                    original_size));
+        }
+        out += original_size;
+    }
+}
+
+cppcoro::task<blob>
+read_chunked_file(cppcoro::static_thread_pool& pool, file_path path)
+{
+    chunked_file_reader reader{std::move(path)};
+    if (reader.codec() == disk_cache_codec::store && reader.num_chunks() > 0)
+    {
+        // Zero-copy: the blob refers to the value inside the mapped file.
+        auto owner{std::make_shared<stored_value_owner>(
+            reader.path(), reader.data_offset())};
+        co_return blob{owner, owner->bytes(), reader.original_size()};
+    }
+    auto buffer{make_shared_buffer(reader.original_size())};
+    auto* data{buffer->data()};
+    // Split the chunks into one contiguous group per thread, so that each
+    // group needs to open and seek the file only once.
+    std::size_t num_chunks{reader.num_chunks()};
+    std::size_t num_groups{
+        std::min<std::size_t>(pool.thread_count(), num_chunks)};
+    std::vector<cppcoro::task<void>> tasks;
+    tasks.reserve(num_groups);
+    for (std::size_t group = 0; group < num_groups; ++group)
+    {
+        std::size_t first{group * num_chunks / num_groups};
+        std::size_t last{(group + 1) * num_chunks / num_groups};
+        tasks.push_back(decompress_chunks(
+            pool, reader, first, last, data + first * reader.chunk_size()));
+    }
+    co_await cppcoro::when_all(std::move(tasks));
+    auto const* bytes{buffer->bytes()};
+    co_return blob{std::move(buffer), bytes, reader.original_size()};
+}
+
+} // namespace cradle
@@ -0,0 +1,177 @@
+#ifndef CRADLE_PLUGINS_SECONDARY_CACHE_LOCAL_CHUNKED_FILE_H
+#define CRADLE_PLUGINS_SECONDARY_CACHE_LOCAL_CHUNKED_FILE_H
+
+// The format of the files in which the local disk cache stores large values.
+//
+// A value is split into chunks of a fixed (original) size, except for the
+// last one, which may be smaller. Each chunk is compressed independently, so
+// chunks can be compressed and decompressed in parallel, and any chunk can
+// be decompressed without touching the others.
+//
+// File layout (all integers little-endian):
+//   header (32 bytes):
+//     [0]  magic: 0x00 'C' 'D' 'C'
+//     [4]  uint8  format version (1)
+//     [5]  uint8  codec (disk_cache_codec)
+//     [6]  uint16 reserved (0)
+//     [8]  uint32 chunk size (original)
+//     [12] uint32 number of chunks
+//     [16] uint64 original value size
+//     [24] uint64 reserved (0)
+//   chunk table: one uint32 compressed size per chunk
+//   the compressed chunks, in order
+//
+// With the "store" codec, chunks are not compressed, so the chunks together
+// form the original value, as one contiguous byte range. Such files are
+// memory-mapped when read, and the value is returned without copying it.
+//
+// Files written by earlier versions hold a single LZ4 block. Such a block
+// never starts with a 0x00 byte (for a non-empty value), so the magic
+// distinguishes the two formats.
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/task.hpp>
+
+#include <cradle/inner/core/exception.h>
+#include <cradle/inner/core/type_definitions.h>
+#include <cradle/inner/fs/types.h>
+
+namespace cradle {
+
+// How the chunks in a file are compressed
+enum class disk_cache_codec : uint8_t
+{
+    // No compression
+    store = 0,
+    lz4 = 1,
+    zstd = 2,
+};
+
+// Translates a codec name ("store", "lz4" or "zstd") to its enum value
+disk_cache_codec
+parse_disk_cache_codec(std::string const& name);
+
+struct chunked_file_options
+{
+    disk_cache_codec codec{disk_cache_codec::lz4};
+    // Compression level; used for zstd only, where 0 selects the default
+    int level{0};
+    // Original size of all chunks but the last one
+    std::size_t chunk_size{std::size_t{1} << 20};
+    // If set, values of at least this size are written with the store codec,
+    // so that reading them needs no copying
+    std::optional<std::size_t> store_threshold;
+};
+
+// This exception indicates that a file is not in the chunked format, or is
+// corrupt.
+CRADLE_DEFINE_EXCEPTION(chunked_file_error)
+// This exception also provides file_path_info and
+// internal_error_message_info.
+
+// Returns true if the file at path starts with the chunked format's magic
+bool
+is_chunked_file(file_path const& path);
+
+// Compresses value and writes it to path, in the chunked format.
+// Chunks are compressed in parallel on pool, and written as soon as they are
+// available; only a limited number of compressed chunks are held in memory
+// at any time.
+// The file is written under a temporary name and then renamed to path, so
+// that readers never see a partially written file, and an existing file at
+// path is replaced rather than overwritten in place (processes that still
+// have it open can continue to use it).
+// This function blocks until the file has been written; it should not be
+// called from one of pool's threads. Returns the size of the file.
+std::size_t
+write_chunked_file(
+    cppcoro::static_thread_pool& pool,
+    file_path const& path,
+    blob const& value,
+    chunked_file_options const& options);
+
+/*
+ * Provides random access to the chunks in a chunked file.
+ * The constructor reads the header and the chunk table; the other member
+ * functions are thread-safe.
+ */
+class chunked_file_reader
+{
+ public:
+    explicit chunked_file_reader(file_path path);
+
+    file_path const&
+    path() const
+    {
+        return path_;
+    }
+
+    disk_cache_codec
+    codec() const
+    {
+        return codec_;
+    }
+
+    std::size_t
+    original_size() const
+    {
+        return original_size_;
+    }
+
+    std::size_t
+    num_chunks() const
+    {
+        return compressed_sizes_.size();
+    }
+
+    std::size_t
+    chunk_size() const
+    {
+        return chunk_size_;
+    }
+
+    // Returns the offset in the file of the first chunk; for the store codec,
+    // the offset of the original value
+    uint64_t
+    data_offset() const
+    {
+        return data_offset_;
+    }
+
+    // Returns the original (decompressed) size of the given chunk
+    std::size_t
+    chunk_original_size(std::size_t chunk) const;
+
+    // Decompresses the chunks in [first, last) into dst, which should have
+    // room for their original sizes. Opens its own stream on the file, so
+    // multiple threads can read different chunks at the same time.
+    void
+    read_chunks(std::size_t first, std::size_t last, void* dst) const;
+
+ private:
+    file_path path_;
+    disk_cache_codec codec_{};
+    std::size_t chunk_size_{};
+    std::size_t original_size_{};
+    uint64_t data_offset_{};
+    std::vector<uint32_t> compressed_sizes_;
+    // File offset of each chunk
+    std::vector<uint64_t> offsets_;
+};
+
+// Reads and decompresses an entire chunked file. Groups of chunks are
+// decompressed in parallel on pool, directly into the returned blob.
+// For the store codec, the file is memory-mapped instead, and the returned
+// blob refers to the mapped data.
+cppcoro::task<blob>
+read_chunked_file(cppcoro::static_thread_pool& pool, file_path path);
+
+} // namespace cradle
+
+#endif
@@ -1,9 +1,19 @@
 #include <cradle/plugins/secondary_cache/local/ll_disk_cache.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -22,19 +32,23 @@
 
 namespace cradle {
 
-struct ll_disk_cache_impl
+// A connection to the index database, with its prepared statements.
+// A connection is used by a single thread at a time.
+struct ll_disk_cache_connection
 {
     file_path dir;
 
+    std::shared_ptr<spdlog::logger> logger;
+
     sqlite3* db = nullptr;
 
-    // prepared statements
+    // prepared statements; read connections have only the queries marked R
     sqlite3_stmt* database_version_query = nullptr;
 
     sqlite3_stmt* insert_ac_entry_statement = nullptr;
-    sqlite3_stmt* ac_lookup_query = nullptr;
+    sqlite3_stmt* ac_lookup_query = nullptr; // R
     sqlite3_stmt* get_cas_id_from_ac_query = nullptr;
-    sqlite3_stmt* ac_entry_count_query = nullptr;
+    sqlite3_stmt* ac_entry_count_query = nullptr; // R
     sqlite3_stmt* ac_lru_entry_list_query = nullptr;
     sqlite3_stmt* record_ac_usage_statement = nullptr;
     sqlite3_stmt* remove_ac_entry_statement = nullptr;
@@ -44,16 +58,61 @@ struct ll_disk_cache_impl
     sqlite3_stmt* finish_cas_insert_statement = nullptr;
     sqlite3_stmt* cas_lookup_by_digest_query = nullptr;
     sqlite3_stmt* cas_lookup_query = nullptr;
-    sqlite3_stmt* cas_entry_count_query = nullptr;
-    sqlite3_stmt* total_cas_size_query = nullptr;
+    sqlite3_stmt* cas_lookup_by_ac_key_query = nullptr; // R
+    sqlite3_stmt* cas_entry_count_query = nullptr; // R
+    sqlite3_stmt* total_cas_size_query = nullptr; // R
     sqlite3_stmt* count_cas_entry_refs_query = nullptr;
     sqlite3_stmt* remove_cas_entry_statement = nullptr;
+};
+
+// A modification of the database, performed by the writer thread
+struct ll_disk_cache_write_job
+{
+    // Performs the modification, inside the transaction for the job's batch
+    std::function<void(ll_disk_cache_impl&)> execute;
+
+    // Fulfilled when the transaction has been committed, or the job has
+    // failed; nullptr if nobody is waiting for the job
+    std::shared_ptr<std::promise<void>> done;
+};
+
+struct ll_disk_cache_impl
+{
+    file_path dir;
 
     int64_t size_limit;
 
-    // used to track when we need to check if the cache is too big
+    // All modifications go through this connection, which is used by the
+    // writer thread only (once the cache has been initialized).
+    ll_disk_cache_connection write_connection;
+
+    // Connections for look-ups. The database is in WAL mode, so readers see
+    // the latest committed state, and readers and the writer do not block
+    // each other.
+    std::vector<std::unique_ptr<ll_disk_cache_connection>> read_connections;
+    // The read connections that are not in use
+    std::vector<ll_disk_cache_connection*> idle_read_connections;
+    std::mutex read_connections_mutex;
+    std::condition_variable read_connections_cv;
+
+    // Jobs waiting for the writer thread. The writer takes all jobs that
+    // have queued up, and performs them in a single transaction, so that
+    // concurrent writers share the cost of a commit.
+    std::deque<ll_disk_cache_write_job> write_queue;
+    bool stop_writing = false;
+    std::mutex write_queue_mutex;
+    std::condition_variable write_queue_cv;
+    std::thread writer;
+
+    // used to track when we need to check if the cache is too big; accessed
+    // by the writer thread only
     int64_t bytes_inserted_since_last_sweep = 0;
 
+    // Growth recorded by the write jobs in the current batch that have not
+    // been rolled back; added to bytes_inserted_since_last_sweep when the
+    // batch commits. Accessed by the writer thread only.
+    int64_t bytes_inserted_in_batch = 0;
+
     // Used for detecting an idle period
     std::chrono::time_point<std::chrono::system_clock> latest_activity;
 
@@ -63,14 +122,17 @@ struct ll_disk_cache_impl
     // look-up measurably slower.
     std::vector<int64_t> ac_ids_to_flush;
 
-    // Protects all access to the cache. The ll_disk_cache member functions
-    // lock this mutex; other functions may assume it's locked.
-    std::mutex mutex;
+    // Protects latest_activity and ac_ids_to_flush
+    std::mutex usage_mutex;
+
+    // reset() locks this mutex exclusively, the other ll_disk_cache member
+    // functions lock it shared.
+    std::shared_mutex mutex;
 
     std::shared_ptr<spdlog::logger> logger;
 
-    int hit_count{0};
-    int miss_count{0};
+    std::atomic<int> hit_count{0};
+    std::atomic<int> miss_count{0};
 };
 
 // SQLITE UTILITIES
@@ -78,7 +140,6 @@ struct ll_disk_cache_impl
 static void
 open_db(sqlite3** db, file_path const& file)
 {
-    spdlog::get("cradle")->info("Using disk cache {}", file.string());
     // sqlite3_open() apparently is successful even if file is not an SQLite
     // database.
     if (sqlite3_open(file.string().c_str(), db) != SQLITE_OK)
@@ -87,20 +148,20 @@ open_db(sqlite3** db, file_path const& file)
             ll_disk_cache_failure()
             << ll_disk_cache_path_info(file.parent_path())
             << internal_error_message_info(
-                   "failed to create disk cache index file (index.db)"));
+                "failed to create disk cache index file (index.db)"));
     }
 }
 
 static void
 throw_for_code(
-    ll_disk_cache_impl const& cache, int code, std::string const& prefix)
+    ll_disk_cache_connection const& conn, int code, std::string const& prefix)
 {
     std::string code_text{sqlite3_errstr(code)};
-    std::string msg_text{sqlite3_errmsg(cache.db)};
+    std::string msg_text{sqlite3_errmsg(conn.db)};
     std::string all_text{
         fmt::format("{} ({}): {}", prefix, code_text, msg_text)};
     CRADLE_THROW(
-        ll_disk_cache_failure() << ll_disk_cache_path_info(cache.dir)
+        ll_disk_cache_failure() << ll_disk_cache_path_info(conn.dir)
                                 << internal_error_message_info(all_text));
 }
 
@@ -115,13 +176,13 @@ throw_for_code(int code, std::string const& prefix)
 
 static void
 throw_query_error(
-    ll_disk_cache_impl const& cache,
+    ll_disk_cache_connection const& conn,
     std::string const& sql,
     std::string const& error)
 {
     CRADLE_THROW(
         ll_disk_cache_failure()
-        << ll_disk_cache_path_info(cache.dir)
+        << ll_disk_cache_path_info(conn.dir)
         << internal_error_message_info(fmt::format(
                "error executing SQL query in index.db\n"
                "SQL query: {}\n"
@@ -146,15 +207,40 @@ copy_and_free_message(char* msg)
 }
 
 static void
-execute_sql(ll_disk_cache_impl const& cache, std::string const& sql)
+execute_sql(ll_disk_cache_connection const& conn, std::string const& sql)
 {
     char* msg;
-    int code = sqlite3_exec(cache.db, sql.c_str(), 0, 0, &msg);
+    int code = sqlite3_exec(conn.db, sql.c_str(), 0, 0, &msg);
     std::string error = copy_and_free_message(msg);
     if (code != SQLITE_OK)
     {
-        throw_query_error(cache, sql, error);
+        throw_query_error(conn, sql, error);
+    }
+}
+
+// Runs :fn inside a transaction, which is committed if fn returns normally,
+// and rolled back if it throws.
+//
+// :begin_sql starts the transaction. A write transaction should be
+// "begin immediate;", taking the write lock up front: a deferred transaction
+// that starts reading and then wants to write fails with SQLITE_BUSY, without
+// the busy handler being invoked, if another connection wrote in between.
+template<class Fn>
+static void
+run_in_transaction(
+    ll_disk_cache_connection const& conn, char const* begin_sql, Fn const& fn)
+{
+    execute_sql(conn, begin_sql);
+    try
+    {
+        fn();
     }
+    catch (...)
+    {
+        execute_sql(conn, "rollback transaction;");
+        throw;
+    }
+    execute_sql(conn, "commit transaction;");
 }
 
 // Check a return code from SQLite.
@@ -171,11 +257,11 @@ check_sqlite_code(int code)
 // This checks to make sure that the creation was successful, so the returned
 // pointer is always valid.
 static sqlite3_stmt*
-prepare_statement(ll_disk_cache_impl const& cache, std::string const& sql)
+prepare_statement(ll_disk_cache_connection const& conn, std::string const& sql)
 {
     sqlite3_stmt* statement;
     auto code = sqlite3_prepare_v2(
-        cache.db,
+        conn.db,
         sql.c_str(),
         boost::numeric_cast<int>(sql.length()),
         &statement,
@@ -183,7 +269,7 @@ prepare_statement(ll_disk_cache_impl const& cache, std::string const& sql)
     if (code != SQLITE_OK)
     {
         throw_for_code(
-            cache, code, fmt::format("error preparing SQL query {}", sql));
+            conn, code, fmt::format("error preparing SQL query {}", sql));
     }
     return statement;
 }
@@ -226,13 +312,13 @@ bind_blob(sqlite3_stmt* statement, int parameter_index, blob const& value)
 // This should only be used for statements that don't return results.
 static void
 execute_prepared_statement(
-    ll_disk_cache_impl const& cache, sqlite3_stmt* statement)
+    ll_disk_cache_connection const& conn, sqlite3_stmt* statement)
 {
-    // cache.logger->debug("execute_prepared_statement simple");
+    // conn.logger->debug("execute_prepared_statement simple");
     auto code = sqlite3_step(statement);
     if (code != SQLITE_DONE)
     {
-        throw_for_code(cache, code, "SQL query failed");
+        throw_for_code(conn, code, "SQL query failed");
     }
     check_sqlite_code(sqlite3_reset(statement));
     // Strings and blobs are bound with SQLITE_STATIC, promising the passed
@@ -362,13 +448,13 @@ struct single_row_result
 template<class RowHandler>
 static void
 execute_prepared_statement(
-    ll_disk_cache_impl const& cache,
+    ll_disk_cache_connection const& conn,
     sqlite3_stmt* statement,
     expected_column_count expected_columns,
     single_row_result single_row,
     RowHandler const& row_handler)
 {
-    // cache.logger->debug("execute_prepared_statement extended");
+    // conn.logger->debug("execute_prepared_statement extended");
     int row_count = 0;
     int code;
     while (true)
@@ -380,7 +466,7 @@ execute_prepared_statement(
             {
                 CRADLE_THROW(
                     ll_disk_cache_failure()
-                    << ll_disk_cache_path_info(cache.dir)
+                    << ll_disk_cache_path_info(conn.dir)
                     << internal_error_message_info(std::string(
                            "SQL query result column count incorrect\n")));
             }
@@ -396,13 +482,13 @@ execute_prepared_statement(
     }
     if (code != SQLITE_DONE)
     {
-        throw_for_code(cache, code, "SQL query failed");
+        throw_for_code(conn, code, "SQL query failed");
     }
     if (single_row.value && row_count != 1)
     {
         CRADLE_THROW(
             ll_disk_cache_failure()
-            << ll_disk_cache_path_info(cache.dir)
+            << ll_disk_cache_path_info(conn.dir)
             << internal_error_message_info(
                    std::string("SQL query row count incorrect\n")));
     }
@@ -412,28 +498,30 @@ execute_prepared_statement(
 // OPERATIONS ON THE AC
 
 static void
-record_ac_usage(ll_disk_cache_impl& cache, int64_t ac_id)
+record_ac_usage(ll_disk_cache_connection& conn, int64_t ac_id)
 {
-    auto* stmt = cache.record_ac_usage_statement;
+    auto* stmt = conn.record_ac_usage_statement;
     bind_int64(stmt, 1, ac_id);
-    execute_prepared_statement(cache, stmt);
+    execute_prepared_statement(conn, stmt);
 }
 
+// Writes the usage of the given AC entries to the database; called on the
+// writer thread, so the updates share a transaction.
 static void
-flush_ac_usage(ll_disk_cache_impl& cache)
+flush_ac_usage(
+    ll_disk_cache_connection& conn, std::vector<int64_t> const& ac_ids)
 {
-    cache.logger->info(
-        "flush_ac_usage ({} items)", cache.ac_ids_to_flush.size());
+    conn.logger->info("flush_ac_usage ({} items)", ac_ids.size());
     // An alternative would be a single
     //   UPDATE actions SET ... WHERE ac_id in (...)
     // but this happens to be slower than performing a query for each ac_id.
-    for (auto ac_id : cache.ac_ids_to_flush)
+    for (auto ac_id : ac_ids)
     {
-        record_ac_usage(cache, ac_id);
+        record_ac_usage(conn, ac_id);
     }
-    cache.ac_ids_to_flush.clear();
 }
 
+// The caller should hold cache.usage_mutex.
 static bool
 should_flush_ac_usage(ll_disk_cache_impl const& cache)
 {
@@ -458,28 +546,29 @@ should_flush_ac_usage(ll_disk_cache_impl const& cache)
 
 static void
 insert_ac_entry(
-    ll_disk_cache_impl& cache, std::string const& ac_key, int64_t cas_id)
+    ll_disk_cache_connection& conn, std::string const& ac_key, int64_t cas_id)
 {
-    cache.logger->debug(
+    conn.logger->debug(
         " insert_ac_entry: ac_key {}, cas_id {}", ac_key, cas_id);
-    auto* stmt = cache.insert_ac_entry_statement;
+    auto* stmt = conn.insert_ac_entry_statement;
     bind_string(stmt, 1, ac_key);
     bind_int64(stmt, 2, cas_id);
-    execute_prepared_statement(cache, stmt);
+    execute_prepared_statement(conn, stmt);
 }
 
 // Returns (ac_id, cas_id) pair for the specified AC entry, or nullopt if no
 // such entry
 static std::optional<std::pair<int64_t, int64_t>>
-look_up_ac_and_cas_ids(ll_disk_cache_impl& cache, std::string const& ac_key)
+look_up_ac_and_cas_ids(
+    ll_disk_cache_connection& conn, std::string const& ac_key)
 {
-    auto* stmt = cache.ac_lookup_query;
+    auto* stmt = conn.ac_lookup_query;
     bind_string(stmt, 1, ac_key);
     bool exists = false;
     int64_t ac_id{};
     int64_t cas_id{};
     execute_prepared_statement(
-        cache,
+        conn,
         stmt,
         expected_column_count{2},
         single_row_result{false},
@@ -492,28 +581,13 @@ look_up_ac_and_cas_ids(ll_disk_cache_impl& cache, std::string const& ac_key)
     {
         return std::nullopt;
     }
-
-    // Add ac_id to ac_ids_to_flush, ensuring no duplicates appear. In a
-    // production environment, the memory cache will (or should) already ensure
-    // this, but benchmark tests that measure just disk cache performance
-    // do not.
-    // A compromise is to first check on ac_id's presence. This has no
-    // measurable performance impact, and prevents negative impact on benchmark
-    // output.
-    if (std::find(
-            cache.ac_ids_to_flush.begin(), cache.ac_ids_to_flush.end(), ac_id)
-        == cache.ac_ids_to_flush.end())
-    {
-        cache.ac_ids_to_flush.push_back(ac_id);
-    }
-
     return std::make_pair(ac_id, cas_id);
 }
 
 static std::optional<int64_t>
-look_up_ac_id(ll_disk_cache_impl& cache, std::string const& ac_key)
+look_up_ac_id(ll_disk_cache_connection& conn, std::string const& ac_key)
 {
-    auto opt_id_pair = look_up_ac_and_cas_ids(cache, ac_key);
+    auto opt_id_pair = look_up_ac_and_cas_ids(conn, ac_key);
     if (!opt_id_pair)
     {
         return std::nullopt;
@@ -522,9 +596,9 @@ look_up_ac_id(ll_disk_cache_impl& cache, std::string const& ac_key)
 }
 
 static std::optional<int64_t>
-look_up_cas_id(ll_disk_cache_impl& cache, std::string const& ac_key)
+look_up_cas_id(ll_disk_cache_connection& conn, std::string const& ac_key)
 {
-    auto opt_id_pair = look_up_ac_and_cas_ids(cache, ac_key);
+    auto opt_id_pair = look_up_ac_and_cas_ids(conn, ac_key);
     if (!opt_id_pair)
     {
         return std::nullopt;
@@ -534,13 +608,13 @@ look_up_cas_id(ll_disk_cache_impl& cache, std::string const& ac_key)
 
 // Returns the cas_id from the AC entry for ac_id.
 static int64_t
-get_cas_id_for_ac_entry(ll_disk_cache_impl const& cache, int64_t ac_id)
+get_cas_id_for_ac_entry(ll_disk_cache_connection const& conn, int64_t ac_id)
 {
-    auto* stmt = cache.get_cas_id_from_ac_query;
+    auto* stmt = conn.get_cas_id_from_ac_query;
     bind_int64(stmt, 1, ac_id);
     int64_t cas_id = 0;
     execute_prepared_statement(
-        cache,
+        conn,
         stmt,
         expected_column_count{1},
         single_row_result{true},
@@ -550,12 +624,12 @@ get_cas_id_for_ac_entry(ll_disk_cache_impl const& cache, int64_t ac_id)
 
 // Get the number of entries in the AC.
 static int64_t
-get_ac_entry_count(ll_disk_cache_impl& cache)
+get_ac_entry_count(ll_disk_cache_connection& conn)
 {
     int64_t count;
     execute_prepared_statement(
-        cache,
-        cache.ac_entry_count_query,
+        conn,
+        conn.ac_entry_count_query,
         expected_column_count{1},
         single_row_result{true},
         [&](sqlite_row& row) { count = read_int64(row, 0); });
@@ -571,12 +645,12 @@ using lru_entry_list_t = std::vector<lru_entry_t>;
 
 // Get a list of entries in the AC in LRU order.
 static lru_entry_list_t
-get_ac_lru_entries(ll_disk_cache_impl& cache)
+get_ac_lru_entries(ll_disk_cache_connection& conn)
 {
     lru_entry_list_t entries;
     execute_prepared_statement(
-        cache,
-        cache.ac_lru_entry_list_query,
+        conn,
+        conn.ac_lru_entry_list_query,
         expected_column_count{2},
         single_row_result{false},
         [&](sqlite_row& row) {
@@ -588,12 +662,12 @@ get_ac_lru_entries(ll_disk_cache_impl& cache)
 }
 
 static void
-remove_ac_entry(ll_disk_cache_impl& cache, int64_t ac_id)
+remove_ac_entry(ll_disk_cache_connection& conn, int64_t ac_id)
 {
-    cache.logger->debug(" remove AC entry {}", ac_id);
-    auto* stmt = cache.remove_ac_entry_statement;
+    conn.logger->debug(" remove AC entry {}", ac_id);
+    auto* stmt = conn.remove_ac_entry_statement;
     bind_int64(stmt, 1, ac_id);
-    execute_prepared_statement(cache, stmt);
+    execute_prepared_statement(conn, stmt);
 }
 
 // OPERATIONS ON THE CAS (DB ONLY)
@@ -601,18 +675,18 @@ remove_ac_entry(ll_disk_cache_impl& cache, int64_t ac_id)
 // Inserts a complete entry in the CAS, returning its cas_id
 static int64_t
 insert_cas_entry(
-    ll_disk_cache_impl const& cache,
+    ll_disk_cache_connection const& conn,
     std::string const& digest,
     blob const& value,
     std::size_t original_size)
 {
-    auto* stmt = cache.cas_insert_statement;
+    auto* stmt = conn.cas_insert_statement;
     auto storage{from_storage_t(storage_t::in_db)};
     auto const* bound_blob{&value};
     blob blob_file_path;
     if (auto const* owner = value.mapped_file_data_owner())
     {
-        cache.logger->debug(
+        conn.logger->debug(
             " insert_cas_entry: blob file {}", owner->mapped_file());
         storage = from_storage_t(storage_t::blob_file);
         blob_file_path = make_blob(owner->mapped_file());
@@ -623,10 +697,10 @@ insert_cas_entry(
     bind_blob(stmt, 3, *bound_blob);
     bind_int64(stmt, 4, value.size());
     bind_int64(stmt, 5, original_size);
-    execute_prepared_statement(cache, stmt);
+    execute_prepared_statement(conn, stmt);
     // Alternative: use a RETURNING clause
-    auto cas_id = sqlite3_last_insert_rowid(cache.db);
-    cache.logger->debug(
+    auto cas_id = sqlite3_last_insert_rowid(conn.db);
+    conn.logger->debug(
         " insert_cas_entry: digest {}, original_size {} -> cas_id {}",
         digest,
         original_size,
@@ -637,7 +711,7 @@ insert_cas_entry(
         // get here.
         CRADLE_THROW(
             ll_disk_cache_failure()
-            << ll_disk_cache_path_info(cache.dir)
+            << ll_disk_cache_path_info(conn.dir)
             << internal_error_message_info(
                    "failed to create entry in index.db"));
     }
@@ -646,20 +720,21 @@ insert_cas_entry(
 
 // Inserts an incomplete / invalid entry in the CAS, returning its cas_id.
 static int64_t
-initiate_cas_insert(ll_disk_cache_impl const& cache, std::string const& digest)
+initiate_cas_insert(
+    ll_disk_cache_connection const& conn, std::string const& digest)
 {
-    auto* stmt = cache.initiate_cas_insert_statement;
+    auto* stmt = conn.initiate_cas_insert_statement;
     bind_string(stmt, 1, digest);
-    execute_prepared_statement(cache, stmt);
+    execute_prepared_statement(conn, stmt);
     // Get the ID that was inserted.
-    auto cas_id = sqlite3_last_insert_rowid(cache.db);
+    auto cas_id = sqlite3_last_insert_rowid(conn.db);
     if (cas_id == 0)
     {
         // Since we checked that the insert succeeded, we really shouldn't
         // get here.
         CRADLE_THROW(
             ll_disk_cache_failure()
-            << ll_disk_cache_path_info(cache.dir)
+            << ll_disk_cache_path_info(conn.dir)
             << internal_error_message_info(
                    "failed to create entry in index.db"));
     }
@@ -669,28 +744,28 @@ initiate_cas_insert(ll_disk_cache_impl const& cache, std::string const& digest)
 // Finalizes a CAS entry that was inserted via initiate_cas_insert().
 static void
 finish_cas_insert(
-    ll_disk_cache_impl const& cache,
+    ll_disk_cache_connection const& conn,
     int64_t cas_id,
     std::size_t size,
     std::size_t original_size)
 {
-    auto* stmt = cache.finish_cas_insert_statement;
+    auto* stmt = conn.finish_cas_insert_statement;
     bind_int64(stmt, 1, size);
     bind_int64(stmt, 2, original_size);
     bind_int64(stmt, 3, cas_id);
-    execute_prepared_statement(cache, stmt);
+    execute_prepared_statement(conn, stmt);
 }
 
 static std::optional<int64_t>
 look_up_cas_id_by_digest(
-    ll_disk_cache_impl const& cache, std::string const& digest)
+    ll_disk_cache_connection const& conn, std::string const& digest)
 {
-    auto* stmt = cache.cas_lookup_by_digest_query;
+    auto* stmt = conn.cas_lookup_by_digest_query;
     bind_string(stmt, 1, digest);
     bool exists = false;
     int64_t cas_id{};
     execute_prepared_statement(
-        cache,
+        conn,
         stmt,
         expected_column_count{1},
         single_row_result{false},
@@ -717,34 +792,50 @@ struct internal_cas_entry_t
     int64_t original_size;
 };
 
+// Reads the columns (digest, storage, value, size, original_size), starting
+// at first_column, into entry.
+static void
+read_cas_columns(
+    sqlite_row& row, int first_column, internal_cas_entry_t& entry)
+{
+    entry.digest = read_string(row, first_column);
+    entry.storage = to_storage_t(read_string(row, first_column + 1));
+    entry.value = has_value(row, first_column + 2)
+                      ? std::make_optional(read_blob(row, first_column + 2))
+                      : std::nullopt;
+    entry.size = has_value(row, first_column + 3)
+                     ? read_int64(row, first_column + 3)
+                     : 0;
+    entry.original_size = has_value(row, first_column + 4)
+                              ? read_int64(row, first_column + 4)
+                              : 0;
+}
+
 static internal_cas_entry_t
-look_up_internal_cas_entry(ll_disk_cache_impl const& cache, int64_t cas_id)
+look_up_internal_cas_entry(
+    ll_disk_cache_connection const& conn, int64_t cas_id)
 {
-    auto* stmt = cache.cas_lookup_query;
+    auto* stmt = conn.cas_lookup_query;
     bind_int64(stmt, 1, cas_id);
     internal_cas_entry_t entry{};
     execute_prepared_statement(
-        cache,
+        conn,
         stmt,
         expected_column_count{5},
         single_row_result{true},
         [&](sqlite_row& row) {
             entry.cas_id = cas_id;
-            entry.digest = read_string(row, 0);
-            entry.storage = to_storage_t(read_string(row, 1));
-            entry.value = has_value(row, 2)
-                              ? std::make_optional(read_blob(row, 2))
-                              : std::nullopt;
-            entry.size = has_value(row, 3) ? read_int64(row, 3) : 0;
-            entry.original_size = has_value(row, 4) ? read_int64(row, 4) : 0;
+            read_cas_columns(row, 0, entry);
         });
     return entry;
 }
 
+// Converts an internal CAS entry to the form returned by the API; returns
+// nullopt if the entry is invalid.
 static std::optional<ll_disk_cache_cas_entry>
-look_up_cas_entry(ll_disk_cache_impl const& cache, int64_t cas_id)
+to_cas_entry(
+    ll_disk_cache_connection const& conn, internal_cas_entry_t internal_entry)
 {
-    auto internal_entry = look_up_internal_cas_entry(cache, cas_id);
     if (internal_entry.storage == storage_t::invalid)
     {
         return std::nullopt;
@@ -752,7 +843,7 @@ look_up_cas_entry(ll_disk_cache_impl const& cache, int64_t cas_id)
     auto opt_value = std::move(internal_entry.value);
     if (internal_entry.storage == storage_t::blob_file)
     {
-        cache.logger->debug(" looked up blob file {}", to_string(*opt_value));
+        conn.logger->debug(" looked up blob file {}", to_string(*opt_value));
         file_path path{to_string(*opt_value)};
         auto owner = std::make_shared<blob_file_reader>(path);
         opt_value = blob{owner, owner->bytes(), owner->size()};
@@ -767,12 +858,12 @@ look_up_cas_entry(ll_disk_cache_impl const& cache, int64_t cas_id)
 
 // Get the number of entries in the CAS.
 static int64_t
-get_cas_entry_count(ll_disk_cache_impl& cache)
+get_cas_entry_count(ll_disk_cache_connection& conn)
 {
     int64_t count{};
     execute_prepared_statement(
-        cache,
-        cache.cas_entry_count_query,
+        conn,
+        conn.cas_entry_count_query,
         expected_column_count{1},
         single_row_result{true},
         [&](sqlite_row& row) { count = read_int64(row, 0); });
@@ -781,12 +872,12 @@ get_cas_entry_count(ll_disk_cache_impl& cache)
 
 // Returns the total size of all entries in the CAS.
 static int64_t
-get_total_cas_size(ll_disk_cache_impl& cache)
+get_total_cas_size(ll_disk_cache_connection& conn)
 {
     int64_t size{};
     execute_prepared_statement(
-        cache,
-        cache.total_cas_size_query,
+        conn,
+        conn.total_cas_size_query,
         expected_column_count{1},
         single_row_result{true},
         [&](sqlite_row& row) { size = read_int64(row, 0); });
@@ -795,36 +886,36 @@ get_total_cas_size(ll_disk_cache_impl& cache)
 
 // Returns the number of AC records referring to the specified CAS record.
 static int64_t
-count_cas_entry_refs(ll_disk_cache_impl& cache, int64_t cas_id)
+count_cas_entry_refs(ll_disk_cache_connection& conn, int64_t cas_id)
 {
-    auto* stmt = cache.count_cas_entry_refs_query;
+    auto* stmt = conn.count_cas_entry_refs_query;
     bind_int64(stmt, 1, cas_id);
     int64_t count{};
     execute_prepared_statement(
-        cache,
+        conn,
         stmt,
         expected_column_count{1},
         single_row_result{true},
         [&](sqlite_row& row) { count = read_int64(row, 0); });
-    cache.logger->debug(" count_cas_entry_refs({}) -> {}", cas_id, count);
+    conn.logger->debug(" count_cas_entry_refs({}) -> {}", cas_id, count);
     return count;
 }
 
 static void
-remove_cas_entry_db_only(ll_disk_cache_impl& cache, int64_t cas_id)
+remove_cas_entry_db_only(ll_disk_cache_connection& conn, int64_t cas_id)
 {
-    auto* stmt = cache.remove_cas_entry_statement;
+    auto* stmt = conn.remove_cas_entry_statement;
     bind_int64(stmt, 1, cas_id);
-    execute_prepared_statement(cache, stmt);
+    execute_prepared_statement(conn, stmt);
 }
 
 // OPERATIONS ON THE CAS (FILE ONLY)
 
 static file_path
-get_path_for_digest(ll_disk_cache_impl& cache, std::string const& digest)
+get_path_for_digest(file_path const& dir, std::string const& digest)
 {
     // The digest is used as filename.
-    return cache.dir / digest;
+    return dir / digest;
 }
 
 // OPERATIONS ON THE CAS (DB AND FILE)
@@ -833,14 +924,14 @@ get_path_for_digest(ll_disk_cache_impl& cache, std::string const& digest)
 // file if any. Does not remove a blob file.
 // Returns the size of the removed CAS entry.
 static int64_t
-remove_cas_entry_db_and_file(ll_disk_cache_impl& cache, int64_t cas_id)
+remove_cas_entry_db_and_file(ll_disk_cache_connection& conn, int64_t cas_id)
 {
-    auto entry = look_up_internal_cas_entry(cache, cas_id);
+    auto entry = look_up_internal_cas_entry(conn, cas_id);
     auto size_diff = entry.size;
-    remove_cas_entry_db_only(cache, cas_id);
+    remove_cas_entry_db_only(conn, cas_id);
     if (entry.storage == storage_t::in_file)
     {
-        auto path{get_path_for_digest(cache, entry.digest)};
+        auto path{get_path_for_digest(conn.dir, entry.digest)};
         if (exists(path))
         {
             remove(path);
@@ -851,25 +942,73 @@ remove_cas_entry_db_and_file(ll_disk_cache_impl& cache, int64_t cas_id)
 
 // OPERATIONS ON COMBINED AC AND CAS
 
-// Returns the CAS entry, if any, associated with a particular AC key.
+// The result of looking up an AC key
+struct ac_look_up_result
+{
+    int64_t ac_id;
+
+    // The CAS entry the AC entry refers to; nullopt if the value will be in
+    // a file, but the write has not finished.
+    std::optional<ll_disk_cache_cas_entry> cas_entry;
+};
+
+// Looks up the AC entry for ac_key, and the CAS entry it refers to, in a
+// single query (so the two are consistent even while the writer is active).
 //
 // There are several possibilities:
 // - The entry is not in the AC: return nullopt.
 // - The entry exists in the AC and the value is in the database:
-//   return an object with value set to something non-nullopt.
+//   cas_entry->value is set to something non-nullopt.
 // - The entry exists in the AC and the value is in a file:
-//   return an object with value set to nullopt.
+//   cas_entry->value is nullopt.
 // - The entry exists in the AC, the value will be in a file, but the write has
-//   not finished: return nullopt.
-static std::optional<ll_disk_cache_cas_entry>
-look_up(ll_disk_cache_impl& cache, std::string const& ac_key)
+//   not finished: cas_entry is nullopt.
+static std::optional<ac_look_up_result>
+look_up(ll_disk_cache_connection& conn, std::string const& ac_key)
 {
-    auto opt_cas_id = look_up_cas_id(cache, ac_key);
-    if (!opt_cas_id)
+    auto* stmt = conn.cas_lookup_by_ac_key_query;
+    bind_string(stmt, 1, ac_key);
+    bool exists = false;
+    int64_t ac_id{};
+    internal_cas_entry_t entry{};
+    execute_prepared_statement(
+        conn,
+        stmt,
+        expected_column_count{7},
+        single_row_result{false},
+        [&](sqlite_row& row) {
+            ac_id = read_int64(row, 0);
+            entry.cas_id = read_int64(row, 1);
+            read_cas_columns(row, 2, entry);
+            exists = true;
+        });
+    if (!exists)
     {
         return std::nullopt;
     }
-    return look_up_cas_entry(cache, *opt_cas_id);
+    return ac_look_up_result{
+        .ac_id = ac_id, .cas_entry = to_cas_entry(conn, std::move(entry))};
+}
+
+// Returns true iff look_up(conn, ac_key) would find a valid CAS entry,
+// without opening the file holding its value.
+static bool
+has_valid_entry(ll_disk_cache_connection& conn, std::string const& ac_key)
+{
+    auto* stmt = conn.cas_lookup_by_ac_key_query;
+    bind_string(stmt, 1, ac_key);
+    bool valid = false;
+    execute_prepared_statement(
+        conn,
+        stmt,
+        expected_column_count{7},
+        single_row_result{false},
+        [&](sqlite_row& row) {
+            internal_cas_entry_t entry{};
+            read_cas_columns(row, 2, entry);
+            valid = entry.storage != storage_t::invalid;
+        });
+    return valid;
 }
 
 // Removes the specified AC entry, and the CAS entry it refers to if this is
@@ -877,15 +1016,15 @@ look_up(ll_disk_cache_impl& cache, std::string const& ac_key)
 // was removed.
 static int64_t
 remove_ac_entry_with_cas_entry(
-    ll_disk_cache_impl& cache, int64_t ac_id, int64_t cas_id)
+    ll_disk_cache_connection& conn, int64_t ac_id, int64_t cas_id)
 {
     int64_t size_diff{0};
-    remove_ac_entry(cache, ac_id);
-    if (count_cas_entry_refs(cache, cas_id) == 0)
+    remove_ac_entry(conn, ac_id);
+    if (count_cas_entry_refs(conn, cas_id) == 0)
     {
-        cache.logger->info(" removing stale CAS entry {}", cas_id);
-        size_diff = remove_cas_entry_db_and_file(cache, cas_id);
-        cache.logger->info(" reclaimed {} bytes", size_diff);
+        conn.logger->info(" removing stale CAS entry {}", cas_id);
+        size_diff = remove_cas_entry_db_and_file(conn, cas_id);
+        conn.logger->info(" reclaimed {} bytes", size_diff);
     }
     return size_diff;
 }
@@ -893,24 +1032,24 @@ remove_ac_entry_with_cas_entry(
 // Removes the specified AC entry, and the CAS entry it refers to if this is
 // the last reference.
 static void
-remove_ac_entry_with_cas_entry(ll_disk_cache_impl& cache, int64_t ac_id)
+remove_ac_entry_with_cas_entry(ll_disk_cache_connection& conn, int64_t ac_id)
 {
-    int64_t cas_id{get_cas_id_for_ac_entry(cache, ac_id)};
-    remove_ac_entry_with_cas_entry(cache, ac_id, cas_id);
+    int64_t cas_id{get_cas_id_for_ac_entry(conn, ac_id)};
+    remove_ac_entry_with_cas_entry(conn, ac_id, cas_id);
 }
 
 static void
-remove_all_entries(ll_disk_cache_impl& cache)
+remove_all_entries(ll_disk_cache_connection& conn)
 {
-    for (auto const& entry : get_ac_lru_entries(cache))
+    for (auto const& entry : get_ac_lru_entries(conn))
     {
         try
         {
-            remove_ac_entry_with_cas_entry(cache, entry.ac_id, entry.cas_id);
+            remove_ac_entry_with_cas_entry(conn, entry.ac_id, entry.cas_id);
         }
         catch (std::exception const& e)
         {
-            cache.logger->error(
+            conn.logger->error(
                 "Error removing entries {}/{}: {}",
                 entry.ac_id,
                 entry.cas_id,
@@ -929,34 +1068,40 @@ remove_all_entries(ll_disk_cache_impl& cache)
 // The solution is to have cache initialization remove invalid entries, so that
 // a new initiate_insert() can proceed.
 static void
-remove_invalid_entries(ll_disk_cache_impl& cache)
+remove_invalid_entries(ll_disk_cache_connection& conn)
 {
-    cache.logger->info("deleting invalid entries");
+    conn.logger->info("deleting invalid entries");
     // Delete AC entries referring to an invalid CAS entry.
     execute_sql(
-        cache,
+        conn,
         "delete from actions where cas_id in"
         " (select cas_id from cas where storage == 'X');");
     // Delete the invalid CAS entries themselves.
-    execute_sql(cache, "delete from cas where storage == 'X';");
+    execute_sql(conn, "delete from cas where storage == 'X';");
 }
 
 // OTHER UTILITIES
 
+// Evicts LRU entries until the cache fits its size limit; the evictions are
+// committed in a single transaction.
 static void
 enforce_cache_size_limit(ll_disk_cache_impl& cache)
 {
+    auto& conn = cache.write_connection;
     try
     {
-        int64_t size = get_total_cas_size(cache);
-        if (size > cache.size_limit)
-        {
-            for (auto const& i : get_ac_lru_entries(cache))
+        run_in_transaction(conn, "begin immediate;", [&] {
+            int64_t size = get_total_cas_size(conn);
+            if (size <= cache.size_limit)
+            {
+                return;
+            }
+            for (auto const& i : get_ac_lru_entries(conn))
             {
                 try
                 {
                     auto size_diff = remove_ac_entry_with_cas_entry(
-                        cache, i.ac_id, i.cas_id);
+                        conn, i.ac_id, i.cas_id);
                     size -= size_diff;
                     if (size <= cache.size_limit)
                     {
@@ -972,7 +1117,7 @@ enforce_cache_size_limit(ll_disk_cache_impl& cache)
                         short_what(e));
                 }
             }
-        }
+        });
         cache.bytes_inserted_since_last_sweep = 0;
     }
     catch (std::exception const& e)
@@ -985,70 +1130,384 @@ enforce_cache_size_limit(ll_disk_cache_impl& cache)
 static void
 record_activity(ll_disk_cache_impl& cache)
 {
+    std::scoped_lock<std::mutex> lock(cache.usage_mutex);
     cache.latest_activity = std::chrono::system_clock::now();
 }
 
+// Notes that the AC entry was read, so that its usage will be written to the
+// database by a future flush_ac_usage().
+static void
+note_ac_usage(ll_disk_cache_impl& cache, int64_t ac_id)
+{
+    std::scoped_lock<std::mutex> lock(cache.usage_mutex);
+    // Add ac_id to ac_ids_to_flush, ensuring no duplicates appear. In a
+    // production environment, the memory cache will (or should) already ensure
+    // this, but benchmark tests that measure just disk cache performance
+    // do not.
+    // A compromise is to first check on ac_id's presence. This has no
+    // measurable performance impact, and prevents negative impact on benchmark
+    // output.
+    if (std::find(
+            cache.ac_ids_to_flush.begin(), cache.ac_ids_to_flush.end(), ac_id)
+        == cache.ac_ids_to_flush.end())
+    {
+        cache.ac_ids_to_flush.push_back(ac_id);
+    }
+}
+
+// Records the outcome of a look-up: the AC entry's usage, and the hit / miss
+// statistics. Returns the CAS entry, if any.
+static std::optional<ll_disk_cache_cas_entry>
+record_look_up(
+    ll_disk_cache_impl& cache, std::optional<ac_look_up_result> result)
+{
+    if (!result)
+    {
+        cache.miss_count += 1;
+        return std::nullopt;
+    }
+    note_ac_usage(cache, result->ac_id);
+    if (result->cas_entry)
+    {
+        cache.hit_count += 1;
+    }
+    else
+    {
+        cache.miss_count += 1;
+    }
+    return std::move(result->cas_entry);
+}
+
+// Called on the writer thread only, from a write job; the growth counts
+// once the job's batch has been committed.
 static void
 record_cache_growth(ll_disk_cache_impl& cache, uint64_t size)
 {
-    cache.bytes_inserted_since_last_sweep += size;
-    // Allow the cache to write out roughly 1% of its capacity between size
-    // checks. (So it could exceed its limit slightly, but only temporarily,
-    // and not by much.)
-    // Size checks on the database could also be avoided by locally keeping
-    // track of total CAS size.
-    if (cache.bytes_inserted_since_last_sweep > cache.size_limit / 0x80)
+    cache.bytes_inserted_in_batch += size;
+}
+
+// Allow the cache to write out roughly 1% of its capacity between size
+// checks. (So it could exceed its limit slightly, but only temporarily,
+// and not by much.)
+// Size checks on the database could also be avoided by locally keeping
+// track of total CAS size.
+static bool
+should_enforce_cache_size_limit(ll_disk_cache_impl const& cache)
+{
+    return cache.bytes_inserted_since_last_sweep > cache.size_limit / 0x80;
+}
+
+// READ CONNECTIONS
+
+// Borrows an idle read connection for the lifetime of this object, waiting
+// for one if they are all in use.
+class read_connection_lease
+{
+ public:
+    explicit read_connection_lease(ll_disk_cache_impl& cache) : cache_{cache}
+    {
+        std::unique_lock<std::mutex> lock(cache_.read_connections_mutex);
+        cache_.read_connections_cv.wait(
+            lock, [&] { return !cache_.idle_read_connections.empty(); });
+        conn_ = cache_.idle_read_connections.back();
+        cache_.idle_read_connections.pop_back();
+    }
+
+    ~read_connection_lease()
+    {
+        {
+            std::scoped_lock<std::mutex> lock(cache_.read_connections_mutex);
+            cache_.idle_read_connections.push_back(conn_);
+        }
+        cache_.read_connections_cv.notify_one();
+    }
+
+    read_connection_lease(read_connection_lease const&) = delete;
+    read_connection_lease&
+    operator=(read_connection_lease const&) = delete;
+
+    ll_disk_cache_connection&
+    get() const
+    {
+        return *conn_;
+    }
+
+ private:
+    ll_disk_cache_impl& cache_;
+    ll_disk_cache_connection* conn_;
+};
+
+// WRITER THREAD
+
+// Maximum number of jobs committed in a single transaction
+static constexpr std::size_t max_write_batch_size = 256;
+
+static void
+submit_write_job(ll_disk_cache_impl& cache, ll_disk_cache_write_job job)
+{
+    {
+        std::scoped_lock<std::mutex> lock(cache.write_queue_mutex);
+        cache.write_queue.push_back(std::move(job));
+    }
+    cache.write_queue_cv.notify_one();
+}
+
+// Has the writer thread run fn, and waits until the transaction that fn was
+// part of has been committed. Returns what fn returned, or rethrows what it
+// threw.
+template<class Fn>
+static std::invoke_result_t<Fn, ll_disk_cache_impl&>
+run_write_job(ll_disk_cache_impl& cache, Fn const& fn)
+{
+    using result_t = std::invoke_result_t<Fn, ll_disk_cache_impl&>;
+    auto done = std::make_shared<std::promise<void>>();
+    auto committed = done->get_future();
+    if constexpr (std::is_void_v<result_t>)
+    {
+        submit_write_job(
+            cache,
+            ll_disk_cache_write_job{
+                [&](ll_disk_cache_impl& impl) { fn(impl); },
+                std::move(done)});
+        committed.get();
+    }
+    else
+    {
+        std::optional<result_t> result;
+        submit_write_job(
+            cache,
+            ll_disk_cache_write_job{
+                [&](ll_disk_cache_impl& impl) { result = fn(impl); },
+                std::move(done)});
+        committed.get();
+        return std::move(*result);
+    }
+}
+
+static void
+complete_write_job(
+    ll_disk_cache_impl& cache,
+    ll_disk_cache_write_job& job,
+    std::exception_ptr const& error)
+{
+    if (job.done)
+    {
+        if (error)
+        {
+            job.done->set_exception(error);
+        }
+        else
+        {
+            job.done->set_value();
+        }
+    }
+    else if (error)
+    {
+        try
+        {
+            std::rethrow_exception(error);
+        }
+        catch (std::exception const& e)
+        {
+            cache.logger->error("disk cache write failed: {}", short_what(e));
+        }
+    }
+}
+
+// Performs a batch of jobs in a single transaction, so that they share the
+// cost of a commit. Each job runs in its own savepoint, so that a failing job
+// does not affect the other ones.
+static void
+run_write_batch(
+    ll_disk_cache_impl& cache, std::vector<ll_disk_cache_write_job>& batch)
+{
+    auto& conn = cache.write_connection;
+    std::vector<std::exception_ptr> errors(batch.size());
+    cache.bytes_inserted_in_batch = 0;
+    try
+    {
+        execute_sql(conn, "begin immediate;");
+        for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+            auto growth_before_job = cache.bytes_inserted_in_batch;
+            execute_sql(conn, "savepoint job;");
+            try
+            {
+                batch[i].execute(cache);
+                execute_sql(conn, "release job;");
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+                execute_sql(conn, "rollback to job; release job;");
+                cache.bytes_inserted_in_batch = growth_before_job;
+            }
+        }
+        execute_sql(conn, "commit transaction;");
+        cache.bytes_inserted_since_last_sweep += cache.bytes_inserted_in_batch;
+    }
+    catch (...)
+    {
+        // The transaction as a whole failed, taking all jobs with it.
+        if (!sqlite3_get_autocommit(conn.db))
+        {
+            sqlite3_exec(conn.db, "rollback transaction;", 0, 0, nullptr);
+        }
+        std::fill(errors.begin(), errors.end(), std::current_exception());
+    }
+    // Evict entries before reporting the jobs as done, so that the cache
+    // has its expected size when the writers continue.
+    if (should_enforce_cache_size_limit(cache))
     {
         enforce_cache_size_limit(cache);
     }
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        complete_write_job(cache, batch[i], errors[i]);
+    }
 }
 
+// The writer thread's main function. Jobs that are submitted while a batch
+// is being committed form the next batch.
 static void
-shut_down(ll_disk_cache_impl& cache)
+run_writer(ll_disk_cache_impl& cache)
+{
+    std::vector<ll_disk_cache_write_job> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(cache.write_queue_mutex);
+            cache.write_queue_cv.wait(lock, [&] {
+                return cache.stop_writing || !cache.write_queue.empty();
+            });
+            if (cache.write_queue.empty())
+            {
+                // Asked to stop, and all jobs have been done
+                return;
+            }
+            while (!cache.write_queue.empty()
+                   && batch.size() < max_write_batch_size)
+            {
+                batch.push_back(std::move(cache.write_queue.front()));
+                cache.write_queue.pop_front();
+            }
+        }
+        run_write_batch(cache, batch);
+        batch.clear();
+    }
+}
+
+static void
+start_writer(ll_disk_cache_impl& cache)
+{
+    cache.stop_writing = false;
+    cache.writer = std::thread{run_writer, std::ref(cache)};
+}
+
+// Stops the writer thread once it has done all jobs submitted so far.
+static void
+stop_writer(ll_disk_cache_impl& cache)
 {
-    if (cache.db)
     {
-        sqlite3_finalize(cache.database_version_query);
+        std::scoped_lock<std::mutex> lock(cache.write_queue_mutex);
+        cache.stop_writing = true;
+    }
+    cache.write_queue_cv.notify_one();
+    cache.writer.join();
+}
 
-        sqlite3_finalize(cache.insert_ac_entry_statement);
-        sqlite3_finalize(cache.ac_lookup_query);
-        sqlite3_finalize(cache.get_cas_id_from_ac_query);
-        sqlite3_finalize(cache.ac_entry_count_query);
-        sqlite3_finalize(cache.ac_lru_entry_list_query);
-        sqlite3_finalize(cache.record_ac_usage_statement);
-        sqlite3_finalize(cache.remove_ac_entry_statement);
+// Takes the AC usage that still needs to be written to the database. If
+// forced is false, takes nothing unless should_flush_ac_usage() says so.
+static std::vector<int64_t>
+take_ac_ids_to_flush(ll_disk_cache_impl& cache, bool forced)
+{
+    std::scoped_lock<std::mutex> lock(cache.usage_mutex);
+    std::vector<int64_t> ac_ids;
+    if (forced || should_flush_ac_usage(cache))
+    {
+        ac_ids.swap(cache.ac_ids_to_flush);
+    }
+    return ac_ids;
+}
 
-        sqlite3_finalize(cache.cas_insert_statement);
-        sqlite3_finalize(cache.initiate_cas_insert_statement);
-        sqlite3_finalize(cache.finish_cas_insert_statement);
-        sqlite3_finalize(cache.cas_lookup_by_digest_query);
-        sqlite3_finalize(cache.cas_lookup_query);
-        sqlite3_finalize(cache.cas_entry_count_query);
-        sqlite3_finalize(cache.total_cas_size_query);
-        sqlite3_finalize(cache.count_cas_entry_refs_query);
-        sqlite3_finalize(cache.remove_cas_entry_statement);
+// INITIALIZATION AND SHUTDOWN
 
-        sqlite3_close(cache.db);
-        cache.db = nullptr;
+static void
+close_connection(ll_disk_cache_connection& conn)
+{
+    if (conn.db)
+    {
+        // sqlite3_finalize() is a no-op for statements that weren't prepared
+        sqlite3_finalize(conn.database_version_query);
+
+        sqlite3_finalize(conn.insert_ac_entry_statement);
+        sqlite3_finalize(conn.ac_lookup_query);
+        sqlite3_finalize(conn.get_cas_id_from_ac_query);
+        sqlite3_finalize(conn.ac_entry_count_query);
+        sqlite3_finalize(conn.ac_lru_entry_list_query);
+        sqlite3_finalize(conn.record_ac_usage_statement);
+        sqlite3_finalize(conn.remove_ac_entry_statement);
+
+        sqlite3_finalize(conn.cas_insert_statement);
+        sqlite3_finalize(conn.initiate_cas_insert_statement);
+        sqlite3_finalize(conn.finish_cas_insert_statement);
+        sqlite3_finalize(conn.cas_lookup_by_digest_query);
+        sqlite3_finalize(conn.cas_lookup_query);
+        sqlite3_finalize(conn.cas_lookup_by_ac_key_query);
+        sqlite3_finalize(conn.cas_entry_count_query);
+        sqlite3_finalize(conn.total_cas_size_query);
+        sqlite3_finalize(conn.count_cas_entry_refs_query);
+        sqlite3_finalize(conn.remove_cas_entry_statement);
+
+        sqlite3_close(conn.db);
     }
+    conn = ll_disk_cache_connection{};
+}
+
+static void
+shut_down(ll_disk_cache_impl& cache)
+{
+    if (cache.writer.joinable())
+    {
+        // Write out any pending usage information before stopping.
+        auto ac_ids = take_ac_ids_to_flush(cache, true);
+        if (!ac_ids.empty())
+        {
+            submit_write_job(
+                cache,
+                ll_disk_cache_write_job{
+                    [ac_ids = std::move(ac_ids)](ll_disk_cache_impl& impl) {
+                        flush_ac_usage(impl.write_connection, ac_ids);
+                    },
+                    nullptr});
+        }
+        stop_writer(cache);
+    }
+    cache.idle_read_connections.clear();
+    for (auto& conn : cache.read_connections)
+    {
+        close_connection(*conn);
+    }
+    cache.read_connections.clear();
+    close_connection(cache.write_connection);
 }
 
 // Open (or create) the database file and verify that the version number is
 // what we expect.
 static void
-open_and_check_db(ll_disk_cache_impl& cache)
+open_and_check_db(ll_disk_cache_connection& conn)
 {
     int const expected_database_version = 5;
 
-    open_db(&cache.db, cache.dir / "index.db");
+    open_db(&conn.db, conn.dir / "index.db");
 
     // Get the version number embedded in the database.
-    cache.database_version_query
-        = prepare_statement(cache, "pragma user_version;");
+    conn.database_version_query
+        = prepare_statement(conn, "pragma user_version;");
     int database_version{};
     execute_prepared_statement(
-        cache,
-        cache.database_version_query,
+        conn,
+        conn.database_version_query,
         expected_column_count{1},
         single_row_result{true},
         [&](sqlite_row& row) { database_version = read_int32(row, 0); });
@@ -1056,10 +1515,10 @@ open_and_check_db(ll_disk_cache_impl& cache)
     // A database_version of 0 indicates a fresh database, so initialize it.
     if (database_version == 0)
     {
-        cache.logger->info("creating tables on fresh database");
+        conn.logger->info("creating tables on fresh database");
         // Create the CAS part of the cache.
         execute_sql(
-            cache,
+            conn,
             "create table cas("
             " cas_id integer primary key,"
             " digest text unique not null,"
@@ -1069,14 +1528,14 @@ open_and_check_db(ll_disk_cache_impl& cache)
             " original_size integer);");
         // Create the AC part of the cache
         execute_sql(
-            cache,
+            conn,
             "create table actions("
             " ac_id integer primary key,"
             " key text unique not null,"
             " cas_id integer not null,"
             " last_accessed datetime);");
         execute_sql(
-            cache,
+            conn,
             fmt::format(
                 "pragma user_version = {};", expected_database_version));
 
@@ -1084,11 +1543,11 @@ open_and_check_db(ll_disk_cache_impl& cache)
         // it.
         // Try to speed up key lookup (ac_lookup_query); used every time the
         // cache is consulted:
-        // execute_sql(cache,
+        // execute_sql(conn,
         //   "create unique index actions_key on actions(key);");
         // Try to speed up count_cas_entry_refs_query; used when an actions
         // entry is deleted:
-        // execute_sql(cache,
+        // execute_sql(conn,
         //   "create index actions_cas_id on actions(cas_id);");
     }
     // If we find a database from a different version, abort.
@@ -1096,11 +1555,92 @@ open_and_check_db(ll_disk_cache_impl& cache)
     {
         CRADLE_THROW(
             ll_disk_cache_failure()
-            << ll_disk_cache_path_info(cache.dir)
+            << ll_disk_cache_path_info(conn.dir)
             << internal_error_message_info("incompatible database"));
     }
 }
 
+// Time that a connection waits for a lock held by another connection. With
+// a single writer and WAL, this should happen only in rare cases (e.g., while
+// a checkpoint is being performed).
+static constexpr int busy_timeout_ms = 10'000;
+
+// Prepares the statements that are needed on read connections.
+static void
+prepare_read_statements(ll_disk_cache_connection& conn)
+{
+    conn.ac_lookup_query = prepare_statement(
+        conn, "select ac_id, cas_id from actions where key=?1;");
+    conn.ac_entry_count_query
+        = prepare_statement(conn, "select count(*) from actions;");
+    conn.cas_lookup_by_ac_key_query = prepare_statement(
+        conn,
+        "select actions.ac_id, cas.cas_id, cas.digest, cas.storage,"
+        " cas.value, cas.size, cas.original_size"
+        " from actions join cas on cas.cas_id = actions.cas_id"
+        " where actions.key=?1;");
+    conn.cas_entry_count_query
+        = prepare_statement(conn, "select count(*) from cas;");
+    conn.total_cas_size_query
+        = prepare_statement(conn, "select sum(size) from cas;");
+}
+
+// Prepares the statements that are needed on the write connection only.
+static void
+prepare_write_statements(ll_disk_cache_connection& conn)
+{
+    conn.insert_ac_entry_statement = prepare_statement(
+        conn,
+        "insert into actions"
+        " (key, cas_id, last_accessed)"
+        " values(?1, ?2, strftime('%Y-%m-%d %H:%M:%f', 'now'));");
+    conn.get_cas_id_from_ac_query = prepare_statement(
+        conn, "select cas_id from actions where ac_id=?1;");
+    conn.ac_lru_entry_list_query = prepare_statement(
+        conn,
+        "select ac_id, cas_id from actions"
+        " order by last_accessed;");
+    conn.record_ac_usage_statement = prepare_statement(
+        conn,
+        "update actions set last_accessed=strftime('%Y-%m-%d %H:%M:%f', 'now')"
+        " where ac_id=?1;");
+    conn.remove_ac_entry_statement
+        = prepare_statement(conn, "delete from actions where ac_id=?1;");
+
+    conn.cas_insert_statement = prepare_statement(
+        conn,
+        "insert into cas(digest, storage, value, size, original_size) "
+        "values (?1, ?2, ?3, ?4, ?5);");
+    conn.initiate_cas_insert_statement = prepare_statement(
+        conn, "insert into cas(digest, storage) values (?1, 'X');");
+    conn.finish_cas_insert_statement = prepare_statement(
+        conn,
+        "update cas set storage='F', size=?1, original_size=?2"
+        " where cas_id=?3;");
+    conn.cas_lookup_by_digest_query
+        = prepare_statement(conn, "select cas_id from cas where digest=?1;");
+    conn.cas_lookup_query = prepare_statement(
+        conn,
+        "select digest, storage, value, size, original_size"
+        " from cas where cas_id=?1;");
+    conn.count_cas_entry_refs_query = prepare_statement(
+        conn, "select count(*) from actions where cas_id=?1;");
+    conn.remove_cas_entry_statement
+        = prepare_statement(conn, "delete from cas where cas_id=?1;");
+}
+
+static void
+open_read_connection(
+    ll_disk_cache_impl const& cache, ll_disk_cache_connection& conn)
+{
+    conn.dir = cache.dir;
+    conn.logger = cache.logger;
+    open_db(&conn.db, conn.dir / "index.db");
+    check_sqlite_code(sqlite3_busy_timeout(conn.db, busy_timeout_ms));
+    execute_sql(conn, "pragma query_only = on;");
+    prepare_read_statements(conn);
+}
+
 static void
 initialize(ll_disk_cache_impl& cache, ll_disk_cache_config const& config)
 {
@@ -1109,6 +1649,8 @@ initialize(ll_disk_cache_impl& cache, ll_disk_cache_config const& config)
                     : get_shared_cache_dir(std::nullopt, "cradle");
     cache.size_limit = config.size_limit.value_or(0x40'00'00'00);
     cache.logger = ensure_logger("ll_disk_cache");
+    cache.bytes_inserted_since_last_sweep = 0;
+    spdlog::get("cradle")->info("Using disk cache {}", cache.dir.string());
 
     // Prepare the directory.
     if (config.start_empty)
@@ -1122,9 +1664,12 @@ initialize(ll_disk_cache_impl& cache, ll_disk_cache_config const& config)
     }
 
     // Open the database file.
+    auto& conn = cache.write_connection;
+    conn.dir = cache.dir;
+    conn.logger = cache.logger;
     try
     {
-        open_and_check_db(cache);
+        open_and_check_db(conn);
     }
     catch (std::exception const& e)
     {
@@ -1135,80 +1680,52 @@ initialize(ll_disk_cache_impl& cache, ll_disk_cache_config const& config)
         // again.
         shut_down(cache);
         reset_directory(cache.dir);
-        open_and_check_db(cache);
+        conn.dir = cache.dir;
+        conn.logger = cache.logger;
+        open_and_check_db(conn);
     }
 
     // Set various performance tuning flags.
 
-    // Somewhat dangerous in case of an OS crash or power loss.
-    // Much much faster than FULL or NORMAL unless combined with WAL.
-    execute_sql(cache, "pragma synchronous = off;");
+    // With WAL, readers don't block the writer and vice versa, so look-ups
+    // can proceed on their own connections while the writer thread commits.
+    // Unlike the former "memory" journal, an application crash in the middle
+    // of a transaction does not corrupt the database.
+    execute_sql(conn, "pragma journal_mode = wal;");
 
-    // Much faster than NORMAL
-    execute_sql(cache, "pragma locking_mode = exclusive;");
+    // In WAL mode, NORMAL syncs only when checkpointing, not on each commit;
+    // a commit might be lost on OS crash or power loss, but the database
+    // stays consistent.
+    execute_sql(conn, "pragma synchronous = normal;");
 
-    // Dangerous: if the application crashes in the middle of a transaction,
-    // then the database file will very likely go corrupt.
-    // WAL is safer but slower, and removes the need for the flush_ac_usage
-    // mechanism.
-    execute_sql(cache, "pragma journal_mode = memory;");
+    check_sqlite_code(sqlite3_busy_timeout(conn.db, busy_timeout_ms));
 
     // Initialize our prepared statements.
-    cache.insert_ac_entry_statement = prepare_statement(
-        cache,
-        "insert into actions"
-        " (key, cas_id, last_accessed)"
-        " values(?1, ?2, strftime('%Y-%m-%d %H:%M:%f', 'now'));");
-    cache.ac_lookup_query = prepare_statement(
-        cache, "select ac_id, cas_id from actions where key=?1;");
-    cache.get_cas_id_from_ac_query = prepare_statement(
-        cache, "select cas_id from actions where ac_id=?1;");
-    cache.ac_entry_count_query
-        = prepare_statement(cache, "select count(*) from actions;");
-    cache.ac_lru_entry_list_query = prepare_statement(
-        cache,
-        "select ac_id, cas_id from actions"
-        " order by last_accessed;");
-    cache.record_ac_usage_statement = prepare_statement(
-        cache,
-        "update actions set last_accessed=strftime('%Y-%m-%d %H:%M:%f', 'now')"
-        " where ac_id=?1;");
-    cache.remove_ac_entry_statement
-        = prepare_statement(cache, "delete from actions where ac_id=?1;");
-
-    cache.cas_insert_statement = prepare_statement(
-        cache,
-        "insert into cas(digest, storage, value, size, original_size) "
-        "values (?1, ?2, ?3, ?4, ?5);");
-    cache.initiate_cas_insert_statement = prepare_statement(
-        cache, "insert into cas(digest, storage) values (?1, 'X');");
-    cache.finish_cas_insert_statement = prepare_statement(
-        cache,
-        "update cas set storage='F', size=?1, original_size=?2"
-        " where cas_id=?3;");
-    cache.cas_lookup_by_digest_query
-        = prepare_statement(cache, "select cas_id from cas where digest=?1;");
-    cache.cas_lookup_query = prepare_statement(
-        cache,
-        "select digest, storage, value, size, original_size"
-        " from cas where cas_id=?1;");
-    cache.cas_entry_count_query
-        = prepare_statement(cache, "select count(*) from cas;");
-    cache.total_cas_size_query
-        = prepare_statement(cache, "select sum(size) from cas;");
-    cache.count_cas_entry_refs_query = prepare_statement(
-        cache, "select count(*) from actions where cas_id=?1;");
-    cache.remove_cas_entry_statement
-        = prepare_statement(cache, "delete from cas where cas_id=?1;");
+    prepare_read_statements(conn);
+    prepare_write_statements(conn);
 
     if (config.start_empty)
     {
-        remove_all_entries(cache);
+        remove_all_entries(conn);
     }
     // Do initial housekeeping.
-    remove_invalid_entries(cache);
+    remove_invalid_entries(conn);
     record_activity(cache);
     enforce_cache_size_limit(cache);
+
+    // Open the read connections; they need the database to be in WAL mode.
+    auto num_read_connections
+        = std::max(config.num_read_connections, std::size_t{1});
+    for (std::size_t i = 0; i < num_read_connections; ++i)
+    {
+        cache.read_connections.push_back(
+            std::make_unique<ll_disk_cache_connection>());
+        open_read_connection(cache, *cache.read_connections.back());
+        cache.idle_read_connections.push_back(
+            cache.read_connections.back().get());
+    }
+
+    start_writer(cache);
 }
 
 // API
@@ -1235,7 +1752,7 @@ void
 ll_disk_cache::reset(ll_disk_cache_config const& config)
 {
     auto& cache = *this->impl_;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::unique_lock<std::shared_mutex> lock(cache.mutex);
 
     shut_down(cache);
     initialize(cache, config);
@@ -1245,14 +1762,19 @@ disk_cache_info
 ll_disk_cache::get_summary_info()
 {
     auto& cache = *this->impl_;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
     disk_cache_info info;
     info.directory = cache.dir.string();
     info.size_limit = cache.size_limit;
-    info.ac_entry_count = get_ac_entry_count(cache);
-    info.cas_entry_count = get_cas_entry_count(cache);
-    info.total_size = get_total_cas_size(cache);
+    read_connection_lease lease{cache};
+    auto& conn = lease.get();
+    // A (read) transaction makes the counts consistent with each other.
+    run_in_transaction(conn, "begin transaction;", [&] {
+        info.ac_entry_count = get_ac_entry_count(conn);
+        info.cas_entry_count = get_cas_entry_count(conn);
+        info.total_size = get_total_cas_size(conn);
+    });
     info.hit_count = cache.hit_count;
     info.miss_count = cache.miss_count;
     return info;
@@ -1263,9 +1785,11 @@ ll_disk_cache::remove_entry(int64_t ac_id)
 {
     auto& cache = *this->impl_;
     cache.logger->info("remove_entry: ac_id {}", ac_id);
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
-    remove_ac_entry_with_cas_entry(cache, ac_id);
+    run_write_job(cache, [&](ll_disk_cache_impl& impl) {
+        remove_ac_entry_with_cas_entry(impl.write_connection, ac_id);
+    });
 }
 
 void
@@ -1273,30 +1797,69 @@ ll_disk_cache::clear()
 {
     auto& cache = *this->impl_;
     cache.logger->info("clear");
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
-    remove_all_entries(cache);
+    run_write_job(cache, [](ll_disk_cache_impl& impl) {
+        remove_all_entries(impl.write_connection);
+    });
 }
 
 std::optional<ll_disk_cache_cas_entry>
 ll_disk_cache::find(std::string const& ac_key)
 {
     auto& cache = *this->impl_;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
     record_activity(cache);
 
-    auto result = look_up(cache, ac_key);
-    if (result)
+    std::optional<ac_look_up_result> result;
     {
-        cache.hit_count += 1;
+        read_connection_lease lease{cache};
+        result = look_up(lease.get(), ac_key);
     }
-    else
+    return record_look_up(cache, std::move(result));
+}
+
+std::vector<std::optional<ll_disk_cache_cas_entry>>
+ll_disk_cache::find_many(std::vector<std::string> const& ac_keys)
+{
+    auto& cache = *this->impl_;
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
+
+    record_activity(cache);
+
+    std::vector<std::optional<ac_look_up_result>> results;
+    results.reserve(ac_keys.size());
     {
-        cache.miss_count += 1;
+        read_connection_lease lease{cache};
+        for (auto const& ac_key : ac_keys)
+        {
+            results.push_back(look_up(lease.get(), ac_key));
+        }
     }
+    std::vector<std::optional<ll_disk_cache_cas_entry>> entries;
+    entries.reserve(results.size());
+    for (auto& result : results)
+    {
+        entries.push_back(record_look_up(cache, std::move(result)));
+    }
+    return entries;
+}
+
+std::vector<bool>
+ll_disk_cache::contains_many(std::vector<std::string> const& ac_keys)
+{
+    auto& cache = *this->impl_;
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
-    return result;
+    std::vector<bool> results;
+    results.reserve(ac_keys.size());
+    read_connection_lease lease{cache};
+    for (auto const& ac_key : ac_keys)
+    {
+        results.push_back(has_valid_entry(lease.get(), ac_key));
+    }
+    return results;
 }
 
 std::optional<int64_t>
@@ -1304,95 +1867,159 @@ ll_disk_cache::look_up_ac_id(std::string const& ac_key)
 {
     auto& cache = *this->impl_;
     cache.logger->info("look_up_ac_id {}", ac_key);
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
     record_activity(cache);
 
-    return cradle::look_up_ac_id(cache, ac_key);
+    std::optional<int64_t> opt_ac_id;
+    {
+        read_connection_lease lease{cache};
+        opt_ac_id = cradle::look_up_ac_id(lease.get(), ac_key);
+    }
+    if (opt_ac_id)
+    {
+        note_ac_usage(cache, *opt_ac_id);
+    }
+    return opt_ac_id;
 }
 
-void
-ll_disk_cache::insert(
+// Inserts a small entry (see ll_disk_cache::insert()); returns the number of
+// bytes by which the CAS grew.
+static uint64_t
+insert_small_entry(
+    ll_disk_cache_connection& conn,
     std::string const& ac_key,
     std::string const& digest,
     blob const& value,
     std::optional<std::size_t> original_size)
 {
-    auto& cache = *this->impl_;
-    cache.logger->info("insert: ac_key {}, digest {}", ac_key, digest);
-    std::scoped_lock<std::mutex> lock(cache.mutex);
-
-    record_activity(cache);
-
-    auto opt_cas_id_for_ac = look_up_cas_id(cache, ac_key);
+    auto opt_cas_id_for_ac = look_up_cas_id(conn, ac_key);
     if (opt_cas_id_for_ac)
     {
         // The entries already exist; must be a race condition
-        cache.logger->info(
+        conn.logger->info(
             " insert: ac_key {} already there, cas_id {}",
             ac_key,
             *opt_cas_id_for_ac);
-        return;
+        return 0;
     }
-    auto opt_cas_id_for_cas = look_up_cas_id_by_digest(cache, digest);
+    auto opt_cas_id_for_cas = look_up_cas_id_by_digest(conn, digest);
     int64_t cas_id{};
     uint64_t growth{};
     if (opt_cas_id_for_cas)
     {
         cas_id = *opt_cas_id_for_cas;
-        cache.logger->debug(
+        conn.logger->debug(
             " insert: cas_id {} already there for digest {}", cas_id, digest);
     }
     else
     {
         auto stored_original_size
             = original_size ? *original_size : value.size();
-        cas_id = insert_cas_entry(cache, digest, value, stored_original_size);
+        cas_id = insert_cas_entry(conn, digest, value, stored_original_size);
         growth = value.size();
     }
-    insert_ac_entry(cache, ac_key, cas_id);
-    record_cache_growth(cache, growth);
+    insert_ac_entry(conn, ac_key, cas_id);
+    return growth;
 }
 
-std::optional<int64_t>
-ll_disk_cache::initiate_insert(
-    std::string const& ac_key, std::string const& digest)
+void
+ll_disk_cache::insert(
+    std::string const& ac_key,
+    std::string const& digest,
+    blob const& value,
+    std::optional<std::size_t> original_size)
 {
     auto& cache = *this->impl_;
-    cache.logger->info(
-        "initiate_insert: ac_key {}, digest {}", ac_key, digest);
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    cache.logger->info("insert: ac_key {}, digest {}", ac_key, digest);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
+
+    record_activity(cache);
+
+    run_write_job(cache, [&](ll_disk_cache_impl& impl) {
+        auto growth = insert_small_entry(
+            impl.write_connection, ac_key, digest, value, original_size);
+        record_cache_growth(impl, growth);
+    });
+}
+
+void
+ll_disk_cache::insert_many(
+    std::vector<ll_disk_cache_insert_entry> const& entries)
+{
+    auto& cache = *this->impl_;
+    cache.logger->info("insert_many: {} entries", entries.size());
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
     record_activity(cache);
 
-    auto opt_cas_id_for_ac = look_up_cas_id(cache, ac_key);
+    // A single job, so the entries are inserted all or none.
+    run_write_job(cache, [&](ll_disk_cache_impl& impl) {
+        uint64_t growth{};
+        for (auto const& entry : entries)
+        {
+            growth += insert_small_entry(
+                impl.write_connection,
+                entry.ac_key,
+                entry.digest,
+                entry.value,
+                std::nullopt);
+        }
+        record_cache_growth(impl, growth);
+    });
+}
+
+// Performs ll_disk_cache::initiate_insert() on the writer thread.
+static std::optional<int64_t>
+initiate_insert_entry(
+    ll_disk_cache_connection& conn,
+    std::string const& ac_key,
+    std::string const& digest)
+{
+    auto opt_cas_id_for_ac = look_up_cas_id(conn, ac_key);
     if (opt_cas_id_for_ac)
     {
         // The entries already exist; must be a race condition
-        cache.logger->info(
+        conn.logger->info(
             " initiate_insert: ac_key {} already there, cas_id {}",
             ac_key,
             *opt_cas_id_for_ac);
         return std::nullopt;
     }
-    auto opt_cas_id_for_cas = look_up_cas_id_by_digest(cache, digest);
+    auto opt_cas_id_for_cas = look_up_cas_id_by_digest(conn, digest);
     if (opt_cas_id_for_cas)
     {
         // A suitable CAS entry already exists; just create an AC entry
         // referring to it. The CAS entry could be invalid; if so, someone else
         // should be writing the file and call finish_insert() when done, but
         // we cannot verify this.
-        cache.logger->info(
+        conn.logger->info(
             " initiate_insert: found CAS entry with cas_id {}",
             *opt_cas_id_for_cas);
-        insert_ac_entry(cache, ac_key, *opt_cas_id_for_cas);
+        insert_ac_entry(conn, ac_key, *opt_cas_id_for_cas);
         return std::nullopt;
     }
-    auto cas_id = initiate_cas_insert(cache, digest);
-    insert_ac_entry(cache, ac_key, cas_id);
+    auto cas_id = initiate_cas_insert(conn, digest);
+    insert_ac_entry(conn, ac_key, cas_id);
     return cas_id;
 }
 
+std::optional<int64_t>
+ll_disk_cache::initiate_insert(
+    std::string const& ac_key, std::string const& digest)
+{
+    auto& cache = *this->impl_;
+    cache.logger->info(
+        "initiate_insert: ac_key {}, digest {}", ac_key, digest);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
+
+    record_activity(cache);
+
+    return run_write_job(cache, [&](ll_disk_cache_impl& impl) {
+        return initiate_insert_entry(impl.write_connection, ac_key, digest);
+    });
+}
+
 void
 ll_disk_cache::finish_insert(
     int64_t cas_id, std::size_t size, std::size_t original_size)
@@ -1403,22 +2030,23 @@ ll_disk_cache::finish_insert(
         cas_id,
         size,
         original_size);
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
     record_activity(cache);
 
-    finish_cas_insert(cache, cas_id, size, original_size);
-
-    record_cache_growth(cache, size);
+    run_write_job(cache, [&](ll_disk_cache_impl& impl) {
+        finish_cas_insert(impl.write_connection, cas_id, size, original_size);
+        record_cache_growth(impl, size);
+    });
 }
 
 file_path
 ll_disk_cache::get_path_for_digest(std::string const& digest)
 {
     auto& cache = *this->impl_;
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
-    return cradle::get_path_for_digest(cache, digest);
+    return cradle::get_path_for_digest(cache.dir, digest);
 }
 
 void
@@ -1426,11 +2054,25 @@ ll_disk_cache::flush_ac_usage(bool forced)
 {
     auto& cache = *this->impl_;
     // cache.logger->info("flush_ac_usage forced {}", forced);
-    std::scoped_lock<std::mutex> lock(cache.mutex);
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
 
-    if (forced || should_flush_ac_usage(cache))
+    auto ac_ids = take_ac_ids_to_flush(cache, forced);
+    if (ac_ids.empty())
+    {
+        return;
+    }
+    auto flush = [ac_ids = std::move(ac_ids)](ll_disk_cache_impl& impl) {
+        cradle::flush_ac_usage(impl.write_connection, ac_ids);
+    };
+    if (forced)
+    {
+        // Wait until the usage is in the database.
+        run_write_job(cache, flush);
+    }
+    else
     {
-        cradle::flush_ac_usage(cache);
+        submit_write_job(
+            cache, ll_disk_cache_write_job{std::move(flush), nullptr});
     }
 }
 
@@ -26,8 +26,12 @@ namespace cradle {
 // operation of a program, there should always be a way to recover from these
 // exceptions.
 
-// A cache is internally protected by a mutex, so it can be used concurrently
-// from multiple threads.
+// A cache can be used concurrently from multiple threads. Look-ups run on a
+// small pool of read-only database connections. All modifications are handed
+// to a single writer thread, which commits the ones that queued up together
+// in a single transaction (group commit); the functions modifying the cache
+// return once their transaction has been committed. The database is in WAL
+// mode, so readers and the writer don't block each other.
 
 // ll_disk_cache stands for "low level disk cache": it is a helper in the
 // implementation of the local disk cache.
@@ -37,6 +41,8 @@ struct ll_disk_cache_config
     std::optional<std::string> directory;
     std::optional<std::size_t> size_limit;
     bool start_empty{};
+    // The number of database connections available for look-ups
+    std::size_t num_read_connections{4};
 };
 
 // An entry in the CAS.
@@ -61,6 +67,14 @@ struct ll_disk_cache_cas_entry
     int64_t original_size;
 };
 
+// A small entry to be added to the cache via insert_many().
+struct ll_disk_cache_insert_entry
+{
+    std::string ac_key;
+    std::string digest;
+    blob value;
+};
+
 // This exception indicates a failure in the operation of the disk cache.
 CRADLE_DEFINE_EXCEPTION(ll_disk_cache_failure)
 // This provides the path to the disk cache directory.
@@ -105,6 +119,18 @@ class ll_disk_cache
     std::optional<ll_disk_cache_cas_entry>
     find(std::string const& ac_key);
 
+    // Looks up a number of AC keys, using a single read connection;
+    // result[i] is as find(ac_keys[i]) would return.
+    std::vector<std::optional<ll_disk_cache_cas_entry>>
+    find_many(std::vector<std::string> const& ac_keys);
+
+    // Checks which of a number of AC keys have a valid CAS entry; result[i]
+    // is true iff find(ac_keys[i]) would return an entry. A pure query: no
+    // impact on hit_count / miss_count or the entries' usage, and values
+    // stored in files are not opened.
+    std::vector<bool>
+    contains_many(std::vector<std::string> const& ac_keys);
+
     // Returns the ac_id for the specified AC entry if existing, or nullopt
     // otherwise. No impact on hit_count / miss_count.
     std::optional<int64_t>
@@ -126,6 +152,11 @@ class ll_disk_cache
         blob const& value,
         std::optional<std::size_t> original_size = std::nullopt);
 
+    // Adds a number of small, uncompressed entries to the cache, atomically.
+    // Each entry should qualify for insert().
+    void
+    insert_many(std::vector<ll_disk_cache_insert_entry> const& entries);
+
     // Add an arbitrarily large entry to the cache.
     //
     // This is a two-part process.
@@ -153,9 +184,10 @@ class ll_disk_cache
 
     // Writes pending AC usage information to the database.
     // Should be called on polling basis with forced = false, where the
-    // implementation decides if a write will really happen. A final call
-    // before shutdown could have force = true. This could also be useful
-    // for unit tests.
+    // implementation decides if a write will really happen; the write is
+    // then queued for the writer thread. With forced = true, the call waits
+    // until the information has been committed; this could be useful for
+    // unit tests. Pending information is also written on shutdown.
     void
     flush_ac_usage(bool forced = false);
 
@@ -1,7 +1,10 @@
 // A reference key-value store based on a local disk cache.
 
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
 
+#include <cppcoro/when_all.hpp>
 #include <fmt/format.h>
 
 #include <cradle/inner/core/fmt_format.h>
@@ -22,14 +25,6 @@ class disk_cache_error : public std::runtime_error
     using runtime_error::runtime_error;
 };
 
-static cppcoro::task<std::string>
-read_file_contents(
-    cppcoro::static_thread_pool& read_pool, file_path const& path)
-{
-    co_await read_pool.schedule();
-    co_return read_file_contents(path);
-}
-
 static bool
 get_check_file_data(service_config const& config)
 {
@@ -44,7 +39,9 @@ make_ll_disk_cache_config(service_config const& config)
         config.get_optional_string(local_disk_cache_config_keys::DIRECTORY),
         config.get_optional_number(local_disk_cache_config_keys::SIZE_LIMIT),
         config.get_bool_or_default(
-            local_disk_cache_config_keys::START_EMPTY, false)};
+            local_disk_cache_config_keys::START_EMPTY, false),
+        config.get_number_or_default(
+            local_disk_cache_config_keys::NUM_READ_CONNECTIONS, 4)};
 }
 
 static uint32_t
@@ -61,6 +58,29 @@ get_num_threads_write_pool(service_config const& config)
         local_disk_cache_config_keys::NUM_THREADS_WRITE_POOL, 2));
 }
 
+static uint32_t
+get_num_threads_codec_pool(service_config const& config)
+{
+    return static_cast<uint32_t>(config.get_number_or_default(
+        local_disk_cache_config_keys::NUM_THREADS_CODEC_POOL,
+        std::max(std::thread::hardware_concurrency(), 1u)));
+}
+
+static chunked_file_options
+make_chunked_file_options(service_config const& config)
+{
+    chunked_file_options options;
+    options.codec = parse_disk_cache_codec(config.get_string_or_default(
+        local_disk_cache_config_keys::CODEC, "lz4"));
+    options.level = static_cast<int>(config.get_number_or_default(
+        local_disk_cache_config_keys::COMPRESSION_LEVEL, 0));
+    options.chunk_size = config.get_number_or_default(
+        local_disk_cache_config_keys::CHUNK_SIZE, options.chunk_size);
+    options.store_threshold = config.get_optional_number(
+        local_disk_cache_config_keys::STORE_THRESHOLD);
+    return options;
+}
+
 static int
 get_poll_interval(service_config const& config)
 {
@@ -72,6 +92,8 @@ local_disk_cache::local_disk_cache(service_config const& config)
     : check_file_data_{get_check_file_data(config)},
       ll_cache_{make_ll_disk_cache_config(config)},
       poller_{ll_cache_, get_poll_interval(config)},
+      chunked_file_options_{make_chunked_file_options(config)},
+      codec_pool_{get_num_threads_codec_pool(config)},
       read_pool_{get_num_threads_read_pool(config)},
       write_pool_{get_num_threads_write_pool(config)},
       logger_{spdlog::get("cradle")}
@@ -87,10 +109,68 @@ local_disk_cache::clear()
 // This is a coroutine so takes key by value.
 cppcoro::task<std::optional<blob>>
 local_disk_cache::read(std::string key)
+{
+    std::optional<ll_disk_cache_cas_entry> entry;
+    try
+    {
+        entry = ll_cache_.find(key);
+    }
+    catch (std::exception const& e)
+    {
+        logger_->error("error reading disk cache entry {}: {}", key, e.what());
+        co_return std::nullopt;
+    }
+    co_return co_await read_entry(std::move(key), std::move(entry));
+}
+
+cppcoro::task<std::vector<std::optional<blob>>>
+local_disk_cache::read_many(std::vector<std::string> keys)
+{
+    std::vector<std::optional<ll_disk_cache_cas_entry>> entries;
+    try
+    {
+        entries = ll_cache_.find_many(keys);
+    }
+    catch (std::exception const& e)
+    {
+        logger_->error("error reading disk cache entries: {}", e.what());
+        co_return std::vector<std::optional<blob>>(keys.size());
+    }
+    // Values stored in files are read in parallel (on the read pool).
+    std::vector<cppcoro::task<std::optional<blob>>> tasks;
+    tasks.reserve(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        tasks.push_back(read_entry(std::move(keys[i]), std::move(entries[i])));
+    }
+    co_return co_await cppcoro::when_all(std::move(tasks));
+}
+
+cppcoro::task<std::vector<bool>>
+local_disk_cache::contains_many(std::vector<std::string> keys)
+{
+    std::vector<bool> results;
+    try
+    {
+        results = ll_cache_.contains_many(keys);
+    }
+    catch (std::exception const& e)
+    {
+        logger_->error("error looking up disk cache entries: {}", e.what());
+        results.assign(keys.size(), false);
+    }
+    co_return results;
+}
+
+// Returns the value for an entry found by ll_disk_cache::find() or
+// find_many(), reading it from its file if needed.
+// This is a coroutine so takes its arguments by value.
+cppcoro::task<std::optional<blob>>
+local_disk_cache::read_entry(
+    std::string key, std::optional<ll_disk_cache_cas_entry> entry)
 {
     try
     {
-        auto entry = ll_cache_.find(key);
         if (!entry)
         {
             logger_->info("disk cache miss on {}", key);
@@ -106,8 +186,21 @@ local_disk_cache::read(std::string key)
         {
             auto path{ll_cache_.get_path_for_digest(entry->digest)};
             logger_->debug("reading file for key {}: {}", key, path.string());
-            auto data = co_await read_file_contents(read_pool_, path);
-            auto result = decompress_file_data(key, *entry, data);
+            co_await read_pool_.schedule();
+            blob result;
+            if (is_chunked_file(path))
+            {
+                // Chunks are read and decompressed in parallel, straight
+                // into the result; or, if stored uncompressed, the file is
+                // mapped.
+                result = co_await read_chunked_file(codec_pool_, path);
+            }
+            else
+            {
+                auto data = read_file_contents(path);
+                result = decompress_legacy_file_data(key, *entry, data);
+            }
+            check_file_value(key, *entry, result);
             logger_->debug("returning for {}", key);
             co_return result;
         }
@@ -121,8 +214,10 @@ local_disk_cache::read(std::string key)
     co_return std::nullopt;
 }
 
+// Decompresses the contents of a file written before the chunked format was
+// introduced: a single LZ4 block.
 blob
-local_disk_cache::decompress_file_data(
+local_disk_cache::decompress_legacy_file_data(
     std::string const& key,
     ll_disk_cache_cas_entry const& entry,
     std::string const& data)
@@ -132,16 +227,25 @@ local_disk_cache::decompress_file_data(
     byte_vector decompressed(original_size);
     auto decompressed_size = lz4::decompress(
         decompressed.data(), original_size, data.data(), data.size());
+    return make_blob(std::move(decompressed), decompressed_size);
+}
 
+void
+local_disk_cache::check_file_value(
+    std::string const& key,
+    ll_disk_cache_cas_entry const& entry,
+    blob const& value)
+{
     // The file might be corrupt (truncated) if the write operation was
     // interrupted. If so, the decompress operation will most likely fail,
     // and even if it succeeds, the resulting data will be truncated as well.
     // Check this.
-    if (decompressed_size != original_size)
+    auto original_size = boost::numeric_cast<std::size_t>(entry.original_size);
+    if (value.size() != original_size)
     {
         throw disk_cache_error(fmt::format(
             "decompression gave {} bytes, expected {}",
-            decompressed_size,
+            value.size(),
             original_size));
     }
 
@@ -150,61 +254,64 @@ local_disk_cache::decompress_file_data(
     // so.
     if (check_file_data_)
     {
-        logger_->debug("checking digest over decompressed data");
-        auto digest = get_unique_string_tmpl(decompressed);
+        logger_->debug("checking digest over decompressed data for {}", key);
+        auto digest = get_unique_string_tmpl(value);
         if (digest != entry.digest)
         {
             throw disk_cache_error("digest mismatch on decompressed data");
         }
     }
+}
 
-    return make_blob(std::move(decompressed));
+// A value is stored in an external file only if:
+// - It's big enough; and
+// - It's not already stored in a blob file.
+static bool
+should_store_in_file(blob const& value)
+{
+    return value.size() > 1024 && !value.mapped_file_data_owner();
+}
+
+// Compresses a value and stores it in an external file, in the chunked
+// format. The chunks are compressed in parallel on codec_pool.
+static void
+write_value_to_file(
+    ll_disk_cache& ll_cache,
+    cppcoro::static_thread_pool& codec_pool,
+    chunked_file_options const& options,
+    spdlog::logger& logger,
+    std::string const& key,
+    std::string const& digest,
+    blob const& value)
+{
+    auto optional_cas_id = ll_cache.initiate_insert(key, digest);
+    if (!optional_cas_id)
+    {
+        return;
+    }
+    auto cas_id = *optional_cas_id;
+    auto path = ll_cache.get_path_for_digest(digest);
+    logger.debug("writing {}", path.string());
+    auto stored_size = write_chunked_file(codec_pool, path, value, options);
+    ll_cache.finish_insert(cas_id, stored_size, value.size());
 }
 
 cppcoro::task<void>
 local_disk_cache::write(std::string key, blob value)
 {
     write_pool_.detach_task([&ll_cache = ll_cache_,
+                             &codec_pool = codec_pool_,
+                             &options = chunked_file_options_,
                              &logger = *logger_,
                              key,
                              value] {
         try
         {
             auto digest{get_unique_string_tmpl(value)};
-            // A value is stored in an external file only if:
-            // - It's big enough; and
-            // - It's not already stored in a blob file.
-            if (value.size() > 1024 && !value.mapped_file_data_owner())
+            if (should_store_in_file(value))
             {
-                auto optional_cas_id = ll_cache.initiate_insert(key, digest);
-                if (optional_cas_id)
-                {
-                    auto cas_id = *optional_cas_id;
-                    auto max_compressed_size
-                        = lz4::max_compressed_size(value.size());
-                    byte_vector compressed(max_compressed_size);
-                    auto actual_compressed_size = lz4::compress(
-                        compressed.data(),
-                        max_compressed_size,
-                        value.data(),
-                        value.size());
-
-                    {
-                        auto path = ll_cache.get_path_for_digest(digest);
-                        logger.debug("writing {}", path.string());
-                        std::ofstream output;
-                        open_file(
-                            output,
-                            path,
-                            std::ios::out | std::ios::trunc
-                                | std::ios::binary);
-                        output.write(
-                            reinterpret_cast<char const*>(compressed.data()),
-                            actual_compressed_size);
-                    }
-                    ll_cache.finish_insert(
-                        cas_id, actual_compressed_size, value.size());
-                }
+                write_value_to_file(
+                    ll_cache, codec_pool, options, logger, key, digest, value);
             }
             else
             {
@@ -223,6 +330,60 @@ local_disk_cache::write(std::string key, blob value)
     co_return;
 }
 
+// Values that are stored in the database are inserted in a single
+// transaction; values that are stored in files are written one by one.
+cppcoro::task<void>
+local_disk_cache::write_many(std::vector<std::pair<std::string, blob>> entries)
+{
+    write_pool_.detach_task([&ll_cache = ll_cache_,
+                             &codec_pool = codec_pool_,
+                             &options = chunked_file_options_,
+                             &logger = *logger_,
+                             entries = std::move(entries)] {
+        std::vector<ll_disk_cache_insert_entry> db_entries;
+        for (auto const& [key, value] : entries)
+        {
+            try
+            {
+                auto digest{get_unique_string_tmpl(value)};
+                if (should_store_in_file(value))
+                {
+                    write_value_to_file(
+                        ll_cache,
+                        codec_pool,
+                        options,
+                        logger,
+                        key,
+                        digest,
+                        value);
+                }
+                else
+                {
+                    db_entries.push_back(
+                        ll_disk_cache_insert_entry{key, digest, value});
+                }
+            }
+            catch (std::exception& e)
+            {
+                logger.warn("error writing disk cache entry {}", key);
+                logger.warn(e.what());
+            }
+        }
+        try
+        {
+            ll_cache.insert_many(db_entries);
+        }
+        catch (std::exception& e)
+        {
+            logger.warn(
+                "error writing {} disk cache entries", db_entries.size());
+            logger.warn(e.what());
+        }
+    });
+
+    co_return;
+}
+
 disk_cache_info
 local_disk_cache::get_summary_info()
 {
@@ -4,6 +4,8 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <BS_thread_pool.hpp>
 #include <cppcoro/static_thread_pool.hpp>
@@ -11,6 +13,7 @@
 
 #include <cradle/inner/service/config.h>
 #include <cradle/inner/service/secondary_storage_intf.h>
+#include <cradle/plugins/secondary_cache/local/chunked_file.h>
 #include <cradle/plugins/secondary_cache/local/disk_cache_info.h>
 #include <cradle/plugins/secondary_cache/local/disk_cache_poller.h>
 #include <cradle/plugins/secondary_cache/local/ll_disk_cache.h>
@@ -53,6 +56,43 @@ struct local_disk_cache_config_keys
     inline static std::string const NUM_THREADS_WRITE_POOL{
         "disk_cache/num_threads_write_pool"};
 
+    // (Optional integer)
+    // Threads compressing and decompressing the chunks of values stored in
+    // files; defaults to the number of hardware threads.
+    inline static std::string const NUM_THREADS_CODEC_POOL{
+        "disk_cache/num_threads_codec_pool"};
+
+    // (Optional string)
+    // Codec compressing values stored in files: "lz4" (default), "zstd", or
+    // "store" (no compression).
+    // Files are self-describing, so changing the codec does not invalidate
+    // existing files.
+    inline static std::string const CODEC{"disk_cache/codec"};
+
+    // (Optional integer)
+    // Compression level for the zstd codec; 0 selects zstd's default.
+    inline static std::string const COMPRESSION_LEVEL{
+        "disk_cache/compression_level"};
+
+    // (Optional integer)
+    // Size, in bytes, of the chunks into which values stored in files are
+    // split; each chunk is compressed independently.
+    inline static std::string const CHUNK_SIZE{"disk_cache/chunk_size"};
+
+    // (Optional integer)
+    // Values of at least this size, in bytes, are stored uncompressed,
+    // whatever the codec. A read returns such a value as a blob referring to
+    // the memory-mapped file, without copying; processes reading the same
+    // value share the mapped pages.
+    inline static std::string const STORE_THRESHOLD{
+        "disk_cache/store_threshold"};
+
+    // (Optional integer)
+    // The number of database connections available for look-ups; look-ups
+    // beyond this number wait for a connection to become available.
+    inline static std::string const NUM_READ_CONNECTIONS{
+        "disk_cache/num_read_connections"};
+
     // Poll interval, in ms, for updating usage info in the database
     // (Optional integer)
     inline static std::string const POLL_INTERVAL{"disk_cache/poll_interval"};
@@ -93,6 +133,17 @@ class local_disk_cache : public secondary_storage_intf
     cppcoro::task<void>
     write(std::string key, blob value) override;
 
+    // Looks up all keys in a single pass over the database.
+    cppcoro::task<std::vector<std::optional<blob>>>
+    read_many(std::vector<std::string> keys) override;
+
+    // Stores all values that go into the database in a single transaction.
+    cppcoro::task<void>
+    write_many(std::vector<std::pair<std::string, blob>> entries) override;
+
+    cppcoro::task<std::vector<bool>>
+    contains_many(std::vector<std::string> keys) override;
+
     bool
     allow_blob_files() const override
     {
@@ -125,15 +176,27 @@ class local_disk_cache : public secondary_storage_intf
     bool check_file_data_;
     ll_disk_cache ll_cache_;
     disk_cache_poller poller_;
+    chunked_file_options chunked_file_options_;
+    // Must outlive write_pool_, whose tasks use it.
+    cppcoro::static_thread_pool codec_pool_;
     cppcoro::static_thread_pool read_pool_;
     BS::thread_pool write_pool_;
     std::shared_ptr<spdlog::logger> logger_;
 
+    cppcoro::task<std::optional<blob>>
+    read_entry(std::string key, std::optional<ll_disk_cache_cas_entry> entry);
+
     blob
-    decompress_file_data(
+    decompress_legacy_file_data(
         std::string const& key,
         ll_disk_cache_cas_entry const& entry,
         std::string const& data);
+
+    void
+    check_file_value(
+        std::string const& key,
+        ll_disk_cache_cas_entry const& entry,
+        blob const& value);
 };
 
 } // namespace cradle
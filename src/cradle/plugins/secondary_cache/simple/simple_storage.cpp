@@ -25,6 +25,44 @@ simple_blob_storage::write(std::string key, blob value)
     co_return;
 }
 
+cppcoro::task<std::vector<std::optional<blob>>>
+simple_blob_storage::read_many(std::vector<std::string> keys)
+{
+    std::vector<std::optional<blob>> results;
+    results.reserve(keys.size());
+    for (auto const& key : keys)
+    {
+        auto it = storage_.find(key);
+        results.push_back(
+            it != storage_.end() ? std::make_optional(it->second)
+                                 : std::nullopt);
+    }
+    co_return results;
+}
+
+cppcoro::task<void>
+simple_blob_storage::write_many(
+    std::vector<std::pair<std::string, blob>> entries)
+{
+    for (auto& [key, value] : entries)
+    {
+        storage_[key] = std::move(value);
+    }
+    co_return;
+}
+
+cppcoro::task<std::vector<bool>>
+simple_blob_storage::contains_many(std::vector<std::string> keys)
+{
+    std::vector<bool> results;
+    results.reserve(keys.size());
+    for (auto const& key : keys)
+    {
+        results.push_back(storage_.contains(key));
+    }
+    co_return results;
+}
+
 void
 simple_string_storage::clear()
 {
@@ -46,4 +84,42 @@ simple_string_storage::write(std::string key, blob value)
     co_return;
 }
 
+cppcoro::task<std::vector<std::optional<blob>>>
+simple_string_storage::read_many(std::vector<std::string> keys)
+{
+    std::vector<std::optional<blob>> results;
+    results.reserve(keys.size());
+    for (auto const& key : keys)
+    {
+        auto it = storage_.find(key);
+        results.push_back(
+            it != storage_.end() ? std::make_optional(make_blob(it->second))
+                                 : std::nullopt);
+    }
+    co_return results;
+}
+
+cppcoro::task<void>
+simple_string_storage::write_many(
+    std::vector<std::pair<std::string, blob>> entries)
+{
+    for (auto& [key, value] : entries)
+    {
+        storage_[key] = to_string(value);
+    }
+    co_return;
+}
+
+cppcoro::task<std::vector<bool>>
+simple_string_storage::contains_many(std::vector<std::string> keys)
+{
+    std::vector<bool> results;
+    results.reserve(keys.size());
+    for (auto const& key : keys)
+    {
+        results.push_back(storage_.contains(key));
+    }
+    co_return results;
+}
+
 } // namespace cradle
@@ -4,6 +4,8 @@
 #include <map>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <cppcoro/task.hpp>
 
@@ -38,6 +40,15 @@ class simple_blob_storage : public secondary_storage_intf
     cppcoro::task<void>
     write(std::string key, blob value) override;
 
+    cppcoro::task<std::vector<std::optional<blob>>>
+    read_many(std::vector<std::string> keys) override;
+
+    cppcoro::task<void>
+    write_many(std::vector<std::pair<std::string, blob>> entries) override;
+
+    cppcoro::task<std::vector<bool>>
+    contains_many(std::vector<std::string> keys) override;
+
     bool
     allow_blob_files() const override
     {
@@ -75,6 +86,15 @@ class simple_string_storage : public secondary_storage_intf
     cppcoro::task<void>
     write(std::string key, blob value) override;
 
+    cppcoro::task<std::vector<std::optional<blob>>>
+    read_many(std::vector<std::string> keys) override;
+
+    cppcoro::task<void>
+    write_many(std::vector<std::pair<std::string, blob>> entries) override;
+
+    cppcoro::task<std::vector<bool>>
+    contains_many(std::vector<std::string> keys) override;
+
     bool
     allow_blob_files() const override
     {
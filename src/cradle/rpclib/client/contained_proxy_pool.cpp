@@ -1,40 +1,227 @@
+#include <algorithm>
+#include <utility>
+
+#include <boost/algorithm/string.hpp>
+#include <fmt/format.h>
+
 #include <cradle/inner/service/config.h>
+#include <cradle/inner/utilities/logging.h>
 #include <cradle/rpclib/client/contained_proxy_pool.h>
 #include <cradle/rpclib/client/proxy.h>
 #include <cradle/rpclib/common/config.h>
 
 namespace cradle {
 
+namespace {
+
+std::vector<std::string>
+get_preload_dlls(service_config const& config)
+{
+    std::vector<std::string> dlls;
+    auto names{config.get_optional_string(
+        rpclib_config_keys::CONTAINED_PRELOAD_DLLS)};
+    if (names)
+    {
+        boost::algorithm::split(dlls, *names, boost::is_any_of(","));
+        for (auto& dll : dlls)
+        {
+            boost::algorithm::trim(dll);
+        }
+        std::erase(dlls, std::string{});
+    }
+    return dlls;
+}
+
+} // namespace
+
+contained_proxy_pool::contained_proxy_pool(service_config const& config)
+    : config_{config},
+      logger_{ensure_logger("creq")},
+      warm_pool_size_{static_cast<int>(config.get_number_or_default(
+          rpclib_config_keys::CONTAINED_WARM_POOL_SIZE, 0))},
+      preload_dll_dir_{config.get_string_or_default(
+          rpclib_config_keys::CONTAINED_PRELOAD_DLL_DIR, "")},
+      preload_dlls_{get_preload_dlls(config)},
+      max_calls_{config.get_number_or_default(
+          rpclib_config_keys::CONTAINED_MAX_CALLS, 0)},
+      max_memory_{config.get_number_or_default(
+          rpclib_config_keys::CONTAINED_MAX_MEMORY, 0)}
+{
+    if (!preload_dlls_.empty() && preload_dll_dir_.empty())
+    {
+        throw config_error{fmt::format(
+            "{} requires {}",
+            rpclib_config_keys::CONTAINED_PRELOAD_DLLS,
+            rpclib_config_keys::CONTAINED_PRELOAD_DLL_DIR)};
+    }
+    // In contained mode, this pool is not used.
+    if (warm_pool_size_ > 0
+        && !config.get_bool_or_default(rpclib_config_keys::CONTAINED, false))
+    {
+        replenish_thread_ = std::jthread{
+            [this](std::stop_token stop_token) { replenish_func(stop_token); }};
+    }
+}
+
+// ~jthread() stops and joins replenish_thread_
+contained_proxy_pool::~contained_proxy_pool() = default;
+
 std::unique_ptr<rpclib_client>
 contained_proxy_pool::alloc_proxy(
     service_config const& config, std::shared_ptr<spdlog::logger> logger)
 {
-    std::scoped_lock lock{mutex_};
-    std::unique_ptr<rpclib_client> proxy;
-    if (!available_proxies_.empty())
     {
-        proxy = std::move(available_proxies_.front());
-        available_proxies_.pop_front();
-        logger->info("reusing proxy with port {}", proxy->get_port());
+        std::scoped_lock lock{mutex_};
+        if (!available_proxies_.empty())
+        {
+            auto proxy = std::move(available_proxies_.front());
+            available_proxies_.pop_front();
+            info_.num_hits += 1;
+            logger->info("reusing proxy with port {}", proxy->get_port());
+            replenish_cond_.notify_one();
+            return proxy;
+        }
+        info_.num_misses += 1;
     }
-    else
-    {
-        proxy = std::make_unique<rpclib_client>(config, &port_owner_, logger);
-        logger->info("created new proxy with port {}", proxy->get_port());
-    }
-    return proxy;
+    // Starting the process takes a while; don't block the other callers.
+    return spawn_proxy(config, std::move(logger), false);
 }
 
 void
 contained_proxy_pool::free_proxy(
     std::unique_ptr<rpclib_client> proxy, bool succeeded)
 {
+    std::size_t num_calls;
+    {
+        std::scoped_lock lock{mutex_};
+        num_calls = ++num_calls_[proxy.get()];
+    }
+    // must_recycle() may query the contained process, so is called without
+    // mutex_ locked; the proxy is not shared yet.
+    bool recycle{succeeded && must_recycle(*proxy, num_calls)};
+    std::unique_ptr<rpclib_client> doomed_proxy;
+    {
+        std::scoped_lock lock{mutex_};
+        if (succeeded && !recycle)
+        {
+            available_proxies_.push_back(std::move(proxy));
+            return;
+        }
+        if (recycle)
+        {
+            info_.num_recycled += 1;
+        }
+        num_calls_.erase(proxy.get());
+        doomed_proxy = std::move(proxy);
+        replenish_cond_.notify_one();
+    }
+    // Terminating the process should not block the other callers either.
+    doomed_proxy.reset();
+}
+
+contained_proxy_pool_info
+contained_proxy_pool::get_info() const
+{
+    std::scoped_lock lock{mutex_};
+    auto info{info_};
+    info.num_idle = static_cast<int>(available_proxies_.size());
+    return info;
+}
+
+std::unique_ptr<rpclib_client>
+contained_proxy_pool::spawn_proxy(
+    service_config const& config,
+    std::shared_ptr<spdlog::logger> logger,
+    bool preload)
+{
+    auto start{std::chrono::steady_clock::now()};
+    auto proxy = std::make_unique<rpclib_client>(config, &port_owner_, logger);
+    if (preload)
+    {
+        for (auto const& dll : preload_dlls_)
+        {
+            proxy->load_shared_library(preload_dll_dir_, dll);
+        }
+    }
+    auto spawn_time{std::chrono::steady_clock::now() - start};
+    logger->info(
+        "created new proxy with port {} in {}ms",
+        proxy->get_port(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(spawn_time)
+            .count());
     std::scoped_lock lock{mutex_};
-    if (succeeded)
+    num_calls_[proxy.get()] = 0;
+    info_.num_spawned += 1;
+    info_.total_spawn_time += spawn_time;
+    info_.max_spawn_time = std::max(info_.max_spawn_time, spawn_time);
+    return proxy;
+}
+
+// Called without mutex_ locked, as it may perform an RPC to proxy's server
+bool
+contained_proxy_pool::must_recycle(rpclib_client& proxy, std::size_t num_calls)
+{
+    if (max_calls_ > 0 && num_calls >= max_calls_)
+    {
+        logger_->info(
+            "recycling proxy with port {} after {} calls",
+            proxy.get_port(),
+            num_calls);
+        return true;
+    }
+    if (max_memory_ > 0)
+    {
+        auto memory_usage{proxy.get_server_memory_usage()};
+        if (memory_usage && *memory_usage > max_memory_)
+        {
+            logger_->info(
+                "recycling proxy with port {} using {} bytes",
+                proxy.get_port(),
+                *memory_usage);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Keeps warm_pool_size_ idle proxies available
+void
+contained_proxy_pool::replenish_func(std::stop_token stop_token)
+{
+    for (;;)
     {
-        available_proxies_.push_back(std::move(proxy));
+        {
+            std::unique_lock lock{mutex_};
+            if (!replenish_cond_.wait(lock, stop_token, [this] {
+                    return std::cmp_less(
+                        available_proxies_.size(), warm_pool_size_);
+                }))
+            {
+                // Stop requested
+                return;
+            }
+        }
+        try
+        {
+            auto proxy{spawn_proxy(config_, logger_, true)};
+            std::scoped_lock lock{mutex_};
+            available_proxies_.push_back(std::move(proxy));
+        }
+        catch (std::exception const& e)
+        {
+            logger_->error("could not start contained process: {}", e.what());
+            // Don't retry immediately, and stop waiting when so requested.
+            std::unique_lock lock{mutex_};
+            replenish_cond_.wait_for(
+                lock, stop_token, std::chrono::seconds{1}, [] {
+                    return false;
+                });
+            if (stop_token.stop_requested())
+            {
+                return;
+            }
+        }
     }
-    // else call proxy's destructor
 }
 
 } // namespace cradle
@@ -1,25 +1,64 @@
 #ifndef CRADLE_RPCLIB_CLIENT_CONTAINED_PROXY_POOL_H
 #define CRADLE_RPCLIB_CLIENT_CONTAINED_PROXY_POOL_H
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <stop_token>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
+#include <cradle/inner/service/config.h>
 #include <cradle/rpclib/client/ephemeral_port_owner.h>
 
 namespace cradle {
 
 class rpclib_client;
-class service_config;
+
+// Summary information on a contained_proxy_pool.
+struct contained_proxy_pool_info
+{
+    // Number of idle proxies (processes) in the pool.
+    int num_idle;
+    // Number of alloc_proxy() calls served by an idle proxy.
+    int num_hits;
+    // Number of alloc_proxy() calls that had to start a new process.
+    int num_misses;
+    // Number of processes started, on demand or in the background.
+    int num_spawned;
+    // Number of processes terminated because they reached the call or memory
+    // limit.
+    int num_recycled;
+    // Total and maximum time needed for starting a process (and preloading
+    // DLLs, if it was started in the background).
+    std::chrono::nanoseconds total_spawn_time;
+    std::chrono::nanoseconds max_spawn_time;
+};
 
 // A pool of rpclib_client objects communicating to the contained processes
 // (rpclib server instances running in contained mode).
+//
+// If the CONTAINED_WARM_POOL_SIZE config item is set, the pool tries to keep
+// that many idle processes available, starting new ones in the background,
+// with the CONTAINED_PRELOAD_DLLS already loaded. This keeps process startup
+// and DLL loading out of the latency of a contained request.
+// A process is recycled (terminated) once it has executed
+// CONTAINED_MAX_CALLS functions, or its memory usage exceeds
+// CONTAINED_MAX_MEMORY.
 class contained_proxy_pool
 {
  public:
+    contained_proxy_pool(service_config const& config);
+
+    ~contained_proxy_pool();
+
     // Allocates an rpclib_client object from the pool.
     //
     // Uses the DEPLOY_DIR config item (if set).
@@ -36,10 +75,42 @@ class contained_proxy_pool
     void
     free_proxy(std::unique_ptr<rpclib_client> proxy, bool succeeded);
 
+    contained_proxy_pool_info
+    get_info() const;
+
  private:
-    std::mutex mutex_;
+    service_config const config_;
+    std::shared_ptr<spdlog::logger> logger_;
+    int const warm_pool_size_;
+    std::string const preload_dll_dir_;
+    std::vector<std::string> const preload_dlls_;
+    std::size_t const max_calls_;
+    std::size_t const max_memory_;
+
+    mutable std::mutex mutex_;
     ephemeral_port_owner port_owner_;
     std::deque<std::unique_ptr<rpclib_client>> available_proxies_;
+    // The number of functions executed by each proxy that is in use or
+    // available
+    std::unordered_map<rpclib_client*, std::size_t> num_calls_;
+    contained_proxy_pool_info info_{};
+    std::condition_variable_any replenish_cond_;
+
+    // Must be the last member, so that the thread is stopped before the
+    // other members are destroyed.
+    std::jthread replenish_thread_;
+
+    std::unique_ptr<rpclib_client>
+    spawn_proxy(
+        service_config const& config,
+        std::shared_ptr<spdlog::logger> logger,
+        bool preload);
+
+    bool
+    must_recycle(rpclib_client& proxy, std::size_t num_calls);
+
+    void
+    replenish_func(std::stop_token stop_token);
 };
 
 } // namespace cradle
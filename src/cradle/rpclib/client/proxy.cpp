@@ -1,4 +1,6 @@
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <thread>
@@ -8,6 +10,9 @@
 #include <fmt/format.h>
 #include <rpc/client.h>
 #include <rpc/rpc_error.h>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
 
 #include <cradle/deploy_dir.h>
 #include <cradle/inner/core/fmt_format.h>
@@ -92,6 +97,32 @@ alloc_port(ephemeral_port_owner* port_owner, service_config const& config)
     return get_testing(config) ? RPCLIB_PORT_TESTING : RPCLIB_PORT_PRODUCTION;
 }
 
+request_format
+get_request_format(service_config const& config)
+{
+    auto format = config.get_string_or_default(
+        rpclib_config_keys::REQUEST_FORMAT, "msgpack");
+    if (format == "msgpack")
+    {
+        return request_format::msgpack;
+    }
+    if (format == "json")
+    {
+        return request_format::json;
+    }
+    throw config_error{fmt::format(
+        "invalid {}: {}", rpclib_config_keys::REQUEST_FORMAT, format)};
+}
+
+// Returns an id that is unique for each client object on this host.
+std::string
+make_client_id()
+{
+    static std::atomic<int> next_client_number{0};
+    return fmt::format(
+        "{}:{}", boost::this_process::get_id(), next_client_number++);
+}
+
 } // namespace
 
 rpclib_client::rpclib_client(
@@ -117,8 +148,10 @@ rpclib_client_impl::rpclib_client_impl(
           rpclib_config_keys::EXPECT_SERVER, false)},
       deploy_dir_{config.get_optional_string(generic_config_keys::DEPLOY_DIR)},
       port_{alloc_port(port_owner, config)},
+      request_format_{get_request_format(config)},
       secondary_cache_factory_{config.get_optional_string(
-          inner_config_keys::SECONDARY_CACHE_FACTORY)}
+          inner_config_keys::SECONDARY_CACHE_FACTORY)},
+      client_id_{make_client_id()}
 {
     ensure_server();
 }
@@ -157,6 +190,12 @@ rpclib_client::get_logger()
     return *pimpl_->logger_;
 }
 
+request_format
+rpclib_client::get_request_format() const
+{
+    return pimpl_->request_format_;
+}
+
 void
 rpclib_client::store_request(
     std::string storage_name, std::string key, std::string seri_req)
@@ -172,11 +211,15 @@ rpclib_client::resolve_sync(service_config config, std::string seri_req)
 {
     auto& logger{*pimpl_->logger_};
     logger.debug("resolve_sync");
+    // Let the server schedule this request fairly with respect to the ones
+    // from other clients.
+    auto config_map{config.get_config_map()};
+    config_map[rpclib_config_keys::CLIENT_ID] = pimpl_->client_id_;
     auto response = pimpl_
                         ->do_rpc_call(
                             "resolve_sync",
                             -1,
-                            write_config_map_to_json(config.get_config_map()),
+                            write_config_map_to_json(config_map),
                             seri_req)
                         .as<rpclib_response>();
     return pimpl_->make_serialized_result(response);
@@ -241,6 +284,28 @@ rpclib_client::get_async_status(async_id aid)
     return status;
 }
 
+async_status
+rpclib_client::wait_async_status(
+    async_id aid,
+    async_status known_status,
+    std::chrono::milliseconds timeout)
+{
+    auto& logger{*pimpl_->logger_};
+    logger.debug("wait_async_status {} {}", aid, known_status);
+    int timeout_ms{static_cast<int>(timeout.count())};
+    auto status_value = pimpl_
+                            ->do_rpc_call(
+                                "wait_async_status",
+                                pimpl_->default_timeout + timeout_ms,
+                                aid,
+                                static_cast<int>(known_status),
+                                timeout_ms)
+                            .as<int>();
+    async_status status{status_value};
+    logger.debug("async_status for {}: {}", aid, status);
+    return status;
+}
+
 std::string
 rpclib_client::get_async_error_message(async_id aid)
 {
@@ -435,6 +500,30 @@ rpclib_client_impl::verify_rpclib_protocol(
     }
 }
 
+std::optional<std::size_t>
+rpclib_client::get_server_memory_usage() const
+{
+    auto const& child{pimpl_->child_};
+    if (!child.valid())
+    {
+        // Server not started by this client
+        return std::nullopt;
+    }
+#if defined(__linux__)
+    // The second field in statm is the resident set size, in pages.
+    std::ifstream statm{fmt::format("/proc/{}/statm", child.id())};
+    std::size_t size_pages{};
+    std::size_t resident_pages{};
+    if (!(statm >> size_pages >> resident_pages))
+    {
+        return std::nullopt;
+    }
+    return resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return std::nullopt;
+#endif
+}
+
 // Note is asynchronous
 void
 rpclib_client_impl::ack_response(uint32_t pool_id)
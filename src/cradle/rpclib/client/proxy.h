@@ -1,7 +1,9 @@
 #ifndef CRADLE_RPCLIB_CLIENT_PROXY_H
 #define CRADLE_RPCLIB_CLIENT_PROXY_H
 
+#include <cstddef>
 #include <memory>
+#include <optional>
 
 #include <cradle/inner/remote/proxy.h>
 #include <cradle/rpclib/common/port.h>
@@ -44,6 +46,9 @@ class rpclib_client : public remote_proxy
     spdlog::logger&
     get_logger() override;
 
+    request_format
+    get_request_format() const override;
+
     void
     store_request(
         std::string storage_name,
@@ -68,6 +73,12 @@ class rpclib_client : public remote_proxy
     async_status
     get_async_status(async_id aid) override;
 
+    async_status
+    wait_async_status(
+        async_id aid,
+        async_status known_status,
+        std::chrono::milliseconds timeout) override;
+
     std::string
     get_async_error_message(async_id aid) override;
 
@@ -112,6 +123,11 @@ class rpclib_client : public remote_proxy
     void
     verify_rpclib_protocol(std::string const& server_rpclib_protocol);
 
+    // Returns the resident memory size, in bytes, of the server process
+    // started by this client, if known.
+    std::optional<std::size_t>
+    get_server_memory_usage() const;
+
  private:
     std::unique_ptr<rpclib_client_impl> pimpl_;
 };
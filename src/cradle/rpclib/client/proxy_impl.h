@@ -14,6 +14,7 @@
 
 #include <cradle/inner/core/type_definitions.h>
 #include <cradle/inner/requests/generic.h>
+#include <cradle/inner/requests/serialization.h>
 #include <cradle/inner/resolve/seri_result.h>
 #include <cradle/inner/service/config.h>
 #include <cradle/rpclib/common/common.h>
@@ -98,7 +99,10 @@ class rpclib_client_impl
     bool const expect_server_{};
     std::optional<std::string> const deploy_dir_;
     rpclib_port_t const port_{};
+    request_format const request_format_;
     std::optional<std::string> secondary_cache_factory_;
+    // Sent along with resolve_sync requests, for fair scheduling
+    std::string const client_id_;
 
     // On Windows, localhost and 127.0.0.1 are not the same:
     // https://stackoverflow.com/questions/68957411/winsock-connect-is-slow
@@ -0,0 +1,95 @@
+#include <stdexcept>
+
+#include <cradle/rpclib/common/admission_queue.h>
+
+namespace cradle {
+
+admission_queue::ticket&
+admission_queue::ticket::operator=(ticket&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (queue_)
+        {
+            queue_->release();
+        }
+        queue_ = other.queue_;
+        other.queue_ = nullptr;
+    }
+    return *this;
+}
+
+admission_queue::ticket::~ticket()
+{
+    if (queue_)
+    {
+        queue_->release();
+    }
+}
+
+admission_queue::admission_queue(int max_active, int max_waiting)
+    : num_free_slots_{max_active}, max_waiting_{max_waiting}
+{
+}
+
+admission_queue::ticket
+admission_queue::admit(std::string const& client_id)
+{
+    std::unique_lock lock{mutex_};
+    if (num_free_slots_ > 0)
+    {
+        num_free_slots_ -= 1;
+        return ticket{*this};
+    }
+    if (num_waiting_ >= max_waiting_)
+    {
+        // Disguise as an error raised by the rpclib library, so that it looks
+        // retryable.
+        throw std::runtime_error{
+            "rpclib: too many requests waiting; the server is busy"};
+    }
+    waiter self;
+    waiting_[client_id].push_back(&self);
+    num_waiting_ += 1;
+    // release() hands over its slot, and removes self from waiting_
+    admitted_cv_.wait(lock, [&] { return self.admitted; });
+    return ticket{*this};
+}
+
+int
+admission_queue::num_waiting() const
+{
+    std::scoped_lock lock{mutex_};
+    return num_waiting_;
+}
+
+void
+admission_queue::release()
+{
+    {
+        std::scoped_lock lock{mutex_};
+        if (waiting_.empty())
+        {
+            num_free_slots_ += 1;
+            return;
+        }
+        // Hand the slot over to the first client after the one that was
+        // admitted last.
+        auto it = waiting_.upper_bound(last_admitted_client_);
+        if (it == waiting_.end())
+        {
+            it = waiting_.begin();
+        }
+        it->second.front()->admitted = true;
+        it->second.pop_front();
+        last_admitted_client_ = it->first;
+        if (it->second.empty())
+        {
+            waiting_.erase(it);
+        }
+        num_waiting_ -= 1;
+    }
+    admitted_cv_.notify_all();
+}
+
+} // namespace cradle
@@ -0,0 +1,80 @@
+#ifndef CRADLE_RPCLIB_COMMON_ADMISSION_QUEUE_H
+#define CRADLE_RPCLIB_COMMON_ADMISSION_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace cradle {
+
+// Admits requests for resolution, at most max_active at a time.
+// A request that cannot be admitted immediately blocks the calling thread
+// until a slot becomes free; if max_waiting requests are waiting already, it
+// is rejected instead. Waiting requests are admitted round-robin across
+// clients, so that a burst of requests from one client does not hold up the
+// others.
+class admission_queue
+{
+ public:
+    // Admission to a slot.
+    // RAII class; the slot is released when the ticket is destroyed.
+    class ticket
+    {
+     public:
+        ticket() = default;
+
+        explicit ticket(admission_queue& queue) : queue_{&queue}
+        {
+        }
+
+        ticket(ticket&& other) noexcept : queue_{other.queue_}
+        {
+            other.queue_ = nullptr;
+        }
+
+        ticket&
+        operator=(ticket&& other) noexcept;
+
+        ~ticket();
+
+     private:
+        admission_queue* queue_{nullptr};
+    };
+
+    admission_queue(int max_active, int max_waiting);
+
+    // Blocks until a request from the given client is admitted.
+    // Throws if max_waiting requests are waiting already; the error message
+    // starts with "rpclib: ", so that the client considers it retryable.
+    ticket
+    admit(std::string const& client_id);
+
+    // The number of requests currently waiting for admission
+    int
+    num_waiting() const;
+
+ private:
+    struct waiter
+    {
+        bool admitted{false};
+    };
+
+    void
+    release();
+
+    mutable std::mutex mutex_;
+    std::condition_variable admitted_cv_;
+    int num_free_slots_;
+    int const max_waiting_;
+    // The blocked requests, per client
+    std::map<std::string, std::deque<waiter*>> waiting_;
+    int num_waiting_{0};
+    // The client whose request was most recently admitted from waiting_
+    std::string last_admitted_client_;
+};
+
+} // namespace cradle
+
+#endif
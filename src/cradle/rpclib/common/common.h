@@ -18,7 +18,7 @@ namespace cradle {
 // Must be identical between client and server (currently always running on
 // the same machine).
 // Must be increased when the protocol changes.
-static const inline std::string RPCLIB_PROTOCOL{"2"};
+static const inline std::string RPCLIB_PROTOCOL{"5"};
 
 // Response to "resolve" request
 // Using a tuple because a struct requires several non-intrusive msgpack
@@ -24,12 +24,80 @@ struct rpclib_config_keys
     inline static std::string const REQUEST_CONCURRENCY{
         "rpclib/request_concurrency"};
 
+    // (Optional integer)
+    // How many resolve_sync requests can wait for one of the
+    // REQUEST_CONCURRENCY slots, on the rpclib server; further requests are
+    // rejected with a retryable "busy" error. Each waiting request occupies
+    // a (blocked) handler thread.
+    inline static std::string const REQUEST_QUEUE_SIZE{
+        "rpclib/request_queue_size"};
+
+    // (Optional string)
+    // Identifies the client sending a request; the server schedules waiting
+    // requests fairly across clients. Set by the rpclib client.
+    inline static std::string const CLIENT_ID{"rpclib/client_id"};
+
     // (Optional boolean)
     // If true, expects a running server; client shouldn't start it, and it is
     // an error if no server is listening on the specified port.
     // If false, client tries to start a server on the specified port if it
     // doesn't detect an existing one.
     inline static std::string const EXPECT_SERVER{"rpclib/expect_server"};
+
+    // (Optional string)
+    // Format in which the client sends requests to the server: "msgpack"
+    // (the default) or "json". Requests that cannot be serialized to msgpack
+    // are always sent as JSON.
+    // The format is not negotiated: the server detects it per request, and
+    // a server that understands msgpack requests is ensured by the
+    // RPCLIB_PROTOCOL check.
+    inline static std::string const REQUEST_FORMAT{"rpclib/request_format"};
+
+    // (Optional integer)
+    // How many idle contained processes the contained proxy pool tries to
+    // keep available; they are started in the background. Default is 0,
+    // meaning contained processes are only started on demand.
+    inline static std::string const CONTAINED_WARM_POOL_SIZE{
+        "rpclib/contained_warm_pool_size"};
+
+    // (Optional string)
+    // Directory containing the DLLs listed in CONTAINED_PRELOAD_DLLS.
+    inline static std::string const CONTAINED_PRELOAD_DLL_DIR{
+        "rpclib/contained_preload_dll_dir"};
+
+    // (Optional string)
+    // Comma-separated names of the DLLs that are loaded into the contained
+    // processes started in the background.
+    inline static std::string const CONTAINED_PRELOAD_DLLS{
+        "rpclib/contained_preload_dlls"};
+
+    // (Optional integer)
+    // The number of function calls after which a contained process is
+    // terminated instead of being reused. Default is 0, meaning no limit.
+    inline static std::string const CONTAINED_MAX_CALLS{
+        "rpclib/contained_max_calls"};
+
+    // (Optional integer)
+    // The resident memory size, in bytes, above which a contained process is
+    // terminated instead of being reused. Default is 0, meaning no limit.
+    // Only supported on Linux.
+    inline static std::string const CONTAINED_MAX_MEMORY{
+        "rpclib/contained_max_memory"};
+
+    // (Optional integer)
+    // Serialized requests and results, exchanged with a contained process,
+    // of at least this many bytes are passed via shared memory (a blob
+    // file), instead of through the socket. Default is 64KB; 0 disables
+    // shared memory. Also sent to the contained process, with each request.
+    inline static std::string const SHARED_MEMORY_THRESHOLD{
+        "rpclib/shared_memory_threshold"};
+
+    // (Optional string)
+    // Path to the blob file holding the serialized request; if set, the
+    // request itself is passed as an empty string. Set by the client of a
+    // contained process.
+    inline static std::string const SHARED_REQUEST_FILE{
+        "rpclib/shared_request_file"};
 };
 
 } // namespace cradle
@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <stdexcept>
@@ -9,6 +12,7 @@
 #include <cppcoro/task.hpp>
 #include <rpc/this_handler.h>
 
+#include <cradle/inner/blob_file/blob_file.h>
 #include <cradle/inner/caching/immutable/cache.h>
 #include <cradle/inner/core/exception.h>
 #include <cradle/inner/core/fmt_format.h>
@@ -18,6 +22,7 @@
 #include <cradle/inner/remote/config.h>
 #include <cradle/inner/requests/cast_ctx.h>
 #include <cradle/inner/requests/domain.h>
+#include <cradle/inner/requests/serialization.h>
 #include <cradle/inner/resolve/seri_lock.h>
 #include <cradle/inner/resolve/seri_req.h>
 #include <cradle/inner/resolve/util.h>
@@ -38,15 +43,25 @@ thread_pool_guard::thread_pool_guard(int num_available_threads)
 void
 thread_pool_guard::claim_thread()
 {
-    std::scoped_lock lock{mutex_};
-    if (num_free_threads_ == 0)
+    if (!try_claim_thread())
     {
         // Disguise as an error raised by the rpclib library, so that it looks
         // retryable.
         throw std::runtime_error{
             "rpclib: all threads for this request type are busy"};
     }
+}
+
+bool
+thread_pool_guard::try_claim_thread()
+{
+    std::scoped_lock lock{mutex_};
+    if (num_free_threads_ == 0)
+    {
+        return false;
+    }
     num_free_threads_ -= 1;
+    return true;
 }
 
 void
@@ -61,6 +76,12 @@ thread_pool_claim::thread_pool_claim(thread_pool_guard& guard) : guard_{guard}
     guard_.claim_thread();
 }
 
+thread_pool_claim::thread_pool_claim(
+    thread_pool_guard& guard, std::adopt_lock_t)
+    : guard_{guard}
+{
+}
+
 thread_pool_claim::~thread_pool_claim()
 {
     guard_.release_thread();
@@ -74,10 +95,14 @@ rpclib_handler_context::rpclib_handler_context(
       testing_{
           config.get_bool_or_default(generic_config_keys::TESTING, false)},
       logger_{logger},
-      handler_pool_size_{std::max(
-          2,
+      request_concurrency_{std::max(
+          1,
           static_cast<int>(config.get_number_or_default(
               rpclib_config_keys::REQUEST_CONCURRENCY, 16)))},
+      request_queue_size_{static_cast<int>(config.get_number_or_default(
+          rpclib_config_keys::REQUEST_QUEUE_SIZE, 16))},
+      sync_request_queue_{request_concurrency_, request_queue_size_},
+      handler_pool_size_{request_concurrency_ + request_queue_size_ + 1},
       handler_pool_guard_{handler_pool_size_ - 1},
       async_request_pool_size_{static_cast<int>(config.get_number_or_default(
           rpclib_config_keys::REQUEST_CONCURRENCY, 16))},
@@ -92,6 +117,17 @@ rpclib_handler_context::claim_sync_request_thread()
     return thread_pool_claim{handler_pool_guard_};
 }
 
+std::optional<thread_pool_claim>
+rpclib_handler_context::try_claim_wait_request_thread()
+{
+    if (!handler_pool_guard_.try_claim_thread())
+    {
+        return std::nullopt;
+    }
+    return std::optional<thread_pool_claim>{
+        std::in_place, handler_pool_guard_, std::adopt_lock};
+}
+
 static seri_cache_record_lock_t
 alloc_cache_record_lock_if_needed(
     rpclib_handler_context& hctx, bool need_record_lock)
@@ -123,8 +159,15 @@ resolve_sync(
     service_config config{read_config_map_from_json(config_json)};
     auto domain_name
         = config.get_mandatory_string(remote_config_keys::DOMAIN_NAME);
-    logger.info("resolve_sync {}: {}", domain_name, seri_req);
+    logger.info(
+        "resolve_sync {}: {}",
+        domain_name,
+        describe_serialized_request(seri_req));
     logger.info("  config_json {}", config_json);
+    auto client_id{
+        config.get_string_or_default(rpclib_config_keys::CLIENT_ID, "")};
+    // Blocks this handler thread until the request is admitted
+    auto ticket{hctx.sync_request_queue().admit(client_id)};
     auto need_record_lock{config.get_bool_or_default(
         remote_config_keys::NEED_RECORD_LOCK, false)};
     auto seri_lock{alloc_cache_record_lock_if_needed(hctx, need_record_lock)};
@@ -173,8 +216,9 @@ handle_resolve_sync(
 try
 {
     auto claim{hctx.claim_sync_request_thread()};
-    // resolve_sync() blocks the handler thread, but thanks to the claim there
-    // will be at least one thread left to handle incoming requests.
+    // resolve_sync() blocks the handler thread while the request waits for
+    // admission and while it is resolved, but thanks to the claim there will
+    // be at least one thread left to handle incoming requests.
     return resolve_sync(hctx, std::move(config_json), std::move(seri_req));
 }
 catch (std::exception& e)
@@ -231,14 +275,39 @@ catch (std::exception& e)
     return int{};
 }
 
+// Reads a serialized request that the client passed via shared memory.
+static std::string
+read_shared_request(std::string const& path)
+{
+    blob_file_reader reader{file_path{path}};
+    return std::string(
+        reinterpret_cast<char const*>(reader.data()), reader.size());
+}
+
+// Copies a large serialized result to shared memory (a blob file), so that
+// the response refers to that file instead of containing the data, and the
+// client can use the data without copying.
+static blob
+share_result(rpclib_handler_context& hctx, blob const& result)
+{
+    auto writer{hctx.service().make_blob_file_writer(result.size())};
+    std::memcpy(writer->data(), result.data(), result.size());
+    writer->on_write_completed();
+    auto* data{writer->bytes()};
+    return blob{std::move(writer), data, result.size()};
+}
+
 // Resolves an async request, running on a dedicated thread from the
 // async_request_pool_.
+// Results of at least shared_memory_threshold bytes are passed via shared
+// memory (if the threshold is non-zero).
 static void
 resolve_async(
     rpclib_handler_context& hctx,
     std::shared_ptr<root_local_async_context_intf> actx,
     std::string seri_req,
-    seri_cache_record_lock_t seri_lock)
+    seri_cache_record_lock_t seri_lock,
+    std::size_t shared_memory_threshold)
 {
     auto& logger{hctx.logger()};
     if (auto* test_ctx = dynamic_cast<test_context_intf*>(&*actx))
@@ -254,6 +323,12 @@ resolve_async(
                                      *actx, std::move(seri_req), seri_lock))
                   .value();
         logger.info("resolve_async done: {}", res);
+        if (shared_memory_threshold > 0
+            && res.size() >= shared_memory_threshold
+            && !res.mapped_file_data_owner())
+        {
+            res = share_result(hctx, res);
+        }
         actx->set_result(std::move(res));
         actx->set_cache_record_id(seri_lock.record_id);
         actx->on_value_complete();
@@ -280,8 +355,17 @@ try_handle_submit_async(
     service_config config{read_config_map_from_json(config_json)};
     auto domain_name
         = config.get_mandatory_string(remote_config_keys::DOMAIN_NAME);
-    logger.info("submit_async {}: {} ...", domain_name, seri_req);
-    //"submit_async {}: {} ...", domain_name, seri_req.substr(0, 10));
+    if (auto shared_request_file = config.get_optional_string(
+            rpclib_config_keys::SHARED_REQUEST_FILE))
+    {
+        seri_req = read_shared_request(*shared_request_file);
+    }
+    auto shared_memory_threshold{config.get_number_or_default(
+        rpclib_config_keys::SHARED_MEMORY_THRESHOLD, 0)};
+    logger.info(
+        "submit_async {}: {} ...",
+        domain_name,
+        describe_serialized_request(seri_req));
     logger.info("  config_json {}", config_json);
     auto& dom = hctx.service().find_domain(domain_name);
     auto actx{dom.make_local_async_context(config)};
@@ -303,12 +387,19 @@ try_handle_submit_async(
     auto need_record_lock{config.get_bool_or_default(
         remote_config_keys::NEED_RECORD_LOCK, false)};
     auto seri_lock{alloc_cache_record_lock_if_needed(hctx, need_record_lock)};
-    hctx.async_request_pool().detach_task([&hctx,
-                                           actx,
-                                           seri_req = std::move(seri_req),
-                                           seri_lock = std::move(seri_lock)] {
-        resolve_async(hctx, actx, std::move(seri_req), std::move(seri_lock));
-    });
+    hctx.async_request_pool().detach_task(
+        [&hctx,
+         actx,
+         seri_req = std::move(seri_req),
+         seri_lock = std::move(seri_lock),
+         shared_memory_threshold] {
+            resolve_async(
+                hctx,
+                actx,
+                std::move(seri_req),
+                std::move(seri_lock),
+                shared_memory_threshold);
+        });
     async_id aid = actx->get_id();
     logger.info("async_id {}", aid);
     return aid;
@@ -407,6 +498,44 @@ catch (std::exception& e)
     return int{};
 }
 
+// Upper limit on the time that a wait_async_status request blocks its handler
+// thread, in milliseconds
+static constexpr int max_wait_async_status_timeout{10000};
+
+int
+handle_wait_async_status(
+    rpclib_handler_context& hctx,
+    async_id aid,
+    int known_status,
+    int timeout_ms)
+try
+{
+    auto& db{hctx.get_async_db()};
+    auto& logger{hctx.logger()};
+    logger.debug("handle_wait_async_status {} {}", aid, known_status);
+    auto actx{db.find(aid)};
+    async_status status;
+    // If no handler thread can be spared for waiting, return the current
+    // status immediately; the client will then back off before retrying.
+    if (auto claim = hctx.try_claim_wait_request_thread())
+    {
+        auto timeout{std::chrono::milliseconds{
+            std::clamp(timeout_ms, 0, max_wait_async_status_timeout)}};
+        status = actx->wait_status_change(async_status{known_status}, timeout);
+    }
+    else
+    {
+        status = actx->get_status();
+    }
+    logger.debug("handle_wait_async_status -> {}", status);
+    return static_cast<int>(status);
+}
+catch (std::exception& e)
+{
+    handle_exception(hctx, e);
+    return int{};
+}
+
 std::string
 handle_get_async_error_message(rpclib_handler_context& hctx, async_id aid)
 try
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 
 #include <BS_thread_pool.hpp>
@@ -13,6 +14,7 @@
 #include <cradle/inner/remote/async_db.h>
 #include <cradle/inner/remote/proxy.h>
 #include <cradle/inner/remote/types.h>
+#include <cradle/rpclib/common/admission_queue.h>
 #include <cradle/rpclib/common/common.h>
 #include <cradle/thinknode/service/core.h>
 
@@ -29,6 +31,10 @@ class thread_pool_guard
     void
     claim_thread();
 
+    // Claims a thread; returns false if none available
+    bool
+    try_claim_thread();
+
     // Releases a claimed thread
     void
     release_thread();
@@ -47,6 +53,9 @@ class thread_pool_claim
  public:
     thread_pool_claim(thread_pool_guard& guard);
 
+    // Takes over a thread that was already claimed on guard
+    thread_pool_claim(thread_pool_guard& guard, std::adopt_lock_t);
+
     ~thread_pool_claim();
 
  private:
@@ -105,23 +114,43 @@ class rpclib_handler_context
     thread_pool_claim
     claim_sync_request_thread();
 
+    // Admission queue for the resolve_sync requests
+    admission_queue&
+    sync_request_queue()
+    {
+        return sync_request_queue_;
+    }
+
+    // Tries to claim a thread for handling a wait_async_status request, which
+    // blocks a handler thread for a limited time. These requests share the
+    // threads with the resolve_sync ones.
+    std::optional<thread_pool_claim>
+    try_claim_wait_request_thread();
+
  private:
     service_core& service_;
     bool testing_;
     spdlog::logger& logger_;
 
+    // At most request_concurrency_ resolve_sync requests are resolved at the
+    // same time. Up to request_queue_size_ further resolve_sync requests wait
+    // in sync_request_queue_. rpclib expects a handler to return its response,
+    // so both an active and a waiting request block their handler thread:
+    // the admitted request is resolved via sync_wait() on that thread.
+    int const request_concurrency_;
+    int const request_queue_size_;
+    admission_queue sync_request_queue_;
+
     // Each incoming request is handled by a separate thread from a pool
-    // containing handler_pool_size_ threads.
-    // A handler thread handles a short request (taking little time to handle),
-    // or a potentially long resolve_sync one. If all handler threads would be
-    // busy resolving a resolve_sync request, the server is unresponsive until
-    // the first thread finishes.
-    // To prevent this, the number of threads available for the resolve_sync
-    // requests is handler_pool_size_ - 1, so that always one thread is left to
-    // handle short requests, and the server remains responsive. This means
-    // that handler_pool_size_ must be at least 2.
-    // If a resolve_sync request comes in while no threads are available, the
-    // request immediately fails with a "busy" error.
+    // containing handler_pool_size_ threads: one for each active or waiting
+    // resolve_sync request, plus one. Each waiting request thus costs an idle
+    // thread, which is why request_queue_size_ should be kept modest.
+    // The number of threads available for the resolve_sync requests is
+    // handler_pool_size_ - 1, so that always one thread is left to handle
+    // short requests, and the server remains responsive.
+    // If a resolve_sync request comes in while no threads are available, or
+    // while the queue is full, the request immediately fails with a "busy"
+    // error, which the client considers retryable.
     // The thread pool itself is created in run_server().
     int const handler_pool_size_;
     thread_pool_guard handler_pool_guard_;
@@ -172,6 +201,13 @@ handle_get_sub_contexts(rpclib_handler_context& hctx, async_id aid);
 int
 handle_get_async_status(rpclib_handler_context& hctx, async_id aid);
 
+int
+handle_wait_async_status(
+    rpclib_handler_context& hctx,
+    async_id aid,
+    int known_status,
+    int timeout_ms);
+
 std::string
 handle_get_async_error_message(rpclib_handler_context& hctx, async_id aid);
 
@@ -244,6 +244,12 @@ run_server(cli_options const& options)
     srv.bind("get_async_status", [&](async_id aid) {
         return handle_get_async_status(hctx, aid);
     });
+    srv.bind(
+        "wait_async_status",
+        [&](async_id aid, int known_status, int timeout_ms) {
+            return handle_wait_async_status(
+                hctx, aid, known_status, timeout_ms);
+        });
     srv.bind("get_async_error_message", [&](async_id aid) {
         return handle_get_async_error_message(hctx, aid);
     });
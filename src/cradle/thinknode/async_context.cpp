@@ -17,7 +17,7 @@ std::string const the_domain_name{"thinknode"};
 root_local_async_thinknode_context::root_local_async_thinknode_context(
     std::unique_ptr<local_tree_context_base> tree_ctx,
     service_config const& config)
-    : root_local_async_context_base{*tree_ctx},
+    : root_local_async_context_base{*tree_ctx, config},
       test_params_context_mixin{config},
       owning_tree_ctx_{std::move(tree_ctx)}
 {
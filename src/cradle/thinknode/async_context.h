@@ -318,6 +318,13 @@ class async_thinknode_context final : public root_local_async_context_intf,
         return get_local_root().get_status();
     }
 
+    async_status
+    wait_status_change(
+        async_status known_status, std::chrono::milliseconds timeout) override
+    {
+        return get_local_root().wait_status_change(known_status, timeout);
+    }
+
     std::string
     get_error_message() override
     {
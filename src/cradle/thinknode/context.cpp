@@ -27,6 +27,7 @@ thinknode_request_context::thinknode_request_context(
       service{service},
       session{make_session(config)}
 {
+    set_schedule_hint(read_schedule_hint(config));
 }
 
 thinknode_request_context::thinknode_request_context(
@@ -59,6 +60,7 @@ thinknode_request_context::make_config(bool need_record_lock) const
         {thinknode_config_keys::API_URL, session.api_url},
         {thinknode_config_keys::ACCESS_TOKEN, session.access_token},
     };
+    update_config_map_with_schedule_hint(config_map);
     if (!tasklets_.empty())
     {
         config_map.insert(std::pair{
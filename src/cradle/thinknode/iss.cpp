@@ -223,6 +223,11 @@ retrieve_immutable_blob_uncached(
             + "?context=" + context_id,
         {{"Authorization", "Bearer " + ctx.session.access_token},
          {"Accept", "application/octet-stream"}});
+    // Receive the blob directly in its final (data_owner) buffer, so that
+    // the body need not be copied.
+    query.body_owner_factory = [&ctx](std::size_t size) {
+        return ctx.make_data_owner(size, false);
+    };
     auto response = co_await async_http_request(ctx, query);
     co_return response.body;
 }
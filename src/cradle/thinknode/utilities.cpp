@@ -116,7 +116,7 @@ cppcoro::task<http_response>
 async_http_request(thinknode_request_context ctx, http_request request)
 {
     return ctx.service.async_http_request(
-        std::move(request), ctx.get_tasklet());
+        std::move(request), ctx.get_tasklet(), ctx.get_schedule_hint());
 }
 
 void
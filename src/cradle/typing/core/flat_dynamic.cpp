@@ -0,0 +1,541 @@
+#include <cradle/typing/core/flat_dynamic.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/numeric/conversion/cast.hpp>
+
+namespace cradle {
+
+namespace detail {
+
+struct flat_dynamic_arena
+{
+    std::vector<std::unique_ptr<std::byte[]>> chunks;
+    // The blobs referenced by blob nodes; a deque, so that they don't move.
+    std::deque<blob> blobs;
+    size_t allocated_size{0};
+};
+
+} // namespace detail
+
+using detail::flat_dynamic_node;
+
+namespace {
+
+flat_dynamic_node const nil_node{value_type::NIL, 0, {false}};
+
+ptime const the_epoch(date(1970, 1, 1));
+
+// Three-way comparison with the semantics of the dynamic operators
+int
+compare_nodes(flat_dynamic_node const& a, flat_dynamic_node const& b);
+
+template<class T>
+int
+compare_values(T const& a, T const& b)
+{
+    return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+int
+compare_children(
+    flat_dynamic_node const* a,
+    size_t a_size,
+    flat_dynamic_node const* b,
+    size_t b_size)
+{
+    size_t common_size = std::min(a_size, b_size);
+    for (size_t i = 0; i != common_size; ++i)
+    {
+        int c = compare_nodes(a[i], b[i]);
+        if (c != 0)
+            return c;
+    }
+    return compare_values(a_size, b_size);
+}
+
+int
+compare_nodes(flat_dynamic_node const& a, flat_dynamic_node const& b)
+{
+    if (a.type != b.type)
+        return compare_values(a.type, b.type);
+    switch (a.type)
+    {
+        case value_type::NIL:
+        default:
+            return 0;
+        case value_type::BOOLEAN:
+            return compare_values(a.boolean, b.boolean);
+        case value_type::INTEGER:
+            return compare_values(a.integer_value, b.integer_value);
+        case value_type::FLOAT:
+            return compare_values(a.float_value, b.float_value);
+        case value_type::STRING:
+            return compare_values(
+                std::string_view(a.string, a.size),
+                std::string_view(b.string, b.size));
+        case value_type::BLOB:
+            return compare_values(*a.blob_value, *b.blob_value);
+        case value_type::DATETIME:
+            return compare_values(a.datetime, b.datetime);
+        case value_type::ARRAY:
+            return compare_children(a.children, a.size, b.children, b.size);
+        case value_type::MAP:
+            // The keys and values are interleaved, so this compares the
+            // entries the same way as std::map does.
+            return compare_children(
+                a.children,
+                2 * size_t(a.size),
+                b.children,
+                2 * size_t(b.size));
+    }
+}
+
+} // namespace
+
+// VIEWS
+
+ptime
+flat_dynamic_view::as_datetime() const
+{
+    check_type(value_type::DATETIME, node_->type);
+    return the_epoch + boost::posix_time::microseconds(node_->datetime);
+}
+
+bool
+flat_dynamic_view::get_field(
+    flat_dynamic_view* value, std::string_view key) const
+{
+    check_type(value_type::MAP, node_->type);
+    // Binary search over the (sorted) keys
+    size_t low = 0;
+    size_t high = node_->size;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        auto const& k = node_->children[2 * mid];
+        bool less = k.type != value_type::STRING
+                        ? k.type < value_type::STRING
+                        : std::string_view(k.string, k.size) < key;
+        if (less)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == node_->size)
+        return false;
+    auto const& k = node_->children[2 * low];
+    if (k.type != value_type::STRING
+        || std::string_view(k.string, k.size) != key)
+    {
+        return false;
+    }
+    *value = flat_dynamic_view(&node_->children[2 * low + 1]);
+    return true;
+}
+
+flat_dynamic_view
+flat_dynamic_view::get_field(std::string_view key) const
+{
+    flat_dynamic_view value{nullptr};
+    if (!get_field(&value, key))
+    {
+        CRADLE_THROW(missing_field() << field_name_info(string(key)));
+    }
+    return value;
+}
+
+bool
+operator==(flat_dynamic_view a, flat_dynamic_view b)
+{
+    return compare_nodes(*a.node(), *b.node()) == 0;
+}
+bool
+operator!=(flat_dynamic_view a, flat_dynamic_view b)
+{
+    return !(a == b);
+}
+bool
+operator<(flat_dynamic_view a, flat_dynamic_view b)
+{
+    return compare_nodes(*a.node(), *b.node()) < 0;
+}
+
+// VALUES
+
+flat_dynamic::flat_dynamic() : root_{&nil_node}
+{
+}
+
+size_t
+flat_dynamic::arena_size() const
+{
+    return arena_ ? arena_->allocated_size : 0;
+}
+
+// BUILDER
+
+namespace {
+
+// The first chunk is small, so that small values don't waste memory; after
+// that, the chunk size doubles up to a maximum.
+size_t const initial_chunk_size = 1024;
+size_t const max_chunk_size = 1024 * 1024;
+
+// Only strings up to this length are interned. Longer strings are unlikely to
+// repeat, so hashing them would be a waste.
+size_t const max_interned_string_length = 64;
+
+} // namespace
+
+struct flat_dynamic_builder::impl
+{
+    std::shared_ptr<detail::flat_dynamic_arena> arena{
+        std::make_shared<detail::flat_dynamic_arena>()};
+    std::byte* chunk_position{nullptr};
+    size_t chunk_remaining{0};
+    size_t next_chunk_size{initial_chunk_size};
+    std::unordered_set<std::string_view> interned_strings;
+
+    void*
+    allocate(size_t size, size_t alignment)
+    {
+        size_t padding = (alignment
+                          - reinterpret_cast<std::uintptr_t>(chunk_position)
+                                % alignment)
+                         % alignment;
+        if (chunk_remaining < size + padding)
+        {
+            // Big allocations get a chunk of their own, so that they don't
+            // waste the remainder of the current chunk.
+            if (size > next_chunk_size / 4)
+                return allocate_chunk(size);
+            chunk_position
+                = static_cast<std::byte*>(allocate_chunk(next_chunk_size));
+            chunk_remaining = next_chunk_size;
+            next_chunk_size = std::min(next_chunk_size * 2, max_chunk_size);
+            padding = 0;
+        }
+        auto* result = chunk_position + padding;
+        chunk_position += padding + size;
+        chunk_remaining -= padding + size;
+        return result;
+    }
+
+    // The new[] allocation is suitably aligned for any node. (This doesn't
+    // use make_unique because that would zero the memory.)
+    void*
+    allocate_chunk(size_t size)
+    {
+        arena->chunks.emplace_back(new std::byte[size]);
+        arena->allocated_size += size;
+        return arena->chunks.back().get();
+    }
+};
+
+flat_dynamic_builder::flat_dynamic_builder() : impl_{std::make_unique<impl>()}
+{
+    root_ = allocate_nodes(1);
+}
+
+flat_dynamic_builder::~flat_dynamic_builder() = default;
+
+flat_dynamic_builder::node*
+flat_dynamic_builder::allocate_nodes(size_t count)
+{
+    auto* nodes = static_cast<node*>(
+        impl_->allocate(count * sizeof(node), alignof(node)));
+    for (size_t i = 0; i != count; ++i)
+    {
+        nodes[i].type = value_type::NIL;
+        nodes[i].size = 0;
+    }
+    return nodes;
+}
+
+void
+flat_dynamic_builder::set_nil(node& n)
+{
+    n.type = value_type::NIL;
+    n.size = 0;
+}
+
+void
+flat_dynamic_builder::set_bool(node& n, bool x)
+{
+    n.type = value_type::BOOLEAN;
+    n.boolean = x;
+}
+
+void
+flat_dynamic_builder::set_integer(node& n, integer x)
+{
+    n.type = value_type::INTEGER;
+    n.integer_value = x;
+}
+
+void
+flat_dynamic_builder::set_double(node& n, double x)
+{
+    n.type = value_type::FLOAT;
+    n.float_value = x;
+}
+
+void
+flat_dynamic_builder::set_string(node& n, std::string_view x)
+{
+    n.type = value_type::STRING;
+    n.size = boost::numeric_cast<uint32_t>(x.size());
+    if (x.empty())
+    {
+        n.string = "";
+        return;
+    }
+    bool intern = x.size() <= max_interned_string_length;
+    if (intern)
+    {
+        auto i = impl_->interned_strings.find(x);
+        if (i != impl_->interned_strings.end())
+        {
+            n.string = i->data();
+            return;
+        }
+    }
+    auto* copy = static_cast<char*>(impl_->allocate(x.size(), 1));
+    std::memcpy(copy, x.data(), x.size());
+    n.string = copy;
+    if (intern)
+    {
+        impl_->interned_strings.insert(std::string_view(copy, x.size()));
+    }
+}
+
+void
+flat_dynamic_builder::set_blob(node& n, blob x)
+{
+    auto& blobs = impl_->arena->blobs;
+    blobs.push_back(std::move(x));
+    n.type = value_type::BLOB;
+    n.blob_value = &blobs.back();
+}
+
+void
+flat_dynamic_builder::set_datetime(node& n, ptime const& x)
+{
+    n.type = value_type::DATETIME;
+    n.datetime = (x - the_epoch).total_microseconds();
+}
+
+flat_dynamic_builder::node*
+flat_dynamic_builder::set_array(node& n, size_t size)
+{
+    auto* children = allocate_nodes(size);
+    n.type = value_type::ARRAY;
+    n.size = boost::numeric_cast<uint32_t>(size);
+    n.children = children;
+    return children;
+}
+
+flat_dynamic_builder::node*
+flat_dynamic_builder::set_map(node& n, size_t size)
+{
+    auto* children = allocate_nodes(2 * size);
+    n.type = value_type::MAP;
+    n.size = boost::numeric_cast<uint32_t>(size);
+    n.children = children;
+    return children;
+}
+
+void
+flat_dynamic_builder::finish_map(node& n)
+{
+    // The children were allocated by set_map(), so they're ours to modify.
+    auto* entries = const_cast<node*>(n.children);
+    size_t size = n.size;
+
+    // Maps usually arrive sorted (e.g., when they were encoded from a
+    // dynamic_map), in which case there's nothing to do.
+    bool sorted = true;
+    for (size_t i = 1; i < size; ++i)
+    {
+        if (compare_nodes(entries[2 * (i - 1)], entries[2 * i]) >= 0)
+        {
+            sorted = false;
+            break;
+        }
+    }
+    if (sorted)
+        return;
+
+    std::vector<uint32_t> order(size);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return compare_nodes(entries[2 * a], entries[2 * b]) < 0;
+    });
+    // Of any entries with the same key, keep the last one.
+    std::vector<node> sorted_entries;
+    sorted_entries.reserve(2 * size);
+    for (auto i : order)
+    {
+        if (!sorted_entries.empty()
+            && compare_nodes(
+                   sorted_entries[sorted_entries.size() - 2], entries[2 * i])
+                   == 0)
+        {
+            sorted_entries.back() = entries[2 * i + 1];
+        }
+        else
+        {
+            sorted_entries.push_back(entries[2 * i]);
+            sorted_entries.push_back(entries[2 * i + 1]);
+        }
+    }
+    std::copy(sorted_entries.begin(), sorted_entries.end(), entries);
+    n.size = uint32_t(sorted_entries.size() / 2);
+}
+
+flat_dynamic
+flat_dynamic_builder::finish()
+{
+    flat_dynamic result{std::move(impl_->arena), root_};
+    impl_.reset();
+    return result;
+}
+
+// CONVERSIONS
+
+static void
+build_flat_node(
+    flat_dynamic_builder& builder,
+    flat_dynamic_builder::node& n,
+    dynamic const& v)
+{
+    switch (v.type())
+    {
+        case value_type::NIL:
+            builder.set_nil(n);
+            break;
+        case value_type::BOOLEAN:
+            builder.set_bool(n, cast<bool>(v));
+            break;
+        case value_type::INTEGER:
+            builder.set_integer(n, cast<integer>(v));
+            break;
+        case value_type::FLOAT:
+            builder.set_double(n, cast<double>(v));
+            break;
+        case value_type::STRING:
+            builder.set_string(n, cast<string>(v));
+            break;
+        case value_type::BLOB:
+            builder.set_blob(n, cast<blob>(v));
+            break;
+        case value_type::DATETIME:
+            builder.set_datetime(n, cast<ptime>(v));
+            break;
+        case value_type::ARRAY: {
+            auto const& array = cast<dynamic_array>(v);
+            auto* elements = builder.set_array(n, array.size());
+            for (size_t i = 0; i != array.size(); ++i)
+                build_flat_node(builder, elements[i], array[i]);
+            break;
+        }
+        case value_type::MAP: {
+            auto const& map = cast<dynamic_map>(v);
+            auto* entries = builder.set_map(n, map.size());
+            for (auto const& [key, value] : map)
+            {
+                build_flat_node(builder, *entries++, key);
+                build_flat_node(builder, *entries++, value);
+            }
+            builder.finish_map(n);
+            break;
+        }
+    }
+}
+
+flat_dynamic
+make_flat_dynamic(dynamic const& v)
+{
+    flat_dynamic_builder builder;
+    build_flat_node(builder, builder.root(), v);
+    return builder.finish();
+}
+
+void
+to_dynamic(dynamic* v, flat_dynamic_view x)
+{
+    switch (x.type())
+    {
+        case value_type::NIL:
+            *v = nil;
+            break;
+        case value_type::BOOLEAN:
+            *v = x.as_bool();
+            break;
+        case value_type::INTEGER:
+            *v = x.as_integer();
+            break;
+        case value_type::FLOAT:
+            *v = x.as_double();
+            break;
+        case value_type::STRING:
+            *v = string(x.as_string());
+            break;
+        case value_type::BLOB:
+            *v = x.as_blob();
+            break;
+        case value_type::DATETIME:
+            *v = x.as_datetime();
+            break;
+        case value_type::ARRAY: {
+            size_t size = x.size();
+            dynamic_array array(size);
+            for (size_t i = 0; i != size; ++i)
+                to_dynamic(&array[i], x[i]);
+            *v = std::move(array);
+            break;
+        }
+        case value_type::MAP: {
+            size_t size = x.size();
+            dynamic_map map;
+            for (size_t i = 0; i != size; ++i)
+            {
+                dynamic key;
+                to_dynamic(&key, x.key(i));
+                // The entries are already sorted, so each one goes at the
+                // end.
+                auto entry
+                    = map.emplace_hint(map.end(), std::move(key), dynamic());
+                to_dynamic(&entry->second, x.value(i));
+            }
+            *v = std::move(map);
+            break;
+        }
+    }
+}
+
+void
+to_dynamic(dynamic* v, flat_dynamic const& x)
+{
+    to_dynamic(v, x.root());
+}
+
+void
+from_dynamic(flat_dynamic* x, dynamic const& v)
+{
+    *x = make_flat_dynamic(v);
+}
+
+std::ostream&
+operator<<(std::ostream& os, flat_dynamic const& v)
+{
+    return os << to_dynamic(v);
+}
+
+} // namespace cradle
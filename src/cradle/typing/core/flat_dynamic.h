@@ -0,0 +1,300 @@
+#ifndef CRADLE_TYPING_CORE_FLAT_DYNAMIC_H
+#define CRADLE_TYPING_CORE_FLAT_DYNAMIC_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include <cradle/typing/core/dynamic.h>
+
+// A flat_dynamic is an immutable alternative to dynamic for large values, such
+// as parsed Thinknode results.
+//
+// All nodes of a flat_dynamic live in a single arena. The elements of an
+// array, and the key/value pairs of a map, are stored contiguously, with map
+// entries sorted by key (in the same order as a dynamic_map). Strings are
+// interned within the arena, and blobs can reference the buffer that the
+// value was parsed from. Building a flat_dynamic therefore takes a handful of
+// allocations rather than one per node, and destroying it is (nearly) free.
+//
+// The parsers produce flat_dynamics directly (see parse_json_flat_value() and
+// parse_msgpack_flat_value()), and they can be converted to and from
+// dynamic.
+
+namespace cradle {
+
+namespace detail {
+
+struct flat_dynamic_node
+{
+    value_type type;
+    // string: length; array: number of elements; map: number of entries
+    uint32_t size;
+    union
+    {
+        bool boolean;
+        integer integer_value;
+        double float_value;
+        // microseconds since the epoch
+        int64_t datetime;
+        char const* string;
+        blob const* blob_value;
+        // array: the elements; map: the keys and values, interleaved
+        flat_dynamic_node const* children;
+    };
+};
+
+struct flat_dynamic_arena;
+
+} // namespace detail
+
+// A non-owning reference to a node within a flat_dynamic. It's only valid as
+// long as the flat_dynamic is alive.
+class flat_dynamic_view
+{
+ public:
+    explicit flat_dynamic_view(detail::flat_dynamic_node const* node)
+        : node_{node}
+    {
+    }
+
+    value_type
+    type() const
+    {
+        return node_->type;
+    }
+
+    bool
+    as_bool() const
+    {
+        check_type(value_type::BOOLEAN, node_->type);
+        return node_->boolean;
+    }
+
+    integer
+    as_integer() const
+    {
+        check_type(value_type::INTEGER, node_->type);
+        return node_->integer_value;
+    }
+
+    double
+    as_double() const
+    {
+        check_type(value_type::FLOAT, node_->type);
+        return node_->float_value;
+    }
+
+    std::string_view
+    as_string() const
+    {
+        check_type(value_type::STRING, node_->type);
+        return std::string_view(node_->string, node_->size);
+    }
+
+    blob const&
+    as_blob() const
+    {
+        check_type(value_type::BLOB, node_->type);
+        return *node_->blob_value;
+    }
+
+    ptime
+    as_datetime() const;
+
+    // The number of elements in an array, or of entries in a map
+    size_t
+    size() const
+    {
+        if (node_->type != value_type::MAP)
+            check_type(value_type::ARRAY, node_->type);
+        return node_->size;
+    }
+
+    // Array element i
+    flat_dynamic_view
+    operator[](size_t i) const
+    {
+        check_type(value_type::ARRAY, node_->type);
+        return flat_dynamic_view(&node_->children[i]);
+    }
+
+    // The key and value of map entry i
+    flat_dynamic_view
+    key(size_t i) const
+    {
+        check_type(value_type::MAP, node_->type);
+        return flat_dynamic_view(&node_->children[2 * i]);
+    }
+    flat_dynamic_view
+    value(size_t i) const
+    {
+        check_type(value_type::MAP, node_->type);
+        return flat_dynamic_view(&node_->children[2 * i + 1]);
+    }
+
+    // Looks up a string key in a map, in logarithmic time. If it's there,
+    // sets *value to its value and returns true.
+    bool
+    get_field(flat_dynamic_view* value, std::string_view key) const;
+
+    // Same, but throws missing_field if the key isn't there.
+    flat_dynamic_view
+    get_field(std::string_view key) const;
+
+    detail::flat_dynamic_node const*
+    node() const
+    {
+        return node_;
+    }
+
+ private:
+    detail::flat_dynamic_node const* node_;
+};
+
+// Compares two views with the same semantics as the dynamic operators.
+bool
+operator==(flat_dynamic_view a, flat_dynamic_view b);
+bool
+operator!=(flat_dynamic_view a, flat_dynamic_view b);
+bool
+operator<(flat_dynamic_view a, flat_dynamic_view b);
+
+// An immutable value, stored in its own arena. Copies share the arena.
+class flat_dynamic
+{
+ public:
+    // Creates a nil value.
+    flat_dynamic();
+
+    flat_dynamic(
+        std::shared_ptr<detail::flat_dynamic_arena const> arena,
+        detail::flat_dynamic_node const* root)
+        : arena_{std::move(arena)}, root_{root}
+    {
+    }
+
+    flat_dynamic_view
+    root() const
+    {
+        return flat_dynamic_view(root_);
+    }
+
+    value_type
+    type() const
+    {
+        return root_->type;
+    }
+
+    // The number of bytes allocated for the arena
+    size_t
+    arena_size() const;
+
+ private:
+    std::shared_ptr<detail::flat_dynamic_arena const> arena_;
+    detail::flat_dynamic_node const* root_;
+};
+
+inline bool
+operator==(flat_dynamic const& a, flat_dynamic const& b)
+{
+    return a.root() == b.root();
+}
+inline bool
+operator!=(flat_dynamic const& a, flat_dynamic const& b)
+{
+    return !(a == b);
+}
+
+// Builds a flat_dynamic, top-down. The caller first creates the root node,
+// and then fills in each node; filling in an array or map node allocates
+// the (uninitialized) nodes for its contents, which must be filled in
+// subsequently.
+class flat_dynamic_builder
+{
+ public:
+    using node = detail::flat_dynamic_node;
+
+    flat_dynamic_builder();
+    ~flat_dynamic_builder();
+
+    flat_dynamic_builder(flat_dynamic_builder const&) = delete;
+    flat_dynamic_builder&
+    operator=(flat_dynamic_builder const&)
+        = delete;
+
+    node&
+    root()
+    {
+        return *root_;
+    }
+
+    void
+    set_nil(node& n);
+
+    void
+    set_bool(node& n, bool x);
+
+    void
+    set_integer(node& n, integer x);
+
+    void
+    set_double(node& n, double x);
+
+    // The string is copied into the arena, unless an equal string is already
+    // there.
+    void
+    set_string(node& n, std::string_view x);
+
+    void
+    set_blob(node& n, blob x);
+
+    void
+    set_datetime(node& n, ptime const& x);
+
+    // Returns the size nodes for the elements.
+    node*
+    set_array(node& n, size_t size);
+
+    // Returns the 2 * size nodes for the entries (key, value, key, value...),
+    // which may be filled in any order; finish_map() must be called once
+    // they're filled in.
+    node*
+    set_map(node& n, size_t size);
+
+    // Sorts the entries of a map node. If the same key appears more than
+    // once, the last entry wins (as when inserting into a dynamic_map).
+    void
+    finish_map(node& n);
+
+    // Returns the built value. The builder can't be used afterwards.
+    flat_dynamic
+    finish();
+
+ private:
+    node*
+    allocate_nodes(size_t count);
+
+    struct impl;
+    std::unique_ptr<impl> impl_;
+    node* root_;
+};
+
+flat_dynamic
+make_flat_dynamic(dynamic const& v);
+
+void
+to_dynamic(dynamic* v, flat_dynamic_view x);
+
+void
+to_dynamic(dynamic* v, flat_dynamic const& x);
+
+void
+from_dynamic(flat_dynamic* x, dynamic const& v);
+
+std::ostream&
+operator<<(std::ostream& os, flat_dynamic const& v);
+
+} // namespace cradle
+
+#endif
@@ -77,6 +77,11 @@ struct structure_field_type_info_adder
 
 struct dynamic;
 
+// The direct MessagePack codec (see typing/encodings/msgpack_codec.h)
+class msgpack_writer;
+class msgpack_reader;
+class msgpack_record;
+
 enum class value_type
 {
     NIL, // nil_t - no value
@@ -50,6 +50,73 @@ safe_isdigit(char ch)
     return std::isdigit(static_cast<unsigned char>(ch));
 }
 
+// Times are also encoded as JSON strings, so this checks to see if the
+// string parses as a time. If so, it just assumes it's actually a time.
+static optional<ptime>
+parse_json_time_string(std::string_view s)
+{
+    // First check if it looks anything like a time string.
+    if (s.length() > 16 && safe_isdigit(s[0]) && safe_isdigit(s[1])
+        && safe_isdigit(s[2]) && safe_isdigit(s[3]) && s[4] == '-')
+    {
+        try
+        {
+            auto t = parse_ptime(string(s));
+            // Check that it can be converted back without changing its
+            // value. This could be necessary if we actually expected a
+            // string here.
+            if (to_value_string(t) == s)
+            {
+                return t;
+            }
+        }
+        catch (...)
+        {
+        }
+    }
+    return none;
+}
+
+// Blobs are encoded as JSON objects that are tagged as such.
+static bool
+is_json_blob(simdjson::dom::object const& object)
+{
+    auto type = object.at_key("type");
+    return type.error() != simdjson::NO_SUCH_FIELD && type.value().is_string()
+           && type.value().get_string().value() == "base64-encoded-blob";
+}
+
+static blob
+read_json_blob(simdjson::dom::element const& json)
+{
+    simdjson::dom::object object = json;
+    auto json_blob = object.at_key("blob");
+    if (json_blob.error() != simdjson::NO_SUCH_FIELD
+        && json_blob.value().is_string())
+    {
+        auto encoded = json_blob.value().get_string().value();
+        size_t max_decoded_size = get_base64_decoded_length(encoded.length());
+        byte_vector decoded(max_decoded_size);
+        size_t decoded_size;
+        base64_decode(
+            decoded.data(),
+            &decoded_size,
+            encoded.data(),
+            encoded.length(),
+            get_mime_base64_character_set());
+        return make_blob(std::move(decoded), decoded_size);
+    }
+    else
+    {
+        // This was supposed to be a blob, but it's not.
+        CRADLE_THROW(
+            parsing_error()
+            << expected_format_info("base64-encoded-blob")
+            << parsed_text_info(simdjson::minify(json))
+            << parsing_error_info("object tagged as blob but missing data"));
+    }
+}
+
 // Read a JSON value into a CRADLE dynamic.
 static dynamic
 read_json_value(simdjson::dom::element const& json)
@@ -68,29 +135,9 @@ read_json_value(simdjson::dom::element const& json)
         case simdjson::dom::element_type::DOUBLE:
             return dynamic(double(json));
         case simdjson::dom::element_type::STRING: {
-            // Times are also encoded as JSON strings, so this checks to see if
-            // the string parses as a time. If so, it just assumes it's
-            // actually a time.
             auto s = json.get_string().value();
-            // First check if it looks anything like a time string.
-            if (s.length() > 16 && safe_isdigit(s[0]) && safe_isdigit(s[1])
-                && safe_isdigit(s[2]) && safe_isdigit(s[3]) && s[4] == '-')
-            {
-                try
-                {
-                    auto t = parse_ptime(string(s));
-                    // Check that it can be converted back without changing its
-                    // value. This could be necessary if we actually expected a
-                    // string here.
-                    if (to_value_string(t) == s)
-                    {
-                        return dynamic(t);
-                    }
-                }
-                catch (...)
-                {
-                }
-            }
+            if (auto t = parse_json_time_string(s))
+                return dynamic(*t);
             return dynamic(string(s));
         }
         case simdjson::dom::element_type::ARRAY: {
@@ -123,39 +170,9 @@ read_json_value(simdjson::dom::element const& json)
             // also encoded as JSON objects, so we have to check here if it's
             // actually one of those.
             simdjson::dom::object object = json;
-            auto type = object.at_key("type");
-            if (type.error() != simdjson::NO_SUCH_FIELD
-                && type.value().is_string()
-                && type.value().get_string().value() == "base64-encoded-blob")
+            if (is_json_blob(object))
             {
-                auto json_blob = object.at_key("blob");
-                if (json_blob.error() != simdjson::NO_SUCH_FIELD
-                    && json_blob.value().is_string())
-                {
-                    auto encoded = json_blob.value().get_string().value();
-                    size_t max_decoded_size
-                        = get_base64_decoded_length(encoded.length());
-                    byte_vector decoded(max_decoded_size);
-                    size_t decoded_size;
-                    base64_decode(
-                        decoded.data(),
-                        &decoded_size,
-                        encoded.data(),
-                        encoded.length(),
-                        get_mime_base64_character_set());
-                    return dynamic(
-                        make_blob(std::move(decoded), decoded_size));
-                }
-                else
-                {
-                    // This was supposed to be a blob, but it's not.
-                    CRADLE_THROW(
-                        parsing_error()
-                        << expected_format_info("base64-encoded-blob")
-                        << parsed_text_info(simdjson::minify(json))
-                        << parsing_error_info(
-                               "object tagged as blob but missing data"));
-                }
+                return dynamic(read_json_blob(json));
             }
             else
             {
@@ -171,8 +188,11 @@ read_json_value(simdjson::dom::element const& json)
     }
 }
 
-dynamic
-parse_json_value(char const* json, size_t length)
+// Parse some JSON text and pass the resulting document to read. The document
+// is only valid within the call.
+template<class Read>
+static auto
+with_parsed_json(char const* json, size_t length, Read&& read)
 {
     static simdjson::dom::parser the_parser;
     static std::mutex the_mutex;
@@ -191,7 +211,106 @@ parse_json_value(char const* json, size_t length)
                             << parsed_text_info(string(json, json + length))
                             << parsing_error_info(e.what()));
     }
-    return read_json_value(doc);
+    return read(doc);
+}
+
+dynamic
+parse_json_value(char const* json, size_t length)
+{
+    return with_parsed_json(json, length, [](auto const& doc) {
+        return read_json_value(doc);
+    });
+}
+
+// Read a JSON value into a flat_dynamic node. This mirrors read_json_value().
+static void
+read_json_flat_value(
+    flat_dynamic_builder& builder,
+    flat_dynamic_builder::node& n,
+    simdjson::dom::element const& json)
+{
+    switch (json.type())
+    {
+        case simdjson::dom::element_type::NULL_VALUE:
+        default: // to avoid warnings
+            builder.set_nil(n);
+            break;
+        case simdjson::dom::element_type::BOOL:
+            builder.set_bool(n, bool(json));
+            break;
+        case simdjson::dom::element_type::INT64:
+            builder.set_integer(
+                n, boost::numeric_cast<integer>(int64_t(json)));
+            break;
+        case simdjson::dom::element_type::UINT64:
+            builder.set_integer(
+                n, boost::numeric_cast<integer>(uint64_t(json)));
+            break;
+        case simdjson::dom::element_type::DOUBLE:
+            builder.set_double(n, double(json));
+            break;
+        case simdjson::dom::element_type::STRING: {
+            auto s = json.get_string().value();
+            if (auto t = parse_json_time_string(s))
+                builder.set_datetime(n, *t);
+            else
+                builder.set_string(n, s);
+            break;
+        }
+        case simdjson::dom::element_type::ARRAY: {
+            simdjson::dom::array source = json;
+            if (array_resembles_map(source))
+            {
+                auto* entries = builder.set_map(n, source.size());
+                for (auto const& i : source)
+                {
+                    read_json_flat_value(builder, entries[0], i["key"]);
+                    read_json_flat_value(builder, entries[1], i["value"]);
+                    entries += 2;
+                }
+                builder.finish_map(n);
+            }
+            else
+            {
+                auto* elements = builder.set_array(n, source.size());
+                for (auto const& i : source)
+                {
+                    read_json_flat_value(builder, *elements, i);
+                    ++elements;
+                }
+            }
+            break;
+        }
+        case simdjson::dom::element_type::OBJECT: {
+            simdjson::dom::object object = json;
+            if (is_json_blob(object))
+            {
+                builder.set_blob(n, read_json_blob(json));
+            }
+            else
+            {
+                auto* entries = builder.set_map(n, object.size());
+                for (auto const& i : object)
+                {
+                    builder.set_string(entries[0], i.key);
+                    read_json_flat_value(builder, entries[1], i.value);
+                    entries += 2;
+                }
+                builder.finish_map(n);
+            }
+            break;
+        }
+    }
+}
+
+flat_dynamic
+parse_json_flat_value(char const* json, size_t length)
+{
+    return with_parsed_json(json, length, [](auto const& doc) {
+        flat_dynamic_builder builder;
+        read_json_flat_value(builder, builder.root(), doc);
+        return builder.finish();
+    });
 }
 
 static bool
@@ -2,6 +2,7 @@
 #define CRADLE_TYPING_ENCODINGS_JSON_H
 
 #include <cradle/typing/core.h>
+#include <cradle/typing/core/flat_dynamic.h>
 
 // JSON - conversion to and from JSON strings
 
@@ -18,6 +19,16 @@ parse_json_value(string const& json)
     return parse_json_value(json.c_str(), json.length());
 }
 
+// Parse some JSON text into a flat_dynamic.
+flat_dynamic
+parse_json_flat_value(char const* json, size_t length);
+
+inline flat_dynamic
+parse_json_flat_value(string const& json)
+{
+    return parse_json_flat_value(json.c_str(), json.length());
+}
+
 // Write a value to a string in JSON format.
 string
 value_to_json(dynamic const& v);
@@ -0,0 +1,826 @@
+#include <cradle/typing/encodings/msgpack_codec.h>
+
+#include <cstring>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+
+#include <cradle/inner/utilities/text.h>
+
+namespace cradle {
+
+// The MessagePack format codes used below
+// (see https://github.com/msgpack/msgpack/blob/master/spec.md)
+namespace {
+
+uint8_t const nil_code = 0xc0;
+uint8_t const false_code = 0xc2;
+uint8_t const true_code = 0xc3;
+uint8_t const bin8_code = 0xc4;
+uint8_t const bin16_code = 0xc5;
+uint8_t const bin32_code = 0xc6;
+uint8_t const ext8_code = 0xc7;
+uint8_t const ext16_code = 0xc8;
+uint8_t const ext32_code = 0xc9;
+uint8_t const float32_code = 0xca;
+uint8_t const float64_code = 0xcb;
+uint8_t const uint8_code = 0xcc;
+uint8_t const uint16_code = 0xcd;
+uint8_t const uint32_code = 0xce;
+uint8_t const uint64_code = 0xcf;
+uint8_t const int8_code = 0xd0;
+uint8_t const int16_code = 0xd1;
+uint8_t const int32_code = 0xd2;
+uint8_t const int64_code = 0xd3;
+uint8_t const fixext1_code = 0xd4;
+uint8_t const fixext2_code = 0xd5;
+uint8_t const fixext4_code = 0xd6;
+uint8_t const fixext8_code = 0xd7;
+uint8_t const fixext16_code = 0xd8;
+uint8_t const str8_code = 0xd9;
+uint8_t const str16_code = 0xda;
+uint8_t const str32_code = 0xdb;
+uint8_t const array16_code = 0xdc;
+uint8_t const array32_code = 0xdd;
+uint8_t const map16_code = 0xde;
+uint8_t const map32_code = 0xdf;
+
+// Thinknode datetime ext type
+int8_t const datetime_ext_type = 1;
+
+[[noreturn]] void
+throw_msgpack_error(char const* message)
+{
+    CRADLE_THROW(
+        parsing_error() << expected_format_info("MessagePack")
+                        << parsing_error_info(message));
+}
+
+} // namespace
+
+// WRITER
+
+void
+msgpack_writer::pack_raw(void const* data, size_t size)
+{
+    buffer_.append(static_cast<char const*>(data), size);
+}
+
+template<class Int>
+void
+msgpack_writer::pack_big_endian(uint8_t tag, Int x)
+{
+    boost::endian::native_to_big_inplace(x);
+    buffer_.push_back(char(tag));
+    pack_raw(&x, sizeof(x));
+}
+
+void
+msgpack_writer::pack_nil()
+{
+    buffer_.push_back(char(nil_code));
+}
+
+void
+msgpack_writer::pack_bool(bool x)
+{
+    buffer_.push_back(char(x ? true_code : false_code));
+}
+
+// This picks the same representations as msgpack-c's pack_int64().
+void
+msgpack_writer::pack_integer(integer x)
+{
+    if (x < -(1 << 5))
+    {
+        if (x < -0x80'00'00'00LL)
+            pack_big_endian(int64_code, int64_t(x));
+        else if (x < -0x80'00)
+            pack_big_endian(int32_code, int32_t(x));
+        else if (x < -0x80)
+            pack_big_endian(int16_code, int16_t(x));
+        else
+            pack_big_endian(int8_code, int8_t(x));
+    }
+    else if (x < (1 << 7))
+    {
+        // positive or negative fixint
+        buffer_.push_back(char(int8_t(x)));
+    }
+    else if (x < 0x1'00)
+        pack_big_endian(uint8_code, uint8_t(x));
+    else if (x < 0x1'00'00)
+        pack_big_endian(uint16_code, uint16_t(x));
+    else if (x < 0x1'00'00'00'00LL)
+        pack_big_endian(uint32_code, uint32_t(x));
+    else
+        pack_big_endian(uint64_code, uint64_t(x));
+}
+
+void
+msgpack_writer::pack_double(double x)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    pack_big_endian(float64_code, bits);
+}
+
+void
+msgpack_writer::pack_string(std::string_view x)
+{
+    size_t size = x.size();
+    if (size < 32)
+        buffer_.push_back(char(0xa0 | size));
+    else if (size < 0x1'00)
+        pack_big_endian(str8_code, uint8_t(size));
+    else if (size < 0x1'00'00)
+        pack_big_endian(str16_code, uint16_t(size));
+    else
+        pack_big_endian(str32_code, boost::numeric_cast<uint32_t>(size));
+    pack_raw(x.data(), size);
+}
+
+void
+msgpack_writer::pack_blob(blob const& x)
+{
+    size_t size = x.size();
+    // Check to make sure that the blob size is within the MessagePack
+    // specification's limit.
+    if (size >= 0x1'00'00'00'00)
+    {
+        CRADLE_THROW(
+            msgpack_blob_size_limit_exceeded()
+            << msgpack_blob_size_info(size)
+            << msgpack_blob_size_limit_info(0x1'00'00'00'00));
+    }
+    if (size < 0x1'00)
+        pack_big_endian(bin8_code, uint8_t(size));
+    else if (size < 0x1'00'00)
+        pack_big_endian(bin16_code, uint16_t(size));
+    else
+        pack_big_endian(bin32_code, uint32_t(size));
+    pack_raw(x.data(), size);
+}
+
+void
+msgpack_writer::pack_datetime(ptime const& x)
+{
+    int64_t t = (x - ptime(date(1970, 1, 1))).total_milliseconds();
+    // We need to use the smallest possible int type to store the datetime.
+    auto pack_ext = [&](uint8_t code, auto value) {
+        buffer_.push_back(char(code));
+        buffer_.push_back(char(datetime_ext_type));
+        boost::endian::native_to_big_inplace(value);
+        pack_raw(&value, sizeof(value));
+    };
+    if (t >= -0x80 && t < 0x80)
+        pack_ext(fixext1_code, int8_t(t));
+    else if (t >= -0x80'00 && t < 0x80'00)
+        pack_ext(fixext2_code, int16_t(t));
+    else if (t >= -int64_t(0x80'00'00'00) && t < int64_t(0x80'00'00'00))
+        pack_ext(fixext4_code, int32_t(t));
+    else
+        pack_ext(fixext8_code, t);
+}
+
+void
+msgpack_writer::pack_array_header(size_t size)
+{
+    if (size < 16)
+        buffer_.push_back(char(0x90 | size));
+    else if (size < 0x1'00'00)
+        pack_big_endian(array16_code, uint16_t(size));
+    else
+        pack_big_endian(array32_code, boost::numeric_cast<uint32_t>(size));
+}
+
+void
+msgpack_writer::pack_map_header(size_t size)
+{
+    if (size < 16)
+        buffer_.push_back(char(0x80 | size));
+    else if (size < 0x1'00'00)
+        pack_big_endian(map16_code, uint16_t(size));
+    else
+        pack_big_endian(map32_code, boost::numeric_cast<uint32_t>(size));
+}
+
+void
+msgpack_writer::pack_dynamic(dynamic const& v)
+{
+    switch (v.type())
+    {
+        case value_type::NIL:
+            pack_nil();
+            break;
+        case value_type::BOOLEAN:
+            pack_bool(cast<bool>(v));
+            break;
+        case value_type::INTEGER:
+            pack_integer(cast<integer>(v));
+            break;
+        case value_type::FLOAT:
+            pack_double(cast<double>(v));
+            break;
+        case value_type::STRING:
+            pack_string(cast<string>(v));
+            break;
+        case value_type::BLOB:
+            pack_blob(cast<blob>(v));
+            break;
+        case value_type::DATETIME:
+            pack_datetime(cast<ptime>(v));
+            break;
+        case value_type::ARRAY: {
+            auto const& x = cast<dynamic_array>(v);
+            pack_array_header(x.size());
+            for (auto const& item : x)
+                pack_dynamic(item);
+            break;
+        }
+        case value_type::MAP: {
+            auto const& x = cast<dynamic_map>(v);
+            pack_map_header(x.size());
+            for (auto const& [key, value] : x)
+            {
+                pack_dynamic(key);
+                pack_dynamic(value);
+            }
+            break;
+        }
+    }
+}
+
+// READER
+
+msgpack_reader::msgpack_reader(
+    std::shared_ptr<data_owner> owner, uint8_t const* data, size_t size)
+    : owner_{std::move(owner)}, position_{data}, end_{data + size}
+{
+}
+
+uint8_t
+msgpack_reader::peek() const
+{
+    if (position_ == end_)
+    {
+        throw_msgpack_error("unexpected end of data");
+    }
+    return *position_;
+}
+
+uint8_t const*
+msgpack_reader::consume(size_t size)
+{
+    if (size_t(end_ - position_) < size)
+    {
+        throw_msgpack_error("unexpected end of data");
+    }
+    auto const* data = position_;
+    position_ += size;
+    return data;
+}
+
+template<class Int>
+Int
+msgpack_reader::read_big_endian()
+{
+    Int x;
+    std::memcpy(&x, consume(sizeof(x)), sizeof(x));
+    return boost::endian::big_to_native(x);
+}
+
+void
+msgpack_reader::throw_type_mismatch(value_type expected) const
+{
+    CRADLE_THROW(
+        type_mismatch() << expected_value_type_info(expected)
+                        << actual_value_type_info(next_type()));
+}
+
+value_type
+msgpack_reader::next_type() const
+{
+    uint8_t code = peek();
+    if (code < 0x80 || code >= 0xe0)
+        return value_type::INTEGER;
+    if (code < 0x90)
+        return value_type::MAP;
+    if (code < 0xa0)
+        return value_type::ARRAY;
+    if (code < 0xc0)
+        return value_type::STRING;
+    switch (code)
+    {
+        case nil_code:
+            return value_type::NIL;
+        case false_code:
+        case true_code:
+            return value_type::BOOLEAN;
+        case bin8_code:
+        case bin16_code:
+        case bin32_code:
+            return value_type::BLOB;
+        case float32_code:
+        case float64_code:
+            return value_type::FLOAT;
+        case uint8_code:
+        case uint16_code:
+        case uint32_code:
+        case uint64_code:
+        case int8_code:
+        case int16_code:
+        case int32_code:
+        case int64_code:
+            return value_type::INTEGER;
+        case ext8_code:
+        case ext16_code:
+        case ext32_code:
+        case fixext1_code:
+        case fixext2_code:
+        case fixext4_code:
+        case fixext8_code:
+        case fixext16_code:
+            return value_type::DATETIME;
+        case str8_code:
+        case str16_code:
+        case str32_code:
+            return value_type::STRING;
+        case array16_code:
+        case array32_code:
+            return value_type::ARRAY;
+        case map16_code:
+        case map32_code:
+            return value_type::MAP;
+        default:
+            throw_msgpack_error("invalid MessagePack format code");
+    }
+}
+
+void
+msgpack_reader::read_nil()
+{
+    if (peek() != nil_code)
+        throw_type_mismatch(value_type::NIL);
+    ++position_;
+}
+
+bool
+msgpack_reader::read_bool()
+{
+    switch (peek())
+    {
+        case false_code:
+            ++position_;
+            return false;
+        case true_code:
+            ++position_;
+            return true;
+        default:
+            throw_type_mismatch(value_type::BOOLEAN);
+    }
+}
+
+integer
+msgpack_reader::read_integer()
+{
+    uint8_t code = peek();
+    if (code < 0x80 || code >= 0xe0)
+    {
+        ++position_;
+        return int8_t(code);
+    }
+    switch (code)
+    {
+        case uint8_code:
+            ++position_;
+            return read_big_endian<uint8_t>();
+        case uint16_code:
+            ++position_;
+            return read_big_endian<uint16_t>();
+        case uint32_code:
+            ++position_;
+            return read_big_endian<uint32_t>();
+        case uint64_code:
+            ++position_;
+            return boost::numeric_cast<integer>(read_big_endian<uint64_t>());
+        case int8_code:
+            ++position_;
+            return read_big_endian<int8_t>();
+        case int16_code:
+            ++position_;
+            return read_big_endian<int16_t>();
+        case int32_code:
+            ++position_;
+            return read_big_endian<int32_t>();
+        case int64_code:
+            ++position_;
+            return read_big_endian<int64_t>();
+        default:
+            throw_type_mismatch(value_type::INTEGER);
+    }
+}
+
+double
+msgpack_reader::read_double()
+{
+    switch (peek())
+    {
+        case float32_code: {
+            ++position_;
+            auto bits = read_big_endian<uint32_t>();
+            float x;
+            std::memcpy(&x, &bits, sizeof(x));
+            return x;
+        }
+        case float64_code: {
+            ++position_;
+            auto bits = read_big_endian<uint64_t>();
+            double x;
+            std::memcpy(&x, &bits, sizeof(x));
+            return x;
+        }
+        default:
+            if (next_type() == value_type::INTEGER)
+                return boost::numeric_cast<double>(read_integer());
+            throw_type_mismatch(value_type::FLOAT);
+    }
+}
+
+std::string_view
+msgpack_reader::read_string()
+{
+    uint8_t code = peek();
+    size_t size;
+    if (code >= 0xa0 && code < 0xc0)
+    {
+        ++position_;
+        size = code & 0x1f;
+    }
+    else if (code == str8_code)
+    {
+        ++position_;
+        size = read_big_endian<uint8_t>();
+    }
+    else if (code == str16_code)
+    {
+        ++position_;
+        size = read_big_endian<uint16_t>();
+    }
+    else if (code == str32_code)
+    {
+        ++position_;
+        size = read_big_endian<uint32_t>();
+    }
+    else
+    {
+        throw_type_mismatch(value_type::STRING);
+    }
+    auto const* data = consume(size);
+    return std::string_view(reinterpret_cast<char const*>(data), size);
+}
+
+blob
+msgpack_reader::read_blob()
+{
+    size_t size;
+    switch (peek())
+    {
+        case bin8_code:
+            ++position_;
+            size = read_big_endian<uint8_t>();
+            break;
+        case bin16_code:
+            ++position_;
+            size = read_big_endian<uint16_t>();
+            break;
+        case bin32_code:
+            ++position_;
+            size = read_big_endian<uint32_t>();
+            break;
+        default:
+            throw_type_mismatch(value_type::BLOB);
+    }
+    return blob{owner_, as_bytes(consume(size)), size};
+}
+
+ptime
+msgpack_reader::read_datetime()
+{
+    size_t size;
+    switch (peek())
+    {
+        case fixext1_code:
+            size = 1;
+            break;
+        case fixext2_code:
+            size = 2;
+            break;
+        case fixext4_code:
+            size = 4;
+            break;
+        case fixext8_code:
+            size = 8;
+            break;
+        case ext8_code:
+        case ext16_code:
+        case ext32_code:
+        case fixext16_code:
+            throw_msgpack_error("unsupported MessagePack extension type");
+        default:
+            throw_type_mismatch(value_type::DATETIME);
+    }
+    ++position_;
+    if (int8_t(*consume(1)) != datetime_ext_type)
+    {
+        throw_msgpack_error("unsupported MessagePack extension type");
+    }
+    int64_t t = 0;
+    switch (size)
+    {
+        case 1:
+            t = read_big_endian<int8_t>();
+            break;
+        case 2:
+            t = read_big_endian<int16_t>();
+            break;
+        case 4:
+            t = read_big_endian<int32_t>();
+            break;
+        case 8:
+            t = read_big_endian<int64_t>();
+            break;
+    }
+    return ptime(date(1970, 1, 1)) + boost::posix_time::milliseconds(t);
+}
+
+size_t
+msgpack_reader::read_array_header()
+{
+    uint8_t code = peek();
+    if (code >= 0x90 && code < 0xa0)
+    {
+        ++position_;
+        return code & 0x0f;
+    }
+    switch (code)
+    {
+        case array16_code:
+            ++position_;
+            return read_big_endian<uint16_t>();
+        case array32_code:
+            ++position_;
+            return read_big_endian<uint32_t>();
+        default:
+            throw_type_mismatch(value_type::ARRAY);
+    }
+}
+
+size_t
+msgpack_reader::read_map_header()
+{
+    uint8_t code = peek();
+    if (code >= 0x80 && code < 0x90)
+    {
+        ++position_;
+        return code & 0x0f;
+    }
+    switch (code)
+    {
+        case map16_code:
+            ++position_;
+            return read_big_endian<uint16_t>();
+        case map32_code:
+            ++position_;
+            return read_big_endian<uint32_t>();
+        default:
+            throw_type_mismatch(value_type::MAP);
+    }
+}
+
+dynamic
+msgpack_reader::read_dynamic()
+{
+    switch (next_type())
+    {
+        case value_type::NIL:
+        default:
+            read_nil();
+            return dynamic(nil);
+        case value_type::BOOLEAN:
+            return dynamic(read_bool());
+        case value_type::INTEGER:
+            return dynamic(read_integer());
+        case value_type::FLOAT:
+            return dynamic(read_double());
+        case value_type::STRING:
+            return dynamic(string(read_string()));
+        case value_type::BLOB:
+            return dynamic(read_blob());
+        case value_type::DATETIME:
+            return dynamic(read_datetime());
+        case value_type::ARRAY: {
+            size_t size = read_array_header();
+            dynamic_array array;
+            array.reserve(size);
+            for (size_t i = 0; i != size; ++i)
+                array.push_back(read_dynamic());
+            return dynamic(std::move(array));
+        }
+        case value_type::MAP: {
+            size_t size = read_map_header();
+            dynamic_map map;
+            for (size_t i = 0; i != size; ++i)
+            {
+                auto key = read_dynamic();
+                map[std::move(key)] = read_dynamic();
+            }
+            return dynamic(std::move(map));
+        }
+    }
+}
+
+void
+msgpack_reader::skip()
+{
+    switch (next_type())
+    {
+        case value_type::NIL:
+            read_nil();
+            break;
+        case value_type::BOOLEAN:
+            read_bool();
+            break;
+        case value_type::INTEGER:
+            read_integer();
+            break;
+        case value_type::FLOAT:
+            read_double();
+            break;
+        case value_type::STRING:
+            read_string();
+            break;
+        case value_type::BLOB: {
+            // Avoid touching the owner's reference count.
+            uint8_t code = *position_++;
+            size_t size = code == bin8_code ? read_big_endian<uint8_t>()
+                          : code == bin16_code
+                              ? read_big_endian<uint16_t>()
+                              : read_big_endian<uint32_t>();
+            consume(size);
+            break;
+        }
+        case value_type::DATETIME:
+            read_datetime();
+            break;
+        case value_type::ARRAY: {
+            size_t size = read_array_header();
+            for (size_t i = 0; i != size; ++i)
+                skip();
+            break;
+        }
+        case value_type::MAP: {
+            size_t size = read_map_header();
+            for (size_t i = 0; i != 2 * size; ++i)
+                skip();
+            break;
+        }
+    }
+}
+
+// RECORDS
+
+msgpack_record::msgpack_record(msgpack_reader& reader) : reader_{reader}
+{
+    size_t size = reader.read_map_header();
+    fields_.reserve(size);
+    for (size_t i = 0; i != size; ++i)
+    {
+        auto name = reader.read_string();
+        auto const* begin = reader.position();
+        reader.skip();
+        fields_.push_back(field{name, begin, reader.position()});
+    }
+}
+
+bool
+msgpack_record::get_field(msgpack_reader* value, std::string_view name) const
+{
+    for (auto const& f : fields_)
+    {
+        if (f.name == name)
+        {
+            *value = reader_.slice(f.begin, f.end);
+            return true;
+        }
+    }
+    return false;
+}
+
+msgpack_reader
+msgpack_record::get_field(std::string_view name) const
+{
+    msgpack_reader value{nullptr, nullptr, 0};
+    if (!get_field(&value, name))
+    {
+        CRADLE_THROW(missing_field() << field_name_info(string(name)));
+    }
+    return value;
+}
+
+std::string_view
+read_msgpack_union_tag(msgpack_reader& r)
+{
+    if (r.read_map_header() != 1)
+    {
+        CRADLE_THROW(multifield_union());
+    }
+    return r.read_string();
+}
+
+// FLAT DYNAMIC VALUES
+
+static void
+read_flat_value(
+    msgpack_reader& r,
+    flat_dynamic_builder& builder,
+    flat_dynamic_builder::node& n)
+{
+    switch (r.next_type())
+    {
+        case value_type::NIL:
+            r.read_nil();
+            builder.set_nil(n);
+            break;
+        case value_type::BOOLEAN:
+            builder.set_bool(n, r.read_bool());
+            break;
+        case value_type::INTEGER:
+            builder.set_integer(n, r.read_integer());
+            break;
+        case value_type::FLOAT:
+            builder.set_double(n, r.read_double());
+            break;
+        case value_type::STRING:
+            builder.set_string(n, r.read_string());
+            break;
+        case value_type::BLOB:
+            builder.set_blob(n, r.read_blob());
+            break;
+        case value_type::DATETIME:
+            builder.set_datetime(n, r.read_datetime());
+            break;
+        case value_type::ARRAY: {
+            size_t size = r.read_array_header();
+            // Each element takes at least one byte, so this guards against
+            // allocating nodes for a bogus size.
+            if (size > r.remaining())
+                throw_msgpack_error("unexpected end of data");
+            auto* elements = builder.set_array(n, size);
+            for (size_t i = 0; i != size; ++i)
+                read_flat_value(r, builder, elements[i]);
+            break;
+        }
+        case value_type::MAP: {
+            size_t size = r.read_map_header();
+            if (2 * size > r.remaining())
+                throw_msgpack_error("unexpected end of data");
+            auto* entries = builder.set_map(n, size);
+            for (size_t i = 0; i != 2 * size; ++i)
+                read_flat_value(r, builder, entries[i]);
+            builder.finish_map(n);
+            break;
+        }
+    }
+}
+
+flat_dynamic
+parse_msgpack_flat_value(
+    std::shared_ptr<data_owner> owner, uint8_t const* data, size_t size)
+{
+    msgpack_reader r{std::move(owner), data, size};
+    flat_dynamic_builder builder;
+    read_flat_value(r, builder, builder.root());
+    return builder.finish();
+}
+
+// STRING AND DATE
+
+void
+from_msgpack(string* x, msgpack_reader& r)
+{
+    // Strings are also used to encode datetimes in JSON, so it's possible we
+    // might misinterpret a string as a datetime.
+    if (r.next_type() == value_type::DATETIME)
+        *x = to_value_string(r.read_datetime());
+    else
+        *x = string(r.read_string());
+}
+
+void
+from_msgpack(date* x, msgpack_reader& r)
+{
+    from_dynamic(x, dynamic(string(r.read_string())));
+}
+
+} // namespace cradle
@@ -0,0 +1,722 @@
+#ifndef CRADLE_TYPING_ENCODINGS_MSGPACK_CODEC_H
+#define CRADLE_TYPING_ENCODINGS_MSGPACK_CODEC_H
+
+// This file provides direct MessagePack encoding and decoding of CRADLE
+// values, i.e., without going through an intermediate dynamic tree.
+//
+// The interface mirrors to_dynamic() / from_dynamic():
+//
+//   void to_msgpack(msgpack_writer& w, T const& x);
+//   void from_msgpack(T* x, msgpack_reader& r);
+//
+// The preprocessor generates these for (non-template) structures and unions,
+// and this file supplies them for the built-in types. Anything else (e.g.,
+// enums) falls back to converting through dynamic.
+//
+// The encoding is the same as value_to_msgpack_string(to_dynamic(x)) would
+// produce, except that structure fields appear in declaration order rather
+// than sorted by name, so the two forms can be mixed freely.
+//
+// Unlike msgpack_internals.h, this doesn't include the msgpack-c headers.
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cradle/typing/core/dynamic.h>
+#include <cradle/typing/core/flat_dynamic.h>
+#include <cradle/typing/core/omissible.h>
+#include <cradle/typing/core/type_interfaces.h>
+#include <cradle/typing/encodings/msgpack.h>
+
+namespace cradle {
+
+// Encodes MessagePack into a string.
+class msgpack_writer
+{
+ public:
+    void
+    pack_nil();
+
+    void
+    pack_bool(bool x);
+
+    void
+    pack_integer(integer x);
+
+    void
+    pack_double(double x);
+
+    void
+    pack_string(std::string_view x);
+
+    void
+    pack_blob(blob const& x);
+
+    void
+    pack_datetime(ptime const& x);
+
+    void
+    pack_array_header(size_t size);
+
+    // The header must be followed by size key/value pairs.
+    void
+    pack_map_header(size_t size);
+
+    void
+    pack_dynamic(dynamic const& x);
+
+    std::string const&
+    buffer() const
+    {
+        return buffer_;
+    }
+
+    std::string
+    release()
+    {
+        return std::move(buffer_);
+    }
+
+ private:
+    void
+    pack_raw(void const* data, size_t size);
+
+    template<class Int>
+    void
+    pack_big_endian(uint8_t tag, Int x);
+
+    std::string buffer_;
+};
+
+// Decodes MessagePack from a buffer, one value at a time.
+//
+// Blobs reference the buffer rather than copying it; they share ownership
+// through owner.
+class msgpack_reader
+{
+ public:
+    msgpack_reader(
+        std::shared_ptr<data_owner> owner, uint8_t const* data, size_t size);
+
+    // Returns the type of the next value, as it would be represented in a
+    // dynamic.
+    value_type
+    next_type() const;
+
+    void
+    read_nil();
+
+    bool
+    read_bool();
+
+    integer
+    read_integer();
+
+    // Also accepts integers.
+    double
+    read_double();
+
+    // The returned view refers to the buffer.
+    std::string_view
+    read_string();
+
+    blob
+    read_blob();
+
+    ptime
+    read_datetime();
+
+    size_t
+    read_array_header();
+
+    size_t
+    read_map_header();
+
+    dynamic
+    read_dynamic();
+
+    // Skips over the next value (including any nested values).
+    void
+    skip();
+
+    bool
+    at_end() const
+    {
+        return position_ == end_;
+    }
+
+    uint8_t const*
+    position() const
+    {
+        return position_;
+    }
+
+    size_t
+    remaining() const
+    {
+        return size_t(end_ - position_);
+    }
+
+    // Returns a reader for the range [begin, end) of this reader's buffer.
+    msgpack_reader
+    slice(uint8_t const* begin, uint8_t const* end) const
+    {
+        return msgpack_reader(owner_, begin, size_t(end - begin));
+    }
+
+ private:
+    uint8_t
+    peek() const;
+
+    uint8_t const*
+    consume(size_t size);
+
+    template<class Int>
+    Int
+    read_big_endian();
+
+    [[noreturn]] void
+    throw_type_mismatch(value_type expected) const;
+
+    std::shared_ptr<data_owner> owner_;
+    uint8_t const* position_;
+    uint8_t const* end_;
+};
+
+// A MessagePack map whose keys are strings, indexed so that its values can be
+// looked up by name. This plays the role of the dynamic_map in
+// read_fields_from_record().
+class msgpack_record
+{
+ public:
+    // Consumes a map from reader, which must outlive the record.
+    explicit msgpack_record(msgpack_reader& reader);
+
+    // If the record has a field with the given name, sets *value to a reader
+    // for its value and returns true.
+    bool
+    get_field(msgpack_reader* value, std::string_view name) const;
+
+    // Same, but throws missing_field if there is no such field.
+    msgpack_reader
+    get_field(std::string_view name) const;
+
+    size_t
+    size() const
+    {
+        return fields_.size();
+    }
+
+ private:
+    struct field
+    {
+        std::string_view name;
+        uint8_t const* begin;
+        uint8_t const* end;
+    };
+
+    msgpack_reader const& reader_;
+    std::vector<field> fields_;
+};
+
+// Reads the header of a union value (a single-entry map) and returns the tag.
+// The reader is left at the member value.
+std::string_view
+read_msgpack_union_tag(msgpack_reader& r);
+
+// NIL
+
+inline void
+to_msgpack(msgpack_writer& w, nil_t)
+{
+    w.pack_nil();
+}
+
+inline void
+from_msgpack(nil_t*, msgpack_reader& r)
+{
+    r.skip();
+}
+
+// BOOL
+
+inline void
+to_msgpack(msgpack_writer& w, bool x)
+{
+    w.pack_bool(x);
+}
+
+inline void
+from_msgpack(bool* x, msgpack_reader& r)
+{
+    *x = r.read_bool();
+}
+
+// INTEGERS AND FLOATS
+
+// As with from_dynamic(), integers and floats are accepted for each other if
+// they convert properly.
+#define CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(T)                            \
+    inline void to_msgpack(msgpack_writer& w, T x)                            \
+    {                                                                         \
+        w.pack_integer(boost::numeric_cast<integer>(x));                      \
+    }                                                                         \
+    inline void from_msgpack(T* x, msgpack_reader& r)                         \
+    {                                                                         \
+        if (r.next_type() == value_type::FLOAT)                               \
+            *x = boost::numeric_cast<T>(r.read_double());                     \
+        else                                                                  \
+            *x = boost::numeric_cast<T>(r.read_integer());                    \
+    }
+
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(signed char)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(unsigned char)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(signed short)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(unsigned short)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(signed int)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(unsigned int)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(signed long)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(unsigned long)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(signed long long)
+CRADLE_DEFINE_MSGPACK_INTEGER_INTERFACE(unsigned long long)
+
+#define CRADLE_DEFINE_MSGPACK_FLOAT_INTERFACE(T)                              \
+    inline void to_msgpack(msgpack_writer& w, T x)                            \
+    {                                                                         \
+        w.pack_double(double(x));                                             \
+    }                                                                         \
+    inline void from_msgpack(T* x, msgpack_reader& r)                         \
+    {                                                                         \
+        *x = boost::numeric_cast<T>(r.read_double());                         \
+    }
+
+CRADLE_DEFINE_MSGPACK_FLOAT_INTERFACE(float)
+CRADLE_DEFINE_MSGPACK_FLOAT_INTERFACE(double)
+
+// STRING
+
+inline void
+to_msgpack(msgpack_writer& w, string const& x)
+{
+    w.pack_string(x);
+}
+
+void
+from_msgpack(string* x, msgpack_reader& r);
+
+// DATE
+
+inline void
+to_msgpack(msgpack_writer& w, date const& x)
+{
+    w.pack_string(to_string(x));
+}
+
+void
+from_msgpack(date* x, msgpack_reader& r);
+
+// PTIME
+
+inline void
+to_msgpack(msgpack_writer& w, ptime const& x)
+{
+    w.pack_datetime(x);
+}
+
+inline void
+from_msgpack(ptime* x, msgpack_reader& r)
+{
+    *x = r.read_datetime();
+}
+
+// BLOB
+
+inline void
+to_msgpack(msgpack_writer& w, blob const& x)
+{
+    w.pack_blob(x);
+}
+
+inline void
+from_msgpack(blob* x, msgpack_reader& r)
+{
+    *x = r.read_blob();
+}
+
+// DYNAMIC
+
+inline void
+to_msgpack(msgpack_writer& w, dynamic const& x)
+{
+    w.pack_dynamic(x);
+}
+
+inline void
+from_msgpack(dynamic* x, msgpack_reader& r)
+{
+    *x = r.read_dynamic();
+}
+
+// The templates are declared up front so that they can refer to each other
+// regardless of the order in which they're defined.
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, T const& x);
+template<class T>
+void
+from_msgpack(T* x, msgpack_reader& r);
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, std::vector<T> const& x);
+template<class T>
+void
+from_msgpack(std::vector<T>* x, msgpack_reader& r);
+
+template<class Key, class Value>
+void
+to_msgpack(msgpack_writer& w, std::map<Key, Value> const& x);
+template<class Key, class Value>
+void
+from_msgpack(std::map<Key, Value>* x, msgpack_reader& r);
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, optional<T> const& x);
+template<class T>
+void
+from_msgpack(optional<T>* x, msgpack_reader& r);
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, omissible<T> const& x);
+template<class T>
+void
+from_msgpack(omissible<T>* x, msgpack_reader& r);
+
+// GENERIC FALLBACK - via dynamic
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, T const& x)
+{
+    w.pack_dynamic(to_dynamic(x));
+}
+
+template<class T>
+void
+from_msgpack(T* x, msgpack_reader& r)
+{
+    from_dynamic(x, r.read_dynamic());
+}
+
+// STD::VECTOR
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, std::vector<T> const& x)
+{
+    w.pack_array_header(x.size());
+    for (auto const& item : x)
+    {
+        to_msgpack(w, item);
+    }
+}
+
+template<class T>
+void
+from_msgpack(std::vector<T>* x, msgpack_reader& r)
+{
+    // As in from_dynamic(), an empty map is accepted as an empty array.
+    if (r.next_type() == value_type::MAP)
+    {
+        msgpack_record record(r);
+        if (record.size() != 0)
+        {
+            CRADLE_THROW(
+                type_mismatch()
+                << expected_value_type_info(value_type::ARRAY)
+                << actual_value_type_info(value_type::MAP));
+        }
+        return;
+    }
+    size_t n_elements = r.read_array_header();
+    x->resize(n_elements);
+    for (size_t i = 0; i != n_elements; ++i)
+    {
+        try
+        {
+            from_msgpack(&(*x)[i], r);
+        }
+        catch (boost::exception& e)
+        {
+            add_dynamic_path_element(e, integer(i));
+            throw;
+        }
+    }
+}
+
+// STD::MAP
+
+template<class Key, class Value>
+void
+to_msgpack(msgpack_writer& w, std::map<Key, Value> const& x)
+{
+    w.pack_map_header(x.size());
+    for (auto const& [key, value] : x)
+    {
+        to_msgpack(w, key);
+        to_msgpack(w, value);
+    }
+}
+
+template<class Key, class Value>
+void
+from_msgpack(std::map<Key, Value>* x, msgpack_reader& r)
+{
+    // As in from_dynamic(), an empty array is accepted as an empty map.
+    if (r.next_type() == value_type::ARRAY)
+    {
+        if (r.read_array_header() != 0)
+        {
+            CRADLE_THROW(
+                type_mismatch() << expected_value_type_info(value_type::MAP)
+                                << actual_value_type_info(value_type::ARRAY));
+        }
+        return;
+    }
+    size_t n_entries = r.read_map_header();
+    for (size_t i = 0; i != n_entries; ++i)
+    {
+        Key key;
+        from_msgpack(&key, r);
+        try
+        {
+            from_msgpack(&(*x)[key], r);
+        }
+        catch (boost::exception& e)
+        {
+            add_dynamic_path_element(e, to_dynamic(key));
+            throw;
+        }
+    }
+}
+
+// OPTIONAL
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, optional<T> const& x)
+{
+    w.pack_map_header(1);
+    if (x)
+    {
+        w.pack_string("some");
+        to_msgpack(w, *x);
+    }
+    else
+    {
+        w.pack_string("none");
+        w.pack_nil();
+    }
+}
+
+template<class T>
+void
+from_msgpack(optional<T>* x, msgpack_reader& r)
+{
+    auto tag = read_msgpack_union_tag(r);
+    if (tag == "some")
+    {
+        try
+        {
+            T t;
+            from_msgpack(&t, r);
+            *x = std::move(t);
+        }
+        catch (boost::exception& e)
+        {
+            add_dynamic_path_element(e, "some");
+            throw;
+        }
+    }
+    else if (tag == "none")
+    {
+        r.skip();
+        *x = none;
+    }
+    else
+    {
+        CRADLE_THROW(
+            invalid_optional_type() << optional_type_tag_info(string(tag)));
+    }
+}
+
+// OMISSIBLE
+
+template<class T>
+void
+to_msgpack(msgpack_writer& w, omissible<T> const& x)
+{
+    w.pack_map_header(1);
+    if (x)
+    {
+        w.pack_string("some");
+        to_msgpack(w, *x);
+    }
+    else
+    {
+        w.pack_string("none");
+        w.pack_nil();
+    }
+}
+
+template<class T>
+void
+from_msgpack(omissible<T>* x, msgpack_reader& r)
+{
+    auto tag = read_msgpack_union_tag(r);
+    if (tag == "some")
+    {
+        T t;
+        from_msgpack(&t, r);
+        *x = std::move(t);
+    }
+    else if (tag == "none")
+    {
+        r.skip();
+        *x = none;
+    }
+    else
+    {
+        CRADLE_THROW(
+            invalid_omissible_type_tag()
+            << omissible_type_tag_info(string(tag)));
+    }
+}
+
+// STRUCTURE FIELDS
+//
+// These are the counterparts of write_field_to_record() and
+// read_field_from_record(), which exist primarily so that omissible fields
+// can be left out.
+
+template<class Field>
+size_t
+count_msgpack_field(Field const&)
+{
+    return 1;
+}
+
+template<class Field>
+void
+write_field_to_msgpack(
+    msgpack_writer& w, std::string_view field_name, Field const& field_value)
+{
+    w.pack_string(field_name);
+    to_msgpack(w, field_value);
+}
+
+template<class Field>
+void
+read_field_from_msgpack(
+    Field* field_value,
+    msgpack_record const& record,
+    std::string_view field_name)
+{
+    auto r = record.get_field(field_name);
+    try
+    {
+        from_msgpack(field_value, r);
+    }
+    catch (boost::exception& e)
+    {
+        add_dynamic_path_element(e, string(field_name));
+        throw;
+    }
+}
+
+template<class T>
+size_t
+count_msgpack_field(omissible<T> const& field_value)
+{
+    return field_value ? 1 : 0;
+}
+
+template<class T>
+void
+write_field_to_msgpack(
+    msgpack_writer& w,
+    std::string_view field_name,
+    omissible<T> const& field_value)
+{
+    // Only write the field if it has a value.
+    if (field_value)
+        write_field_to_msgpack(w, field_name, *field_value);
+}
+
+template<class T>
+void
+read_field_from_msgpack(
+    omissible<T>* field_value,
+    msgpack_record const& record,
+    std::string_view field_name)
+{
+    // If the field doesn't appear in the record, just set it to none.
+    msgpack_reader r{nullptr, nullptr, 0};
+    if (record.get_field(&r, field_name))
+    {
+        try
+        {
+            T value;
+            from_msgpack(&value, r);
+            *field_value = std::move(value);
+        }
+        catch (boost::exception& e)
+        {
+            add_dynamic_path_element(e, string(field_name));
+            throw;
+        }
+    }
+    else
+    {
+        *field_value = none;
+    }
+}
+
+// CONVENIENCE FUNCTIONS
+
+// Parses the MessagePack in [data, data + size) into a flat_dynamic. Blobs
+// within the value share ownership of the data through owner.
+flat_dynamic
+parse_msgpack_flat_value(
+    std::shared_ptr<data_owner> owner, uint8_t const* data, size_t size);
+
+template<class T>
+std::string
+value_to_msgpack_string_direct(T const& x)
+{
+    msgpack_writer w;
+    to_msgpack(w, x);
+    return w.release();
+}
+
+// Decodes a T from the MessagePack in [data, data + size). Blobs within the
+// value share ownership of the data through owner.
+template<class T>
+T
+parse_msgpack_value_direct(
+    std::shared_ptr<data_owner> owner, uint8_t const* data, size_t size)
+{
+    msgpack_reader r{std::move(owner), data, size};
+    T x;
+    from_msgpack(&x, r);
+    return x;
+}
+
+} // namespace cradle
+
+#endif
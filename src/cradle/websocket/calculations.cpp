@@ -13,8 +13,19 @@
 #include <boost/crc.hpp>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include <cppcoro/shared_task.hpp>
 #include <cppcoro/when_all.hpp>
 
+#include <cradle/inner/core/hash.h>
 #include <cradle/inner/core/sha256_hash_id.h>
 #include <cradle/inner/fs/file_io.h>
 #include <cradle/inner/utilities/errors.h>
@@ -81,24 +92,388 @@ perform_lambda_calc(
         });
 }
 
-cppcoro::task<std::string>
+namespace {
+
+// A subcalculation, hash-consed within a calc_resolution: structurally equal
+// subtrees share one node, so nodes can be identified by their addresses.
+// Nodes are built bottom-up, so each one hashes only its own fields and the
+// hashes of its children.
+struct calc_node
+{
+    // The request, with its subcalculations moved out into children
+    calculation_request shell;
+    // The subcalculations, in the order defined by take_subcalcs()
+    std::vector<calc_node const*> children;
+    std::size_t hash{0};
+};
+
+bool
+operator==(calc_node const& a, calc_node const& b)
+{
+    return a.hash == b.hash && a.children == b.children && a.shell == b.shell;
+}
+
+struct calc_node_hash
+{
+    std::size_t
+    operator()(calc_node const& node) const
+    {
+        return node.hash;
+    }
+};
+
+// Moves the subcalculations out of request, leaving default-constructed
+// requests in their place. They are returned in a fixed order: arguments,
+// items and properties in their own order; for a LET, the variables followed
+// by the body.
+std::vector<calculation_request>
+take_subcalcs(calculation_request& request)
+{
+    std::vector<calculation_request> subcalcs;
+    auto take = [&](calculation_request& subcalc) {
+        subcalcs.push_back(std::exchange(subcalc, calculation_request()));
+    };
+    switch (get_tag(request))
+    {
+        case calculation_request_tag::LAMBDA:
+            return std::exchange(as_lambda(request).args, {});
+        case calculation_request_tag::FUNCTION:
+            return std::exchange(as_function(request).args, {});
+        case calculation_request_tag::ARRAY:
+            return std::exchange(as_array(request).items, {});
+        case calculation_request_tag::ITEM:
+            take(as_item(request).array);
+            take(as_item(request).index);
+            break;
+        case calculation_request_tag::OBJECT:
+            for (auto& property : as_object(request).properties)
+            {
+                take(property.second);
+            }
+            break;
+        case calculation_request_tag::PROPERTY:
+            take(as_property(request).object);
+            take(as_property(request).field);
+            break;
+        case calculation_request_tag::LET:
+            for (auto& variable : as_let(request).variables)
+            {
+                take(variable.second);
+            }
+            take(as_let(request).in);
+            break;
+        case calculation_request_tag::META:
+            take(as_meta(request).generator);
+            break;
+        case calculation_request_tag::CAST:
+            take(as_cast(request).object);
+            break;
+        default:
+            break;
+    }
+    return subcalcs;
+}
+
+// A persistent environment of LET variables. Extending an environment
+// creates a node referring to its parent, so the variables of enclosing LETs
+// aren't copied.
+struct calc_environment
+{
+    // Unique within a calc_resolution; 0 denotes the empty environment
+    std::uint64_t id;
+    std::map<string, calc_node const*> variables;
+    std::shared_ptr<calc_environment const> parent;
+};
+
+using calc_environment_ptr = std::shared_ptr<calc_environment const>;
+
+// Identifies a subcalculation within a resolution: a node evaluated in an
+// environment.
+struct calc_memo_key
+{
+    std::uint64_t environment_id;
+    calc_node const* node;
+};
+
+bool
+operator==(calc_memo_key const& a, calc_memo_key const& b)
+{
+    return a.environment_id == b.environment_id && a.node == b.node;
+}
+
+struct calc_memo_key_hash
+{
+    std::size_t
+    operator()(calc_memo_key const& key) const
+    {
+        return combine_hashes(key.environment_id, key.node->hash);
+    }
+};
+
+// The memoized evaluation of a subcalculation
+struct calc_memo_entry
+{
+    // The entries whose results this entry's evaluation is waiting for. The
+    // graph formed by these edges must stay acyclic: a cycle would mean that a
+    // calculation (through its LET variables) depends on its own result.
+    std::vector<calc_memo_entry const*> awaiting;
+};
+
+template<class Value>
+struct typed_calc_memo_entry : calc_memo_entry
+{
+    // Lazy; it starts when it's first awaited
+    cppcoro::shared_task<Value> task;
+};
+
+template<class Value>
+using calc_memo = std::unordered_map<
+    calc_memo_key,
+    typed_calc_memo_entry<Value>,
+    calc_memo_key_hash>;
+
+// The state shared by all subcalculations of one top-level
+// resolve_calc_to_value() or resolve_calc_to_iss_object() call.
+// It turns the calculation tree into a DAG: each distinct subcalculation,
+// including each LET variable, is evaluated once per environment, and its
+// value is shared by all references to it from that environment. This also
+// covers identical subtrees generated by META calculations.
+struct calc_resolution
+{
+    std::atomic<std::uint64_t> next_environment_id{1};
+    // Protects the following members (and calc_memo_entry::awaiting)
+    std::mutex mutex;
+    std::unordered_set<calc_node, calc_node_hash> nodes;
+    // The subcalculations that have been evaluated, or are being evaluated
+    calc_memo<dynamic> values;
+    calc_memo<std::string> iss_objects;
+};
+
+// Turns request into a node, reusing the existing node for each subtree that
+// has been seen before in this resolution.
+calc_node const*
+intern_calc(calc_resolution& resolution, calculation_request request)
+{
+    calc_node node;
+    for (auto& subcalc : take_subcalcs(request))
+    {
+        node.children.push_back(intern_calc(resolution, std::move(subcalc)));
+    }
+    node.hash = invoke_hash(request);
+    for (auto const* child : node.children)
+    {
+        node.hash = combine_hashes(node.hash, child->hash);
+    }
+    node.shell = std::move(request);
+    std::scoped_lock<std::mutex> lock(resolution.mutex);
+    return &*resolution.nodes.insert(std::move(node)).first;
+}
+
+// Returns true if from is, or is (indirectly) waiting for, to.
+// resolution.mutex must be locked.
+bool
+is_waiting_for(calc_memo_entry const& from, calc_memo_entry const& to)
+{
+    std::vector<calc_memo_entry const*> pending{&from};
+    std::unordered_set<calc_memo_entry const*> visited;
+    while (!pending.empty())
+    {
+        auto const* entry = pending.back();
+        pending.pop_back();
+        if (entry == &to)
+        {
+            return true;
+        }
+        if (visited.insert(entry).second)
+        {
+            pending.insert(
+                pending.end(), entry->awaiting.begin(), entry->awaiting.end());
+        }
+    }
+    return false;
+}
+
+// Removes the edge from waiter to entry when the wait is over.
+struct calc_wait_guard
+{
+    calc_resolution& resolution;
+    calc_memo_entry* waiter;
+    calc_memo_entry const* entry;
+
+    ~calc_wait_guard()
+    {
+        if (waiter)
+        {
+            std::scoped_lock<std::mutex> lock(resolution.mutex);
+            auto& awaiting{waiter->awaiting};
+            awaiting.erase(std::find(awaiting.begin(), awaiting.end(), entry));
+        }
+    }
+};
+
+// Resolves the subcalculation identified by key, on behalf of waiter (the
+// entry of the calculation that needs it, or nullptr at the top level). If it
+// isn't in memo yet, evaluate(entry) creates its task.
+template<class Value, class Evaluate>
+cppcoro::task<Value>
+resolve_memoized(
+    calc_resolution& resolution,
+    calc_memo<Value>& memo,
+    calc_memo_key key,
+    calc_memo_entry* waiter,
+    Evaluate evaluate)
+{
+    typed_calc_memo_entry<Value>* entry;
+    {
+        std::scoped_lock<std::mutex> lock(resolution.mutex);
+        auto [it, inserted] = memo.try_emplace(key);
+        entry = &it->second;
+        if (inserted)
+        {
+            entry->task = evaluate(*entry);
+        }
+        if (waiter)
+        {
+            if (is_waiting_for(*entry, *waiter))
+            {
+                throw std::invalid_argument(
+                    "calculation depends on its own result "
+                    "(cyclic LET variables)");
+            }
+            waiter->awaiting.push_back(entry);
+        }
+    }
+    calc_wait_guard guard{resolution, waiter, entry};
+    co_return co_await entry->task;
+}
+
+// Creates the environment for the body of a LET node.
+calc_environment_ptr
+extend_environment(
+    calc_resolution& resolution,
+    calc_environment_ptr parent,
+    calc_node const& let)
+{
+    std::map<string, calc_node const*> variables;
+    std::size_t i = 0;
+    for (auto const& variable : as_let(let.shell).variables)
+    {
+        variables[variable.first] = let.children[i++];
+    }
+    return std::make_shared<calc_environment const>(calc_environment{
+        resolution.next_environment_id++,
+        std::move(variables),
+        std::move(parent)});
+}
+
+// Returns the definition of the variable called name. As before, the
+// definition is evaluated in the environment of the reference, not in that of
+// the defining LET; so references from within the same environment share one
+// value.
+calc_node const&
+look_up_variable(calc_environment_ptr const& environment, string const& name)
+{
+    for (auto env = environment; env; env = env->parent)
+    {
+        auto it = env->variables.find(name);
+        if (it != env->variables.end())
+        {
+            return *it->second;
+        }
+    }
+    throw std::out_of_range("unbound variable " + name);
+}
+
+} // namespace
+
+static cppcoro::task<std::string>
 resolve_calc_to_iss_object(
     thinknode_request_context ctx,
     string context_id,
-    std::map<string, calculation_request> const& environment,
-    calculation_request request);
+    calc_resolution& resolution,
+    calc_environment_ptr environment,
+    calc_node const& node,
+    calc_memo_entry* waiter);
 
-cppcoro::task<dynamic>
+// Runs the (lazy) tasks and returns their results, in order.
+// Up to the configured fan-out of tasks run concurrently, each started on the
+// async thread pool with the context's schedule hint; the others wait for one
+// of them to finish. This bounds the number of coroutine frames in flight when
+// a calculation is very wide.
+static cppcoro::task<std::vector<dynamic>>
+resolve_concurrently(
+    thinknode_request_context const& ctx,
+    std::vector<cppcoro::task<dynamic>> tasks)
+{
+    std::vector<dynamic> values(tasks.size());
+    std::size_t fan_out{std::min(
+        ctx.service.config().get_number_or_default(
+            calculation_config_keys::FAN_OUT, 16),
+        tasks.size())};
+    if (fan_out <= 1)
+    {
+        for (std::size_t i = 0; i < tasks.size(); ++i)
+        {
+            values[i] = co_await tasks[i];
+        }
+        co_return values;
+    }
+
+    // Each worker claims the next task that hasn't been started yet. After a
+    // failure, the workers stop claiming tasks, so that when_all() reports
+    // the failure as soon as the running tasks have finished.
+    auto& pool{ctx.service.get_async_thread_pool()};
+    std::atomic<std::size_t> next_task{0};
+    auto worker = [&]() -> cppcoro::task<void> {
+        co_await pool.schedule(ctx.get_schedule_hint());
+        std::size_t i;
+        while ((i = next_task++) < tasks.size())
+        {
+            try
+            {
+                values[i] = co_await tasks[i];
+            }
+            catch (...)
+            {
+                next_task = tasks.size();
+                throw;
+            }
+        }
+    };
+    std::vector<cppcoro::task<void>> workers;
+    workers.reserve(fan_out);
+    for (std::size_t i = 0; i < fan_out; ++i)
+    {
+        workers.push_back(worker());
+    }
+    co_await cppcoro::when_all(std::move(workers));
+    co_return values;
+}
+
+static cppcoro::task<dynamic>
 resolve_calc_to_value(
     thinknode_request_context ctx,
     string context_id,
-    std::map<string, calculation_request> const& environment,
-    calculation_request request)
+    calc_resolution& resolution,
+    calc_environment_ptr environment,
+    calc_node const& node,
+    calc_memo_entry* waiter);
+
+// Evaluates node, in environment, without consulting the resolution's
+// memoized values (for node itself). self is the node's memo entry.
+static cppcoro::shared_task<dynamic>
+evaluate_calc_to_value(
+    thinknode_request_context ctx,
+    string context_id,
+    calc_resolution& resolution,
+    calc_environment_ptr environment,
+    calc_node const& node,
+    calc_memo_entry& self)
 {
     auto recursive_call
-        = [&](calculation_request request) -> cppcoro::task<dynamic> {
+        = [&](calc_node const* child) -> cppcoro::task<dynamic> {
         return resolve_calc_to_value(
-            ctx, context_id, environment, std::move(request));
+            ctx, context_id, resolution, environment, *child, &self);
     };
     auto coercive_call = [&](thinknode_type_info const& schema,
                              dynamic value) -> cppcoro::task<dynamic> {
@@ -106,21 +481,19 @@ resolve_calc_to_value(
             ctx, context_id, schema, std::move(value));
     };
 
+    auto const& request = node.shell;
     switch (get_tag(request))
     {
         case calculation_request_tag::REFERENCE:
             co_return co_await get_iss_object(
                 ctx, context_id, as_reference(request));
         case calculation_request_tag::VALUE:
-            co_return as_value(std::move(request));
+            co_return as_value(request);
         case calculation_request_tag::LAMBDA: {
-            std::vector<dynamic> arg_values;
-            auto lambda = as_lambda(std::move(request));
-            // TODO: Do this in parallel.
-            for (auto& arg : lambda.args)
-                arg_values.push_back(co_await recursive_call(std::move(arg)));
+            auto arg_values = co_await resolve_concurrently(
+                ctx, map(recursive_call, node.children));
             co_return co_await perform_lambda_calc(
-                ctx, lambda.function, std::move(arg_values));
+                ctx, as_lambda(request).function, std::move(arg_values));
         }
         case calculation_request_tag::FUNCTION:
             // If the function is specifically requested to be executed
@@ -134,19 +507,19 @@ resolve_calc_to_value(
                     ctx,
                     context_id,
                     co_await resolve_calc_to_iss_object(
-                        ctx, context_id, environment, std::move(request)));
+                        ctx,
+                        context_id,
+                        resolution,
+                        environment,
+                        node,
+                        &self));
             }
             // Otherwise, we evaluate the function locally.
             else
             {
-                std::vector<dynamic> arg_values;
-                auto function = as_function(std::move(request));
-                // TODO: Do this in parallel.
-                for (auto& arg : function.args)
-                {
-                    arg_values.push_back(
-                        co_await recursive_call(std::move(arg)));
-                }
+                auto const& function = as_function(request);
+                auto arg_values = co_await resolve_concurrently(
+                    ctx, map(recursive_call, node.children));
                 co_return co_await perform_local_function_calc(
                     ctx,
                     context_id,
@@ -156,72 +529,75 @@ resolve_calc_to_value(
                     std::move(arg_values));
             }
         case calculation_request_tag::ARRAY: {
-            std::vector<dynamic> values;
-            auto array = as_array(std::move(request));
-            for (auto& item : array.items)
-            {
-                spdlog::get("cradle")->info(
-                    "array.item_schema: {}",
-                    boost::lexical_cast<std::string>(array.item_schema));
-                values.push_back(co_await coercive_call(
-                    array.item_schema,
-                    co_await recursive_call(std::move(item))));
-            }
-            co_return dynamic(values);
+            auto const& array = as_array(request);
+            spdlog::get("cradle")->info(
+                "array.item_schema: {}",
+                boost::lexical_cast<std::string>(array.item_schema));
+            auto coerced_item_call
+                = [&](calc_node const* item) -> cppcoro::task<dynamic> {
+                co_return co_await coercive_call(
+                    array.item_schema, co_await recursive_call(item));
+            };
+            co_return dynamic(co_await resolve_concurrently(
+                ctx, map(coerced_item_call, node.children)));
         }
         case calculation_request_tag::ITEM: {
-            auto item = as_item(std::move(request));
+            auto values = co_await resolve_concurrently(
+                ctx, map(recursive_call, node.children));
             co_return co_await coercive_call(
-                item.schema,
-                cast<dynamic_array>(
-                    co_await recursive_call(std::move(item.array)))
-                    .at(boost::numeric_cast<size_t>(cast<integer>(
-                        co_await recursive_call(std::move(item.index))))));
+                as_item(request).schema,
+                cast<dynamic_array>(values[0]).at(
+                    boost::numeric_cast<size_t>(cast<integer>(values[1]))));
         }
         case calculation_request_tag::OBJECT: {
-            auto object = as_object(std::move(request));
+            auto const& object = as_object(request);
+            auto values = co_await resolve_concurrently(
+                ctx, map(recursive_call, node.children));
             dynamic_map result;
-            for (auto& property : object.properties)
+            std::size_t i = 0;
+            for (auto const& property : object.properties)
             {
-                result[dynamic(property.first)]
-                    = co_await recursive_call(property.second);
+                result[dynamic(property.first)] = std::move(values[i++]);
             }
             co_return co_await coercive_call(
                 object.schema, dynamic(std::move(result)));
         }
         case calculation_request_tag::PROPERTY: {
-            auto property = as_property(std::move(request));
+            auto values = co_await resolve_concurrently(
+                ctx, map(recursive_call, node.children));
             co_return co_await coercive_call(
-                property.schema,
-                cast<dynamic_map>(
-                    co_await recursive_call(std::move(property.object)))
-                    .at(dynamic(cast<string>(
-                        co_await recursive_call(std::move(property.field))))));
+                as_property(request).schema,
+                cast<dynamic_map>(values[0]).at(
+                    dynamic(cast<string>(values[1]))));
         }
-        case calculation_request_tag::LET: {
-            auto let = as_let(std::move(request));
-            std::map<string, calculation_request> extended_environment
-                = environment;
-            for (auto& v : let.variables)
-                extended_environment[v.first] = std::move(v.second);
+        case calculation_request_tag::LET:
             co_return co_await resolve_calc_to_value(
-                ctx, context_id, extended_environment, std::move(let.in));
-        }
+                ctx,
+                context_id,
+                resolution,
+                extend_environment(resolution, environment, node),
+                *node.children.back(),
+                &self);
         case calculation_request_tag::VARIABLE:
-            co_return co_await recursive_call(
-                environment.at(as_variable(request)));
+            co_return co_await resolve_calc_to_value(
+                ctx,
+                context_id,
+                resolution,
+                environment,
+                look_up_variable(environment, as_variable(request)),
+                &self);
         case calculation_request_tag::META: {
-            auto meta = as_meta(std::move(request));
             auto generated_request = from_dynamic<calculation_request>(
-                co_await recursive_call(std::move(meta.generator)));
+                co_await recursive_call(node.children[0]));
             co_return co_await coercive_call(
-                meta.schema, co_await recursive_call(generated_request));
+                as_meta(request).schema,
+                co_await recursive_call(
+                    intern_calc(resolution, std::move(generated_request))));
         }
-        case calculation_request_tag::CAST: {
-            auto cast = as_cast(std::move(request));
+        case calculation_request_tag::CAST:
             co_return co_await coercive_call(
-                cast.schema, co_await recursive_call(std::move(cast.object)));
-        }
+                as_cast(request).schema,
+                co_await recursive_call(node.children[0]));
         default:
             CRADLE_THROW(
                 invalid_enum_value()
@@ -230,12 +606,45 @@ resolve_calc_to_value(
     }
 }
 
-cppcoro::task<std::string>
-resolve_calc_to_iss_object(
+// Resolves node to a value, in environment, on behalf of waiter. Each
+// distinct (node, environment) combination is evaluated only once per
+// resolution.
+static cppcoro::task<dynamic>
+resolve_calc_to_value(
     thinknode_request_context ctx,
     string context_id,
-    std::map<string, calculation_request> const& environment,
-    calculation_request request)
+    calc_resolution& resolution,
+    calc_environment_ptr environment,
+    calc_node const& node,
+    calc_memo_entry* waiter)
+{
+    // Values are cheaper to copy than to memoize.
+    if (is_value(node.shell))
+    {
+        co_return as_value(node.shell);
+    }
+    co_return co_await resolve_memoized(
+        resolution,
+        resolution.values,
+        calc_memo_key{environment ? environment->id : 0, &node},
+        waiter,
+        [&](calc_memo_entry& entry) {
+            return evaluate_calc_to_value(
+                ctx, context_id, resolution, environment, node, entry);
+        });
+}
+
+// Evaluates node to an ISS object, in environment, without consulting the
+// resolution's memoized objects (for node itself). self is the node's memo
+// entry.
+static cppcoro::shared_task<std::string>
+evaluate_calc_to_iss_object(
+    thinknode_request_context ctx,
+    string context_id,
+    calc_resolution& resolution,
+    calc_environment_ptr environment,
+    calc_node const& node,
+    calc_memo_entry& self)
 {
     // For most calculation types, the resolution will be to convert the
     // calculation to a Thinknode calculation in "shallow form" (where all
@@ -248,11 +657,11 @@ resolve_calc_to_iss_object(
     // calculations. Note that this is not quite the same interface as
     // resolve_calc_to_iss_object() itself provides, but it's more convenient
     // for most of the cases here that require recursion.
-    auto recurse = [&](calculation_request calc)
-        -> cppcoro::task<thinknode_calc_request> {
+    auto recurse
+        = [&](calc_node const* calc) -> cppcoro::task<thinknode_calc_request> {
         co_return make_thinknode_calc_request_with_reference(
             co_await resolve_calc_to_iss_object(
-                ctx, context_id, environment, std::move(calc)));
+                ctx, context_id, resolution, environment, *calc, &self));
     };
 
     // post_calc() aids in posting the shallow form of the calculation.
@@ -272,15 +681,16 @@ resolve_calc_to_iss_object(
             std::move(value));
     };
 
+    auto const& request = node.shell;
     switch (get_tag(request))
     {
         case calculation_request_tag::REFERENCE:
-            co_return as_reference(std::move(request));
+            co_return as_reference(request);
         case calculation_request_tag::VALUE:
-            co_return co_await post_value(as_value(std::move(request)));
+            co_return co_await post_value(as_value(request));
         case calculation_request_tag::LAMBDA: {
             co_return co_await post_value(co_await resolve_calc_to_value(
-                ctx, context_id, environment, std::move(request)));
+                ctx, context_id, resolution, environment, node, &self));
         }
         case calculation_request_tag::FUNCTION: {
             // If the function is specifically requested to be executed
@@ -291,13 +701,12 @@ resolve_calc_to_iss_object(
                        == execution_host_selection::LOCAL)
             {
                 co_return co_await post_value(co_await resolve_calc_to_value(
-                    ctx, context_id, environment, std::move(request)));
+                    ctx, context_id, resolution, environment, node, &self));
             }
             // Otherwise, we request Thinknode to evaluate it.
             else
             {
-                auto subtasks
-                    = map(recurse, std::move(as_function(request).args));
+                auto subtasks = map(recurse, node.children);
                 co_return co_await post_calc(
                     make_thinknode_calc_request_with_function(
                         make_thinknode_function_application(
@@ -309,7 +718,7 @@ resolve_calc_to_iss_object(
             }
         }
         case calculation_request_tag::ARRAY: {
-            auto subtasks = map(recurse, std::move(as_array(request).items));
+            auto subtasks = map(recurse, node.children);
             co_return co_await post_calc(
                 make_thinknode_calc_request_with_array(
                     make_thinknode_array_calc(
@@ -319,15 +728,16 @@ resolve_calc_to_iss_object(
         case calculation_request_tag::ITEM:
             co_return co_await post_calc(
                 make_thinknode_calc_request_with_item(make_thinknode_item_calc(
-                    co_await recurse(as_item(request).array),
-                    co_await recurse(as_item(request).index),
+                    co_await recurse(node.children[0]),
+                    co_await recurse(node.children[1]),
                     as_item(request).schema)));
         case calculation_request_tag::OBJECT: {
             std::map<string, thinknode_calc_request> properties;
-            for (auto& property : as_object(request).properties)
+            std::size_t i = 0;
+            for (auto const& property : as_object(request).properties)
             {
                 properties[property.first]
-                    = co_await recurse(std::move(property.second));
+                    = co_await recurse(node.children[i++]);
             }
             co_return co_await post_calc(
                 make_thinknode_calc_request_with_object(
@@ -338,34 +748,35 @@ resolve_calc_to_iss_object(
             co_return co_await post_calc(
                 make_thinknode_calc_request_with_property(
                     make_thinknode_property_calc(
-                        co_await recurse(as_property(request).object),
-                        co_await recurse(as_property(request).field),
+                        co_await recurse(node.children[0]),
+                        co_await recurse(node.children[1]),
                         as_property(request).schema)));
-        case calculation_request_tag::LET: {
-            auto let = as_let(std::move(request));
-            std::map<string, calculation_request> extended_environment
-                = environment;
-            for (auto& v : let.variables)
-                extended_environment[v.first] = std::move(v.second);
+        case calculation_request_tag::LET:
             co_return co_await resolve_calc_to_iss_object(
-                ctx, context_id, extended_environment, std::move(let.in));
-        }
+                ctx,
+                context_id,
+                resolution,
+                extend_environment(resolution, environment, node),
+                *node.children.back(),
+                &self);
         case calculation_request_tag::VARIABLE:
             co_return co_await resolve_calc_to_iss_object(
                 ctx,
                 context_id,
+                resolution,
                 environment,
-                environment.at(as_variable(request)));
+                look_up_variable(environment, as_variable(request)),
+                &self);
         case calculation_request_tag::META:
             co_return co_await post_calc(
                 make_thinknode_calc_request_with_meta(make_thinknode_meta_calc(
-                    co_await recurse(as_meta(request).generator),
+                    co_await recurse(node.children[0]),
                     as_meta(request).schema)));
         case calculation_request_tag::CAST:
             co_return co_await post_calc(make_thinknode_calc_request_with_cast(
                 make_thinknode_cast_request(
                     as_cast(request).schema,
-                    co_await recurse(as_cast(request).object))));
+                    co_await recurse(node.children[0]))));
         default:
             CRADLE_THROW(
                 invalid_enum_value()
@@ -374,14 +785,39 @@ resolve_calc_to_iss_object(
     }
 }
 
+// Resolves node to an ISS object, in environment, on behalf of waiter. Each
+// distinct (node, environment) combination is posted only once per
+// resolution.
+static cppcoro::task<std::string>
+resolve_calc_to_iss_object(
+    thinknode_request_context ctx,
+    string context_id,
+    calc_resolution& resolution,
+    calc_environment_ptr environment,
+    calc_node const& node,
+    calc_memo_entry* waiter)
+{
+    co_return co_await resolve_memoized(
+        resolution,
+        resolution.iss_objects,
+        calc_memo_key{environment ? environment->id : 0, &node},
+        waiter,
+        [&](calc_memo_entry& entry) {
+            return evaluate_calc_to_iss_object(
+                ctx, context_id, resolution, environment, node, entry);
+        });
+}
+
 cppcoro::task<dynamic>
 resolve_calc_to_value(
     thinknode_request_context ctx,
     string context_id,
     calculation_request request)
 {
+    calc_resolution resolution;
+    auto const& node{*intern_calc(resolution, std::move(request))};
     co_return co_await resolve_calc_to_value(
-        ctx, context_id, {}, std::move(request));
+        ctx, context_id, resolution, nullptr, node, nullptr);
 }
 
 cppcoro::task<std::string>
@@ -390,8 +826,10 @@ resolve_calc_to_iss_object(
     string context_id,
     calculation_request request)
 {
+    calc_resolution resolution;
+    auto const& node{*intern_calc(resolution, std::move(request))};
     co_return co_await resolve_calc_to_iss_object(
-        ctx, context_id, {}, std::move(request));
+        ctx, context_id, resolution, nullptr, node, nullptr);
 }
 
 calculation_request
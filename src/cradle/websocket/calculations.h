@@ -8,6 +8,16 @@
 
 namespace cradle {
 
+struct calculation_config_keys
+{
+    // (Optional integer)
+    // The maximum number of sibling subcalculations (function arguments,
+    // array items, object properties) that resolve_calc_to_value() evaluates
+    // concurrently, per calculation (default 16). 1 evaluates them one after
+    // another.
+    inline static std::string const FAN_OUT{"calculations/fan_out"};
+};
+
 template<class Return, class... Args>
 auto
 make_function_id(Return (*ptr)(Args... args))
@@ -0,0 +1,318 @@
+#include <cradle/websocket/reference_plan.h>
+
+#include <cradle/typing/core/type_interfaces.h>
+
+namespace cradle {
+
+/*
+ * Compiles a reference_plan in three steps:
+ * 1. Build a graph with a vertex for each distinct (sub)type, resolving
+ *    named types. A named type becomes an alias for the vertex of its
+ *    definition, and is resolved only once, so that recursive types lead to
+ *    cycles rather than to an infinite recursion.
+ * 2. Determine which vertices can reach a REFERENCE_TYPE vertex.
+ * 3. Create plan nodes for those vertices only.
+ */
+class reference_plan_compiler
+{
+ public:
+    reference_plan_compiler(
+        reference_plan::named_type_resolver const& resolve)
+        : resolve_{resolve}
+    {
+    }
+
+    cppcoro::task<std::shared_ptr<reference_plan const>>
+    compile(api_type_info const& type)
+    {
+        auto root = co_await add_vertex(type);
+        mark_referencing_vertices();
+        auto plan = std::make_shared<reference_plan>();
+        plan_nodes_.resize(vertices_.size(), nullptr);
+        plan->root_ = make_node(*plan, root);
+        co_return plan;
+    }
+
+ private:
+    static constexpr std::size_t npos = ~std::size_t{0};
+
+    struct vertex
+    {
+        api_type_info_tag tag{api_type_info_tag::NIL_TYPE};
+        // For a named type: the index of its definition's vertex
+        std::size_t alias{npos};
+        // ARRAY_TYPE, OPTIONAL_TYPE, MAP_TYPE (key)
+        std::size_t element{npos};
+        // MAP_TYPE (value)
+        std::size_t value{npos};
+        // STRUCTURE_TYPE fields, UNION_TYPE members
+        std::vector<std::pair<string, std::size_t>> members;
+        bool may_contain_references{false};
+    };
+
+    reference_plan::named_type_resolver const& resolve_;
+    std::vector<vertex> vertices_;
+    // The vertices for the named types that were resolved so far
+    std::map<api_type_info, std::size_t> named_vertices_;
+    // The plan node for each vertex, once created
+    std::vector<reference_plan::node*> plan_nodes_;
+
+    cppcoro::task<std::size_t>
+    add_vertex(api_type_info const& type)
+    {
+        auto tag = get_tag(type);
+        if (tag == api_type_info_tag::NAMED_TYPE)
+        {
+            auto it = named_vertices_.find(type);
+            if (it != named_vertices_.end())
+            {
+                co_return it->second;
+            }
+        }
+        auto ix = vertices_.size();
+        vertices_.push_back(vertex{tag});
+        // vertices_ may be reallocated by the recursive calls, so don't hold
+        // on to references into it.
+        switch (tag)
+        {
+            case api_type_info_tag::ARRAY_TYPE: {
+                auto element
+                    = co_await add_vertex(as_array_type(type).element_schema);
+                vertices_[ix].element = element;
+                break;
+            }
+            case api_type_info_tag::MAP_TYPE: {
+                auto key = co_await add_vertex(as_map_type(type).key_schema);
+                auto value
+                    = co_await add_vertex(as_map_type(type).value_schema);
+                vertices_[ix].element = key;
+                vertices_[ix].value = value;
+                break;
+            }
+            case api_type_info_tag::NAMED_TYPE: {
+                named_vertices_[type] = ix;
+                auto definition = co_await resolve_(as_named_type(type));
+                auto alias = co_await add_vertex(definition);
+                vertices_[ix].alias = alias;
+                break;
+            }
+            case api_type_info_tag::OPTIONAL_TYPE: {
+                auto element = co_await add_vertex(as_optional_type(type));
+                vertices_[ix].element = element;
+                break;
+            }
+            case api_type_info_tag::REFERENCE_TYPE:
+                vertices_[ix].may_contain_references = true;
+                break;
+            case api_type_info_tag::STRUCTURE_TYPE:
+                for (auto const& [name, field] :
+                     as_structure_type(type).fields)
+                {
+                    auto member = co_await add_vertex(field.schema);
+                    vertices_[ix].members.emplace_back(name, member);
+                }
+                break;
+            case api_type_info_tag::UNION_TYPE:
+                for (auto const& [name, member_info] :
+                     as_union_type(type).members)
+                {
+                    auto member = co_await add_vertex(member_info.schema);
+                    vertices_[ix].members.emplace_back(name, member);
+                }
+                break;
+            default:
+                // Blobs, strings, dynamics, etc. could technically contain
+                // references, but we're only looking for explicitly typed
+                // ones.
+                break;
+        }
+        co_return ix;
+    }
+
+    bool
+    may_contain_references(std::size_t ix) const
+    {
+        return ix != npos && vertices_[ix].may_contain_references;
+    }
+
+    // Propagates may_contain_references from children to parents, until
+    // nothing changes anymore (the graph may contain cycles).
+    void
+    mark_referencing_vertices()
+    {
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (auto& v : vertices_)
+            {
+                if (v.may_contain_references)
+                {
+                    continue;
+                }
+                bool found = may_contain_references(v.alias)
+                             || may_contain_references(v.element)
+                             || may_contain_references(v.value);
+                for (auto const& member : v.members)
+                {
+                    found = found || may_contain_references(member.second);
+                }
+                if (found)
+                {
+                    v.may_contain_references = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Returns the plan node for vertex ix, creating it if needed; or nullptr
+    // if the vertex cannot lead to references.
+    reference_plan::node const*
+    make_node(reference_plan& plan, std::size_t ix)
+    {
+        if (!may_contain_references(ix))
+        {
+            return nullptr;
+        }
+        while (vertices_[ix].alias != npos)
+        {
+            ix = vertices_[ix].alias;
+        }
+        if (plan_nodes_[ix])
+        {
+            return plan_nodes_[ix];
+        }
+        plan.nodes_.push_back(std::make_unique<reference_plan::node>());
+        auto* node = plan.nodes_.back().get();
+        // Register the node before creating its children, which may refer
+        // back to it.
+        plan_nodes_[ix] = node;
+        auto const& v = vertices_[ix];
+        node->tag = v.tag;
+        node->element = make_node(plan, v.element);
+        node->value = make_node(plan, v.value);
+        for (auto const& [name, member] : v.members)
+        {
+            auto const* member_node = make_node(plan, member);
+            if (v.tag == api_type_info_tag::UNION_TYPE)
+            {
+                node->members[name] = member_node;
+            }
+            else if (member_node)
+            {
+                node->fields.emplace_back(name, member_node);
+            }
+        }
+        return node;
+    }
+};
+
+cppcoro::task<std::shared_ptr<reference_plan const>>
+reference_plan::compile(
+    api_type_info const& type, named_type_resolver const& resolve)
+{
+    reference_plan_compiler compiler{resolve};
+    co_return co_await compiler.compile(type);
+}
+
+static void
+collect_node_references(
+    reference_plan::node const& node,
+    dynamic const& value,
+    std::vector<string>& refs)
+{
+    switch (node.tag)
+    {
+        case api_type_info_tag::ARRAY_TYPE:
+            for (auto const& item : cast<dynamic_array>(value))
+            {
+                collect_node_references(*node.element, item, refs);
+            }
+            break;
+        case api_type_info_tag::MAP_TYPE:
+            for (auto const& [key, item] : cast<dynamic_map>(value))
+            {
+                if (node.element)
+                {
+                    collect_node_references(*node.element, key, refs);
+                }
+                if (node.value)
+                {
+                    collect_node_references(*node.value, item, refs);
+                }
+            }
+            break;
+        case api_type_info_tag::OPTIONAL_TYPE: {
+            auto const& map = cast<dynamic_map>(value);
+            string tag;
+            from_dynamic(&tag, get_union_tag(map));
+            if (tag == "some")
+            {
+                collect_node_references(
+                    *node.element, get_field(map, "some"), refs);
+            }
+            break;
+        }
+        case api_type_info_tag::REFERENCE_TYPE:
+            refs.push_back(cast<string>(value));
+            break;
+        case api_type_info_tag::STRUCTURE_TYPE: {
+            auto const& fields = cast<dynamic_map>(value);
+            for (auto const& [name, field_node] : node.fields)
+            {
+                dynamic const* field_value;
+                if (get_field(&field_value, fields, name))
+                {
+                    collect_node_references(*field_node, *field_value, refs);
+                }
+            }
+            break;
+        }
+        case api_type_info_tag::UNION_TYPE: {
+            auto const& member_map = cast<dynamic_map>(value);
+            string tag;
+            from_dynamic(&tag, get_union_tag(member_map));
+            if (auto const* member_node = node.members.at(tag))
+            {
+                collect_node_references(
+                    *member_node, get_field(member_map, tag), refs);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void
+reference_plan::collect_references(
+    dynamic const& value, std::vector<string>& refs) const
+{
+    if (root_)
+    {
+        collect_node_references(*root_, value, refs);
+    }
+}
+
+std::size_t
+reference_plan::deep_size() const
+{
+    std::size_t size{sizeof(*this)};
+    for (auto const& n : nodes_)
+    {
+        size += sizeof(node);
+        for (auto const& [name, _] : n->fields)
+        {
+            size += deep_sizeof(name) + sizeof(node const*);
+        }
+        for (auto const& [name, _] : n->members)
+        {
+            // Plus the map's per-element overhead
+            size += deep_sizeof(name) + sizeof(node const*) + 32;
+        }
+    }
+    return size;
+}
+
+} // namespace cradle
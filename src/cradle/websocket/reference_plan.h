@@ -0,0 +1,82 @@
+#ifndef CRADLE_WEBSOCKET_REFERENCE_PLAN_H
+#define CRADLE_WEBSOCKET_REFERENCE_PLAN_H
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <cppcoro/task.hpp>
+
+#include <cradle/inner/utilities/functional.h>
+#include <cradle/typing/core/api_types.hpp>
+#include <cradle/typing/core/dynamic.h>
+
+namespace cradle {
+
+/*
+ * A plan for finding the references (REFERENCE_TYPE values) in values of a
+ * given type, compiled once from the type's schema.
+ *
+ * The plan mirrors the schema, with named types resolved, but contains only
+ * the parts that can lead to a reference. Collecting the references in a
+ * value visits just those parts, so a large array of numbers (or any other
+ * reference-free subtree) is skipped as a whole.
+ * Recursive types lead to cycles between the plan's nodes.
+ */
+class reference_plan
+{
+ public:
+    // Resolves a named type to its definition
+    using named_type_resolver = function_view<cppcoro::task<api_type_info>(
+        api_named_type_reference const& ref)>;
+
+    // Compiles the plan for type. resolve is called once for each distinct
+    // named type that is reachable from type.
+    static cppcoro::task<std::shared_ptr<reference_plan const>>
+    compile(api_type_info const& type, named_type_resolver const& resolve);
+
+    // true if values of the type may contain references
+    bool
+    may_contain_references() const
+    {
+        return root_ != nullptr;
+    }
+
+    // Appends the references in value (of the plan's type) to refs, in the
+    // order in which they are found.
+    void
+    collect_references(dynamic const& value, std::vector<string>& refs) const;
+
+    // Returns the (approximate) amount of memory used by the plan
+    std::size_t
+    deep_size() const;
+
+    struct node;
+
+ private:
+    // Owns all nodes; nodes refer to each other via raw pointers
+    std::vector<std::unique_ptr<node>> nodes_;
+    // nullptr if the type cannot contain references
+    node const* root_{nullptr};
+
+    friend class reference_plan_compiler;
+};
+
+// The plan node for a (resolved) type that may contain references. Child
+// pointers are null for parts that cannot contain references.
+struct reference_plan::node
+{
+    api_type_info_tag tag{api_type_info_tag::NIL_TYPE};
+    // ARRAY_TYPE: the element; OPTIONAL_TYPE: the value; MAP_TYPE: the key
+    node const* element{nullptr};
+    // MAP_TYPE: the value
+    node const* value{nullptr};
+    // STRUCTURE_TYPE: the fields that may contain references
+    std::vector<std::pair<string, node const*>> fields;
+    // UNION_TYPE: all members
+    std::map<string, node const*> members;
+};
+
+} // namespace cradle
+
+#endif
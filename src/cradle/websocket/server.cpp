@@ -3,7 +3,9 @@
 #include <cradle/websocket/server.h>
 #include <cradle/websocket/server_api.h>
 
-#include <set>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
 #include <thread>
 
 // Boost.Crc triggers some warnings on MSVC.
@@ -27,8 +29,6 @@
 #include <spdlog/spdlog.h>
 
 #include <cppcoro/async_scope.hpp>
-#include <cppcoro/schedule_on.hpp>
-#include <cppcoro/static_thread_pool.hpp>
 #include <cppcoro/sync_wait.hpp>
 #include <cppcoro/task.hpp>
 #include <cppcoro/when_all.hpp>
@@ -45,6 +45,7 @@
 #include <cradle/inner/requests/function.h>
 #include <cradle/inner/resolve/resolve_request.h>
 #include <cradle/inner/resolve/seri_req.h>
+#include <cradle/inner/service/work_stealing_pool.h>
 #include <cradle/inner/utilities/errors.h>
 #include <cradle/inner/utilities/functional.h>
 #include <cradle/inner/utilities/logging.h>
@@ -66,12 +67,14 @@
 #include <cradle/typing/core/unique_hash.h>
 #include <cradle/typing/encodings/json.h>
 #include <cradle/typing/encodings/msgpack.h>
+#include <cradle/typing/encodings/msgpack_codec.h>
 #include <cradle/typing/encodings/yaml.h>
 #include <cradle/typing/utilities/diff.hpp>
 #include <cradle/typing/utilities/logging.h>
 #include <cradle/websocket/calculations.h>
 #include <cradle/websocket/introspection.h>
 #include <cradle/websocket/messages.hpp>
+#include <cradle/websocket/reference_plan.h>
 
 // Include this again because some #defines snuck in to overwrite some of our
 // enum constants.
@@ -187,6 +190,7 @@ struct client_request
     connection_hdl client;
     websocket_client_message message;
     tasklet_tracker* tasklet;
+    schedule_hint hint;
 };
 
 class websocket_server_impl
@@ -202,7 +206,8 @@ class websocket_server_impl
     client_connection_list clients;
     service_core core;
     cppcoro::async_scope async_scope;
-    cppcoro::static_thread_pool pool;
+    // Processes the client messages, in the order given by their hints
+    work_stealing_pool pool{std::thread::hardware_concurrency()};
 };
 
 static void
@@ -211,10 +216,11 @@ send(
     connection_hdl hdl,
     websocket_server_message const& message)
 {
-    auto dynamic = to_dynamic(message);
-    auto msgpack = value_to_msgpack_string(dynamic);
+    msgpack_writer writer;
+    to_msgpack(writer, message);
     websocketpp::lib::error_code ec;
-    server.ws.send(hdl, msgpack, websocketpp::frame::opcode::binary, ec);
+    server.ws.send(
+        hdl, writer.buffer(), websocketpp::frame::opcode::binary, ec);
     if (ec)
     {
         CRADLE_THROW(
@@ -458,226 +464,87 @@ post_iss_object(
         std::move(coerced_object));
 }
 
-cppcoro::task<bool>
-type_contains_references(
-    thinknode_request_context ctx,
-    std::set<api_type_info>& already_visited,
-    string const& context_id,
-    api_type_info const& type);
+namespace {
+
+// A reference plan, as stored in the memory cache
+struct cached_reference_plan
+{
+    std::shared_ptr<reference_plan const> plan;
+    // The hash over the inputs that the plan was compiled from, serving as
+    // the plan's digest
+    unique_hasher::result_t origin;
+};
+
+size_t
+deep_sizeof(cached_reference_plan const& x)
+{
+    return sizeof(x) + x.plan->deep_size();
+}
+
+void
+update_unique_hash(unique_hasher& hasher, cached_reference_plan const& x)
+{
+    hasher.combine(x.origin);
+}
+
+} // namespace
 
 namespace uncached {
 
-cppcoro::task<bool>
-type_contains_references(
-    thinknode_request_context ctx,
-    std::set<api_type_info>& already_visited,
-    string const& context_id,
-    api_type_info const& type)
+cppcoro::task<cached_reference_plan>
+compile_reference_plan(
+    thinknode_request_context ctx, string context_id, api_type_info type)
 {
-    auto recurse = [&](api_type_info const& type) -> cppcoro::task<bool> {
-        return cradle::type_contains_references(
-            ctx, already_visited, context_id, type);
+    auto resolve = [&](api_named_type_reference const& ref)
+        -> cppcoro::task<api_type_info> {
+        co_return co_await resolve_named_type_reference(ctx, context_id, ref);
     };
-
-    switch (get_tag(type))
-    {
-        case api_type_info_tag::ARRAY_TYPE:
-            co_return co_await recurse(as_array_type(type).element_schema);
-        case api_type_info_tag::BLOB_TYPE:
-            co_return false;
-        case api_type_info_tag::BOOLEAN_TYPE:
-            co_return false;
-        case api_type_info_tag::DATETIME_TYPE:
-            co_return false;
-        case api_type_info_tag::DYNAMIC_TYPE:
-            // Technically, there could be a reference stored within a
-            // dynamic (or in blobs, strings, etc.), but we're only looking
-            // for explicitly typed references.
-            co_return false;
-        case api_type_info_tag::ENUM_TYPE:
-            co_return false;
-        case api_type_info_tag::FLOAT_TYPE:
-            co_return false;
-        case api_type_info_tag::INTEGER_TYPE:
-            co_return false;
-        case api_type_info_tag::MAP_TYPE: {
-            auto [in_key_type, in_value_type] = co_await cppcoro::when_all(
-                recurse(as_map_type(type).key_schema),
-                recurse(as_map_type(type).value_schema));
-            co_return in_key_type || in_value_type;
-        }
-        case api_type_info_tag::NAMED_TYPE:
-            co_return co_await recurse(
-                co_await cradle::resolve_named_type_reference(
-                    ctx, context_id, as_named_type(type)));
-        case api_type_info_tag::NIL_TYPE:
-        default:
-            co_return false;
-        case api_type_info_tag::OPTIONAL_TYPE:
-            co_return co_await recurse(as_optional_type(type));
-        case api_type_info_tag::REFERENCE_TYPE:
-            co_return true;
-        case api_type_info_tag::STRING_TYPE:
-            co_return false;
-        case api_type_info_tag::STRUCTURE_TYPE: {
-            auto in_fields = co_await cppcoro::when_all(map_to_vector(
-                [&](auto const& pair) -> cppcoro::task<bool> {
-                    return recurse(pair.second.schema);
-                },
-                as_structure_type(type).fields));
-            co_return std::any_of(
-                in_fields.begin(), in_fields.end(), std::identity());
-        }
-        case api_type_info_tag::UNION_TYPE: {
-            auto in_members = co_await cppcoro::when_all(map_to_vector(
-                [&](auto const& pair) -> cppcoro::task<bool> {
-                    return recurse(pair.second.schema);
-                },
-                as_union_type(type).members));
-            co_return std::any_of(
-                in_members.begin(), in_members.end(), std::identity());
-        }
-    }
+    cached_reference_plan result;
+    result.plan = co_await reference_plan::compile(type, resolve);
+    unique_hasher hasher;
+    update_unique_hash(hasher, ctx.session.api_url);
+    update_unique_hash(hasher, context_id);
+    update_unique_hash(hasher, type);
+    result.origin = hasher.get_result();
+    co_return result;
 }
 
 } // namespace uncached
 
-cppcoro::task<bool>
-type_contains_references(
+// Returns the reference plan for values of type, compiling it on first use.
+// Plans are kept in the memory cache, so the ones that are no longer used
+// get evicted.
+static cppcoro::task<std::shared_ptr<reference_plan const>>
+get_reference_plan(
     thinknode_request_context ctx,
-    std::set<api_type_info>& already_visited,
     string const& context_id,
     api_type_info const& type)
 {
-    // CRADLE_LOG_CALL(<< CRADLE_LOG_ARG(context_id) << CRADLE_LOG_ARG(type))
-
-    // Check to see if we have already visited this type within this
-    // evaluation. (This happens when we are processing a recursive union type,
-    // and if we didn't check for it here, we would end up in an infinite
-    // recursion.) We can safely return `false` here because the entire logic
-    // of this function is `or`-driven (i.e., if any part of the type contains
-    // a reference, the whole thing does), and the original evaluation of this
-    // type will return the correct result.
-    if (already_visited.contains(type))
-        co_return false;
-    already_visited.insert(type);
-
+    string function_name{"reference_plan"};
     auto cache_key = make_captured_sha256_hashed_id(
-        "type_contains_references", ctx.session.api_url, context_id, type);
-    auto create_task = [&] {
-        return uncached::type_contains_references(
-            ctx, already_visited, context_id, type);
-    };
-    co_return co_await fully_cached<bool>(ctx.service, cache_key, create_task);
+        function_name, ctx.session.api_url, context_id, type);
+    auto cached_plan = co_await cached<cached_reference_plan>(
+        ctx.service, cache_key, [&](captured_id const&) {
+            return uncached::compile_reference_plan(ctx, context_id, type);
+        });
+    co_return std::move(cached_plan.plan);
 }
 
-cppcoro::task<nil_t>
-visit_object_references(
-    thinknode_request_context ctx,
-    string const& context_id,
-    api_type_info const& type,
-    dynamic const& value,
+// Calls visitor for each distinct reference in refs, concurrently
+static cppcoro::task<nil_t>
+visit_references(
+    std::vector<string> refs,
     function_view<cppcoro::task<nil_t>(string const& ref)> const& visitor)
 {
-    // CRADLE_LOG_CALL(
-    //     << CRADLE_LOG_ARG(context_id) << CRADLE_LOG_ARG(type)
-    //     << CRADLE_LOG_ARG(value))
-
-    auto recurse = [&](api_type_info const& type,
-                       dynamic const& value) -> cppcoro::task<nil_t> {
-        return visit_object_references(ctx, context_id, type, value, visitor);
-    };
-
-    switch (get_tag(type))
+    std::sort(refs.begin(), refs.end());
+    refs.erase(std::unique(refs.begin(), refs.end()), refs.end());
+    std::vector<cppcoro::task<nil_t>> subtasks;
+    subtasks.reserve(refs.size());
+    for (auto const& ref : refs)
     {
-        case api_type_info_tag::ARRAY_TYPE:
-            co_await cppcoro::when_all(map(
-                [&](auto const& item) {
-                    return recurse(as_array_type(type).element_schema, item);
-                },
-                cast<dynamic_array>(value)));
-            break;
-        case api_type_info_tag::BLOB_TYPE:
-            break;
-        case api_type_info_tag::BOOLEAN_TYPE:
-            break;
-        case api_type_info_tag::DATETIME_TYPE:
-            break;
-        case api_type_info_tag::DYNAMIC_TYPE:
-            break;
-        case api_type_info_tag::ENUM_TYPE:
-            break;
-        case api_type_info_tag::FLOAT_TYPE:
-            break;
-        case api_type_info_tag::INTEGER_TYPE:
-            break;
-        case api_type_info_tag::MAP_TYPE: {
-            auto const& map_type = as_map_type(type);
-            std::vector<cppcoro::task<nil_t>> subtasks;
-            for (auto const& pair : cast<dynamic_map>(value))
-            {
-                subtasks.push_back(recurse(map_type.key_schema, pair.first));
-                subtasks.push_back(
-                    recurse(map_type.value_schema, pair.second));
-            }
-            co_await cppcoro::when_all(std::move(subtasks));
-            break;
-        }
-        case api_type_info_tag::NAMED_TYPE: {
-            auto type_info = co_await resolve_named_type_reference(
-                ctx, context_id, as_named_type(type));
-            co_await recurse(type_info, value);
-            break;
-        }
-        case api_type_info_tag::NIL_TYPE:
-        default:
-            break;
-        case api_type_info_tag::OPTIONAL_TYPE: {
-            auto const& map = cast<dynamic_map>(value);
-            string tag;
-            from_dynamic(&tag, cradle::get_union_tag(map));
-            if (tag == "some")
-            {
-                co_await recurse(
-                    as_optional_type(type), get_field(map, "some"));
-            }
-            break;
-        }
-        case api_type_info_tag::REFERENCE_TYPE:
-            co_await visitor(cast<string>(value));
-        case api_type_info_tag::STRING_TYPE:
-            break;
-        case api_type_info_tag::STRUCTURE_TYPE: {
-            auto const& fields = cast<dynamic_map>(value);
-            std::vector<cppcoro::task<nil_t>> in_fields;
-            for (auto const& pair : as_structure_type(type).fields)
-            {
-                auto const& field_info = pair.second;
-                dynamic const* field_value;
-                bool field_present
-                    = get_field(&field_value, fields, pair.first);
-                if (field_present)
-                {
-                    in_fields.push_back(
-                        recurse(field_info.schema, *field_value));
-                }
-            }
-            co_await cppcoro::when_all(std::move(in_fields));
-            break;
-        }
-        case api_type_info_tag::UNION_TYPE: {
-            auto const& member_map = cast<dynamic_map>(value);
-            string tag;
-            from_dynamic(&tag, cradle::get_union_tag(member_map));
-            co_await [&]() -> cppcoro::task<nil_t> {
-                return recurse(
-                    as_union_type(type).members.at(tag).schema,
-                    get_field(member_map, tag));
-            }();
-            break;
-        }
+        subtasks.push_back(visitor(ref));
     }
-
+    co_await cppcoro::when_all(std::move(subtasks));
     co_return nil;
 }
 
@@ -720,12 +587,14 @@ deeply_copy_iss_object(
     auto object_type
         = as_api_type(parse_url_type_string(metadata["Thinknode-Type"]));
 
-    std::set<api_type_info> already_visited;
-    if (co_await cradle::type_contains_references(
-            ctx, already_visited, source_context_id, object_type))
+    auto plan
+        = co_await get_reference_plan(ctx, source_context_id, object_type);
+    if (plan->may_contain_references())
     {
         auto object
             = co_await get_iss_object(ctx, source_context_id, object_id);
+        std::vector<string> refs;
+        plan->collect_references(object, refs);
         auto recurse = [&](string const& ref) -> cppcoro::task<nil_t> {
             co_return co_await cradle::deeply_copy_iss_object(
                 ctx,
@@ -734,8 +603,7 @@ deeply_copy_iss_object(
                 destination_context_id,
                 ref);
         };
-        co_await visit_object_references(
-            ctx, source_context_id, object_type, object, recurse);
+        co_await visit_references(std::move(refs), recurse);
     }
 
     co_return nil;
@@ -774,59 +642,40 @@ deeply_copy_iss_object(
         ctx.service, cache_key, create_task);
 }
 
-cppcoro::task<nil_t>
-visit_calc_references(
-    thinknode_request_context ctx,
-    string const& context_id,
-    thinknode_calc_request const& request,
-    function_view<cppcoro::task<nil_t>(string const& ref)> const& visitor)
+// Appends the references in a calculation request to refs
+static void
+collect_calc_references(
+    thinknode_calc_request const& request, std::vector<string>& refs)
 {
-    auto recurse
-        = [&](thinknode_calc_request const& request) -> cppcoro::task<nil_t> {
-        return visit_calc_references(ctx, context_id, request, visitor);
-    };
-
     switch (get_tag(request))
     {
         case thinknode_calc_request_tag::REFERENCE:
-            co_await visitor(as_reference(request));
+            refs.push_back(as_reference(request));
             break;
         case thinknode_calc_request_tag::VALUE:
             break;
-        case thinknode_calc_request_tag::FUNCTION: {
-            std::vector<cppcoro::task<nil_t>> subtasks;
+        case thinknode_calc_request_tag::FUNCTION:
             for (auto const& arg : as_function(request).args)
-                subtasks.push_back(recurse(arg));
-            co_await cppcoro::when_all_ready(std::move(subtasks));
+                collect_calc_references(arg, refs);
             break;
-        }
-        case thinknode_calc_request_tag::ARRAY: {
-            std::vector<cppcoro::task<nil_t>> subtasks;
+        case thinknode_calc_request_tag::ARRAY:
             for (auto const& item : as_array(request).items)
-                subtasks.push_back(recurse(item));
-            co_await cppcoro::when_all_ready(std::move(subtasks));
+                collect_calc_references(item, refs);
             break;
-        }
         case thinknode_calc_request_tag::ITEM:
-            co_await cppcoro::when_all_ready(
-                recurse(as_item(request).array),
-                recurse(as_item(request).index));
+            collect_calc_references(as_item(request).array, refs);
+            collect_calc_references(as_item(request).index, refs);
             break;
-        case thinknode_calc_request_tag::OBJECT: {
-            std::vector<cppcoro::task<nil_t>> subtasks;
+        case thinknode_calc_request_tag::OBJECT:
             for (auto const& item : as_object(request).properties)
-                subtasks.push_back(recurse(item.second));
-            co_await cppcoro::when_all_ready(std::move(subtasks));
+                collect_calc_references(item.second, refs);
             break;
-        }
-        case thinknode_calc_request_tag::PROPERTY: {
-            co_await cppcoro::when_all_ready(
-                recurse(as_property(request).object),
-                recurse(as_property(request).field));
+        case thinknode_calc_request_tag::PROPERTY:
+            collect_calc_references(as_property(request).object, refs);
+            collect_calc_references(as_property(request).field, refs);
             break;
-        }
         case thinknode_calc_request_tag::CAST:
-            co_await recurse(as_cast(request).object);
+            collect_calc_references(as_cast(request).object, refs);
             break;
         default:
             CRADLE_THROW(
@@ -834,8 +683,18 @@ visit_calc_references(
                 << enum_id_info("thinknode_calc_request_tag")
                 << enum_value_info(static_cast<int>(get_tag(request))));
     }
+}
 
-    co_return nil;
+// Calls visitor for each distinct reference in request, concurrently; any
+// error from a visit is propagated.
+static cppcoro::task<nil_t>
+visit_calc_references(
+    thinknode_calc_request const& request,
+    function_view<cppcoro::task<nil_t>(string const& ref)> const& visitor)
+{
+    std::vector<string> refs;
+    collect_calc_references(request, refs);
+    co_return co_await visit_references(std::move(refs), visitor);
 }
 
 cppcoro::task<nil_t>
@@ -904,8 +763,7 @@ deeply_copy_calculation(
                 destination_context_id,
                 ref);
         };
-        co_await visit_calc_references(
-            ctx, destination_context_id, calculation, recurse);
+        co_await visit_calc_references(calculation, recurse);
     }
 
     if (copy_needed)
@@ -1451,6 +1309,7 @@ make_thinknode_request_context(
         get_client(server.clients, request.client).session,
         request.tasklet,
         proxy_name};
+    ctx.set_schedule_hint(request.hint);
     return ctx;
 }
 
@@ -1827,6 +1686,13 @@ process_message_with_error_handling(
     co_return;
 }
 
+static cppcoro::task<>
+schedule_message(websocket_server_impl& server, client_request request)
+{
+    co_await server.pool.schedule(request.hint);
+    co_await process_message_with_error_handling(server, std::move(request));
+}
+
 static void
 on_open(websocket_server_impl& server, connection_hdl hdl)
 {
@@ -1839,6 +1705,58 @@ on_close(websocket_server_impl& server, connection_hdl hdl)
     remove_client(server.clients, hdl);
 }
 
+// Reads the optional scheduling fields of a client message. These are not
+// part of websocket_client_message, so that existing clients need not set
+// them:
+// - "priority": "background", "normal" (the default) or "interactive"
+// - "deadline_ms": the number of milliseconds within which the client would
+//   like to get the response
+static schedule_hint
+read_schedule_hint(msgpack_record const& record)
+{
+    schedule_hint hint;
+    omissible<string> priority;
+    read_field_from_msgpack(&priority, record, "priority");
+    if (priority)
+    {
+        if (*priority == "background")
+        {
+            hint.priority = request_priority::background;
+        }
+        else if (*priority == "interactive")
+        {
+            hint.priority = request_priority::interactive;
+        }
+        else if (*priority != "normal")
+        {
+            CRADLE_THROW(
+                websocket_server_error() << internal_error_message_info(
+                    "invalid message priority " + *priority));
+        }
+    }
+    omissible<integer> deadline_ms;
+    read_field_from_msgpack(&deadline_ms, record, "deadline_ms");
+    if (deadline_ms)
+    {
+        hint.deadline = std::chrono::steady_clock::now()
+                        + std::chrono::milliseconds(*deadline_ms);
+    }
+    return hint;
+}
+
+// Keeps a websocket frame alive for blobs that point into it
+class websocket_frame_owner : public data_owner
+{
+ public:
+    websocket_frame_owner(ws_server_type::message_ptr message)
+        : message_{std::move(message)}
+    {
+    }
+
+ private:
+    ws_server_type::message_ptr message_;
+};
+
 static void
 on_message(
     websocket_server_impl& server,
@@ -1849,11 +1767,18 @@ on_message(
     tasklet_tracker* tasklet = nullptr;
     try
     {
-        auto dynamic_message = parse_msgpack_value(raw_message->get_payload());
-        request_id = cast<string>(
-            get_field(cast<dynamic_map>(dynamic_message), "request_id"));
+        // Decode the message straight from the frame; blobs in the message
+        // keep the frame alive rather than being copied out of it.
+        auto const& payload = raw_message->get_payload();
+        msgpack_reader reader{
+            std::make_shared<websocket_frame_owner>(raw_message),
+            reinterpret_cast<uint8_t const*>(payload.data()),
+            payload.size()};
+        msgpack_record record{reader};
+        read_field_from_msgpack(&request_id, record, "request_id");
         websocket_client_message message;
-        from_dynamic(&message, dynamic_message);
+        read_fields_from_msgpack(message, record);
+        auto hint{read_schedule_hint(record)};
         if (is_kill(message.content))
         {
             server.ws.stop_listening();
@@ -1875,11 +1800,9 @@ on_message(
             }
             tasklet = create_tasklet_tracker(
                 server.core.the_tasklet_admin(), "server", os.str());
-            server.async_scope.spawn(schedule_on(
-                server.pool,
-                process_message_with_error_handling(
-                    server,
-                    client_request{hdl, std::move(message), tasklet})));
+            server.async_scope.spawn(schedule_message(
+                server,
+                client_request{hdl, std::move(message), tasklet, hint}));
         }
     }
     catch (std::exception& e)
@@ -0,0 +1,139 @@
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../support/inner_service.h"
+#include <cradle/inner/remote/async_db.h>
+#include <cradle/plugins/domain/testing/context.h>
+
+using namespace cradle;
+
+/*
+ * Stress async_db with many concurrent context trees and status pollers.
+ *
+ * A number of trees, each having tree_size contexts, is registered up front.
+ * In BM_async_db_poll_mt, each thread repeatedly looks up contexts, like
+ * clients polling the status of the contexts in their trees.
+ * In BM_async_db_churn_mt, each thread in addition registers and removes a
+ * tree of its own every 256 lookups.
+ */
+
+namespace {
+
+constexpr int num_trees = 64;
+
+struct bm_tree
+{
+    std::shared_ptr<root_local_atst_context> root;
+    std::vector<std::shared_ptr<non_root_local_atst_context>> subs;
+};
+
+std::unique_ptr<inner_resources> the_resources;
+std::unique_ptr<async_db> the_db;
+std::vector<bm_tree> the_trees;
+std::vector<async_id> the_ids;
+
+bm_tree
+make_tree(int tree_size)
+{
+    bm_tree tree;
+    tree.root = std::make_shared<root_local_atst_context>(
+        std::make_unique<local_tree_context_base>(*the_resources),
+        static_cast<tasklet_tracker*>(nullptr));
+    the_db->add(tree.root);
+    auto& tree_ctx{tree.root->get_tree_context()};
+    for (int i = 1; i < tree_size; ++i)
+    {
+        auto sub{std::make_shared<non_root_local_atst_context>(
+            tree_ctx, tree.root.get(), false, nullptr)};
+        the_db->add(sub);
+        tree.subs.push_back(std::move(sub));
+    }
+    return tree;
+}
+
+void
+set_up_db(int tree_size)
+{
+    the_resources = make_inner_test_resources();
+    the_db = std::make_unique<async_db>();
+    the_trees.clear();
+    the_ids.clear();
+    for (int i = 0; i < num_trees; ++i)
+    {
+        the_trees.push_back(make_tree(tree_size));
+        auto const& tree{the_trees.back()};
+        the_ids.push_back(tree.root->get_id());
+        for (auto const& sub : tree.subs)
+        {
+            the_ids.push_back(sub->get_id());
+        }
+    }
+}
+
+void
+tear_down_db()
+{
+    for (auto const& tree : the_trees)
+    {
+        the_db->remove_tree(tree.root->get_id());
+    }
+    the_trees.clear();
+    the_ids.clear();
+    the_db.reset();
+    the_resources.reset();
+}
+
+void
+poll_loop(benchmark::State& state, bool churn)
+{
+    if (state.thread_index() == 0)
+    {
+        set_up_db(static_cast<int>(state.range(0)));
+    }
+    // Threads start at different contexts, and stride through the ids so
+    // that they visit all trees.
+    std::size_t const num_ids{the_ids.size()};
+    std::size_t id_ix = state.thread_index() * (num_ids / state.threads());
+    int num_lookups{0};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(the_db->find(the_ids[id_ix]));
+        id_ix = (id_ix + 97) % num_ids;
+        if (churn && ++num_lookups % 256 == 0)
+        {
+            auto tree{make_tree(static_cast<int>(state.range(0)))};
+            the_db->remove_tree(tree.root->get_id());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        tear_down_db();
+    }
+}
+
+} // namespace
+
+static void
+BM_async_db_poll_mt(benchmark::State& state)
+{
+    poll_loop(state, false);
+}
+BENCHMARK(BM_async_db_poll_mt)
+    ->ArgName("tree_size")
+    ->Arg(1000)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+static void
+BM_async_db_churn_mt(benchmark::State& state)
+{
+    poll_loop(state, true);
+}
+BENCHMARK(BM_async_db_churn_mt)
+    ->ArgName("tree_size")
+    ->Arg(1000)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
+#include <cppcoro/when_all.hpp>
+
+#include <cradle/inner/service/work_stealing_pool.h>
+
+using namespace cradle;
+
+/*
+ * Compares the scheduler formerly used for locally resolving asynchronous
+ * requests (cppcoro::static_thread_pool, with a single global queue) with
+ * work_stealing_pool.
+ *
+ * The benchmarks resolve synthetic request trees, rescheduling subrequests
+ * like local_async_context_base::reschedule_if_opportune() does: all but the
+ * last subrequest of a parent are rescheduled on the pool, after their own
+ * subrequests have been resolved. Each node performs "work" iterations of
+ * some calculation.
+ * - In a thin tree of the given height, each node has a leaf and a thin
+ *   subtree as subrequests; so the tree is deep and narrow, and most of the
+ *   rescheduling is overhead.
+ * - In a triangular tree of the given height, each node has two triangular
+ *   subtrees as subrequests; so the tree is wide, and can keep many threads
+ *   busy.
+ */
+
+namespace {
+
+enum class tree_shape
+{
+    thin,
+    triangular
+};
+
+int
+simulate_work(int amount)
+{
+    unsigned x = static_cast<unsigned>(amount);
+    for (int i = 0; i < amount; ++i)
+    {
+        x = x * 1664525u + 1013904223u;
+        benchmark::DoNotOptimize(x);
+    }
+    return static_cast<int>(x & 1);
+}
+
+template<typename Pool>
+cppcoro::task<int>
+resolve_node(
+    Pool& pool,
+    tree_shape shape,
+    int height,
+    int work,
+    std::atomic<int>* parent_not_running)
+{
+    int result{0};
+    if (height > 1)
+    {
+        std::atomic<int> not_running{2};
+        std::vector<cppcoro::task<int>> subs;
+        if (shape == tree_shape::thin)
+        {
+            subs.push_back(resolve_node(pool, shape, 1, work, &not_running));
+        }
+        else
+        {
+            subs.push_back(
+                resolve_node(pool, shape, height - 1, work, &not_running));
+        }
+        subs.push_back(
+            resolve_node(pool, shape, height - 1, work, &not_running));
+        for (auto sub_result : co_await cppcoro::when_all(std::move(subs)))
+        {
+            result += sub_result;
+        }
+    }
+    if (parent_not_running && parent_not_running->fetch_sub(1) > 1)
+    {
+        co_await pool.schedule();
+    }
+    co_return result + simulate_work(work);
+}
+
+template<typename Pool>
+void
+BM_resolve_tree(benchmark::State& state, tree_shape shape)
+{
+    auto height{static_cast<int>(state.range(0))};
+    auto work{static_cast<int>(state.range(1))};
+    Pool pool{std::max(std::thread::hardware_concurrency(), 2u)};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cppcoro::sync_wait(
+            resolve_node(pool, shape, height, work, nullptr)));
+    }
+}
+
+template<typename Pool>
+void
+BM_resolve_thin_tree(benchmark::State& state)
+{
+    BM_resolve_tree<Pool>(state, tree_shape::thin);
+}
+
+template<typename Pool>
+void
+BM_resolve_triangular_tree(benchmark::State& state)
+{
+    BM_resolve_tree<Pool>(state, tree_shape::triangular);
+}
+
+void
+thin_tree_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"H", "work"})
+        ->Args({64, 100})
+        ->Args({64, 10000})
+        ->Unit(benchmark::kMicrosecond)
+        ->UseRealTime();
+}
+
+void
+triangular_tree_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"H", "work"})
+        ->Args({10, 100})
+        ->Args({10, 10000})
+        ->Unit(benchmark::kMicrosecond)
+        ->UseRealTime();
+}
+
+} // namespace
+
+BENCHMARK(BM_resolve_thin_tree<cppcoro::static_thread_pool>)
+    ->Name("BM_schedule_thin_tree global_queue")
+    ->Apply(thin_tree_args);
+BENCHMARK(BM_resolve_thin_tree<work_stealing_pool>)
+    ->Name("BM_schedule_thin_tree work_stealing")
+    ->Apply(thin_tree_args);
+BENCHMARK(BM_resolve_triangular_tree<cppcoro::static_thread_pool>)
+    ->Name("BM_schedule_triangular_tree global_queue")
+    ->Apply(triangular_tree_args);
+BENCHMARK(BM_resolve_triangular_tree<work_stealing_pool>)
+    ->Name("BM_schedule_triangular_tree work_stealing")
+    ->Apply(triangular_tree_args);
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <cppcoro/sync_wait.hpp>
+
+#include <cradle/thinknode/context.h>
+#include <cradle/thinknode/service/core.h>
+#include <cradle/websocket/calculations.h>
+
+#include "../support/inner_service.h"
+
+using namespace cradle;
+
+/*
+ * Benchmark resolve_calc_to_value() (which handles the websocket server's
+ * local calc requests) on a wide calculation: a lambda calc whose 16
+ * arguments are lambda calcs that each take 1ms, standing in for ISS fetches
+ * or local calcs.
+ *
+ * The argument is the fan-out limit; 1 evaluates the arguments one after
+ * another. Lambda calcs run on a 4-thread pool, so the speed-up levels off at
+ * a fan-out of 4.
+ */
+
+namespace {
+
+constexpr int calc_width = 16;
+
+dynamic
+slow_identity(dynamic_array args, tasklet_tracker*)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    return args.at(0);
+}
+
+dynamic
+count_args(dynamic_array args, tasklet_tracker*)
+{
+    return dynamic(static_cast<integer>(args.size()));
+}
+
+} // namespace
+
+static void
+BM_resolve_wide_calc(benchmark::State& state)
+{
+    auto config_map{make_inner_tests_config().get_config_map()};
+    config_map[calculation_config_keys::FAN_OUT]
+        = static_cast<std::size_t>(state.range(0));
+    service_core service{service_config{config_map}};
+    thinknode_session session;
+    session.api_url = "https://mgh.thinknode.io/api/v1.0";
+    session.access_token = "xyz";
+    thinknode_request_context ctx{service, session, nullptr, ""};
+
+    // Each iteration uses different argument values, so that the lambda calcs
+    // aren't served from the memory cache.
+    int iteration = 0;
+    for (auto _ : state)
+    {
+        std::vector<calculation_request> args;
+        for (int i = 0; i < calc_width; ++i)
+        {
+            args.push_back(
+                make_calculation_request_with_lambda(make_lambda_calculation(
+                    make_function(slow_identity),
+                    {make_calculation_request_with_value(
+                        dynamic(static_cast<integer>(iteration)))})));
+            ++iteration;
+        }
+        benchmark::DoNotOptimize(cppcoro::sync_wait(resolve_calc_to_value(
+            ctx,
+            "5dadeb4a004073e81b5e096255e83652",
+            make_calculation_request_with_lambda(make_lambda_calculation(
+                make_function(count_args), std::move(args))))));
+    }
+    state.SetItemsProcessed(state.iterations() * calc_width);
+}
+BENCHMARK(BM_resolve_wide_calc)
+    ->ArgName("fan_out")
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
@@ -1,4 +1,6 @@
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 #include <fmt/format.h>
@@ -43,4 +45,90 @@ BM_disk_cache_read(benchmark::State& state)
 
 BENCHMARK(BM_disk_cache_read);
 
+/*
+ * Benchmark a mix of look-ups and inserts from multiple threads.
+ *
+ * Look-ups hit entries that were inserted during set-up; inserts add new
+ * entries. The argument is the percentage of operations that are inserts.
+ * Inserts from different threads should share transactions, and look-ups
+ * should not wait for them.
+ */
+
+namespace {
+
+constexpr int num_mixed_items = 1000;
+
+std::unique_ptr<ll_disk_cache> the_cache;
+std::vector<std::string> the_keys;
+
+void
+set_up_mixed_cache()
+{
+    std::string directory{"disk_cache"};
+    reset_directory(directory);
+    ll_disk_cache_config config;
+    config.directory = directory;
+    the_cache = std::make_unique<ll_disk_cache>(config);
+    the_keys.clear();
+    std::vector<ll_disk_cache_insert_entry> entries;
+    for (int i = 0; i < num_mixed_items; ++i)
+    {
+        auto key{get_unique_string_tmpl(fmt::format("key{}", i))};
+        auto value{make_blob(fmt::format("value{}", i))};
+        auto digest{get_unique_string_tmpl(value)};
+        entries.push_back(ll_disk_cache_insert_entry{key, digest, value});
+        the_keys.push_back(key);
+    }
+    the_cache->insert_many(entries);
+}
+
+} // namespace
+
+void
+BM_disk_cache_mixed_mt(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+    {
+        set_up_mixed_cache();
+    }
+    auto insert_percentage = static_cast<int>(state.range(0));
+    int key_ix = state.thread_index() * (num_mixed_items / state.threads());
+    int op_ix = 0;
+    int new_ix = 0;
+    for (auto _ : state)
+    {
+        if (op_ix % 100 < insert_percentage)
+        {
+            auto key{fmt::format("new{}-{}", state.thread_index(), new_ix)};
+            auto value{make_blob(key)};
+            the_cache->insert(key, get_unique_string_tmpl(value), value);
+            ++new_ix;
+        }
+        else
+        {
+            benchmark::DoNotOptimize(the_cache->find(the_keys[key_ix]));
+            key_ix = (key_ix + 1) % num_mixed_items;
+        }
+        op_ix += 1;
+        if (op_ix % 1000 == 0)
+        {
+            the_cache->flush_ac_usage();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        the_cache.reset();
+    }
+}
+
+BENCHMARK(BM_disk_cache_mixed_mt)
+    ->ArgName("insert%")
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50)
+    ->Arg(100)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
 } // namespace cradle
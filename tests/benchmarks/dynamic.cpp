@@ -0,0 +1,145 @@
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <cradle/typing/core/flat_dynamic.h>
+#include <cradle/typing/encodings/json.h>
+#include <cradle/typing/encodings/msgpack.h>
+#include <cradle/typing/encodings/msgpack_codec.h>
+
+using namespace cradle;
+
+/*
+ * Compare dynamic and flat_dynamic on a Thinknode-like result: an array of
+ * records, each with an ID, a label drawn from a small set, a dose, a
+ * position and a small mask blob. The argument is the number of records.
+ */
+
+namespace {
+
+dynamic
+make_sample_records(int n_records)
+{
+    static char const* const labels[] = {"PTV", "CTV", "GTV", "OAR"};
+    dynamic_array records;
+    records.reserve(n_records);
+    for (int i = 0; i < n_records; ++i)
+    {
+        records.push_back(dynamic(dynamic_map{
+            {dynamic("id"), dynamic("record-" + std::to_string(i))},
+            {dynamic("label"), dynamic(labels[i % 4])},
+            {dynamic("dose"), dynamic(i * 0.5)},
+            {dynamic("position"),
+             dynamic(dynamic_array{
+                 dynamic(double(i)), dynamic(1.0), dynamic(-1.0)})},
+            {dynamic("mask"), dynamic(make_blob(std::string(16, 'm')))}}));
+    }
+    return dynamic(std::move(records));
+}
+
+std::shared_ptr<string_owner>
+make_msgpack_sample(benchmark::State& state)
+{
+    return std::make_shared<string_owner>(value_to_msgpack_string(
+        make_sample_records(static_cast<int>(state.range(0)))));
+}
+
+void
+set_counters(benchmark::State& state, size_t bytes)
+{
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+void
+BM_parse_msgpack_dynamic(benchmark::State& state)
+{
+    auto owner = make_msgpack_sample(state);
+    auto const* data = reinterpret_cast<uint8_t const*>(owner->bytes());
+    for (auto _ : state)
+    {
+        msgpack_reader reader{owner, data, owner->size()};
+        benchmark::DoNotOptimize(reader.read_dynamic());
+    }
+    set_counters(state, owner->size());
+}
+
+void
+BM_parse_msgpack_flat(benchmark::State& state)
+{
+    auto owner = make_msgpack_sample(state);
+    auto const* data = reinterpret_cast<uint8_t const*>(owner->bytes());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            parse_msgpack_flat_value(owner, data, owner->size()));
+    }
+    set_counters(state, owner->size());
+}
+
+void
+BM_parse_json_dynamic(benchmark::State& state)
+{
+    auto json = value_to_json(
+        make_sample_records(static_cast<int>(state.range(0))));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(parse_json_value(json));
+    }
+    set_counters(state, json.size());
+}
+
+void
+BM_parse_json_flat(benchmark::State& state)
+{
+    auto json = value_to_json(
+        make_sample_records(static_cast<int>(state.range(0))));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(parse_json_flat_value(json));
+    }
+    set_counters(state, json.size());
+}
+
+void
+BM_sum_doses_dynamic(benchmark::State& state)
+{
+    auto records = make_sample_records(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        double total = 0;
+        for (auto const& record : cast<dynamic_array>(records))
+        {
+            total += cast<double>(
+                get_field(cast<dynamic_map>(record), "dose"));
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void
+BM_sum_doses_flat(benchmark::State& state)
+{
+    auto records = make_flat_dynamic(
+        make_sample_records(static_cast<int>(state.range(0))));
+    for (auto _ : state)
+    {
+        double total = 0;
+        auto root = records.root();
+        for (size_t i = 0; i != root.size(); ++i)
+            total += root[i].get_field("dose").as_double();
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(BM_parse_msgpack_dynamic)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_parse_msgpack_flat)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_parse_json_dynamic)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_parse_json_flat)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_sum_doses_dynamic)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_sum_doses_flat)->Arg(1000)->Arg(100000);
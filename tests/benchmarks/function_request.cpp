@@ -1,9 +1,14 @@
 #include <benchmark/benchmark.h>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
 
 #include <cradle/inner/requests/function.h>
+#include <cradle/inner/requests/interning.h>
+#include <cradle/inner/requests/serialization.h>
 #include <cradle/inner/requests/value.h>
+#include <cradle/inner/resolve/seri_catalog.h>
 #include <cradle/inner/service/resources.h>
 
 #include "../support/inner_service.h"
@@ -308,3 +313,143 @@ BENCHMARK(BM_resolve_triangular_tree_erased_full<4>)
 BENCHMARK(BM_resolve_triangular_tree_erased_full<6>)
     ->Name("BM_resolve_function_request_disk_cached_tri_tree H=6")
     ->Apply(thousand_loops);
+
+// Request trees for the interning benchmarks. Each level has its own uuid,
+// shared by all nodes on that level, so that equal subtrees (and equal trees
+// created in different loops) are equal requests.
+template<caching_level_type level, int H>
+auto
+create_stable_tri_tree()
+{
+    request_props<level> props{
+        request_uuid{fmt::format("benchmark-stable-tri-{}", H)}};
+    if constexpr (H == 1)
+    {
+        return rq_function(props, add, 2, 1);
+    }
+    else
+    {
+        return rq_function(
+            props,
+            add,
+            create_stable_tri_tree<level, H - 1>(),
+            create_stable_tri_tree<level, H - 1>());
+    }
+}
+
+// Creates a request tree and resolves it, in each loop; like a client that
+// rebuilds its requests for each frame.
+template<caching_level_type level, int H, bool interned>
+void
+BM_rebuild_tri_tree(benchmark::State& state)
+{
+    auto resources{make_inner_test_resources(
+        {},
+        no_domain_option(),
+        service_config_map{
+            {inner_config_keys::REQUEST_INTERNING, interned}})};
+    request_resolution_context<level> ctx{*resources};
+    // The requests are created on this thread only
+    request_interning_scope scope{resources->get_request_intern_table()};
+    int num_loops = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        for (int i = 0; i < num_loops; ++i)
+        {
+            auto req{create_stable_tri_tree<level, H>()};
+            benchmark::DoNotOptimize(
+                cppcoro::sync_wait(resolve_request(ctx, req)));
+        }
+    }
+}
+
+BENCHMARK(BM_rebuild_tri_tree<caching_level_type::memory, 4, false>)
+    ->Name("BM_create_resolve_function_request_mem_cached_tri_tree H=4")
+    ->Apply(thousand_loops);
+BENCHMARK(BM_rebuild_tri_tree<caching_level_type::memory, 4, true>)
+    ->Name("BM_create_resolve_function_request_mem_cached_tri_tree H=4 "
+           "interned")
+    ->Apply(thousand_loops);
+BENCHMARK(BM_rebuild_tri_tree<caching_level_type::memory, 6, false>)
+    ->Name("BM_create_resolve_function_request_mem_cached_tri_tree H=6")
+    ->Apply(thousand_loops);
+BENCHMARK(BM_rebuild_tri_tree<caching_level_type::memory, 6, true>)
+    ->Name("BM_create_resolve_function_request_mem_cached_tri_tree H=6 "
+           "interned")
+    ->Apply(thousand_loops);
+
+// Request trees for the serialization benchmarks. All inner nodes in a tree
+// share one uuid, and so do all leaves, so that registering two requests
+// suffices for deserializing the entire tree.
+template<int H, bool thin>
+auto
+create_seri_tree()
+{
+    request_props<caching_level_type::none> props{request_uuid{
+        H == 1 ? "benchmark-seri-leaf"
+               : (thin ? "benchmark-seri-thin" : "benchmark-seri-tri")}};
+    if constexpr (H == 1)
+    {
+        return rq_function(props, add, 2, 1);
+    }
+    else if constexpr (thin)
+    {
+        return rq_function(props, add, create_seri_tree<H - 1, thin>(), 1);
+    }
+    else
+    {
+        return rq_function(
+            props,
+            add,
+            create_seri_tree<H - 1, thin>(),
+            create_seri_tree<H - 1, thin>());
+    }
+}
+
+template<request_format format, int H, bool thin>
+void
+BM_serialize_tree(benchmark::State& state)
+{
+    auto req{create_seri_tree<H, thin>()};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(serialize_request(req, format));
+    }
+    state.counters["bytes"] = static_cast<double>(
+        serialize_request(req, format).size());
+}
+
+template<request_format format, int H, bool thin>
+void
+BM_deserialize_tree(benchmark::State& state)
+{
+    auto resources{make_inner_test_resources()};
+    seri_catalog cat{resources->get_seri_registry()};
+    cat.register_resolver(create_seri_tree<1, thin>());
+    auto req{create_seri_tree<H, thin>()};
+    cat.register_resolver(req);
+    auto seri_req{serialize_request(req, format)};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            deserialize_request<decltype(req)>(*resources, seri_req));
+    }
+}
+
+BENCHMARK(BM_serialize_tree<request_format::json, 64, true>)
+    ->Name("BM_serialize_function_request_thin_tree H=64 JSON");
+BENCHMARK(BM_serialize_tree<request_format::msgpack, 64, true>)
+    ->Name("BM_serialize_function_request_thin_tree H=64 msgpack");
+BENCHMARK(BM_serialize_tree<request_format::json, 6, false>)
+    ->Name("BM_serialize_function_request_tri_tree H=6 JSON");
+BENCHMARK(BM_serialize_tree<request_format::msgpack, 6, false>)
+    ->Name("BM_serialize_function_request_tri_tree H=6 msgpack");
+
+BENCHMARK(BM_deserialize_tree<request_format::json, 64, true>)
+    ->Name("BM_deserialize_function_request_thin_tree H=64 JSON");
+BENCHMARK(BM_deserialize_tree<request_format::msgpack, 64, true>)
+    ->Name("BM_deserialize_function_request_thin_tree H=64 msgpack");
+BENCHMARK(BM_deserialize_tree<request_format::json, 6, false>)
+    ->Name("BM_deserialize_function_request_tri_tree H=6 JSON");
+BENCHMARK(BM_deserialize_tree<request_format::msgpack, 6, false>)
+    ->Name("BM_deserialize_function_request_tri_tree H=6 msgpack");
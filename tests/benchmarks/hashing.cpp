@@ -16,6 +16,7 @@
 
 #include <cradle/inner/core/get_unique_string.h>
 #include <cradle/inner/core/hash.h>
+#include <cradle/inner/core/type_interfaces.h>
 #include <cradle/inner/encodings/lz4.h>
 #include <cradle/plugins/domain/testing/requests.h>
 
@@ -25,9 +26,8 @@
 using namespace cradle;
 
 auto
-make_my_blob()
+make_my_blob(std::size_t size = 1000)
 {
-    std::size_t const size{1000};
     std::string proxy_name{};
     auto resources{
         make_inner_test_resources(proxy_name, testing_domain_option())};
@@ -95,6 +95,29 @@ BM_UniqueHashGetString(benchmark::State& state)
     }
 }
 
+// Unique hash over a plain blob of state.range(0) bytes, under the given
+// scheme.
+// If memoized, the blob has an owner, so that the chunk hashes over a large
+// blob are calculated in the first iteration only; otherwise, the blob has
+// no owner, and each iteration processes all bytes.
+template<unique_hash_scheme scheme, bool memoized = false>
+void
+BM_UniqueHashBlobSize(benchmark::State& state)
+{
+    auto size{static_cast<std::size_t>(state.range(0))};
+    auto owned_blob = make_my_blob(size);
+    auto the_blob = memoized
+                        ? owned_blob
+                        : make_static_blob(owned_blob.data(), size);
+    for (auto _ : state)
+    {
+        unique_hasher hasher{scheme};
+        update_unique_hash(hasher, the_blob);
+        benchmark::DoNotOptimize(hasher.get_result());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
 void
 BM_BoostCrc32(benchmark::State& state)
 {
@@ -141,6 +164,29 @@ BENCHMARK(BM_BoostHash);
 BENCHMARK(BM_CompareEqualBlobs);
 BENCHMARK(BM_UniqueHashGetResult);
 BENCHMARK(BM_UniqueHashGetString);
+// Sweeps from 1KB to 64MB; from 4MB, the chunked schemes hash in parallel
+BENCHMARK(BM_UniqueHashBlobSize<unique_hash_scheme::sha256>)
+    ->Name("BM_UniqueHashBlobSize sha256")
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 64 << 20)
+    ->UseRealTime();
+BENCHMARK(BM_UniqueHashBlobSize<unique_hash_scheme::sha256_chunked>)
+    ->Name("BM_UniqueHashBlobSize sha256_chunked")
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 64 << 20)
+    ->UseRealTime();
+BENCHMARK(BM_UniqueHashBlobSize<unique_hash_scheme::sha256_chunked, true>)
+    ->Name("BM_UniqueHashBlobSize sha256_chunked memoized")
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 64 << 20)
+    ->UseRealTime();
+#if defined(CRADLE_HAVE_BLAKE3)
+BENCHMARK(BM_UniqueHashBlobSize<unique_hash_scheme::blake3>)
+    ->Name("BM_UniqueHashBlobSize blake3")
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 64 << 20)
+    ->UseRealTime();
+#endif
 // Boost's CRC32 does not use hardware acceleration and is thus pretty slow;
 // even slower than hardware-accelerated SHA256.
 BENCHMARK(BM_BoostCrc32);
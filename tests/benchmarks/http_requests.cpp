@@ -0,0 +1,60 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/when_all.hpp>
+
+#include <cradle/inner/io/http_requests.h>
+#include <cradle/inner/service/resources.h>
+
+#include "../support/http_server.h"
+#include "../support/inner_service.h"
+
+using namespace cradle;
+
+/*
+ * Benchmark batches of concurrent HTTP requests to a local server, which
+ * delays each response by 1ms to simulate a remote cache.
+ *
+ * The "engine" variant multiplexes the requests on the async HTTP engine's
+ * single thread, over persistent connections; the "threads" variant performs
+ * each request on a thread from the HTTP thread pool, each with its own
+ * connection.
+ */
+
+static void
+BM_http_requests(benchmark::State& state, bool use_engine)
+{
+    auto batch_size = static_cast<int>(state.range(0));
+    local_http_server server{std::chrono::milliseconds{1}};
+    auto config_map{make_inner_tests_config().get_config_map()};
+    config_map[inner_config_keys::HTTP_ASYNC_ENGINE] = use_engine;
+    inner_resources resources{service_config{config_map}};
+    auto request = make_get_request(server.url("/cas/0"), http_header_list());
+    for (auto _ : state)
+    {
+        std::vector<cppcoro::task<http_response>> tasks;
+        for (int i = 0; i < batch_size; ++i)
+        {
+            tasks.push_back(resources.async_http_request(request));
+        }
+        benchmark::DoNotOptimize(
+            cppcoro::sync_wait(cppcoro::when_all(std::move(tasks))));
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+    state.counters["connections"] = server.num_connections();
+}
+BENCHMARK_CAPTURE(BM_http_requests, engine, true)
+    ->ArgName("batch")
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_http_requests, threads, false)
+    ->ArgName("batch")
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256)
+    ->UseRealTime();
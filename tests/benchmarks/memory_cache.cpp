@@ -0,0 +1,86 @@
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <cppcoro/shared_task.hpp>
+#include <cppcoro/sync_wait.hpp>
+
+#include <cradle/inner/caching/immutable.h>
+#include <cradle/inner/core/id.h>
+
+using namespace cradle;
+
+/*
+ * Benchmark memory cache hits from multiple threads.
+ *
+ * Each iteration creates a pointer to an existing (ready) cache record, and
+ * destroys it again; this acquires and releases the record's shard mutex.
+ * With a single shard, all threads contend on one mutex; with more shards,
+ * the aggregate hit throughput should scale with the number of threads.
+ */
+
+namespace {
+
+constexpr int num_keys = 1024;
+
+cppcoro::shared_task<void>
+record_int_task(untyped_immutable_cache_ptr& untyped_ptr, int value)
+{
+    auto& ptr = static_cast<immutable_cache_ptr<int>&>(untyped_ptr);
+    ptr.record_value(std::move(value));
+    co_return;
+}
+
+std::unique_ptr<immutable_cache> the_cache;
+std::vector<captured_id> the_keys;
+
+void
+set_up_cache(int num_shards)
+{
+    the_cache = std::make_unique<immutable_cache>(immutable_cache_config{
+        .unused_size_limit = 0x40'00'00'00, .num_shards = num_shards});
+    the_keys.clear();
+    for (int i = 0; i < num_keys; ++i)
+    {
+        the_keys.push_back(make_captured_id(i));
+        immutable_cache_ptr<int> ptr(
+            *the_cache,
+            the_keys.back(),
+            [i](untyped_immutable_cache_ptr& ptr) {
+                return record_int_task(ptr, i);
+            });
+        cppcoro::sync_wait(ptr.ensure_value_task());
+    }
+}
+
+} // namespace
+
+static void
+BM_memory_cache_hit_mt(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+    {
+        set_up_cache(static_cast<int>(state.range(0)));
+    }
+    // Threads start at different keys so that they mostly hit different
+    // records.
+    int key_ix = state.thread_index() * (num_keys / state.threads());
+    auto fail
+        = [](untyped_immutable_cache_ptr&) -> cppcoro::shared_task<void> {
+        throw std::logic_error("unexpected cache miss");
+    };
+    for (auto _ : state)
+    {
+        immutable_cache_ptr<int> ptr(*the_cache, the_keys[key_ix], fail);
+        benchmark::DoNotOptimize(ptr.get_value());
+        key_ix = (key_ix + 1) % num_keys;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_memory_cache_hit_mt)
+    ->ArgName("shards")
+    ->Arg(1)
+    ->Arg(16)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
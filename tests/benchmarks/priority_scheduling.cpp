@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <cppcoro/async_scope.hpp>
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
+
+#include <cradle/inner/service/work_stealing_pool.h>
+
+using namespace cradle;
+
+/*
+ * Measures the latency of interactive requests while a pool is loaded with
+ * background requests.
+ *
+ * A load thread keeps the pool's queue filled with background requests,
+ * each performing a chunk of work; there are always about four of them
+ * queued per pool thread. Each benchmark iteration schedules one interactive
+ * request, and measures the time until it has finished its (smaller) amount
+ * of work. The p50 and p99 latencies are reported as counters.
+ *
+ * The schedulers compared are:
+ * - fifo: cppcoro::static_thread_pool, ignoring priorities (as formerly used
+ *   for all pools in inner_resources)
+ * - priority: work_stealing_pool, resuming interactive work first
+ * - reserved: work_stealing_pool with one thread reserved for interactive
+ *   work
+ */
+
+namespace {
+
+using latency_clock = std::chrono::steady_clock;
+
+enum class scheduler_kind
+{
+    fifo,
+    priority,
+    reserved
+};
+
+int
+simulate_work(int amount)
+{
+    unsigned x = static_cast<unsigned>(amount);
+    for (int i = 0; i < amount; ++i)
+    {
+        x = x * 1664525u + 1013904223u;
+        benchmark::DoNotOptimize(x);
+    }
+    return static_cast<int>(x & 1);
+}
+
+auto
+schedule_with_hint(cppcoro::static_thread_pool& pool, schedule_hint)
+{
+    return pool.schedule();
+}
+
+auto
+schedule_with_hint(work_stealing_pool& pool, schedule_hint hint)
+{
+    return pool.schedule(hint);
+}
+
+template<typename Pool>
+cppcoro::task<void>
+resolve_background(
+    Pool& pool, int work, std::atomic<std::uint32_t>& num_queued)
+{
+    co_await schedule_with_hint(
+        pool, schedule_hint{request_priority::background});
+    num_queued -= 1;
+    simulate_work(work);
+}
+
+template<typename Pool>
+cppcoro::task<latency_clock::duration>
+resolve_interactive(Pool& pool, int work)
+{
+    auto start{latency_clock::now()};
+    co_await schedule_with_hint(
+        pool, schedule_hint{request_priority::interactive});
+    simulate_work(work);
+    co_return latency_clock::now() - start;
+}
+
+template<typename Pool>
+void
+measure_interactive_latency(
+    benchmark::State& state, Pool& pool, std::uint32_t num_threads)
+{
+    auto background_work{static_cast<int>(state.range(1))};
+    auto interactive_work{static_cast<int>(state.range(2))};
+    std::atomic<bool> stopping{false};
+    std::thread load_thread{[&] {
+        cppcoro::async_scope scope;
+        std::atomic<std::uint32_t> num_queued{0};
+        while (!stopping)
+        {
+            while (num_queued < num_threads * 4)
+            {
+                num_queued += 1;
+                scope.spawn(
+                    resolve_background(pool, background_work, num_queued));
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        cppcoro::sync_wait(scope.join());
+    }};
+    // Let the load build up
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::vector<double> latencies_us;
+    for (auto _ : state)
+    {
+        auto latency{
+            cppcoro::sync_wait(resolve_interactive(pool, interactive_work))};
+        auto seconds{std::chrono::duration<double>(latency).count()};
+        state.SetIterationTime(seconds);
+        latencies_us.push_back(seconds * 1e6);
+    }
+    stopping = true;
+    load_thread.join();
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    auto percentile = [&](std::size_t p) {
+        return latencies_us[(latencies_us.size() - 1) * p / 100];
+    };
+    state.counters["p50_us"] = percentile(50);
+    state.counters["p99_us"] = percentile(99);
+}
+
+template<scheduler_kind Kind>
+void
+BM_interactive_latency(benchmark::State& state)
+{
+    auto num_threads{static_cast<std::uint32_t>(state.range(0))};
+    if constexpr (Kind == scheduler_kind::fifo)
+    {
+        cppcoro::static_thread_pool pool{num_threads};
+        measure_interactive_latency(state, pool, num_threads);
+    }
+    else
+    {
+        std::uint32_t num_reserved{Kind == scheduler_kind::reserved ? 1u : 0u};
+        work_stealing_pool pool{num_threads, num_reserved};
+        measure_interactive_latency(state, pool, num_threads);
+    }
+}
+
+void
+latency_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"threads", "bg_work", "work"})
+        ->Args({4, 100000, 1000})
+        ->Args({4, 1000000, 1000})
+        ->Iterations(1000)
+        ->Unit(benchmark::kMicrosecond)
+        ->UseManualTime();
+}
+
+} // namespace
+
+BENCHMARK(BM_interactive_latency<scheduler_kind::fifo>)
+    ->Name("BM_interactive_latency fifo")
+    ->Apply(latency_args);
+BENCHMARK(BM_interactive_latency<scheduler_kind::priority>)
+    ->Name("BM_interactive_latency priority")
+    ->Apply(latency_args);
+BENCHMARK(BM_interactive_latency<scheduler_kind::reserved>)
+    ->Name("BM_interactive_latency reserved")
+    ->Apply(latency_args);
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <thread>
+
 #include <benchmark/benchmark.h>
 #include <cppcoro/sync_wait.hpp>
 
@@ -7,6 +10,8 @@
 #include <cradle/inner/requests/generic.h>
 #include <cradle/inner/resolve/resolve_request.h>
 #include <cradle/plugins/domain/testing/context.h>
+#include <cradle/rpclib/client/contained_proxy_pool.h>
+#include <cradle/rpclib/common/config.h>
 #include <cradle/test_dlls_dir.h>
 
 using namespace cradle;
@@ -45,3 +50,66 @@ BM_ResolveContained(benchmark::State& state)
 
 BENCHMARK(BM_ResolveUncontained);
 BENCHMARK(BM_ResolveContained);
+
+// Resolves a contained request locally; each call runs in a new contained
+// process, which is started on demand (cold), or was started in the
+// background by the warm pool.
+void
+BM_ResolveContainedFreshProcess(benchmark::State& state, bool warm)
+{
+    std::string proxy_name{""};
+    service_config_map extra_config{
+        {rpclib_config_keys::CONTAINED_MAX_CALLS, 1U}};
+    if (warm)
+    {
+        extra_config[rpclib_config_keys::CONTAINED_WARM_POOL_SIZE] = 1U;
+        extra_config[rpclib_config_keys::CONTAINED_PRELOAD_DLL_DIR]
+            = get_test_dlls_dir();
+        extra_config[rpclib_config_keys::CONTAINED_PRELOAD_DLLS]
+            = std::string{"test_inner_dll_v1"};
+    }
+    auto resources{make_inner_test_resources(
+        proxy_name, testing_domain_option(), extra_config)};
+    testing_request_context ctx{*resources, proxy_name};
+    auto req{rq_test_adder_v1p_impl(&v1_containment, 7, 2)};
+    for (auto _ : state)
+    {
+        if (warm)
+        {
+            // Don't measure the time needed to replenish the pool.
+            state.PauseTiming();
+            while (resources->get_contained_proxy_pool_info().num_idle == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(
+            cppcoro::sync_wait(resolve_request(ctx, req)));
+    }
+    auto info{resources->get_contained_proxy_pool_info()};
+    state.counters["hits"] = info.num_hits;
+    state.counters["misses"] = info.num_misses;
+    if (info.num_spawned > 0)
+    {
+        state.counters["spawn_ms"]
+            = std::chrono::duration<double, std::milli>(info.total_spawn_time)
+                  .count()
+              / info.num_spawned;
+    }
+}
+
+void
+BM_ResolveContainedCold(benchmark::State& state)
+{
+    BM_ResolveContainedFreshProcess(state, false);
+}
+
+void
+BM_ResolveContainedWarm(benchmark::State& state)
+{
+    BM_ResolveContainedFreshProcess(state, true);
+}
+
+BENCHMARK(BM_ResolveContainedCold)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ResolveContainedWarm)->Unit(benchmark::kMillisecond);
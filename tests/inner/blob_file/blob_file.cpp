@@ -95,12 +95,25 @@ TEST_CASE("allocate blob file", "[blob_file]")
     REQUIRE(blob1_file.filename() == "blob_1");
 }
 
+TEST_CASE("allocate blob file created by another process", "[blob_file]")
+{
+    fs::remove_all(cache_dir_path);
+    auto dir{make_blob_file_directory()};
+    // Simulate another process claiming the next files after the scan
+    touch(cache_dir_path / "blob_0");
+    touch(cache_dir_path / "blob_1");
+
+    auto blob_file{dir->allocate_file()};
+    REQUIRE(blob_file.filename() == "blob_2");
+    REQUIRE(fs::file_size(blob_file) == 0);
+}
+
 TEST_CASE("write/read blob file", "[blob_file]")
 {
     auto dir{make_blob_file_directory()};
     auto path{dir->allocate_file()};
 
-    REQUIRE(!fs::exists(path));
+    REQUIRE(fs::file_size(path) == 0);
 
     auto shared_writer{std::make_shared<blob_file_writer>(path, 5)};
     REQUIRE(fs::exists(path));
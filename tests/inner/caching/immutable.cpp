@@ -1,10 +1,16 @@
+#include <atomic>
+#include <chrono>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <catch2/catch.hpp>
 #include <cppcoro/sync_wait.hpp>
 
 #include <cradle/inner/caching/immutable.h>
+#include <cradle/inner/caching/immutable/eviction.h>
+#include <cradle/inner/caching/immutable/internals.h>
 #include <cradle/inner/caching/immutable/local_locked_record.h>
 #include <cradle/inner/core/get_unique_string.h>
 
@@ -267,6 +273,148 @@ TEST_CASE("immutable cache LRU eviction", tag)
     REQUIRE(await_cache_value(s) == std::string(1024, 'b'));
 }
 
+namespace {
+
+cppcoro::shared_task<void>
+slow_one_kb_string_task(untyped_immutable_cache_ptr& untyped_ptr, char content)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    using ptr_type = immutable_cache_ptr<std::string>;
+    auto& ptr = static_cast<ptr_type&>(untyped_ptr);
+    std::string result(1024, content);
+    ptr.record_value(std::move(result));
+    co_return;
+}
+
+// Obtains a pointer to the record for :key, and releases it again;
+// returns true if the value needed to be created.
+bool
+touch_one_kb_string(
+    immutable_cache& cache,
+    int key,
+    char content,
+    bool slow = false)
+{
+    bool needed_creation = false;
+    immutable_cache_ptr<std::string> ptr(
+        cache, make_captured_id(key), [&](untyped_immutable_cache_ptr& ptr) {
+            needed_creation = true;
+            return slow ? slow_one_kb_string_task(ptr, content)
+                        : one_kb_string_task(ptr, content);
+        });
+    REQUIRE(await_cache_value(ptr) == std::string(1024, content));
+    return needed_creation;
+}
+
+} // namespace
+
+TEST_CASE("immutable cache GDSF eviction", tag)
+{
+    // Only one of the two values fits.
+    immutable_cache cache(immutable_cache_config{
+        .unused_size_limit = 1536,
+        .eviction_policy = make_gdsf_eviction_policy()});
+
+    // ID(1) is expensive to compute; ID(2) is cheap, and released last.
+    REQUIRE(touch_one_kb_string(cache, 1, 'a', true));
+    REQUIRE(touch_one_kb_string(cache, 2, 'b'));
+
+    // LRU would evict ID(1); GDSF evicts ID(2).
+    REQUIRE(!touch_one_kb_string(cache, 1, 'a'));
+    REQUIRE(touch_one_kb_string(cache, 2, 'b'));
+
+    auto info{get_summary_info(cache)};
+    CHECK(info.hit_count == 1);
+    CHECK(info.recompute_cost_saved >= std::chrono::milliseconds(20));
+}
+
+TEST_CASE("immutable cache W-TinyLFU eviction", tag)
+{
+    // Room for four values, in a single shard
+    immutable_cache cache(immutable_cache_config{
+        .unused_size_limit = 4608,
+        .num_shards = 1,
+        .eviction_policy = make_w_tinylfu_eviction_policy()});
+
+    // ID(0) is popular. (Each ID gets a different value, so that each value
+    // has its own CAS record.)
+    REQUIRE(touch_one_kb_string(cache, 0, 'a'));
+    for (int i = 0; i < 5; ++i)
+    {
+        REQUIRE(!touch_one_kb_string(cache, 0, 'a'));
+    }
+
+    // A scan over IDs that are accessed only once should not evict ID(0),
+    // as it would under LRU.
+    for (int key = 1; key <= 8; ++key)
+    {
+        REQUIRE(touch_one_kb_string(cache, key, static_cast<char>('a' + key)));
+    }
+    REQUIRE(!touch_one_kb_string(cache, 0, 'a'));
+    REQUIRE(touch_one_kb_string(cache, 1, 'b'));
+}
+
+namespace {
+
+// Releases :num_records records into a W-TinyLFU shard, the odd ones being
+// popular, then evicts all of them; returns the keys in eviction order.
+// If :probe is true, the shard is asked for its next victim after each
+// release, as happens when other shards have a better candidate.
+std::vector<int>
+w_tinylfu_eviction_order(int num_records, bool probe)
+{
+    auto policy{make_w_tinylfu_eviction_policy()};
+    auto shard{policy->make_shard()};
+    std::vector<std::unique_ptr<detail::immutable_cache_record>> records;
+    for (int i = 0; i < num_records; ++i)
+    {
+        auto record{std::make_unique<detail::immutable_cache_record>()};
+        record->key = make_captured_id(i);
+        for (int j = 0; j < (i % 2) * 5; ++j)
+        {
+            policy->on_access(record->key->hash());
+        }
+        shard->add(*record);
+        records.push_back(std::move(record));
+        if (probe)
+        {
+            shard->next_victim();
+        }
+    }
+    std::vector<int> order;
+    while (auto* victim = shard->next_victim().record)
+    {
+        shard->remove(*victim, true);
+        for (int i = 0; i < num_records; ++i)
+        {
+            if (records[i].get() == victim)
+            {
+                order.push_back(i);
+            }
+        }
+    }
+    return order;
+}
+
+} // namespace
+
+TEST_CASE("immutable cache - W-TinyLFU victim proposals", tag)
+{
+    // Asking for a victim that then isn't evicted should not affect
+    // anything.
+    auto order{w_tinylfu_eviction_order(300, false)};
+    REQUIRE(order.size() == 300);
+    REQUIRE(w_tinylfu_eviction_order(300, true) == order);
+}
+
+TEST_CASE("immutable cache - eviction policy names", tag)
+{
+    CHECK(make_eviction_policy("lru")->name() == "lru");
+    CHECK(make_eviction_policy("gdsf")->name() == "gdsf");
+    CHECK(make_eviction_policy("w_tinylfu")->name() == "w_tinylfu");
+    CHECK_THROWS_AS(make_eviction_policy("fifo"), std::invalid_argument);
+}
+
 TEST_CASE("immutable cache record locking", tag)
 {
     immutable_cache cache(immutable_cache_config{1024});
@@ -643,3 +791,63 @@ TEST_CASE("immutable caching - retry failure", tag)
     auto info1{get_summary_info(cache)};
     CHECK(info1.cas_total_size == sizeof(int));
 }
+
+TEST_CASE("immutable cache - invalid number of shards", tag)
+{
+    REQUIRE_THROWS_AS(
+        immutable_cache{immutable_cache_config{.num_shards = 0}},
+        std::invalid_argument);
+}
+
+TEST_CASE("immutable cache - concurrent access across shards", tag)
+{
+    // Small enough to cause evictions while the threads are running
+    immutable_cache cache{
+        immutable_cache_config{.unused_size_limit = 64, .num_shards = 4}};
+    constexpr int num_threads = 8;
+    constexpr int num_keys = 100;
+    constexpr int num_loops = 20;
+    std::atomic<int> num_errors{0};
+
+    auto thread_func = [&](int thread_ix) {
+        for (int loop = 0; loop < num_loops; ++loop)
+        {
+            for (int i = 0; i < num_keys; ++i)
+            {
+                int key_ix = (i + thread_ix * 7) % num_keys;
+                immutable_cache_ptr<int> ptr(
+                    cache,
+                    make_captured_id(key_ix),
+                    [&](untyped_immutable_cache_ptr& ptr) {
+                        return test_task(ptr, key_ix * 3);
+                    });
+                if (await_cache_value(ptr) != key_ix * 3)
+                {
+                    num_errors += 1;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back(thread_func, i);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    CHECK(num_errors == 0);
+    auto info0{get_summary_info(cache)};
+    CHECK(info0.ac_num_records_in_use == 0);
+    CHECK(info0.hit_count + info0.miss_count
+          == num_threads * num_loops * num_keys);
+    CHECK(info0.cas_total_size <= 64);
+
+    clear_unused_entries(cache);
+    auto info1{get_summary_info(cache)};
+    CHECK(info1.ac_num_records == 0);
+    CHECK(info1.cas_num_records == 0);
+    CHECK(info1.cas_total_size == 0);
+}
@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <filesystem>
+#include <stdexcept>
 #include <vector>
 
 #include <catch2/catch.hpp>
@@ -255,4 +258,161 @@ TEST_CASE("unique_hash: vector edge case", tag)
     REQUIRE(get_unique_string_tmpl(a) != get_unique_string_tmpl(b));
 }
 
+TEST_CASE("unique_hash: parse scheme", tag)
+{
+    REQUIRE(parse_unique_hash_scheme("sha256") == unique_hash_scheme::sha256);
+    REQUIRE(
+        parse_unique_hash_scheme("sha256_chunked")
+        == unique_hash_scheme::sha256_chunked);
+#if defined(CRADLE_HAVE_BLAKE3)
+    REQUIRE(parse_unique_hash_scheme("blake3") == unique_hash_scheme::blake3);
+#else
+    REQUIRE_THROWS(parse_unique_hash_scheme("blake3"));
+#endif
+    REQUIRE_THROWS(parse_unique_hash_scheme("md5"));
+}
+
+TEST_CASE("unique_hash: scheme claims", tag)
+{
+    auto original{get_unique_hash_scheme()};
+    {
+        unique_hash_scheme_claim claim0{unique_hash_scheme::sha256_chunked};
+        REQUIRE(
+            get_unique_hash_scheme() == unique_hash_scheme::sha256_chunked);
+        unique_hash_scheme_claim claim1{unique_hash_scheme::sha256_chunked};
+        REQUIRE_THROWS_AS(
+            unique_hash_scheme_claim{unique_hash_scheme::sha256},
+            std::invalid_argument);
+        REQUIRE(
+            get_unique_hash_scheme() == unique_hash_scheme::sha256_chunked);
+    }
+    // No live claims remain, so a different scheme can be claimed.
+    {
+        unique_hash_scheme_claim claim{unique_hash_scheme::sha256};
+        REQUIRE(get_unique_hash_scheme() == unique_hash_scheme::sha256);
+    }
+    set_unique_hash_scheme(original);
+}
+
+TEST_CASE("unique_hash: sha256_chunked small blob", tag)
+{
+    // Below the parallel threshold, the hash equals the sha256 one, but the
+    // string has a version prefix.
+    std::string ref_data_string(ref_data, sizeof(ref_data));
+    auto val{make_blob(ref_data_string)};
+    unique_hasher ref_hasher{unique_hash_scheme::sha256};
+    update_unique_hash(ref_hasher, val);
+    unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+    update_unique_hash(hasher, val);
+
+    REQUIRE(hasher.get_result() == ref_hasher.get_result());
+    REQUIRE(hasher.get_string() == "v2-" + ref_hasher.get_string());
+}
+
+TEST_CASE("unique_hash: sha256_chunked large blob", tag)
+{
+    auto chunk_size{unique_hasher::parallel_chunk_size};
+    auto size{unique_hasher::parallel_threshold + chunk_size / 2};
+    std::string data(size, '\0');
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<char>(i * 7 + i / 1000);
+    }
+    auto val{make_blob(data)};
+
+    // The reference: a 0x02 tag, the blob size, and the hashes over the
+    // chunks
+    unique_hasher ref_hasher{unique_hash_scheme::sha256_chunked};
+    update_unique_hash(ref_hasher, uint8_t{0x02});
+    update_unique_hash(ref_hasher, static_cast<uint64_t>(size));
+    for (std::size_t offset = 0; offset < size; offset += chunk_size)
+    {
+        unique_hasher chunk_hasher{unique_hash_scheme::sha256_chunked};
+        chunk_hasher.encode_bytes(
+            data.data() + offset, std::min(chunk_size, size - offset));
+        ref_hasher.combine(chunk_hasher.get_result());
+    }
+
+    unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+    update_unique_hash(hasher, val);
+    REQUIRE(hasher.get_string() == ref_hasher.get_string());
+
+    // The original scheme hashes the data as a whole
+    unique_hasher sha256_hasher{unique_hash_scheme::sha256};
+    update_unique_hash(sha256_hasher, val);
+    REQUIRE(sha256_hasher.get_result() != hasher.get_result());
+}
+
+TEST_CASE("unique_hash: sha256_chunked memoized large blob", tag)
+{
+    auto size{unique_hasher::parallel_threshold + 1};
+    byte_vector data(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 7 + i / 1000);
+    }
+    auto val{make_blob(std::move(data))};
+    auto& owner{const_cast<data_owner&>(*val.owner())};
+    unique_hasher::result_t result0;
+    {
+        unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+        update_unique_hash(hasher, val);
+        result0 = hasher.get_result();
+    }
+
+    // The chunk hashes were memoized in the blob's owner. Modifying the data
+    // (which real code should never do) shows that they are used.
+    owner.data()[0] ^= 0xff;
+    {
+        unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+        update_unique_hash(hasher, val);
+        REQUIRE(hasher.get_result() == result0);
+    }
+
+    // The memoized hashes apply to the same range and scheme only.
+    blob shorter{val.shared_owner(), val.data(), size - 1};
+    {
+        unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+        update_unique_hash(hasher, val);
+        update_unique_hash(hasher, shorter);
+    }
+    {
+        unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+        update_unique_hash(hasher, val);
+        REQUIRE(hasher.get_result() != result0);
+    }
+
+    // Without an owner, nothing is memoized.
+    auto static_val{make_static_blob(val.data(), size)};
+    unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+    update_unique_hash(hasher, static_val);
+    REQUIRE(hasher.get_result() != result0);
+}
+
+TEST_CASE("unique_hash: memoize chunk hashes up front", tag)
+{
+    auto chunk_size{unique_hasher::parallel_chunk_size};
+    auto size{unique_hasher::parallel_threshold + chunk_size / 2};
+    byte_vector data(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 7 + i / 1000);
+    }
+    auto val{make_blob(std::move(data))};
+
+    // The reference: hashing the data without memoization
+    unique_hasher ref_hasher{unique_hash_scheme::sha256_chunked};
+    update_unique_hash(ref_hasher, make_static_blob(val.data(), size));
+
+    memoize_chunk_hashes(val, unique_hash_scheme::sha256_chunked);
+    REQUIRE(val.owner()->find_digest(data_owner::digest_key{
+        val.data(),
+        size,
+        static_cast<int>(unique_hash_scheme::sha256_chunked)}));
+
+    unique_hasher hasher{unique_hash_scheme::sha256_chunked};
+    update_unique_hash(hasher, val);
+    REQUIRE(hasher.get_result() == ref_hasher.get_result());
+}
+
 } // namespace cradle
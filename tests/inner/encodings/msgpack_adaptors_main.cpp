@@ -1,5 +1,6 @@
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <catch2/catch.hpp>
 #include <fmt/format.h>
@@ -9,6 +10,7 @@
 #include <cradle/inner/core/type_interfaces.h>
 #include <cradle/inner/encodings/msgpack_adaptors_main.h>
 #include <cradle/inner/encodings/msgpack_packer.h>
+#include <cradle/inner/encodings/msgpack_value.h>
 #include <cradle/inner/service/resources.h>
 
 using namespace cradle;
@@ -148,3 +150,23 @@ TEST_CASE(
     std::byte data[1]{};
     test_both_throw(blob(data, 0x1'00'00'00'00));
 }
+
+TEST_CASE(
+    "msgpack deserialize_value references large blobs (main)",
+    "[encodings][msgpack]")
+{
+    std::string large_string(min_referenced_bin_size, 'x');
+    auto large{make_blob(large_string)};
+    auto small{make_string_literal_blob("abcde")};
+    std::vector<blob> original{large, small};
+    bool const allow_blob_files{false};
+    auto serialized{serialize_value(original, allow_blob_files)};
+    REQUIRE(serialized.shared_owner());
+
+    auto result{deserialize_value<std::vector<blob>>(serialized)};
+
+    REQUIRE(result == original);
+    // The large blob shares the serialized data; the small one is a copy.
+    REQUIRE(result[0].shared_owner() == serialized.shared_owner());
+    REQUIRE(result[1].shared_owner() != serialized.shared_owner());
+}
@@ -0,0 +1,140 @@
+#include <vector>
+
+#include <catch2/catch.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/when_all.hpp>
+#include <fmt/format.h>
+
+#include <cradle/inner/blob_file/blob_file.h>
+#include <cradle/inner/core/type_interfaces.h>
+#include <cradle/inner/io/http_requests.h>
+
+#include "../../support/http_server.h"
+#include "../../support/inner_service.h"
+
+using namespace cradle;
+
+namespace {
+
+static char const tag[] = "[inner][io][http_requests]";
+
+std::string
+make_large_body()
+{
+    std::string body(5 << 20, '\0');
+    for (std::size_t i = 0; i < body.size(); ++i)
+    {
+        body[i] = static_cast<char>('a' + i % 23);
+    }
+    return body;
+}
+
+} // namespace
+
+TEST_CASE("concurrent async HTTP requests", tag)
+{
+    local_http_server server;
+    auto resources{make_inner_test_resources()};
+    constexpr int num_requests = 40;
+
+    std::vector<cppcoro::task<http_response>> tasks;
+    for (int i = 0; i < num_requests; ++i)
+    {
+        tasks.push_back(resources->async_http_request(make_get_request(
+            server.url(fmt::format("/item/{}", i)), http_header_list())));
+    }
+    auto responses = cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
+
+    for (int i = 0; i < num_requests; ++i)
+    {
+        REQUIRE(responses[i].status_code == 200);
+        REQUIRE(to_string(responses[i].body) == fmt::format("/item/{}", i));
+    }
+    REQUIRE(server.num_requests() == num_requests);
+    // The number of connections to a host is limited.
+    REQUIRE(server.num_connections() <= 32);
+}
+
+TEST_CASE("async HTTP requests reuse connections", tag)
+{
+    local_http_server server;
+    auto resources{make_inner_test_resources()};
+
+    for (int i = 0; i < 10; ++i)
+    {
+        auto response = cppcoro::sync_wait(resources->async_http_request(
+            make_get_request(server.url("/item"), http_header_list())));
+        REQUIRE(to_string(response.body) == "/item");
+    }
+    REQUIRE(server.num_connections() == 1);
+}
+
+TEST_CASE("async HTTP POST request", tag)
+{
+    local_http_server server;
+    auto resources{make_inner_test_resources()};
+
+    auto response = cppcoro::sync_wait(
+        resources->async_http_request(make_http_request(
+            http_request_method::POST,
+            server.url("/echo"),
+            http_header_list(),
+            make_blob("some body"))));
+
+    REQUIRE(response.status_code == 200);
+    REQUIRE(to_string(response.body) == "some body");
+}
+
+TEST_CASE("async HTTP request with bad status code", tag)
+{
+    local_http_server server;
+    auto resources{make_inner_test_resources()};
+
+    REQUIRE_THROWS_AS(
+        cppcoro::sync_wait(resources->async_http_request(
+            make_get_request(server.url("/status/404"), http_header_list()))),
+        bad_http_status_code);
+}
+
+TEST_CASE("async HTTP request with large response", tag)
+{
+    local_http_server server;
+    auto resources{make_inner_test_resources()};
+    auto body{make_large_body()};
+
+    auto response = cppcoro::sync_wait(
+        resources->async_http_request(make_http_request(
+            http_request_method::POST,
+            server.url("/echo"),
+            http_header_list(),
+            make_blob(body))));
+
+    REQUIRE(response.status_code == 200);
+    REQUIRE(response.body.mapped_file_data_owner() == nullptr);
+    REQUIRE(to_string(response.body) == body);
+}
+
+TEST_CASE("async HTTP response received into blob file", tag)
+{
+    local_http_server server;
+    auto resources{make_inner_test_resources()};
+    auto body{make_large_body()};
+    auto request{make_http_request(
+        http_request_method::POST,
+        server.url("/echo"),
+        http_header_list(),
+        make_blob(body))};
+    std::size_t owner_size{0};
+    request.body_owner_factory = [&](std::size_t size) {
+        owner_size = size;
+        return resources->make_blob_file_writer(size);
+    };
+
+    auto response = cppcoro::sync_wait(
+        resources->async_http_request(std::move(request)));
+
+    REQUIRE(response.status_code == 200);
+    REQUIRE(owner_size == body.size());
+    REQUIRE(response.body.mapped_file_data_owner() != nullptr);
+    REQUIRE(to_string(response.body) == body);
+}
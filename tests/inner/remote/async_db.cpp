@@ -0,0 +1,103 @@
+#include <memory>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "../../support/inner_service.h"
+#include <cradle/inner/remote/async_db.h>
+#include <cradle/inner/remote/async_exceptions.h>
+#include <cradle/plugins/domain/testing/context.h>
+
+using namespace cradle;
+
+namespace {
+
+static char const tag[] = "[inner][remote][async_db]";
+
+// A root context with a number of value subcontexts
+struct test_tree
+{
+    std::shared_ptr<root_local_atst_context> root;
+    std::vector<std::shared_ptr<non_root_local_atst_context>> subs;
+};
+
+test_tree
+make_test_tree(inner_resources& resources, async_db& db, int num_subs)
+{
+    test_tree tree;
+    tree.root = std::make_shared<root_local_atst_context>(
+        std::make_unique<local_tree_context_base>(resources),
+        static_cast<tasklet_tracker*>(nullptr));
+    db.add(tree.root);
+    auto& tree_ctx{tree.root->get_tree_context()};
+    for (int i = 0; i < num_subs; ++i)
+    {
+        auto sub{std::make_shared<non_root_local_atst_context>(
+            tree_ctx, tree.root.get(), false, nullptr)};
+        db.add(sub);
+        tree.subs.push_back(std::move(sub));
+    }
+    return tree;
+}
+
+} // namespace
+
+TEST_CASE("async_db find", tag)
+{
+    auto resources{make_inner_test_resources()};
+    async_db db;
+    auto tree{make_test_tree(*resources, db, 3)};
+
+    REQUIRE(db.size() == 4);
+    REQUIRE(db.find(tree.root->get_id()) == tree.root);
+    REQUIRE(db.find_root(tree.root->get_id()) == tree.root);
+    for (auto const& sub : tree.subs)
+    {
+        REQUIRE(db.find(sub->get_id()) == sub);
+        REQUIRE_THROWS_AS(db.find_root(sub->get_id()), bad_async_id_error);
+    }
+    REQUIRE_THROWS_AS(db.find(0), bad_async_id_error);
+}
+
+TEST_CASE("async_db remove_tree", tag)
+{
+    auto resources{make_inner_test_resources()};
+    async_db db;
+    auto tree0{make_test_tree(*resources, db, 3)};
+    auto tree1{make_test_tree(*resources, db, 2)};
+    REQUIRE(db.size() == 7);
+
+    db.remove_tree(tree0.root->get_id());
+
+    REQUIRE(db.size() == 3);
+    REQUIRE_THROWS_AS(db.find(tree0.root->get_id()), bad_async_id_error);
+    for (auto const& sub : tree0.subs)
+    {
+        REQUIRE_THROWS_AS(db.find(sub->get_id()), bad_async_id_error);
+    }
+    REQUIRE(db.find_root(tree1.root->get_id()) == tree1.root);
+    for (auto const& sub : tree1.subs)
+    {
+        REQUIRE(db.find(sub->get_id()) == sub);
+    }
+    REQUIRE_THROWS_AS(
+        db.remove_tree(tree0.root->get_id()), bad_async_id_error);
+}
+
+TEST_CASE("async_db add to removed tree", tag)
+{
+    auto resources{make_inner_test_resources()};
+    async_db db;
+    auto tree{make_test_tree(*resources, db, 2)};
+    db.remove_tree(tree.root->get_id());
+    REQUIRE(db.size() == 0);
+
+    // A late sub context (e.g., created while a cancelled resolution winds
+    // down) must not linger in the database.
+    auto late{std::make_shared<non_root_local_atst_context>(
+        tree.root->get_tree_context(), tree.root.get(), false, nullptr)};
+    db.add(late);
+
+    REQUIRE(db.size() == 0);
+    REQUIRE_THROWS_AS(db.find(late->get_id()), bad_async_id_error);
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <fmt/format.h>
+
+#include "../../support/inner_service.h"
+#include <cradle/inner/requests/function.h>
+#include <cradle/inner/requests/interning.h>
+
+using namespace cradle;
+
+namespace {
+
+static char const tag[] = "[inner][requests][interning]";
+
+static auto add2 = [](int a, int b) { return a + b; };
+
+request_uuid
+make_test_uuid(int ext)
+{
+    return request_uuid{fmt::format("{}-{:04d}", tag, ext)};
+}
+
+std::unique_ptr<inner_resources>
+make_interning_resources()
+{
+    return make_inner_test_resources(
+        {},
+        no_domain_option(),
+        service_config_map{{inner_config_keys::REQUEST_INTERNING, true}});
+}
+
+template<typename Req>
+id_interface const*
+impl_of(Req const& req)
+{
+    return &*req.get_captured_id();
+}
+
+auto
+make_tree(int leaf_arg)
+{
+    request_props<caching_level_type::memory> props0{make_test_uuid(400)};
+    request_props<caching_level_type::memory> props1{make_test_uuid(401)};
+    auto leaf0{rq_function(props0, add2, leaf_arg, 2)};
+    auto leaf1{rq_function(props0, add2, 3, 4)};
+    return rq_function(props1, add2, leaf0, leaf1);
+}
+
+} // namespace
+
+TEST_CASE("request interning: identical trees share objects", tag)
+{
+    auto resources{make_interning_resources()};
+    request_interning_scope scope{resources->get_request_intern_table()};
+    auto tree_a{make_tree(1)};
+    auto tree_b{make_tree(1)};
+    auto tree_c{make_tree(2)};
+
+    REQUIRE(impl_of(tree_a) == impl_of(tree_b));
+    REQUIRE(tree_a == tree_b);
+    REQUIRE(tree_a.hash() == tree_b.hash());
+    REQUIRE(impl_of(tree_a) != impl_of(tree_c));
+    REQUIRE(tree_a != tree_c);
+    REQUIRE((tree_a < tree_c || tree_c < tree_a));
+
+    non_caching_request_resolution_context ctx{*resources};
+    REQUIRE(cppcoro::sync_wait(tree_a.resolve(ctx, nullptr)) == 10);
+    REQUIRE(cppcoro::sync_wait(tree_c.resolve(ctx, nullptr)) == 11);
+}
+
+TEST_CASE("request interning: disabled", tag)
+{
+    auto resources{make_inner_test_resources()};
+    REQUIRE(resources->get_request_intern_table() == nullptr);
+    request_interning_scope scope{resources->get_request_intern_table()};
+    auto tree_a{make_tree(1)};
+    auto tree_b{make_tree(1)};
+
+    REQUIRE(impl_of(tree_a) != impl_of(tree_b));
+    REQUIRE(tree_a == tree_b);
+}
+
+TEST_CASE("request interning: outside scope", tag)
+{
+    auto resources{make_interning_resources()};
+    auto tree_a{make_tree(1)};
+    auto tree_b{make_tree(1)};
+
+    REQUIRE(impl_of(tree_a) != impl_of(tree_b));
+    REQUIRE(resources->get_request_intern_table()->size() == 0);
+}
+
+TEST_CASE("request interning: per-resources tables", tag)
+{
+    auto resources0{make_interning_resources()};
+    auto resources1{make_interning_resources()};
+    auto make_tree_in = [](inner_resources& resources) {
+        request_interning_scope scope{resources.get_request_intern_table()};
+        return make_tree(1);
+    };
+    auto tree_a{make_tree_in(*resources0)};
+    auto tree_b{make_tree_in(*resources1)};
+
+    REQUIRE(impl_of(tree_a) != impl_of(tree_b));
+    // Objects interned in different tables are compared in full
+    REQUIRE(tree_a == tree_b);
+    REQUIRE(impl_of(make_tree_in(*resources0)) == impl_of(tree_a));
+}
+
+TEST_CASE("request interning: purge", tag)
+{
+    auto resources{make_interning_resources()};
+    auto& table{*resources->get_request_intern_table()};
+    request_interning_scope scope{&table};
+    request_props<caching_level_type::memory> props0{make_test_uuid(404)};
+    request_props<caching_level_type::memory> props1{make_test_uuid(405)};
+    auto req0_a{rq_function(props0, add2, 1, 2)};
+    auto req1_a{rq_function(props1, add2, 1, 2)};
+
+    table.purge({make_test_uuid(404).str()});
+    REQUIRE(table.size() == 1);
+    auto req0_b{rq_function(props0, add2, 1, 2)};
+    auto req1_b{rq_function(props1, add2, 1, 2)};
+
+    // req0_b no longer shares req0_a's object, but they are still equal
+    REQUIRE(impl_of(req0_a) != impl_of(req0_b));
+    REQUIRE(req0_a == req0_b);
+    REQUIRE(impl_of(req1_a) == impl_of(req1_b));
+}
+
+TEST_CASE("request interning: set_containment", tag)
+{
+    auto resources{make_interning_resources()};
+    request_interning_scope scope{resources->get_request_intern_table()};
+    request_props<caching_level_type::memory> props{make_test_uuid(402)};
+    auto req_a{rq_function(props, add2, 1, 2)};
+    auto req_b{rq_function(props, add2, 1, 2)};
+    REQUIRE(impl_of(req_a) == impl_of(req_b));
+
+    // req_a gets its own object, so that req_b does not become contained
+    req_a.set_containment(
+        containment_data{make_test_uuid(403), "dll_dir", "dll_name"});
+    REQUIRE(impl_of(req_a) != impl_of(req_b));
+    REQUIRE(req_a == req_b);
+}
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <functional>
 #include <thread>
 
@@ -225,6 +226,31 @@ TEST_CASE("resolve async on loopback", tag)
     test_resolve_async_across_rpc(*resources, proxy_name);
 }
 
+TEST_CASE("resolve async on loopback from the only async thread", tag)
+{
+    // The client waits for the remote on the only thread of the async pool,
+    // which the remote needs as well; so waiting must not block the thread.
+    std::string proxy_name{"loopback"};
+    auto resources{make_inner_test_resources(
+        proxy_name,
+        testing_domain_option(),
+        {{inner_config_keys::ASYNC_CONCURRENCY, 1U}})};
+    auto& pool{resources->get_async_thread_pool()};
+
+    cppcoro::sync_wait([&]() -> cppcoro::task<void> {
+        co_await pool.schedule();
+        constexpr int loops = 3;
+        constexpr auto level = caching_level_type::memory;
+        auto req{rq_cancellable_coro<level>(
+            rq_cancellable_coro<level>(loops, 5),
+            rq_cancellable_coro<level>(loops, 60))};
+        ResolutionConstraintsRemoteAsync constraints;
+        atst_context ctx{*resources, proxy_name};
+        co_await test_resolve_async_coro(
+            ctx, req, constraints, true, loops, 5, 60);
+    }());
+}
+
 TEST_CASE("resolve async on rpclib", tag)
 {
     std::string proxy_name{"rpclib"};
@@ -638,4 +664,31 @@ TEST_CASE("resolve proxy async on rpclib", tag)
     test_resolve_async(ctx, req, constraints, true, loops, delay0, delay1);
 }
 
+TEST_CASE("wait for async status change", tag)
+{
+    auto resources{make_inner_test_resources()};
+    auto tree_ctx{std::make_unique<local_tree_context_base>(*resources)};
+    root_local_atst_context ctx{std::move(tree_ctx), nullptr};
+    REQUIRE(ctx.get_status() == async_status::CREATED);
+
+    // Without a status change, the wait times out.
+    REQUIRE(
+        ctx.wait_status_change(
+            async_status::CREATED, std::chrono::milliseconds{10})
+        == async_status::CREATED);
+
+    // A status change ends the wait, well before the timeout.
+    std::thread updater{[&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        ctx.update_status(async_status::SELF_RUNNING);
+    }};
+    auto start{std::chrono::steady_clock::now()};
+    auto status{ctx.wait_status_change(
+        async_status::CREATED, std::chrono::seconds{10})};
+    auto elapsed{std::chrono::steady_clock::now() - start};
+    updater.join();
+    REQUIRE(status == async_status::SELF_RUNNING);
+    REQUIRE(elapsed < std::chrono::seconds{5});
+}
+
 } // namespace cradle
@@ -8,6 +8,8 @@
 #include <cradle/inner/requests/generic.h>
 #include <cradle/inner/resolve/resolve_request.h>
 #include <cradle/plugins/domain/testing/context.h>
+#include <cradle/rpclib/client/contained_proxy_pool.h>
+#include <cradle/rpclib/common/config.h>
 #include <cradle/test_dlls_dir.h>
 
 namespace cradle {
@@ -349,6 +351,76 @@ TEST_CASE("resolve contained local - memory cached", tag)
     test_contained_caching<caching_level_type::memory>();
 }
 
+namespace {
+
+// Waits until the warm pool contains the expected number of idle processes.
+void
+wait_for_idle_proxies(inner_resources& resources, int expected)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        if (resources.get_contained_proxy_pool_info().num_idle >= expected)
+        {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    FAIL("no idle contained processes");
+}
+
+} // namespace
+
+TEST_CASE("resolve contained - warm pool", tag)
+{
+    std::string proxy_name{""};
+    auto resources{make_inner_test_resources(
+        proxy_name,
+        testing_domain_option(),
+        {{rpclib_config_keys::CONTAINED_WARM_POOL_SIZE, 1U},
+         {rpclib_config_keys::CONTAINED_PRELOAD_DLL_DIR, get_test_dlls_dir()},
+         {rpclib_config_keys::CONTAINED_PRELOAD_DLLS,
+          std::string{"test_inner_dll_v1"}},
+         {rpclib_config_keys::CONTAINED_MAX_CALLS, 1U}})};
+    testing_request_context ctx{*resources, proxy_name};
+    auto req{rq_test_adder_v1p_impl(&v1_containment, 7, 2)};
+
+    // A process is started in the background.
+    wait_for_idle_proxies(*resources, 1);
+    auto info0{resources->get_contained_proxy_pool_info()};
+    REQUIRE(info0.num_spawned == 1);
+    REQUIRE(info0.num_hits == 0);
+    REQUIRE(info0.num_misses == 0);
+
+    // Each call is executed by a warm process, which is replaced
+    // afterwards.
+    constexpr int num_calls{3};
+    for (int i = 0; i < num_calls; ++i)
+    {
+        wait_for_idle_proxies(*resources, 1);
+        REQUIRE(cppcoro::sync_wait(resolve_request(ctx, req)) == 7 + 2);
+    }
+    wait_for_idle_proxies(*resources, 1);
+    auto info1{resources->get_contained_proxy_pool_info()};
+    REQUIRE(info1.num_idle == 1);
+    REQUIRE(info1.num_hits == num_calls);
+    REQUIRE(info1.num_misses == 0);
+    REQUIRE(info1.num_recycled == num_calls);
+    REQUIRE(info1.num_spawned == num_calls + 1);
+    REQUIRE(info1.max_spawn_time > std::chrono::nanoseconds{0});
+}
+
+TEST_CASE("resolve contained - shared memory", tag)
+{
+    // Pass all requests and results via shared memory.
+    std::string proxy_name{""};
+    auto resources{make_inner_test_resources(
+        proxy_name,
+        testing_domain_option(),
+        {{rpclib_config_keys::SHARED_MEMORY_THRESHOLD, 1U}})};
+    testing_request_context ctx{*resources, proxy_name};
+    test_contained_all(ctx, proxy_name);
+}
+
 TEST_CASE("resolve contained - submit_async failure", tag)
 {
     std::string proxy_name{""};
@@ -165,8 +165,8 @@ busy_thread_func(
     }
 }
 
-// When too many rpclib server handler threads are busy, a following
-// resolve_sync request should immediately fail.
+// When the rpclib server's admission queue for resolve_sync requests is
+// full, a following resolve_sync request should immediately fail.
 TEST_CASE("rpclib server busy on many parallel resolve_sync requests", tag)
 {
     std::string proxy_name{"rpclib"};
@@ -174,9 +174,10 @@ TEST_CASE("rpclib server busy on many parallel resolve_sync requests", tag)
         make_inner_test_resources(proxy_name, testing_domain_option())};
     testing_request_context ctx{*resources, proxy_name};
 
-    // Send lots of resolve_sync requests to the server, until it starts
-    // responding with "busy" errors.
-    constexpr int max_attempts{80};
+    // Send lots of resolve_sync requests to the server, faster than it can
+    // resolve them, until it starts responding with "busy" errors.
+    // The server resolves 16 requests at a time, and queues up to 16 more.
+    constexpr int max_attempts{200};
     std::vector<std::jthread> threads;
     busy_progress progress;
     for (int attempt = 0; attempt < max_attempts; ++attempt)
@@ -185,7 +186,7 @@ TEST_CASE("rpclib server busy on many parallel resolve_sync requests", tag)
             busy_thread_func, std::ref(ctx), attempt, std::ref(progress));
         if ((attempt + 1) % 8 == 0)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
         if (progress.error_occurred())
         {
@@ -193,13 +194,12 @@ TEST_CASE("rpclib server busy on many parallel resolve_sync requests", tag)
         }
     }
     REQUIRE(progress.error_occurred());
-    REQUIRE(
-        progress.error_message().find(
-            "all threads for this request type are busy")
-        != std::string::npos);
+    // Depending on timing, the handler thread pool or the admission queue
+    // rejects the request.
+    REQUIRE(progress.error_message().find("busy") != std::string::npos);
 
-    // Wait until at least one server thread has become idle again.
-    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    // Wait until the queued requests have been resolved.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
 
     // The server should now accept new resolve_sync requests.
     auto [actual, expected] = resolve_busy_request(ctx, 1);
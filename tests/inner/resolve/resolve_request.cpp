@@ -441,6 +441,55 @@ TEST_CASE("evaluate function request - memory cache behavior", tag)
     CHECK(info3.cas_num_records == 1);
 }
 
+TEST_CASE("evaluate function request - shared result", tag)
+{
+    auto resources{make_inner_test_resources()};
+    auto& mem_cache{resources->memory_cache()};
+    request_props<caching_level_type::memory> props{make_test_uuid(610)};
+    std::atomic<int> num_add_calls{};
+    auto add{create_adder(num_add_calls)};
+    auto req{rq_function(props, add, 6, 3)};
+    caching_request_resolution_context ctx{*resources};
+
+    // The first resolution stores the result in the memory cache.
+    auto res0 = cppcoro::sync_wait(resolve_request_shared(ctx, req));
+    REQUIRE(*res0 == 9);
+    REQUIRE(num_add_calls == 1);
+
+    // The second resolution hits the memory cache, and returns a pointer to
+    // the same value.
+    auto res1 = cppcoro::sync_wait(resolve_request_shared(ctx, req));
+    REQUIRE(*res1 == 9);
+    REQUIRE(num_add_calls == 1);
+    REQUIRE(res1.get() == res0.get());
+    CHECK(get_summary_info(mem_cache).hit_count == 1);
+
+    // Copy semantics remain available.
+    REQUIRE(cppcoro::sync_wait(resolve_request(ctx, req)) == 9);
+    REQUIRE(num_add_calls == 1);
+
+    // The shared value outlives its cache record.
+    clear_unused_entries(mem_cache);
+    CHECK(get_summary_info(mem_cache).cas_num_records == 0);
+    REQUIRE(*res0 == 9);
+}
+
+TEST_CASE("evaluate function request - shared result, uncached", tag)
+{
+    auto resources{make_inner_test_resources()};
+    request_props<caching_level_type::none> props{make_test_uuid(611)};
+    std::atomic<int> num_add_calls{};
+    auto add{create_adder(num_add_calls)};
+    auto req{rq_function(props, add, 6, 3)};
+    non_caching_request_resolution_context ctx{*resources};
+
+    auto res0 = cppcoro::sync_wait(resolve_request_shared(ctx, req));
+    REQUIRE(*res0 == 9);
+    auto res1 = cppcoro::sync_wait(resolve_request_shared(ctx, req));
+    REQUIRE(*res1 == 9);
+    REQUIRE(num_add_calls == 2);
+}
+
 TEST_CASE("evaluate function request - lock cache record", tag)
 {
     auto resources{make_inner_test_resources()};
@@ -970,3 +1019,32 @@ TEST_CASE("resolve outer blob file - full - disallow", tag)
 {
     test_resolve_outer_blob_file(false);
 }
+
+TEST_CASE("evaluate function request tree - prefetched", tag)
+{
+    auto resources{make_inner_test_resources()};
+    request_props<caching_level_type::full> props0{make_test_uuid(620)};
+    request_props<caching_level_type::full> props1{make_test_uuid(621)};
+    std::atomic<int> num_add_calls{};
+    auto add{create_adder(num_add_calls)};
+    auto req0{rq_function(props0, add, 1, 2)};
+    auto req1{rq_function(props1, add, req0, 3)};
+    caching_request_resolution_context ctx{*resources};
+
+    REQUIRE(cppcoro::sync_wait(resolve_request(ctx, req1)) == 6);
+    sync_wait_write_disk_cache(*resources);
+    REQUIRE(num_add_calls == 2);
+
+    // New memory cache, same disk cache
+    resources->reset_memory_cache();
+
+    // Prefetching puts the values from the disk cache in the memory cache,
+    // so that the resolution finds the main request's value there.
+    REQUIRE(cppcoro::sync_wait(resolve_request_prefetched(ctx, req1)) == 6);
+    REQUIRE(num_add_calls == 2);
+    // Both values were inserted by the prefetch; the resolution hits the
+    // main request's value.
+    auto info{get_summary_info(resources->memory_cache())};
+    CHECK(info.miss_count == 2);
+    CHECK(info.hit_count == 1);
+}
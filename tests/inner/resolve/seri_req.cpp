@@ -24,7 +24,9 @@ using namespace cradle;
 static char const tag[] = "[inner][resolve][seri_req]";
 
 static void
-test_resolve(std::string const& proxy_name)
+test_resolve(
+    std::string const& proxy_name,
+    request_format format = request_format::json)
 {
     auto resources{
         make_inner_test_resources(proxy_name, testing_domain_option())};
@@ -32,7 +34,8 @@ test_resolve(std::string const& proxy_name)
 
     constexpr auto caching_level{caching_level_type::full};
     auto req{rq_make_some_blob<caching_level>(256, false)};
-    std::string seri_req{serialize_request(req)};
+    std::string seri_req{serialize_request(req, format)};
+    REQUIRE(detect_request_format(seri_req) == format);
     auto seri_resp
         = cppcoro::sync_wait(resolve_serialized_request(ctx, seri_req));
     blob response = deserialize_value<blob>(seri_resp.value());
@@ -57,6 +60,23 @@ TEST_CASE("resolve serialized request, rpclib", tag)
     test_resolve("rpclib");
 }
 
+TEST_CASE("resolve msgpack-serialized request, locally", tag)
+{
+    test_resolve("", request_format::msgpack);
+}
+
+// The loopback has its own resources, which the request must be deserialized
+// with.
+TEST_CASE("resolve msgpack-serialized request, loopback", tag)
+{
+    test_resolve("loopback", request_format::msgpack);
+}
+
+TEST_CASE("resolve msgpack-serialized request, rpclib", tag)
+{
+    test_resolve("rpclib", request_format::msgpack);
+}
+
 TEST_CASE("resolve serialized request, DLL", tag)
 {
     std::string proxy_name{""};
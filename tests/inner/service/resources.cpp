@@ -31,6 +31,12 @@ class test_proxy : public remote_proxy
         throw not_implemented_error{"test_proxy::get_logger()"};
     }
 
+    request_format
+    get_request_format() const override
+    {
+        return request_format::msgpack;
+    }
+
     void
     store_request(
         std::string storage_name,
@@ -73,6 +79,15 @@ class test_proxy : public remote_proxy
         throw not_implemented_error{"test_proxy::get_async_status()"};
     }
 
+    async_status
+    wait_async_status(
+        async_id aid,
+        async_status known_status,
+        std::chrono::milliseconds timeout) override
+    {
+        throw not_implemented_error{"test_proxy::wait_async_status()"};
+    }
+
     std::string
     get_async_error_message(async_id aid) override
     {
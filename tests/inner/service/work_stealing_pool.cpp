@@ -0,0 +1,164 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
+#include <cppcoro/when_all.hpp>
+
+#include <cradle/inner/service/work_stealing_pool.h>
+
+using namespace cradle;
+
+namespace {
+
+static char const tag[] = "[inner][service][work_stealing_pool]";
+
+// Resolves a binary tree of the given height, rescheduling all but the last
+// subtree like local_async_context_base::reschedule_if_opportune() does.
+cppcoro::task<int>
+resolve_tree(
+    work_stealing_pool& pool, int height, std::atomic<int>* parent_not_running)
+{
+    int result{1};
+    if (height > 1)
+    {
+        std::atomic<int> not_running{2};
+        std::vector<cppcoro::task<int>> subs;
+        subs.push_back(resolve_tree(pool, height - 1, &not_running));
+        subs.push_back(resolve_tree(pool, height - 1, &not_running));
+        for (auto sub_result : co_await cppcoro::when_all(std::move(subs)))
+        {
+            result += sub_result;
+        }
+    }
+    if (parent_not_running && parent_not_running->fetch_sub(1) > 1)
+    {
+        co_await pool.schedule();
+    }
+    co_return result;
+}
+
+} // namespace
+
+TEST_CASE("work_stealing_pool resolve tree", tag)
+{
+    work_stealing_pool pool{4};
+    REQUIRE(pool.thread_count() == 4);
+
+    auto main_task = [&]() -> cppcoro::task<int> {
+        co_await pool.schedule();
+        co_return co_await resolve_tree(pool, 12, nullptr);
+    };
+    REQUIRE(cppcoro::sync_wait(main_task()) == (1 << 12) - 1);
+}
+
+TEST_CASE("work_stealing_pool schedule from outside", tag)
+{
+    work_stealing_pool pool{2};
+    std::atomic<int> num_done{0};
+    auto task = [&]() -> cppcoro::task<std::thread::id> {
+        co_await pool.schedule();
+        num_done += 1;
+        co_return std::this_thread::get_id();
+    };
+    std::vector<cppcoro::task<std::thread::id>> tasks;
+    for (int i = 0; i < 100; ++i)
+    {
+        tasks.push_back(task());
+    }
+    auto thread_ids = cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
+    REQUIRE(num_done == 100);
+    for (auto thread_id : thread_ids)
+    {
+        REQUIRE(thread_id != std::this_thread::get_id());
+    }
+}
+
+TEST_CASE("work_stealing_pool schedule hints", tag)
+{
+    using namespace std::chrono_literals;
+    // A single worker thread resumes the coroutines one by one.
+    work_stealing_pool pool{1};
+    std::promise<void> started_promise;
+    std::promise<void> release_promise;
+    auto release_future{release_promise.get_future()};
+    std::mutex order_mutex;
+    std::vector<int> order;
+
+    // Keeps the worker busy until all other coroutines have been scheduled
+    auto blocker = [&]() -> cppcoro::task<void> {
+        co_await pool.schedule();
+        started_promise.set_value();
+        release_future.wait();
+    };
+    std::thread blocker_thread{[&] { cppcoro::sync_wait(blocker()); }};
+    started_promise.get_future().wait();
+
+    auto task = [&](int id, schedule_hint hint) -> cppcoro::task<void> {
+        co_await pool.schedule(hint);
+        std::scoped_lock lock{order_mutex};
+        order.push_back(id);
+    };
+    auto now{std::chrono::steady_clock::now()};
+    std::vector<cppcoro::task<void>> tasks;
+    tasks.push_back(task(0, schedule_hint{}));
+    tasks.push_back(task(1, schedule_hint{1, now + 2s}));
+    tasks.push_back(task(2, schedule_hint{1, now + 1s}));
+    tasks.push_back(task(3, schedule_hint{}));
+    tasks.push_back(task(4, schedule_hint{2}));
+    std::thread releaser{[&] {
+        std::this_thread::sleep_for(100ms);
+        release_promise.set_value();
+    }};
+    cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
+    releaser.join();
+    blocker_thread.join();
+
+    REQUIRE(order == std::vector<int>{4, 2, 1, 0, 3});
+}
+
+TEST_CASE("work_stealing_pool reserved threads", tag)
+{
+    using namespace std::chrono_literals;
+    // One worker for any work, one reserved for interactive work
+    work_stealing_pool pool{2, 1};
+    REQUIRE(pool.reserved_thread_count() == 1);
+    std::promise<void> started_promise;
+    std::promise<void> release_promise;
+    auto release_future{release_promise.get_future().share()};
+    std::atomic<bool> background_done{false};
+
+    // Keeps the non-reserved worker busy with background work
+    auto blocker = [&]() -> cppcoro::task<void> {
+        co_await pool.schedule(schedule_hint{request_priority::background});
+        started_promise.set_value();
+        release_future.wait();
+    };
+    std::thread blocker_thread{[&] { cppcoro::sync_wait(blocker()); }};
+    started_promise.get_future().wait();
+
+    // Other background work has to wait for the blocker.
+    auto background = [&]() -> cppcoro::task<void> {
+        co_await pool.schedule(schedule_hint{request_priority::background});
+        background_done = true;
+    };
+    std::thread background_thread{[&] { cppcoro::sync_wait(background()); }};
+
+    // Interactive work runs on the reserved worker.
+    auto interactive = [&]() -> cppcoro::task<bool> {
+        co_await pool.schedule(schedule_hint{request_priority::interactive});
+        co_return release_future.wait_for(0s) == std::future_status::timeout;
+    };
+    REQUIRE(cppcoro::sync_wait(interactive()));
+    REQUIRE(!background_done);
+
+    release_promise.set_value();
+    blocker_thread.join();
+    background_thread.join();
+    REQUIRE(background_done);
+}
@@ -0,0 +1,138 @@
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+#include <catch2/catch.hpp>
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/sync_wait.hpp>
+
+#include <cradle/inner/core/type_interfaces.h>
+#include <cradle/inner/fs/file_io.h>
+#include <cradle/plugins/secondary_cache/local/chunked_file.h>
+
+using namespace cradle;
+
+namespace {
+
+char const tag[] = "[chunked_file]";
+
+blob
+make_test_value(std::size_t size)
+{
+    std::string data(size, '\0');
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<char>((i * 7) % 251);
+    }
+    return make_blob(std::move(data));
+}
+
+file_path
+make_test_path()
+{
+    file_path dir{"chunked_file_tests"};
+    std::filesystem::create_directories(dir);
+    return dir / "value";
+}
+
+} // namespace
+
+TEST_CASE("chunked file round trip", tag)
+{
+    auto codec = GENERATE(
+        disk_cache_codec::store,
+        disk_cache_codec::lz4,
+        disk_cache_codec::zstd);
+    // 0: no chunks; 1000: exact multiple; 2500: partial last chunk
+    auto size = GENERATE(as<std::size_t>{}, 0, 1000, 2500);
+    cppcoro::static_thread_pool pool{2};
+    auto path{make_test_path()};
+    auto value{make_test_value(size)};
+    chunked_file_options options{codec, 3, 500};
+
+    auto file_size = write_chunked_file(pool, path, value, options);
+
+    REQUIRE(file_size == std::filesystem::file_size(path));
+    REQUIRE(is_chunked_file(path));
+    auto read_value{cppcoro::sync_wait(read_chunked_file(pool, path))};
+    REQUIRE(read_value == value);
+}
+
+TEST_CASE("chunked file random access", tag)
+{
+    cppcoro::static_thread_pool pool{2};
+    auto path{make_test_path()};
+    auto value{make_test_value(2500)};
+    chunked_file_options options{disk_cache_codec::lz4, 0, 500};
+    write_chunked_file(pool, path, value, options);
+
+    chunked_file_reader reader{path};
+
+    REQUIRE(reader.codec() == disk_cache_codec::lz4);
+    REQUIRE(reader.original_size() == 2500);
+    REQUIRE(reader.num_chunks() == 5);
+    REQUIRE(reader.chunk_original_size(4) == 500);
+    std::string chunk(1000, '\0');
+    reader.read_chunks(3, 5, chunk.data());
+    REQUIRE(chunk == to_string(value).substr(1500, 1000));
+    REQUIRE_THROWS(reader.read_chunks(4, 6, chunk.data()));
+}
+
+TEST_CASE("stored chunked file is mapped", tag)
+{
+    cppcoro::static_thread_pool pool{2};
+    auto path{make_test_path()};
+    auto value{make_test_value(2500)};
+    chunked_file_options options{disk_cache_codec::lz4, 0, 500, 2000};
+    write_chunked_file(pool, path, value, options);
+
+    REQUIRE(chunked_file_reader{path}.codec() == disk_cache_codec::store);
+    auto read_value{cppcoro::sync_wait(read_chunked_file(pool, path))};
+    REQUIRE(read_value == value);
+    REQUIRE(read_value.mapped_file_data_owner() != nullptr);
+}
+
+TEST_CASE("rewriting a mapped chunked file", tag)
+{
+    cppcoro::static_thread_pool pool{2};
+    auto path{make_test_path()};
+    auto value0{make_test_value(2500)};
+    auto value1{make_test_value(3000)};
+    chunked_file_options options{disk_cache_codec::store, 0, 500};
+    write_chunked_file(pool, path, value0, options);
+    auto mapped{cppcoro::sync_wait(read_chunked_file(pool, path))};
+    REQUIRE(mapped.mapped_file_data_owner() != nullptr);
+
+    write_chunked_file(pool, path, value1, options);
+
+    // The earlier mapping still shows the old contents.
+    REQUIRE(mapped == value0);
+    REQUIRE(cppcoro::sync_wait(read_chunked_file(pool, path)) == value1);
+    // No temporary files are left behind.
+    for (auto const& entry :
+         std::filesystem::directory_iterator{path.parent_path()})
+    {
+        REQUIRE(entry.path().extension() != ".tmp");
+    }
+}
+
+TEST_CASE("truncated chunked file", tag)
+{
+    cppcoro::static_thread_pool pool{2};
+    auto path{make_test_path()};
+    auto value{make_test_value(2500)};
+    chunked_file_options options{disk_cache_codec::lz4, 0, 500};
+    write_chunked_file(pool, path, value, options);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    REQUIRE(is_chunked_file(path));
+    REQUIRE_THROWS_AS(chunked_file_reader{path}, chunked_file_error);
+}
+
+TEST_CASE("legacy LZ4 file is not chunked", tag)
+{
+    auto path{make_test_path()};
+    dump_string_to_file(path, "\x1f some LZ4 block");
+
+    REQUIRE(!is_chunked_file(path));
+}
@@ -1,6 +1,8 @@
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <thread>
+#include <vector>
 
 #include <catch2/catch.hpp>
 #include <sqlite3.h>
@@ -549,3 +551,59 @@ TEST_CASE("disk cache - blob file", tag)
     REQUIRE(reader != nullptr);
     REQUIRE(reader->mapped_file() == writer->mapped_file());
 }
+
+TEST_CASE("concurrent inserts and look-ups", tag)
+{
+    std::string cache_dir{"disk_cache"};
+    reset_directory(cache_dir);
+    auto config{create_config(cache_dir)};
+    config.size_limit = 0x10'00'00;
+    config.num_read_connections = 2;
+    ll_disk_cache cache{config};
+    constexpr int num_threads = 4;
+    constexpr int num_items = 50;
+
+    constexpr int num_ids = num_threads * num_items;
+
+    // Each thread inserts its own items, and looks up those of the other
+    // threads. Inserts from different threads are committed in shared
+    // transactions; a look-up must see an item once its insert has returned.
+    // (Catch2 assertions are not thread-safe, so the threads count failures.)
+    std::atomic<int> num_failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&cache, &num_failures, t] {
+            for (int i = 0; i < num_items; ++i)
+            {
+                auto id = t * num_items + i;
+                auto key = generate_key_string(id);
+                auto value{make_blob(generate_value_string(id))};
+                cache.insert(key, get_unique_string_tmpl(value), value);
+                auto entry = cache.find(key);
+                if (!entry || !entry->value || *entry->value != value)
+                {
+                    ++num_failures;
+                }
+                cache.find(generate_key_string((id + num_items) % num_ids));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    REQUIRE(num_failures == 0);
+    cache.flush_ac_usage(true);
+
+    auto info = cache.get_summary_info();
+    REQUIRE(info.ac_entry_count == num_ids);
+    REQUIRE(info.cas_entry_count == num_ids);
+    for (int id = 0; id < num_ids; ++id)
+    {
+        auto entry = cache.find(generate_key_string(id));
+        REQUIRE(entry);
+        REQUIRE(entry->value);
+        REQUIRE(to_string(*entry->value) == generate_value_string(id));
+    }
+}
@@ -1,10 +1,15 @@
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <catch2/catch.hpp>
+#include <cppcoro/sync_wait.hpp>
 
 #include <cradle/inner/core/type_interfaces.h>
 #include <cradle/plugins/secondary_cache/local/local_disk_cache.h>
 
+#include "../../../support/concurrency_testing.h"
+
 using namespace cradle;
 
 namespace {
@@ -57,3 +62,71 @@ TEST_CASE("read non-existent raw value", tag)
     auto read_value1{cache.read_raw_value(read_key)};
     REQUIRE(!read_value1);
 }
+
+TEST_CASE("batched read/write", tag)
+{
+    local_disk_cache cache{create_config()};
+    // One value goes into the database, the other one into an external file.
+    auto small_value{make_string_literal_blob("small value")};
+    auto large_value{make_blob(std::string(2000, 'x'))};
+    std::vector<std::pair<std::string, blob>> entries{
+        {"small_key", small_value}, {"large_key", large_value}};
+
+    cppcoro::sync_wait(cache.write_many(std::move(entries)));
+    REQUIRE(occurs_soon([&] { return !cache.busy_writing_to_file(); }));
+
+    std::vector<std::string> keys{"large_key", "missing_key", "small_key"};
+    auto values{cppcoro::sync_wait(cache.read_many(keys))};
+    REQUIRE(values.size() == 3);
+    REQUIRE(values[0]);
+    REQUIRE(*values[0] == large_value);
+    REQUIRE(!values[1]);
+    REQUIRE(values[2]);
+    REQUIRE(*values[2] == small_value);
+
+    auto found{cppcoro::sync_wait(cache.contains_many(keys))};
+    REQUIRE(found == std::vector<bool>{true, false, true});
+}
+
+TEST_CASE("contains_many is a pure query", tag)
+{
+    local_disk_cache cache{create_config()};
+    cache.write_raw_value("key", make_string_literal_blob("value"));
+    REQUIRE(occurs_soon([&] { return !cache.busy_writing_to_file(); }));
+    auto before{cache.get_summary_info()};
+
+    std::vector<std::string> keys{"key", "missing_key"};
+    auto found{cppcoro::sync_wait(cache.contains_many(keys))};
+
+    REQUIRE(found == std::vector<bool>{true, false});
+    auto after{cache.get_summary_info()};
+    REQUIRE(after.hit_count == before.hit_count);
+    REQUIRE(after.miss_count == before.miss_count);
+}
+
+TEST_CASE("values in chunked files", tag)
+{
+    auto codec = GENERATE(as<std::string>{}, "store", "lz4", "zstd");
+    auto config_map{inner_config_map};
+    config_map[local_disk_cache_config_keys::CODEC] = codec;
+    config_map[local_disk_cache_config_keys::COMPRESSION_LEVEL] = 5U;
+    config_map[local_disk_cache_config_keys::CHUNK_SIZE] = 1000U;
+    config_map[local_disk_cache_config_keys::CHECK_FILE_DATA] = true;
+    local_disk_cache cache{service_config{config_map}};
+    std::string data;
+    for (int i = 0; i < 1000; ++i)
+    {
+        data += std::to_string(i);
+    }
+    // Goes into a file, split into three chunks
+    auto value{make_blob(data)};
+
+    cppcoro::sync_wait(cache.write("key", value));
+    REQUIRE(occurs_soon([&] { return !cache.busy_writing_to_file(); }));
+
+    auto read_value{cppcoro::sync_wait(cache.read("key"))};
+    REQUIRE(read_value);
+    REQUIRE(*read_value == value);
+    // The blob must not be mistaken for one backed by a complete file
+    REQUIRE(read_value->mapped_file_data_owner() == nullptr);
+}
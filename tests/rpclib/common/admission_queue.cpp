@@ -0,0 +1,111 @@
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <cradle/rpclib/common/admission_queue.h>
+
+using namespace cradle;
+
+static char const tag[] = "[rpclib][admission_queue]";
+
+namespace {
+
+void
+wait_until_num_waiting(admission_queue& queue, int expected)
+{
+    while (queue.num_waiting() != expected)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Records the order in which requests are admitted; each admitted request
+// immediately gives up its slot again.
+struct admission_log
+{
+    std::mutex mutex;
+    std::vector<std::string> requests;
+
+    void
+    admit(admission_queue& queue, std::string client_id, std::string request)
+    {
+        auto ticket{queue.admit(client_id)};
+        std::scoped_lock lock{mutex};
+        requests.push_back(std::move(request));
+    }
+};
+
+} // namespace
+
+TEST_CASE("admission_queue admits up to max_active at once", tag)
+{
+    admission_queue queue{2, 0};
+    auto ticket0{queue.admit("a")};
+    auto ticket1{queue.admit("a")};
+    REQUIRE(queue.num_waiting() == 0);
+}
+
+TEST_CASE("admission_queue rejects when max_waiting are waiting", tag)
+{
+    admission_queue queue{1, 2};
+    std::optional<admission_queue::ticket> ticket{queue.admit("a")};
+    admission_log log;
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 2; ++i)
+    {
+        threads.emplace_back([&, i] {
+            log.admit(queue, "a", "a" + std::to_string(i));
+        });
+    }
+    wait_until_num_waiting(queue, 2);
+
+    REQUIRE_THROWS_WITH(
+        queue.admit("b"),
+        "rpclib: too many requests waiting; the server is busy");
+    REQUIRE(queue.num_waiting() == 2);
+
+    // The waiting requests are still admitted.
+    ticket.reset();
+    threads.clear();
+    REQUIRE(log.requests == std::vector<std::string>{"a0", "a1"});
+    REQUIRE(queue.num_waiting() == 0);
+    // Which frees the slot for a new request.
+    auto ticket1{queue.admit("b")};
+}
+
+TEST_CASE("admission_queue admits round-robin across clients", tag)
+{
+    admission_queue queue{1, 10};
+    std::optional<admission_queue::ticket> ticket{queue.admit("x")};
+    admission_log log;
+    std::vector<std::jthread> threads;
+    // A burst of requests from client a, followed by requests from b and c
+    std::vector<std::pair<std::string, std::string>> requests{
+        {"a", "a0"},
+        {"a", "a1"},
+        {"a", "a2"},
+        {"b", "b0"},
+        {"c", "c0"},
+        {"b", "b1"}};
+    for (auto const& [client_id, request] : requests)
+    {
+        int num_waiting{queue.num_waiting()};
+        threads.emplace_back([&, client_id, request] {
+            log.admit(queue, client_id, request);
+        });
+        // Ensure that the requests queue up in this order.
+        wait_until_num_waiting(queue, num_waiting + 1);
+    }
+
+    ticket.reset();
+    threads.clear();
+    REQUIRE(
+        log.requests
+        == std::vector<std::string>{"a0", "b0", "c0", "a1", "b1", "a2"});
+}
@@ -0,0 +1,271 @@
+#include "http_server.h"
+
+#include <atomic>
+#include <istream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// Boost ASIO complains if we don't define this.
+#if defined(WIN32) && !defined(_WIN32_WINNT)
+#define _WIN32_WINNT 0x0601 // Windows 7
+#endif
+#include <boost/algorithm/string.hpp>
+#include <boost/asio.hpp>
+#include <fmt/format.h>
+
+namespace cradle {
+
+using boost::asio::ip::tcp;
+
+struct local_http_server_impl
+{
+    std::chrono::milliseconds response_delay;
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor{io_context};
+    int port{};
+    std::atomic<bool> stopping{false};
+    std::atomic<int> num_connections{0};
+    std::atomic<int> num_requests{0};
+
+    // The sockets of the open connections; protected by mutex
+    std::list<tcp::socket*> sockets;
+    std::mutex mutex;
+
+    std::list<std::thread> connection_threads;
+    std::thread accept_thread;
+};
+
+namespace {
+
+struct parsed_request
+{
+    std::string method;
+    std::string target;
+    std::string body;
+    bool keep_alive{true};
+};
+
+// Reads the next request on socket; returns false if the client closed the
+// connection.
+bool
+read_request(
+    tcp::socket& socket,
+    boost::asio::streambuf& buffer,
+    parsed_request& request)
+{
+    boost::system::error_code ec;
+    auto header_size = boost::asio::read_until(socket, buffer, "\r\n\r\n", ec);
+    if (ec)
+    {
+        return false;
+    }
+    std::string header_text(
+        boost::asio::buffers_begin(buffer.data()),
+        boost::asio::buffers_begin(buffer.data()) + header_size);
+    buffer.consume(header_size);
+
+    std::istringstream header_stream(header_text);
+    std::string line;
+    std::getline(header_stream, line);
+    std::istringstream request_line(line);
+    std::string version;
+    request_line >> request.method >> request.target >> version;
+    request.keep_alive = version != "HTTP/1.0";
+    std::size_t content_length{};
+    while (std::getline(header_stream, line) && line != "\r")
+    {
+        auto index = line.find(':');
+        if (index == std::string::npos)
+        {
+            continue;
+        }
+        auto name = boost::algorithm::to_lower_copy(
+            boost::algorithm::trim_copy(line.substr(0, index)));
+        auto value = boost::algorithm::trim_copy(line.substr(index + 1));
+        if (name == "content-length")
+        {
+            content_length = std::stoul(value);
+        }
+        else if (name == "connection")
+        {
+            request.keep_alive
+                = !boost::algorithm::iequals(value, "close");
+        }
+    }
+
+    if (buffer.size() < content_length)
+    {
+        boost::asio::read(
+            socket,
+            buffer,
+            boost::asio::transfer_exactly(content_length - buffer.size()),
+            ec);
+        if (ec)
+        {
+            return false;
+        }
+    }
+    request.body.assign(
+        boost::asio::buffers_begin(buffer.data()),
+        boost::asio::buffers_begin(buffer.data()) + content_length);
+    buffer.consume(content_length);
+    return true;
+}
+
+std::string
+make_response(parsed_request const& request)
+{
+    int status_code{200};
+    std::string body;
+    std::string const status_prefix{"/status/"};
+    if (request.target.starts_with(status_prefix))
+    {
+        status_code = std::stoi(request.target.substr(status_prefix.size()));
+    }
+    else if (request.method == "POST" || request.method == "PUT")
+    {
+        body = request.body;
+    }
+    else
+    {
+        body = request.target;
+    }
+    auto response = fmt::format(
+        "HTTP/1.1 {} {}\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: {}\r\n"
+        "{}"
+        "\r\n",
+        status_code,
+        status_code == 200 ? "OK" : "Error",
+        body.size(),
+        request.keep_alive ? "" : "Connection: close\r\n");
+    if (request.method != "HEAD")
+    {
+        response += body;
+    }
+    return response;
+}
+
+void
+serve_connection(local_http_server_impl& impl, tcp::socket& socket)
+{
+    boost::asio::streambuf buffer;
+    parsed_request request;
+    while (!impl.stopping && read_request(socket, buffer, request))
+    {
+        if (impl.response_delay.count() > 0)
+        {
+            std::this_thread::sleep_for(impl.response_delay);
+        }
+        ++impl.num_requests;
+        boost::system::error_code ec;
+        boost::asio::write(
+            socket, boost::asio::buffer(make_response(request)), ec);
+        if (ec || !request.keep_alive)
+        {
+            break;
+        }
+    }
+    std::scoped_lock<std::mutex> lock(impl.mutex);
+    impl.sockets.remove(&socket);
+}
+
+void
+accept_connections(local_http_server_impl& impl)
+{
+    while (true)
+    {
+        auto socket = std::make_shared<tcp::socket>(impl.io_context);
+        boost::system::error_code ec;
+        impl.acceptor.accept(*socket, ec);
+        if (impl.stopping)
+        {
+            break;
+        }
+        if (ec)
+        {
+            continue;
+        }
+        ++impl.num_connections;
+        std::scoped_lock<std::mutex> lock(impl.mutex);
+        impl.sockets.push_back(socket.get());
+        // The thread owns the socket.
+        impl.connection_threads.emplace_back(
+            [&impl, socket] { serve_connection(impl, *socket); });
+    }
+}
+
+} // namespace
+
+local_http_server::local_http_server(
+    std::chrono::milliseconds response_delay)
+    : impl_{std::make_unique<local_http_server_impl>()}
+{
+    auto& impl{*impl_};
+    impl.response_delay = response_delay;
+    tcp::endpoint endpoint{boost::asio::ip::make_address("127.0.0.1"), 0};
+    impl.acceptor.open(endpoint.protocol());
+    impl.acceptor.set_option(tcp::acceptor::reuse_address(true));
+    impl.acceptor.bind(endpoint);
+    impl.acceptor.listen();
+    impl.port = impl.acceptor.local_endpoint().port();
+    impl.accept_thread = std::thread{accept_connections, std::ref(impl)};
+}
+
+local_http_server::~local_http_server()
+{
+    auto& impl{*impl_};
+    impl.stopping = true;
+    // Wake up the accepting thread by connecting to it.
+    {
+        boost::system::error_code ec;
+        tcp::socket socket{impl.io_context};
+        socket.connect(
+            tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"),
+                          static_cast<unsigned short>(impl.port)},
+            ec);
+    }
+    impl.accept_thread.join();
+    // Wake up the connection threads.
+    {
+        std::scoped_lock<std::mutex> lock(impl.mutex);
+        for (auto* socket : impl.sockets)
+        {
+            boost::system::error_code ec;
+            socket->shutdown(tcp::socket::shutdown_both, ec);
+        }
+    }
+    for (auto& thread : impl.connection_threads)
+    {
+        thread.join();
+    }
+}
+
+int
+local_http_server::port() const
+{
+    return impl_->port;
+}
+
+std::string
+local_http_server::url(std::string const& target) const
+{
+    return fmt::format("http://127.0.0.1:{}{}", impl_->port, target);
+}
+
+int
+local_http_server::num_connections() const
+{
+    return impl_->num_connections;
+}
+
+int
+local_http_server::num_requests() const
+{
+    return impl_->num_requests;
+}
+
+} // namespace cradle
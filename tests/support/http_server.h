@@ -0,0 +1,59 @@
+#ifndef CRADLE_TESTS_SUPPORT_HTTP_SERVER_H
+#define CRADLE_TESTS_SUPPORT_HTTP_SERVER_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace cradle {
+
+struct local_http_server_impl;
+
+/*
+ * A minimal HTTP/1.1 server on 127.0.0.1, for testing and benchmarking HTTP
+ * clients without network access. Connections are kept alive unless the
+ * client asks otherwise; each connection is served by its own thread.
+ *
+ * The server responds to
+ * - a target of the form /status/<code>: with that status code, and an
+ *   empty body;
+ * - POST and PUT: with status 200 and the request body;
+ * - anything else: with status 200 and the request target as body.
+ */
+class local_http_server
+{
+ public:
+    // Starts serving on an ephemeral port. Each response is delayed by
+    // response_delay, simulating a remote server.
+    explicit local_http_server(
+        std::chrono::milliseconds response_delay = std::chrono::milliseconds{
+            0});
+    ~local_http_server();
+
+    local_http_server(local_http_server const&) = delete;
+    local_http_server&
+    operator=(local_http_server const&)
+        = delete;
+
+    int
+    port() const;
+
+    // Returns the URL for target (which should start with a '/')
+    std::string
+    url(std::string const& target) const;
+
+    // Returns the number of connections accepted so far
+    int
+    num_connections() const;
+
+    // Returns the number of requests served so far
+    int
+    num_requests() const;
+
+ private:
+    std::unique_ptr<local_http_server_impl> impl_;
+};
+
+} // namespace cradle
+
+#endif
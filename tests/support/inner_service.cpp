@@ -44,7 +44,21 @@ std::unique_ptr<inner_resources>
 make_inner_test_resources(
     std::string const& proxy_name, domain_option const& domain)
 {
-    auto config{make_inner_tests_config()};
+    return make_inner_test_resources(proxy_name, domain, {});
+}
+
+std::unique_ptr<inner_resources>
+make_inner_test_resources(
+    std::string const& proxy_name,
+    domain_option const& domain,
+    service_config_map const& extra_config)
+{
+    auto config_map{inner_config_map};
+    for (auto const& [key, value] : extra_config)
+    {
+        config_map[key] = value;
+    }
+    service_config config{config_map};
     auto resources{std::make_unique<inner_resources>(config)};
     resources->set_secondary_cache(std::make_unique<local_disk_cache>(config));
     init_and_register_proxy(*resources, proxy_name, domain);
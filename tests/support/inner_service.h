@@ -19,6 +19,14 @@ make_inner_test_resources(
     std::string const& proxy_name = {},
     domain_option const& domain = no_domain_option());
 
+// Like previous, adding the given items to (or overriding them in) the
+// tests config
+std::unique_ptr<inner_resources>
+make_inner_test_resources(
+    std::string const& proxy_name,
+    domain_option const& domain,
+    service_config_map const& extra_config);
+
 class non_caching_request_resolution_context final
     : public virtual local_context_intf,
       public virtual sync_context_intf
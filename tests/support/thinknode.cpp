@@ -31,12 +31,6 @@ service_config_map const thinknode_config_map{
     {introspection_config_keys::FORCE_FINISH, true},
 };
 
-service_config
-make_thinknode_tests_config()
-{
-    return service_config{thinknode_config_map};
-}
-
 class thinknode_domain_option : public domain_option
 {
  public:
@@ -60,11 +54,13 @@ class thinknode_domain_option : public domain_option
 } // namespace
 
 thinknode_test_scope::thinknode_test_scope(
-    std::string const& proxy_name, bool use_real_api_token)
+    std::string const& proxy_name,
+    bool use_real_api_token,
+    service_config_map const& extra_config)
     : proxy_name_{proxy_name},
       use_real_api_token_{use_real_api_token},
-      resources_{
-          make_thinknode_test_resources(proxy_name, thinknode_domain_option{})}
+      resources_{make_thinknode_test_resources(
+          proxy_name, thinknode_domain_option{}, extra_config)}
 {
     if (!proxy_name_.empty())
     {
@@ -135,7 +131,21 @@ std::unique_ptr<service_core>
 make_thinknode_test_resources(
     std::string const& proxy_name, domain_option const& domain)
 {
-    auto config{make_thinknode_tests_config()};
+    return make_thinknode_test_resources(proxy_name, domain, {});
+}
+
+std::unique_ptr<service_core>
+make_thinknode_test_resources(
+    std::string const& proxy_name,
+    domain_option const& domain,
+    service_config_map const& extra_config)
+{
+    auto config_map{thinknode_config_map};
+    for (auto const& [key, value] : extra_config)
+    {
+        config_map[key] = value;
+    }
+    service_config config{config_map};
     auto resources{std::make_unique<service_core>(config)};
     resources->set_secondary_cache(std::make_unique<local_disk_cache>(config));
     init_and_register_proxy(*resources, proxy_name, domain);
@@ -24,8 +24,11 @@ class thinknode_test_scope
 {
  public:
     // proxy_name should be "" (local, default), "loopback" or "rpclib"
+    // extra_config items are added to (or override) the tests config
     thinknode_test_scope(
-        std::string const& proxy_name = {}, bool use_real_api_token = false);
+        std::string const& proxy_name = {},
+        bool use_real_api_token = false,
+        service_config_map const& extra_config = {});
 
     ~thinknode_test_scope();
 
@@ -72,6 +75,14 @@ make_thinknode_test_resources(
     std::string const& proxy_name = {},
     domain_option const& domain = no_domain_option());
 
+// Like previous, adding the given items to (or overriding them in) the
+// tests config
+std::unique_ptr<service_core>
+make_thinknode_test_resources(
+    std::string const& proxy_name,
+    domain_option const& domain,
+    service_config_map const& extra_config);
+
 } // namespace cradle
 
 #endif
@@ -0,0 +1,157 @@
+#include <cradle/typing/core/flat_dynamic.h>
+
+#include <cradle/typing/core.h>
+#include <cradle/typing/encodings/json.h>
+#include <cradle/typing/encodings/msgpack.h>
+#include <cradle/typing/encodings/msgpack_codec.h>
+#include <cradle/typing/utilities/testing.h>
+
+using namespace cradle;
+
+namespace {
+
+static char const tag[] = "[core][flat_dynamic]";
+
+dynamic
+make_sample_value()
+{
+    auto point = [](double x, integer y) {
+        return dynamic(dynamic_map{
+            {dynamic("x"), dynamic(x)}, {dynamic("y"), dynamic(y)}});
+    };
+    return dynamic(dynamic_map{
+        {dynamic("id"), dynamic("abc")},
+        {dynamic("count"), dynamic(integer(12))},
+        {dynamic("ratio"), dynamic(0.25)},
+        {dynamic("enabled"), dynamic(true)},
+        {dynamic("nothing"), dynamic(nil)},
+        {dynamic("mask"), dynamic(make_blob("mask data"))},
+        {dynamic("time"),
+         dynamic(ptime(
+             boost::gregorian::date(2017, boost::gregorian::Apr, 26),
+             boost::posix_time::time_duration(1, 2, 3)))},
+        {dynamic("points"),
+         dynamic(dynamic_array{point(1.5, -2), point(3.0, 4)})},
+        {dynamic("labels"),
+         dynamic(
+             dynamic_array{dynamic("a"), dynamic("b"), dynamic("a")})}});
+}
+
+} // namespace
+
+TEST_CASE("flat_dynamic conversion", tag)
+{
+    REQUIRE(to_dynamic(flat_dynamic()) == dynamic(nil));
+
+    auto original = make_sample_value();
+    auto flat = make_flat_dynamic(original);
+    REQUIRE(flat.type() == value_type::MAP);
+    REQUIRE(to_dynamic(flat) == original);
+
+    flat_dynamic from;
+    from_dynamic(&from, original);
+    REQUIRE(from == flat);
+    REQUIRE(from != make_flat_dynamic(dynamic(integer(0))));
+}
+
+TEST_CASE("flat_dynamic field lookup", tag)
+{
+    auto flat = make_flat_dynamic(make_sample_value());
+    auto root = flat.root();
+    REQUIRE(root.size() == 9);
+
+    REQUIRE(root.get_field("id").as_string() == "abc");
+    REQUIRE(root.get_field("count").as_integer() == 12);
+    REQUIRE(root.get_field("ratio").as_double() == 0.25);
+    REQUIRE(root.get_field("enabled").as_bool());
+    REQUIRE(root.get_field("nothing").type() == value_type::NIL);
+    REQUIRE(root.get_field("mask").as_blob() == make_blob("mask data"));
+    REQUIRE(
+        root.get_field("time").as_datetime()
+        == ptime(
+            boost::gregorian::date(2017, boost::gregorian::Apr, 26),
+            boost::posix_time::time_duration(1, 2, 3)));
+
+    auto points = root.get_field("points");
+    REQUIRE(points.size() == 2);
+    REQUIRE(points[1].get_field("y").as_integer() == 4);
+
+    flat_dynamic_view missing{nullptr};
+    REQUIRE(!root.get_field(&missing, "missing"));
+    REQUIRE_THROWS_AS(root.get_field("missing"), missing_field);
+    REQUIRE_THROWS_AS(root.get_field("id").as_integer(), type_mismatch);
+}
+
+TEST_CASE("flat_dynamic map building", tag)
+{
+    // Entries are sorted, and the last of any duplicates wins, just as if
+    // they were inserted into a dynamic_map.
+    flat_dynamic_builder builder;
+    auto* entries = builder.set_map(builder.root(), 4);
+    builder.set_string(entries[0], "b");
+    builder.set_integer(entries[1], 1);
+    builder.set_string(entries[2], "a");
+    builder.set_integer(entries[3], 2);
+    builder.set_string(entries[4], "b");
+    builder.set_integer(entries[5], 3);
+    builder.set_integer(entries[6], 0);
+    builder.set_integer(entries[7], 4);
+    builder.finish_map(builder.root());
+    auto flat = builder.finish();
+
+    REQUIRE(
+        to_dynamic(flat)
+        == dynamic(dynamic_map{
+            {dynamic(integer(0)), dynamic(integer(4))},
+            {dynamic("a"), dynamic(integer(2))},
+            {dynamic("b"), dynamic(integer(3))}}));
+    REQUIRE(flat.root().size() == 3);
+    REQUIRE(flat.root().key(2).as_string() == "b");
+}
+
+TEST_CASE("flat_dynamic string interning", tag)
+{
+    auto flat = make_flat_dynamic(make_sample_value());
+    auto labels = flat.root().get_field("labels");
+    REQUIRE(labels[0].as_string().data() == labels[2].as_string().data());
+    REQUIRE(labels[0].as_string().data() != labels[1].as_string().data());
+}
+
+TEST_CASE("flat_dynamic parsing", tag)
+{
+    auto original = make_sample_value();
+
+    SECTION("MessagePack")
+    {
+        auto owner = std::make_shared<string_owner>(
+            value_to_msgpack_string(original));
+        auto const* data = reinterpret_cast<uint8_t const*>(owner->bytes());
+        auto flat = parse_msgpack_flat_value(owner, data, owner->size());
+        REQUIRE(to_dynamic(flat) == original);
+
+        // The blob should reference the encoded data.
+        auto const& mask = flat.root().get_field("mask").as_blob();
+        REQUIRE(mask.owner() == owner.get());
+        REQUIRE(mask.data() > owner->bytes());
+        REQUIRE(mask.data() < owner->bytes() + owner->size());
+
+        REQUIRE_THROWS(parse_msgpack_flat_value(owner, data, 3));
+    }
+
+    SECTION("JSON")
+    {
+        auto json = value_to_json(original);
+        REQUIRE(to_dynamic(parse_json_flat_value(json)) == original);
+        REQUIRE(
+            to_dynamic(parse_json_flat_value(json))
+            == parse_json_value(json));
+
+        // Maps with non-string keys are encoded as key/value arrays.
+        auto map = dynamic(dynamic_map{
+            {dynamic(integer(2)), dynamic("b")},
+            {dynamic(integer(1)), dynamic("a")}});
+        REQUIRE(to_dynamic(parse_json_flat_value(value_to_json(map))) == map);
+
+        REQUIRE_THROWS_AS(parse_json_flat_value("{"), parsing_error);
+    }
+}
@@ -5,6 +5,7 @@
 
 #include <cradle/inner/utilities/text.h>
 #include <cradle/typing/encodings/json.h>
+#include <cradle/typing/encodings/msgpack_codec.h>
 #include <cradle/typing/utilities/testing.h>
 
 using namespace cradle;
@@ -30,6 +31,14 @@ test_msgpack_encoding(
     REQUIRE(converted_msgpack.size() == size);
     REQUIRE(std::memcmp(&converted_msgpack[0], msgpack, size) == 0);
 
+    // The direct codec should agree with both.
+    msgpack_reader reader{nullptr, msgpack, size};
+    dynamic direct_value;
+    from_msgpack(&direct_value, reader);
+    REQUIRE(reader.at_end());
+    REQUIRE(direct_value == expected_value);
+    REQUIRE(value_to_msgpack_string_direct(direct_value) == converted_msgpack);
+
     // Also try getting the MessagePack as a blob.
     auto msgpack_blob = value_to_msgpack_blob(converted_value);
     REQUIRE(msgpack_blob.size() == size);
@@ -0,0 +1,88 @@
+#include <cradle/typing/encodings/msgpack_codec.h>
+
+#include <cradle/typing/utilities/testing.h>
+#include <cradle/websocket/messages.hpp>
+
+using namespace cradle;
+
+namespace {
+
+static char const tag[] = "[encodings][msgpack_codec]";
+
+// Decodes a T directly from the given MessagePack, which is owned by a
+// string_owner.
+template<class T>
+T
+parse_direct(std::shared_ptr<string_owner> const& owner)
+{
+    auto const* data = reinterpret_cast<uint8_t const*>(owner->bytes());
+    msgpack_reader reader{owner, data, owner->size()};
+    T x;
+    from_msgpack(&x, reader);
+    REQUIRE(reader.at_end());
+    return x;
+}
+
+} // namespace
+
+TEST_CASE("direct MessagePack encoding of messages", tag)
+{
+    auto message = make_websocket_client_message(
+        "req1",
+        make_client_message_content_with_post_iss_object(
+            make_post_iss_object_request(
+                "ctx",
+                "string",
+                input_data_encoding::MSGPACK,
+                make_blob("object data"))));
+
+    // The direct encoding should decode to the same message as the encoding
+    // via dynamic, and vice versa.
+    auto direct = value_to_msgpack_string_direct(message);
+    auto via_dynamic = value_to_msgpack_string(to_dynamic(message));
+    REQUIRE(parse_msgpack_value(direct) == to_dynamic(message));
+
+    auto owner = std::make_shared<string_owner>(via_dynamic);
+    REQUIRE(parse_direct<websocket_client_message>(owner) == message);
+
+    // The blob should point into the encoded message rather than having been
+    // copied out of it.
+    owner = std::make_shared<string_owner>(direct);
+    auto decoded = parse_direct<websocket_client_message>(owner);
+    REQUIRE(decoded == message);
+    auto const& object = as_post_iss_object(decoded.content).object;
+    REQUIRE(object.owner() == owner.get());
+    REQUIRE(object.data() > owner->bytes());
+    REQUIRE(object.data() < owner->bytes() + owner->size());
+}
+
+TEST_CASE("direct MessagePack encoding of optional values", tag)
+{
+    auto response = make_websocket_cache_response("k", none);
+    auto owner = std::make_shared<string_owner>(
+        value_to_msgpack_string_direct(response));
+    REQUIRE(parse_direct<websocket_cache_response>(owner) == response);
+
+    response.value = some(string("v"));
+    owner = std::make_shared<string_owner>(
+        value_to_msgpack_string_direct(response));
+    REQUIRE(parse_direct<websocket_cache_response>(owner) == response);
+}
+
+TEST_CASE("direct MessagePack decoding errors", tag)
+{
+    // A websocket_cache_insert without its "value" field
+    dynamic_map record;
+    record[dynamic("key")] = dynamic("k");
+    auto owner = std::make_shared<string_owner>(
+        value_to_msgpack_string(dynamic(record)));
+    REQUIRE_THROWS_AS(
+        parse_direct<websocket_cache_insert>(owner), missing_field);
+
+    // ... and with a value of the wrong type
+    record[dynamic("value")] = dynamic(integer(1));
+    owner = std::make_shared<string_owner>(
+        value_to_msgpack_string(dynamic(record)));
+    REQUIRE_THROWS_AS(
+        parse_direct<websocket_cache_insert>(owner), type_mismatch);
+}
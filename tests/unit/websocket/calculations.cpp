@@ -1,3 +1,10 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include <cppcoro/async_scope.hpp>
 #include <cppcoro/sync_wait.hpp>
 
 #include "../../support/thinknode.h"
@@ -353,6 +360,215 @@ TEST_CASE("mixed calcs", "[calcs][ws]")
     REQUIRE(eval(function_pointer_calc) == dynamic(7.0));
 }
 
+TEST_CASE("wide calcs", "[calcs][ws]")
+{
+    thinknode_test_scope scope;
+
+    // The arguments are evaluated concurrently, on different threads.
+    std::atomic<int> call_count{0};
+    auto twice = make_function([&](dynamic_array args, tasklet_tracker*) {
+        ++call_count;
+        auto x = cast<double>(args.at(0));
+        if (x < 0)
+        {
+            throw std::invalid_argument("negative argument");
+        }
+        return dynamic(2 * x);
+    });
+    auto sum = make_function([&](dynamic_array args, tasklet_tracker*) {
+        ++call_count;
+        double total = 0;
+        for (auto const& arg : args)
+            total += cast<double>(arg);
+        return dynamic(total);
+    });
+
+    auto ctx{scope.make_context()};
+    auto eval = [&](calculation_request const& request) {
+        return cppcoro::sync_wait(resolve_calc_to_value(
+            ctx, "5dadeb4a004073e81b5e096255e83652", request));
+    };
+
+    constexpr int width = 64;
+    std::vector<calculation_request> args;
+    for (int i = 0; i < width; ++i)
+    {
+        args.push_back(
+            make_calculation_request_with_lambda(make_lambda_calculation(
+                twice,
+                {make_calculation_request_with_value(dynamic(double(i)))})));
+    }
+    REQUIRE(
+        eval(make_calculation_request_with_lambda(
+            make_lambda_calculation(sum, args)))
+        == dynamic(double(width * (width - 1))));
+    REQUIRE(call_count == width + 1);
+
+    // The results of an array calc are in the order of its items.
+    std::vector<dynamic> expected_items;
+    for (int i = 0; i < width; ++i)
+    {
+        expected_items.push_back(dynamic(2.0 * i));
+    }
+    REQUIRE(
+        eval(make_calculation_request_with_array(make_array_calc_request(
+            args,
+            make_thinknode_type_info_with_float_type(
+                thinknode_float_type()))))
+        == dynamic(expected_items));
+
+    // A failing argument makes the whole calculation fail.
+    args.push_back(
+        make_calculation_request_with_lambda(make_lambda_calculation(
+            twice, {make_calculation_request_with_value(dynamic(-1.0))})));
+    REQUIRE_THROWS_AS(
+        eval(make_calculation_request_with_lambda(
+            make_lambda_calculation(sum, args))),
+        std::invalid_argument);
+}
+
+TEST_CASE("interactive calcs overtake background load", "[calcs][ws]")
+{
+    // One of the two async threads is reserved for interactive work.
+    thinknode_test_scope scope{
+        "",
+        false,
+        {{inner_config_keys::ASYNC_CONCURRENCY, 2U},
+         {inner_config_keys::ASYNC_INTERACTIVE_THREADS, 1U}}};
+    auto& pool{scope.get_resources().get_async_thread_pool()};
+
+    // Background work blocks the other thread, with more of it queued.
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::atomic<int> num_started{0};
+    auto background = [&]() -> cppcoro::task<void> {
+        co_await pool.schedule(schedule_hint{request_priority::background});
+        ++num_started;
+        released.wait();
+    };
+    cppcoro::async_scope load;
+    for (int i = 0; i < 4; ++i)
+    {
+        load.spawn(background());
+    }
+    while (num_started == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    auto twice = make_function([](dynamic_array args, tasklet_tracker*) {
+        return dynamic(2 * cast<double>(args.at(0)));
+    });
+    auto sum = make_function([](dynamic_array args, tasklet_tracker*) {
+        double total = 0;
+        for (auto const& arg : args)
+            total += cast<double>(arg);
+        return dynamic(total);
+    });
+    std::vector<calculation_request> args;
+    for (int i = 0; i < 4; ++i)
+    {
+        args.push_back(
+            make_calculation_request_with_lambda(make_lambda_calculation(
+                twice,
+                {make_calculation_request_with_value(dynamic(double(i)))})));
+    }
+
+    // The calculation's arguments are resolved on the reserved thread.
+    auto ctx{scope.make_context()};
+    ctx.set_schedule_hint(schedule_hint{request_priority::interactive});
+    auto result = std::async(std::launch::async, [&] {
+        return cppcoro::sync_wait(resolve_calc_to_value(
+            ctx,
+            "5dadeb4a004073e81b5e096255e83652",
+            make_calculation_request_with_lambda(
+                make_lambda_calculation(sum, args))));
+    });
+    bool overtook{
+        result.wait_for(std::chrono::seconds(10))
+        == std::future_status::ready};
+    int num_started_meanwhile{num_started};
+    release.set_value();
+    cppcoro::sync_wait(load.join());
+    REQUIRE(overtook);
+    REQUIRE(num_started_meanwhile == 1);
+    REQUIRE(result.get() == dynamic(12.0));
+}
+
+TEST_CASE("let calcs", "[calcs][ws]")
+{
+    thinknode_test_scope scope;
+
+    std::atomic<int> double_count{0};
+    auto twice = make_function([&](dynamic_array args, tasklet_tracker*) {
+        ++double_count;
+        return dynamic(2 * cast<double>(args.at(0)));
+    });
+    auto add = make_function([](dynamic_array args, tasklet_tracker*) {
+        return dynamic(cast<double>(args.at(0)) + cast<double>(args.at(1)));
+    });
+
+    auto ctx{scope.make_context()};
+    auto eval = [&](calculation_request const& request) {
+        return cppcoro::sync_wait(resolve_calc_to_value(
+            ctx, "5dadeb4a004073e81b5e096255e83652", request));
+    };
+    auto x = make_calculation_request_with_variable("x");
+    auto y = make_calculation_request_with_variable("y");
+
+    // x is referenced four times (through y), but evaluated once; the inner
+    // LET shadows x.
+    auto three = make_calculation_request_with_lambda(make_lambda_calculation(
+        twice, {make_calculation_request_with_value(dynamic(1.5))}));
+    auto ten = make_calculation_request_with_value(dynamic(10.0));
+    REQUIRE(
+        eval(make_calculation_request_with_let(make_let_calc_request(
+            {{"x", three},
+             {"y",
+              make_calculation_request_with_lambda(
+                  make_lambda_calculation(add, {x, x}))}},
+            make_calculation_request_with_lambda(make_lambda_calculation(
+                add,
+                {make_calculation_request_with_lambda(
+                     make_lambda_calculation(add, {y, y})),
+                 make_calculation_request_with_let(
+                     make_let_calc_request({{"x", ten}}, x))})))))
+        == dynamic(22.0));
+    REQUIRE(double_count == 1);
+
+    // A variable is evaluated where it is referenced, so y sees the x of the
+    // inner LET.
+    REQUIRE(
+        eval(make_calculation_request_with_let(make_let_calc_request(
+            {{"x", three},
+             {"y",
+              make_calculation_request_with_lambda(
+                  make_lambda_calculation(add, {x, x}))}},
+            make_calculation_request_with_let(
+                make_let_calc_request({{"x", ten}}, y)))))
+        == dynamic(20.0));
+
+    REQUIRE_THROWS(eval(make_calculation_request_with_variable("z")));
+
+    // Variables whose definitions depend on their own values are rejected,
+    // also when they are evaluated concurrently.
+    REQUIRE_THROWS_AS(
+        eval(make_calculation_request_with_let(
+            make_let_calc_request({{"x", x}}, x))),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        eval(make_calculation_request_with_let(make_let_calc_request(
+            {{"x",
+              make_calculation_request_with_lambda(
+                  make_lambda_calculation(add, {y, ten}))},
+             {"y",
+              make_calculation_request_with_lambda(
+                  make_lambda_calculation(add, {x, ten}))}},
+            make_calculation_request_with_lambda(
+                make_lambda_calculation(add, {x, y}))))),
+        std::invalid_argument);
+}
+
 TEST_CASE("Thinknode calc conversion", "[calcs][ws]")
 {
     // value
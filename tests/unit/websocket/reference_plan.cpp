@@ -0,0 +1,131 @@
+#include <map>
+
+#include <cppcoro/sync_wait.hpp>
+
+#include <cradle/typing/utilities/testing.h>
+#include <cradle/websocket/reference_plan.h>
+
+using namespace cradle;
+
+namespace {
+
+static char const tag[] = "[websocket][reference_plan]";
+
+// Resolves named types from a fixed set of definitions, counting the calls.
+struct fake_resolver
+{
+    std::map<string, api_type_info> definitions;
+    int num_calls{0};
+
+    cppcoro::task<api_type_info>
+    operator()(api_named_type_reference const& ref)
+    {
+        ++num_calls;
+        co_return definitions.at(ref.name);
+    }
+};
+
+std::shared_ptr<reference_plan const>
+compile_plan(api_type_info const& type, fake_resolver& resolver)
+{
+    return cppcoro::sync_wait(reference_plan::compile(type, resolver));
+}
+
+std::vector<string>
+collect_references(reference_plan const& plan, dynamic const& value)
+{
+    std::vector<string> refs;
+    plan.collect_references(value, refs);
+    return refs;
+}
+
+api_type_info
+make_reference_type()
+{
+    return make_api_type_info_with_reference_type(
+        make_api_type_info_with_named_type(
+            make_api_named_type_reference("my_app", "target")));
+}
+
+} // namespace
+
+TEST_CASE("reference plan for reference-free type", tag)
+{
+    fake_resolver resolver;
+    auto array_type = make_api_type_info_with_array_type(make_api_array_info(
+        none, make_api_type_info_with_float_type(api_float_type())));
+    auto plan = compile_plan(array_type, resolver);
+    REQUIRE(!plan->may_contain_references());
+    REQUIRE(
+        collect_references(*plan, dynamic({dynamic(1.0), dynamic(2.0)}))
+            .empty());
+}
+
+TEST_CASE("reference plan for structure array", tag)
+{
+    fake_resolver resolver;
+    auto struct_type
+        = make_api_type_info_with_structure_type(api_structure_info(
+            {{"ref",
+              make_api_structure_field_info("r", make_reference_type(), none)},
+             {"x",
+              make_api_structure_field_info(
+                  "x",
+                  make_api_type_info_with_integer_type(api_integer_type()),
+                  none)}}));
+    auto array_type = make_api_type_info_with_array_type(
+        make_api_array_info(none, struct_type));
+    auto plan = compile_plan(array_type, resolver);
+    REQUIRE(plan->may_contain_references());
+    // The reference type's target is not resolved.
+    REQUIRE(resolver.num_calls == 0);
+
+    auto value = dynamic(
+        {dynamic(
+             {{dynamic("ref"), dynamic("abc")},
+              {dynamic("x"), dynamic(integer(1))}}),
+         dynamic(
+             {{dynamic("ref"), dynamic("def")},
+              {dynamic("x"), dynamic(integer(2))}})});
+    REQUIRE(
+        collect_references(*plan, value) == std::vector<string>{"abc", "def"});
+}
+
+TEST_CASE("reference plan for recursive type", tag)
+{
+    // list = union { nil: nil, cons: struct { head: ref, tail: list } }
+    auto list_type = make_api_type_info_with_named_type(
+        make_api_named_type_reference("my_app", "list"));
+    auto cons_type
+        = make_api_type_info_with_structure_type(api_structure_info(
+            {{"head",
+              make_api_structure_field_info(
+                  "h", make_reference_type(), none)},
+             {"tail", make_api_structure_field_info("t", list_type, none)}}));
+    fake_resolver resolver;
+    resolver.definitions["list"]
+        = make_api_type_info_with_union_type(api_union_info(
+            {{"nil",
+              make_api_union_member_info(
+                  "n", make_api_type_info_with_nil_type(api_nil_type()))},
+             {"cons", make_api_union_member_info("c", cons_type)}}));
+
+    auto plan = compile_plan(list_type, resolver);
+    REQUIRE(plan->may_contain_references());
+    REQUIRE(resolver.num_calls == 1);
+    // The cycle is not followed when sizing the plan.
+    REQUIRE(plan->deep_size() > sizeof(reference_plan));
+
+    auto empty = dynamic({{dynamic("nil"), dynamic(nil)}});
+    auto make_cons = [](string head, dynamic tail) {
+        return dynamic(
+            {{dynamic("cons"),
+              dynamic(
+                  {{dynamic("head"), dynamic(head)},
+                   {dynamic("tail"), tail}})}});
+    };
+    auto value = make_cons("a", make_cons("b", make_cons("c", empty)));
+    REQUIRE(
+        collect_references(*plan, value)
+        == std::vector<string>{"a", "b", "c"});
+}